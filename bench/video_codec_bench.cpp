@@ -0,0 +1,526 @@
+// Reproducible end-to-end benchmarks on synthetic sources.
+//
+// Sources are rendered locally with the lavfi testsrc2 and mandelbrot
+// generators at 720p, 1080p and 4K, encoded with every available codec of
+// the matrix into the work directory and reused by later runs. Each source
+// is then opened/probed and decoded (decode and RGB conversion timed
+// separately). The testsrc2 H.264 source of each resolution also runs
+// through the filter processors, frame saving and encoding, and through
+// random frame access, once cold and once served by the frame cache, and
+// through scene detection and frame QC on the decoded luma plane.
+//
+// Reports fps, ns/pixel and peak RSS per case, as a table and, with
+// --json, in a stable JSON schema for regression tracking. Peak RSS is the
+// process high-water mark after the case, so it only grows.
+//
+// Usage: video_codec_bench [--quick] [--frames=N] [--json=results.json] [--work-dir=dir]
+
+#include <media/media_file.h>
+#include <media/video_writer.h>
+#include <processing/frame_qc_processor.h>
+#include <processing/scene_detect_processor.h>
+#include <processing/simple_frame_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavfilter/avfilter.h>
+#include <libavfilter/buffersink.h>
+#include <libavutil/avutil.h>
+}
+
+namespace
+{
+    constexpr int kSchemaVersion = 1;
+    constexpr int kFrameRate = 30;
+
+    struct Resolution
+    {
+        const char *name;
+        int width;
+        int height;
+    };
+
+    struct Codec
+    {
+        const char *name; // Encoder name
+        const char *extension;
+    };
+
+    struct Source
+    {
+        std::string pattern;
+        Resolution resolution;
+        std::string codec;
+        std::string filename;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::string pattern;
+        Resolution resolution;
+        std::string codec;
+        int frames{0};
+        double seconds{0.0};
+        long peak_rss_kb{0};
+    };
+
+    // Terminal processor that only counts frames
+    class CountingProcessor : public video_codec::FrameProcessor
+    {
+    public:
+        bool processFrame(AVFrame *, int) override
+        {
+            count_++;
+            return true;
+        }
+
+        int getCount() const { return count_; }
+
+    private:
+        int count_{0};
+    };
+
+    // Terminal processor that encodes frames without per-frame logging
+    class EncodingProcessor : public video_codec::FrameProcessor
+    {
+    public:
+        explicit EncodingProcessor(video_codec::VideoWriter &writer) : writer_(writer) {}
+
+        bool processFrame(AVFrame *frame, int) override
+        {
+            return writer_.writeFrame(frame);
+        }
+
+    private:
+        video_codec::VideoWriter &writer_;
+    };
+
+    // Library code reports progress on stdout; keep it out of the results
+    class QuietScope
+    {
+    public:
+        QuietScope() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+        ~QuietScope() { std::cout.rdbuf(saved_); }
+
+    private:
+        std::ostringstream sink_;
+        std::streambuf *saved_;
+    };
+
+    long peakRssKb()
+    {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024; // bytes
+#else
+        return usage.ru_maxrss; // kilobytes
+#endif
+    }
+
+    double stageSeconds(const std::string &name)
+    {
+        return video_codec::PipelineMetrics::instance().stage(name).wall_ns.load() / 1e9;
+    }
+
+    // Render frames of a lavfi generator and encode them to filename
+    bool generateSource(const Source &source, int frames)
+    {
+        std::ostringstream desc;
+        desc << source.pattern << "=size=" << source.resolution.width << "x" << source.resolution.height
+             << ":rate=" << kFrameRate << ",format=rgb24";
+
+        AVFilterGraph *graph = avfilter_graph_alloc();
+        AVFilterContext *sink = nullptr;
+        AVFilterInOut *inputs = avfilter_inout_alloc();
+        bool result = graph && inputs &&
+                      avfilter_graph_create_filter(&sink, avfilter_get_by_name("buffersink"), "out",
+                                                   nullptr, nullptr, graph) >= 0;
+
+        if (result)
+        {
+            inputs->name = av_strdup("out");
+            inputs->filter_ctx = sink;
+            inputs->pad_idx = 0;
+            inputs->next = nullptr;
+            result = avfilter_graph_parse_ptr(graph, desc.str().c_str(), &inputs, nullptr, nullptr) >= 0 &&
+                     avfilter_graph_config(graph, nullptr) >= 0;
+        }
+        avfilter_inout_free(&inputs);
+
+        if (!result)
+        {
+            std::cerr << "Could not create source graph: " << desc.str() << std::endl;
+            avfilter_graph_free(&graph);
+            return false;
+        }
+
+        video_codec::VideoWriter writer;
+        result = writer.open(source.filename, source.resolution.width, source.resolution.height,
+                             kFrameRate, source.codec);
+        if (!result)
+            std::cerr << "Could not open " << source.filename << ": " << writer.getLastError() << std::endl;
+
+        video_codec::FramePtr frame = video_codec::makeFrame();
+        for (int i = 0; result && i < frames; ++i)
+        {
+            if (!frame || av_buffersink_get_frame(sink, frame.get()) < 0)
+            {
+                std::cerr << "Source " << source.pattern << " ended early" << std::endl;
+                result = false;
+                break;
+            }
+
+            result = writer.writeFrame(frame.get());
+            av_frame_unref(frame.get());
+        }
+
+        if (!writer.close())
+            result = false;
+
+        avfilter_graph_free(&graph);
+        if (!result)
+            std::filesystem::remove(source.filename);
+        return result;
+    }
+
+    // Decode the source through processor; metrics are reset beforehand
+    bool runProcessor(const Source &source, video_codec::FrameProcessor &processor, int frames)
+    {
+        video_codec::MediaFile media_file;
+        QuietScope quiet;
+
+        if (!media_file.open(source.filename))
+            return false;
+
+        video_codec::PipelineMetrics::instance().reset();
+        return media_file.processVideoFrames(processor, frames);
+    }
+
+    // Fetch frames at fixed pseudo-random positions within the first frames,
+    // twice on one stream; returns the seconds of both passes
+    bool runRandomAccess(const Source &source, int frames, int lookups, double &cold_seconds, double &cached_seconds)
+    {
+        video_codec::MediaFile media_file;
+        QuietScope quiet;
+
+        if (!media_file.open(source.filename))
+            return false;
+
+        video_codec::VideoStream stream = media_file.getVideoStream();
+        AVRational time_base = stream.getTimeBase();
+        std::vector<int64_t> timestamps;
+        uint32_t state = 12345;
+        for (int i = 0; i < lookups; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            timestamps.push_back(av_rescale_q(state % frames, AVRational{1, kFrameRate}, time_base));
+        }
+
+        for (double *seconds : {&cold_seconds, &cached_seconds})
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int64_t timestamp : timestamps)
+            {
+                if (!stream.getFrame(timestamp))
+                    return false;
+            }
+            *seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return true;
+    }
+
+    // Analysis processor on frames in the decoder's format; metrics are reset beforehand
+    template <typename Analyzer>
+    bool runAnalysis(const Source &source, int frames, int64_t &analyzed)
+    {
+        video_codec::MediaFile media_file;
+        QuietScope quiet;
+
+        if (!media_file.open(source.filename))
+            return false;
+
+        video_codec::VideoStream stream = media_file.getVideoStream();
+        Analyzer analyzer(stream.getTimeBase());
+        video_codec::PipelineMetrics::instance().reset();
+        if (!stream.processNativeFrames(analyzer, frames))
+            return false;
+
+        analyzed = analyzer.getFrameCount();
+        return true;
+    }
+
+    void printResult(const Result &result)
+    {
+        double pixels = static_cast<double>(result.resolution.width) * result.resolution.height * result.frames;
+
+        std::cout << std::left << std::setw(22) << result.name
+                  << std::setw(11) << result.pattern
+                  << std::setw(7) << result.resolution.name
+                  << std::setw(10) << result.codec
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << (result.seconds > 0 ? result.frames / result.seconds : 0.0) << " fps"
+                  << std::setprecision(3)
+                  << std::setw(10) << (pixels > 0 ? result.seconds * 1e9 / pixels : 0.0) << " ns/px"
+                  << std::setw(10) << result.peak_rss_kb / 1024 << " MB RSS" << std::endl;
+    }
+
+    std::string toJson(const std::vector<Result> &results, int frames)
+    {
+        std::ostringstream out;
+        out << std::fixed;
+        out << "{\n  \"schema_version\": " << kSchemaVersion
+            << ",\n  \"benchmark\": \"video_codec_bench\""
+            << ",\n  \"ffmpeg\": \"" << video_codec::escapeJson(av_version_info()) << "\""
+            << ",\n  \"frames_per_source\": " << frames
+            << ",\n  \"results\": [";
+
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &result = results[i];
+            double pixels = static_cast<double>(result.resolution.width) * result.resolution.height * result.frames;
+
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"case\": \"" << video_codec::escapeJson(result.name) << "\""
+                << ", \"source\": \"" << result.pattern << "\""
+                << ", \"resolution\": \"" << result.resolution.name << "\""
+                << ", \"width\": " << result.resolution.width
+                << ", \"height\": " << result.resolution.height
+                << ", \"codec\": \"" << result.codec << "\""
+                << ", \"frames\": " << result.frames
+                << std::setprecision(6) << ", \"seconds\": " << result.seconds
+                << std::setprecision(2) << ", \"fps\": " << (result.seconds > 0 ? result.frames / result.seconds : 0.0)
+                << std::setprecision(4) << ", \"ns_per_pixel\": " << (pixels > 0 ? result.seconds * 1e9 / pixels : 0.0)
+                << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}";
+        }
+
+        out << "\n  ]\n}\n";
+        return out.str();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool quick = false;
+    int frames = 60;
+    std::string json_filename;
+    std::string work_dir = "bench_media";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--quick")
+            quick = true;
+        else if (arg.rfind("--frames=", 0) == 0)
+            frames = std::max(1, std::stoi(arg.substr(9)));
+        else if (arg.rfind("--json=", 0) == 0)
+            json_filename = arg.substr(7);
+        else if (arg.rfind("--work-dir=", 0) == 0)
+            work_dir = arg.substr(11);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--frames=N] [--json=results.json] [--work-dir=dir]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Resolution> resolutions = {{"720p", 1280, 720}, {"1080p", 1920, 1080}, {"4k", 3840, 2160}};
+    std::vector<std::string> patterns = {"testsrc2", "mandelbrot"};
+    std::vector<Codec> codecs = {{"libx264", "mp4"}, {"libx265", "mp4"}, {"mpeg4", "mp4"}};
+    if (quick)
+    {
+        resolutions.resize(1);
+        patterns.resize(1);
+        codecs.resize(1);
+    }
+
+    std::filesystem::create_directories(work_dir);
+    video_codec::PipelineMetrics::instance().setEnabled(true);
+
+    // Sources are deterministic, so files from an earlier run are reused
+    std::vector<Source> sources;
+    for (const auto &pattern : patterns)
+    {
+        for (const auto &resolution : resolutions)
+        {
+            for (const auto &codec : codecs)
+            {
+                if (!avcodec_find_encoder_by_name(codec.name))
+                {
+                    std::cerr << "Skipping " << codec.name << ": encoder not available" << std::endl;
+                    continue;
+                }
+
+                Source source{pattern, resolution, codec.name,
+                              work_dir + "/" + pattern + "_" + resolution.name + "_" + codec.name + "_" +
+                                  std::to_string(frames) + "." + codec.extension};
+
+                if (!std::filesystem::exists(source.filename))
+                {
+                    std::cout << "Generating " << source.filename << std::endl;
+                    QuietScope quiet;
+                    if (!generateSource(source, frames))
+                        continue;
+                }
+                sources.push_back(source);
+            }
+        }
+    }
+
+    std::vector<Result> results;
+    bool ok = true;
+
+    auto record = [&](const std::string &name, const Source &source, int frame_count, double seconds)
+    {
+        results.push_back({name, source.pattern, source.resolution, source.codec, frame_count, seconds, peakRssKb()});
+        printResult(results.back());
+    };
+
+    std::cout << "\n" << std::left << std::setw(22) << "case" << std::setw(11) << "source"
+              << std::setw(7) << "res" << "codec" << std::endl;
+
+    for (const auto &source : sources)
+    {
+        // Open and probe, averaged over a few opens; counts one "frame" per open
+        constexpr int kOpens = 5;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kOpens; ++i)
+        {
+            video_codec::MediaFile media_file;
+            QuietScope quiet;
+            ok = media_file.open(source.filename) && ok;
+        }
+        record("open+probe", source, kOpens,
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        CountingProcessor counter;
+        if (!runProcessor(source, counter, frames))
+        {
+            ok = false;
+            continue;
+        }
+        record("decode", source, counter.getCount(), stageSeconds("decode"));
+        record("colorspace to rgb", source, counter.getCount(), stageSeconds("sws to rgb"));
+
+        // Processors only on one source per resolution to bound the run time
+        if (source.pattern != patterns.front() || source.codec != codecs.front().name)
+            continue;
+
+        struct ProcessorCase
+        {
+            std::string name;
+            std::function<std::unique_ptr<video_codec::FrameProcessor>()> make;
+        };
+
+        std::string frames_dir = work_dir + "/frames_" + source.resolution.name;
+        std::string encode_filename = work_dir + "/encode_" + source.resolution.name + ".mp4";
+        video_codec::VideoWriter writer;
+
+        std::vector<ProcessorCase> cases = {
+            {"grayscale", []
+             { return std::make_unique<video_codec::GrayscaleProcessor>(); }},
+            {"brightness/contrast", []
+             { return std::make_unique<video_codec::BrightnessContrastProcessor>(0.1, 1.2); }},
+            {"filter hflip", []
+             { return std::make_unique<video_codec::FilterProcessor>("hflip"); }},
+            {"save jpg", [&]
+             { return std::make_unique<video_codec::FrameSaverProcessor>(frames_dir, 1, "jpg"); }},
+            {"encode libx264", [&]() -> std::unique_ptr<video_codec::FrameProcessor>
+             {
+                 if (!writer.open(encode_filename, source.resolution.width, source.resolution.height, kFrameRate, "libx264"))
+                     return nullptr;
+                 return std::make_unique<EncodingProcessor>(writer);
+             }},
+        };
+
+        for (const auto &processor_case : cases)
+        {
+            std::unique_ptr<video_codec::FrameProcessor> processor;
+            {
+                QuietScope quiet;
+                processor = processor_case.make();
+            }
+            if (!processor || !runProcessor(source, *processor, frames))
+            {
+                std::cerr << processor_case.name << " failed on " << source.filename << std::endl;
+                ok = false;
+                continue;
+            }
+
+            // Encoder delay is flushed at close and belongs to the case
+            double seconds = stageSeconds("process");
+            if (processor_case.name == "encode libx264")
+            {
+                auto close_start = std::chrono::steady_clock::now();
+                ok = writer.close() && ok;
+                seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - close_start).count();
+            }
+
+            record(processor_case.name, source, video_codec::PipelineMetrics::instance().stage("process").frames.load(), seconds);
+        }
+
+        constexpr int kLookups = 32;
+        double cold_seconds = 0.0;
+        double cached_seconds = 0.0;
+        if (runRandomAccess(source, frames, kLookups, cold_seconds, cached_seconds))
+        {
+            record("random access", source, kLookups, cold_seconds);
+            record("random access cached", source, kLookups, cached_seconds);
+        }
+        else
+        {
+            std::cerr << "random access failed on " << source.filename << std::endl;
+            ok = false;
+        }
+
+        int64_t analyzed = 0;
+        if (runAnalysis<video_codec::SceneDetectProcessor>(source, frames, analyzed))
+            record("scene detect", source, static_cast<int>(analyzed), stageSeconds("scene detect"));
+        else
+        {
+            std::cerr << "scene detect failed on " << source.filename << std::endl;
+            ok = false;
+        }
+
+        if (runAnalysis<video_codec::FrameQcProcessor>(source, frames, analyzed))
+            record("frame qc", source, static_cast<int>(analyzed), stageSeconds("frame qc"));
+        else
+        {
+            std::cerr << "frame qc failed on " << source.filename << std::endl;
+            ok = false;
+        }
+
+        std::filesystem::remove_all(frames_dir);
+        std::filesystem::remove(encode_filename);
+    }
+
+    if (!json_filename.empty())
+    {
+        std::ofstream file(json_filename);
+        file << toJson(results, frames);
+        if (!file)
+        {
+            std::cerr << "Could not write " << json_filename << std::endl;
+            ok = false;
+        }
+        else
+            std::cout << "\nResults written to " << json_filename << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
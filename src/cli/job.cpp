@@ -0,0 +1,1358 @@
+#include <cli/job.h>
+#include <media/abr_ladder.h>
+#include <media/adaptive_encoder.h>
+#include <media/media_concat.h>
+#include <media/media_cut.h>
+#include <media/media_file.h>
+#include <media/quality_compare.h>
+#include <media/raw_frame_file.h>
+#include <processing/crop_detect_processor.h>
+#include <processing/crop_processor.h>
+#include <processing/frame_qc_processor.h>
+#include <processing/raw_frame_writer_processor.h>
+#include <processing/scene_detect_processor.h>
+#include <processing/simple_frame_processor.h>
+#include <processing/video_writer_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+
+namespace video_codec
+{
+    namespace
+    {
+        const char *const kCommands[] = {"probe", "extract", "transcode", "cut", "concat", "proxy", "scenes", "qc", "compare", "adaptive", "ladder"};
+
+        bool parseNumber(const std::string &text, double &value)
+        {
+            if (text.empty())
+                return false;
+
+            char *end = nullptr;
+            value = std::strtod(text.c_str(), &end);
+            return end == text.c_str() + text.size();
+        }
+
+        // value fits into an int; checked before any cast, which would be undefined otherwise
+        bool inIntRange(double value)
+        {
+            return value >= static_cast<double>(INT_MIN) && value <= static_cast<double>(INT_MAX);
+        }
+
+        bool parseThreads(const std::string &text, int &threads)
+        {
+            int value;
+            if (!parseInteger(text, value) || value < 1)
+                return false;
+
+            threads = value;
+            return true;
+        }
+
+        // Comma-separated numbers, e.g. "1080,720,480"
+        bool parseNumberList(const std::string &text, std::vector<double> &values)
+        {
+            values.clear();
+            std::stringstream stream(text);
+            std::string item;
+            while (std::getline(stream, item, ','))
+            {
+                double value;
+                if (!parseNumber(item, value))
+                    return false;
+                values.push_back(value);
+            }
+            return !values.empty();
+        }
+
+        bool writesOutput(const std::string &command)
+        {
+            return command != "probe";
+        }
+
+        // Positional arguments that are always inputs; any further one is the output
+        size_t inputCount(const std::string &command)
+        {
+            return command == "compare" ? 2 : 1;
+        }
+
+        // Create the directory an output file goes into
+        void createParentDirectory(const std::string &filename)
+        {
+            std::filesystem::path parent = std::filesystem::path(filename).parent_path();
+            std::error_code ec;
+            if (!parent.empty() && !std::filesystem::exists(parent, ec))
+                std::filesystem::create_directories(parent, ec);
+        }
+
+        // Build the job's processors in front of sink and return the head of the chain;
+        // a non-empty crop goes first, so the processors only see the picture area
+        FrameProcessor *buildProcessorChain(const JobSpec &job, FrameProcessor &sink,
+                                            std::vector<std::unique_ptr<FrameProcessor>> &chain,
+                                            const CropRect &crop = {})
+        {
+            FrameProcessor *next = &sink;
+            for (auto it = job.processors.rbegin(); it != job.processors.rend(); ++it)
+            {
+                std::unique_ptr<FrameProcessor> processor;
+                if (it->type == "grayscale")
+                    processor = std::make_unique<GrayscaleProcessor>(next);
+                else if (it->type == "brightness_contrast")
+                {
+                    double brightness = std::strtod(it->params.at("brightness").c_str(), nullptr);
+                    double contrast = std::strtod(it->params.at("contrast").c_str(), nullptr);
+                    processor = std::make_unique<BrightnessContrastProcessor>(brightness, contrast, next);
+                }
+                else
+                    processor = std::make_unique<FilterProcessor>(it->params.at("graph"), next);
+
+                next = processor.get();
+                chain.push_back(std::move(processor));
+            }
+
+            if (!crop.isEmpty())
+            {
+                chain.push_back(std::make_unique<CropProcessor>(crop, next));
+                next = chain.back().get();
+            }
+            return next;
+        }
+
+        // Open the first video stream of the input for VideoStream::processNativeFrames()
+        bool openAnalysisStream(const JobSpec &job, MediaFile &file, VideoStream &stream)
+        {
+            if (!file.open(job.inputs[0]))
+                return false;
+
+            int index = av_find_best_stream(file.getFormatContext(), AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+            if (index < 0)
+            {
+                std::cerr << "No video stream in " << job.inputs[0] << std::endl;
+                return false;
+            }
+
+            return stream.initialize(file.getFormatContext(), index, job.threads);
+        }
+
+        // Letterbox bars of a video, from frames sampled over its length; the
+        // analysis has its own demuxer, so its seeks do not disturb the main decode
+        bool detectCrop(const JobSpec &job, CropRect &rect)
+        {
+            MediaFile file;
+            VideoStream stream;
+            if (!openAnalysisStream(job, file, stream))
+                return false;
+
+            CropDetectOptions options;
+            options.limit = job.getInteger("crop_limit", options.limit);
+            options.samples = job.getInteger("crop_samples", options.samples);
+
+            CropDetectProcessor detector(options);
+            if (!stream.processSampledFrames(detector, options.samples) || detector.getFrameCount() == 0)
+            {
+                std::cerr << "Crop detection failed on " << job.inputs[0] << std::endl;
+                return false;
+            }
+
+            rect = detector.getCrop(AV_PIX_FMT_YUV420P);
+            std::cout << "Detected crop " << rect.width << ":" << rect.height << ":" << rect.x << ":" << rect.y
+                      << " from " << detector.getFrameCount() << " frames" << std::endl;
+            return true;
+        }
+
+        // Picture area from --crop=W:H[:X:Y] or --crop=auto, aligned for 4:2:0
+        // output; stays empty when the job does not crop
+        bool resolveCrop(const JobSpec &job, int width, int height, CropRect &rect)
+        {
+            rect = {};
+            std::string text = job.getOption("crop", "");
+            if (text.empty())
+                return true;
+
+            if (text == "auto")
+            {
+                if (isRawFrameFile(job.inputs[0]))
+                {
+                    std::cerr << "--crop=auto needs a decodable input; give the region for .vcraw inputs" << std::endl;
+                    return false;
+                }
+                if (!detectCrop(job, rect))
+                    return false;
+            }
+            else if (!parseCropRect(text, width, height, rect))
+            {
+                std::cerr << "Invalid crop region for a " << width << "x" << height << " video: " << text << std::endl;
+                return false;
+            }
+
+            rect = alignCropRect(rect, width, height, AV_PIX_FMT_YUV420P);
+            if (rect.isEmpty())
+            {
+                std::cerr << "Crop region is empty after alignment: " << text << std::endl;
+                return false;
+            }
+
+            // The whole frame needs no crop stage
+            if (rect.width == width && rect.height == height)
+                rect = {};
+            return true;
+        }
+
+        // Size of the frames after the optional crop
+        int croppedWidth(const CropRect &crop, int width)
+        {
+            return crop.isEmpty() ? width : crop.width;
+        }
+
+        int croppedHeight(const CropRect &crop, int height)
+        {
+            return crop.isEmpty() ? height : crop.height;
+        }
+
+        // Frames a job will decode, from the container or the duration (-1 if unknown)
+        int64_t estimateFrames(MediaFile &file, int max_frames)
+        {
+            AVFormatContext *ctx = file.getFormatContext();
+            int video_index = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+            int64_t frames = -1;
+            if (video_index >= 0)
+            {
+                const AVStream *stream = ctx->streams[video_index];
+                if (stream->nb_frames > 0)
+                    frames = stream->nb_frames;
+                else if (ctx->duration != AV_NOPTS_VALUE && stream->avg_frame_rate.num > 0)
+                    frames = static_cast<int64_t>(ctx->duration * av_q2d(stream->avg_frame_rate) / AV_TIME_BASE);
+            }
+
+            if (max_frames > 0 && (frames < 0 || frames > max_frames))
+                frames = max_frames;
+            return frames;
+        }
+
+        bool writeProbeJson(const MediaFile &file, const std::string &filename)
+        {
+            std::ofstream out(filename);
+            if (!out)
+            {
+                std::cerr << "Could not open probe output: " << filename << std::endl;
+                return false;
+            }
+
+            const AVFormatContext *ctx = file.getFormatContext();
+            double duration = ctx->duration != AV_NOPTS_VALUE ? ctx->duration / static_cast<double>(AV_TIME_BASE) : 0.0;
+
+            out << "{\"filename\": \"" << escapeJson(file.getFilename()) << "\""
+                << ", \"format\": \"" << escapeJson(file.getFormatName()) << "\""
+                << ", \"duration\": " << duration
+                << ", \"bit_rate\": " << file.getBitRate()
+                << ", \"streams\": [";
+
+            bool first = true;
+            for (const auto &info : file.getStreamInfo())
+            {
+                out << (first ? "" : ", ");
+                first = false;
+
+                out << "{\"index\": " << info.index
+                    << ", \"codec\": \"" << escapeJson(info.codec_name) << "\"";
+                if (info.type == AVMEDIA_TYPE_VIDEO)
+                    out << ", \"type\": \"video\", \"width\": " << info.width << ", \"height\": " << info.height
+                        << ", \"frame_rate\": " << info.frame_rate;
+                else if (info.type == AVMEDIA_TYPE_AUDIO)
+                    out << ", \"type\": \"audio\", \"sample_rate\": " << info.sample_rate
+                        << ", \"channels\": " << info.channels;
+                else
+                {
+                    const char *type = av_get_media_type_string(info.type);
+                    out << ", \"type\": \"" << (type ? type : "unknown") << "\"";
+                }
+                out << "}";
+            }
+            out << "]}\n";
+
+            return static_cast<bool>(out);
+        }
+
+        bool runProbe(const JobSpec &job)
+        {
+            MediaFile file;
+            if (!file.open(job.inputs[0]))
+                return false;
+
+            if (job.output.empty())
+            {
+                file.printInfo();
+                return true;
+            }
+
+            createParentDirectory(job.output);
+            return writeProbeJson(file, job.output);
+        }
+
+        // Frames of a raw frame file (.vcraw) need no decoding
+        bool processRawFrames(const JobSpec &job, RawFrameReader &reader, FrameProcessor &sink,
+                              const ProgressCallback &progress, const CropRect &crop = {})
+        {
+            std::vector<std::unique_ptr<FrameProcessor>> chain;
+            FrameProcessor *head = buildProcessorChain(job, sink, chain, crop);
+
+            int max_frames = job.getInteger("max_frames", -1);
+            int64_t frames = static_cast<int64_t>(reader.getFrameCount());
+            ProgressProcessor progress_head(*head, progress, max_frames > 0 ? std::min<int64_t>(frames, max_frames) : frames);
+            if (progress)
+                head = &progress_head;
+
+            return reader.processFrames(*head, max_frames, 16);
+        }
+
+        FrameSaverProcessor makeFrameSaver(const JobSpec &job)
+        {
+            return FrameSaverProcessor(job.output.empty() ? "./frames" : job.output,
+                                       job.getInteger("interval", 1),
+                                       job.getOption("format", "jpg"));
+        }
+
+        bool runExtract(const JobSpec &job, const ProgressCallback &progress)
+        {
+            if (isRawFrameFile(job.inputs[0]))
+            {
+                RawFrameReader reader;
+                CropRect crop;
+                if (!reader.open(job.inputs[0]) || !resolveCrop(job, reader.getWidth(), reader.getHeight(), crop))
+                    return false;
+
+                FrameSaverProcessor saver = makeFrameSaver(job);
+                return processRawFrames(job, reader, saver, progress, crop);
+            }
+
+            MediaFile file;
+            if (!file.open(job.inputs[0]))
+                return false;
+
+            file.setDecoderThreads(job.threads);
+            file.setFrameBatchSize(16);
+
+            CropRect crop;
+            if (!job.getOption("crop", "").empty())
+            {
+                VideoStream stream = file.getVideoStream();
+                if (!stream.getCodecContext())
+                {
+                    std::cerr << "Failed to get video stream information" << std::endl;
+                    return false;
+                }
+                if (!resolveCrop(job, stream.getWidth(), stream.getHeight(), crop))
+                    return false;
+            }
+
+            FrameSaverProcessor saver = makeFrameSaver(job);
+
+            std::vector<std::unique_ptr<FrameProcessor>> chain;
+            FrameProcessor *head = buildProcessorChain(job, saver, chain, crop);
+
+            int max_frames = job.getInteger("max_frames", -1);
+            ProgressProcessor progress_head(*head, progress, estimateFrames(file, max_frames));
+            if (progress)
+                head = &progress_head;
+
+            return file.processVideoFrames(*head, max_frames);
+        }
+
+        // Segmented output from the output extension (.m3u8, .mpd) or --fragmented
+        SegmentedOutputSettings segmentedOutput(const JobSpec &job)
+        {
+            SegmentedOutputSettings segmented;
+            std::string extension = std::filesystem::path(job.output).extension().string();
+            if (extension == ".m3u8")
+                segmented.mode = SegmentedOutputSettings::Mode::Hls;
+            else if (extension == ".mpd")
+                segmented.mode = SegmentedOutputSettings::Mode::Dash;
+            else if (job.getFlag("fragmented"))
+                segmented.mode = SegmentedOutputSettings::Mode::FragmentedMp4;
+
+            segmented.segment_duration = job.getNumber("segment_duration", segmented.segment_duration);
+            segmented.hls_mpegts = job.getFlag("hls_ts");
+            return segmented;
+        }
+
+        // Transcode from a raw frame file, to a video or to another raw frame file
+        bool transcodeRawFrames(const JobSpec &job, const ProgressCallback &progress)
+        {
+            RawFrameReader reader;
+            CropRect crop;
+            if (!reader.open(job.inputs[0]) || !resolveCrop(job, reader.getWidth(), reader.getHeight(), crop))
+                return false;
+
+            double fps = job.getNumber("fps", reader.getFrameRate() > 0 ? reader.getFrameRate() : 30.0);
+            createParentDirectory(job.output);
+
+            if (isRawFrameFile(job.output))
+            {
+                RawFrameWriterProcessor writer(job.output, fps);
+                return processRawFrames(job, reader, writer, progress, crop) && writer.finalize();
+            }
+
+            VideoWriterProcessor writer(job.output, croppedWidth(crop, reader.getWidth()), croppedHeight(crop, reader.getHeight()), fps,
+                                        job.getOption("codec", "libx264"), {}, job.threads, segmentedOutput(job));
+
+            bool result = processRawFrames(job, reader, writer, progress, crop);
+            if (result && !writer.finalize())
+            {
+                std::cerr << "Failed to finalize video output" << std::endl;
+                result = false;
+            }
+            return result;
+        }
+
+        bool runTranscode(const JobSpec &job, const ProgressCallback &progress)
+        {
+            if (isRawFrameFile(job.inputs[0]))
+                return transcodeRawFrames(job, progress);
+
+            MediaFile file;
+            if (!file.open(job.inputs[0]))
+                return false;
+
+            file.setDecoderThreads(job.threads);
+            file.setFrameBatchSize(16);
+
+            VideoStream stream = file.getVideoStream();
+            if (!stream.getCodecContext())
+            {
+                std::cerr << "Failed to get video stream information" << std::endl;
+                return false;
+            }
+
+            double fps = job.getNumber("fps", stream.getFrameRate() > 0 ? stream.getFrameRate() : 30.0);
+
+            int max_frames = job.getInteger("max_frames", -1);
+
+            CropRect crop;
+            if (!resolveCrop(job, stream.getWidth(), stream.getHeight(), crop))
+                return false;
+
+            // Decoded and filtered frames for later passes, without audio
+            if (isRawFrameFile(job.output))
+            {
+                createParentDirectory(job.output);
+                RawFrameWriterProcessor writer(job.output, fps);
+
+                std::vector<std::unique_ptr<FrameProcessor>> chain;
+                FrameProcessor *head = buildProcessorChain(job, writer, chain, crop);
+
+                ProgressProcessor progress_head(*head, progress, estimateFrames(file, max_frames));
+                if (progress)
+                    head = &progress_head;
+
+                return file.processVideoFrames(*head, max_frames) && writer.finalize();
+            }
+
+            // The source audio is not processed, so it is stream-copied
+            AudioOutputSettings audio;
+            int audio_index = file.findAudioStreamIndex();
+            if (audio_index >= 0 && job.getOption("audio", "copy") == "copy")
+            {
+                const AVStream *audio_stream = file.getFormatContext()->streams[audio_index];
+                audio.mode = AudioOutputSettings::Mode::Copy;
+                audio.copy_parameters = audio_stream->codecpar;
+                audio.copy_time_base = audio_stream->time_base;
+                audio.start_time = file.getVideoStartTime();
+            }
+
+            createParentDirectory(job.output);
+            // The writer encodes the cropped views as they are
+            VideoWriterProcessor writer(job.output, croppedWidth(crop, stream.getWidth()), croppedHeight(crop, stream.getHeight()), fps,
+                                        job.getOption("codec", "libx264"), audio, job.threads, segmentedOutput(job));
+            writer.setDropDuplicates(job.getFlag("drop_duplicates"));
+
+            std::vector<std::unique_ptr<FrameProcessor>> chain;
+            FrameProcessor *head = buildProcessorChain(job, writer, chain, crop);
+
+            ProgressProcessor progress_head(*head, progress, estimateFrames(file, max_frames));
+            if (progress)
+                head = &progress_head;
+
+            bool result = file.processMediaFrames(*head, writer, max_frames);
+
+            if (result && !writer.finalize())
+            {
+                std::cerr << "Failed to finalize video output" << std::endl;
+                result = false;
+            }
+            return result;
+        }
+
+        bool runCut(const JobSpec &job)
+        {
+            CutOptions options;
+            options.stream_copy = !job.getFlag("accurate");
+            options.encoder_name = job.getOption("encoder");
+            options.threads = job.threads;
+
+            createParentDirectory(job.output);
+            MediaCutter cutter;
+            return cutter.cut(job.inputs[0], job.output, job.getNumber("start", 0.0),
+                              job.getNumber("duration", 0.0), options);
+        }
+
+        bool runConcat(const JobSpec &job)
+        {
+            MediaConcatenator concatenator;
+            for (const auto &input : job.inputs)
+            {
+                if (!concatenator.addInput(input))
+                    return false;
+            }
+
+            ConcatOptions options;
+            options.allow_reencode = job.getFlag("allow_reencode", true);
+            options.encoder_name = job.getOption("encoder");
+            options.ignore_extradata = job.getFlag("ignore_extradata");
+
+            createParentDirectory(job.output);
+            return concatenator.concatenate(job.output, options);
+        }
+
+        bool runProxy(const JobSpec &job)
+        {
+            MediaFile file;
+            if (!file.open(job.inputs[0]))
+                return false;
+
+            file.setDecoderThreads(job.threads);
+            file.setFrameBatchSize(16);
+
+            ProxyOptions options;
+            options.height = job.getInteger("height", options.height);
+            options.codec = job.getOption("codec", options.codec);
+            options.threads = job.threads;
+
+            if (!job.output.empty())
+                createParentDirectory(job.output);
+            return file.generateProxy(job.output, options);
+        }
+
+        bool writeScenesJson(const std::vector<SceneCut> &cuts, std::ostream &out)
+        {
+            out << "{\"cuts\": [";
+            for (size_t i = 0; i < cuts.size(); ++i)
+            {
+                out << (i == 0 ? "" : ", ")
+                    << "{\"pts\": " << cuts[i].pts
+                    << ", \"time\": " << cuts[i].time
+                    << ", \"score\": " << cuts[i].score
+                    << ", \"confidence\": " << cuts[i].confidence << "}";
+            }
+            out << "]}\n";
+
+            return static_cast<bool>(out);
+        }
+
+        bool runScenes(const JobSpec &job)
+        {
+            // Frames stay in the decoder's format; keyframes only and lowres trade precision for speed
+            MediaFile file;
+            VideoStream stream;
+            stream.setKeyframesOnly(job.getFlag("keyframes"));
+            stream.setLowres(job.getInteger("lowres", 0));
+            if (!openAnalysisStream(job, file, stream))
+                return false;
+
+            SceneDetectOptions options;
+            options.threshold = job.getNumber("threshold", options.threshold);
+            options.min_scene_length = job.getNumber("min_length", options.min_scene_length);
+
+            SceneDetectProcessor detector(stream.getTimeBase(), options);
+            if (!stream.processNativeFrames(detector, job.getInteger("max_frames", -1)))
+                return false;
+            std::cerr << detector.getCuts().size() << " scene cuts" << std::endl;
+
+            if (job.output.empty())
+                return writeScenesJson(detector.getCuts(), std::cout);
+
+            createParentDirectory(job.output);
+            std::ofstream out(job.output);
+            if (!out)
+            {
+                std::cerr << "Could not open scene output: " << job.output << std::endl;
+                return false;
+            }
+            return writeScenesJson(detector.getCuts(), out);
+        }
+
+        bool writeQcJson(const FrameQcProcessor &qc, bool hashes, std::ostream &out)
+        {
+            out << "{\"frames\": " << qc.getFrameCount()
+                << ", \"duplicates\": " << qc.getDuplicateCount()
+                << ", \"runs\": [";
+            const auto &runs = qc.getRuns();
+            for (size_t i = 0; i < runs.size(); ++i)
+            {
+                out << (i == 0 ? "" : ", ")
+                    << "{\"type\": \"" << toString(runs[i].type) << "\""
+                    << ", \"start_pts\": " << runs[i].start_pts
+                    << ", \"end_pts\": " << runs[i].end_pts
+                    << ", \"frames\": " << runs[i].frames
+                    << ", \"start\": " << runs[i].start
+                    << ", \"duration\": " << runs[i].duration << "}";
+            }
+            out << "]";
+
+            // pHash per frame as hex, for near-duplicate searches across assets
+            if (hashes)
+            {
+                out << ", \"hashes\": [";
+                char hex[17];
+                for (size_t i = 0; i < qc.getHashes().size(); ++i)
+                {
+                    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(qc.getHashes()[i]));
+                    out << (i == 0 ? "\"" : ", \"") << hex << "\"";
+                }
+                out << "]";
+            }
+            out << "}\n";
+
+            return static_cast<bool>(out);
+        }
+
+        bool runQc(const JobSpec &job)
+        {
+            MediaFile file;
+            VideoStream stream;
+            if (!openAnalysisStream(job, file, stream))
+                return false;
+
+            FrameQcOptions options;
+            options.freeze_difference = job.getNumber("freeze_difference", options.freeze_difference);
+            options.min_freeze_duration = job.getNumber("min_freeze", options.min_freeze_duration);
+            options.black_level = job.getInteger("black_level", options.black_level);
+            options.min_black_duration = job.getNumber("min_black", options.min_black_duration);
+
+            FrameQcProcessor qc(stream.getTimeBase(), options);
+            if (!stream.processNativeFrames(qc, job.getInteger("max_frames", -1)))
+                return false;
+            qc.finish();
+            std::cerr << qc.getDuplicateCount() << " duplicate frames, " << qc.getRuns().size() << " runs" << std::endl;
+
+            if (job.output.empty())
+                return writeQcJson(qc, job.getFlag("hashes"), std::cout);
+
+            createParentDirectory(job.output);
+            std::ofstream out(job.output);
+            if (!out)
+            {
+                std::cerr << "Could not open QC output: " << job.output << std::endl;
+                return false;
+            }
+            return writeQcJson(qc, job.getFlag("hashes"), out);
+        }
+
+        bool writeQualityJson(const QualityReport &report, std::ostream &out)
+        {
+            // Metrics that were not measured are left out
+            auto writeMetrics = [&](const double *psnr, double psnr_all, const double *ssim, double ssim_all)
+            {
+                if (report.has_psnr)
+                {
+                    out << ", \"psnr\": [";
+                    for (int p = 0; p < report.planes; ++p)
+                        out << (p == 0 ? "" : ", ") << psnr[p];
+                    out << "], \"psnr_all\": " << psnr_all;
+                }
+                if (report.has_ssim)
+                {
+                    out << ", \"ssim\": [";
+                    for (int p = 0; p < report.planes; ++p)
+                        out << (p == 0 ? "" : ", ") << ssim[p];
+                    out << "], \"ssim_all\": " << ssim_all;
+                }
+            };
+
+            out << "{\"width\": " << report.width
+                << ", \"height\": " << report.height
+                << ", \"pix_fmt\": \"" << report.pix_fmt << "\""
+                << ", \"frame_count\": " << report.frames.size();
+            writeMetrics(report.psnr, report.psnr_all, report.ssim, report.ssim_all);
+
+            out << ", \"frames\": [";
+            for (size_t i = 0; i < report.frames.size(); ++i)
+            {
+                const FrameQuality &frame = report.frames[i];
+                out << (i == 0 ? "" : ", ")
+                    << "{\"frame\": " << frame.frame
+                    << ", \"time\": " << frame.time;
+                writeMetrics(frame.psnr, frame.psnr_all, frame.ssim, frame.ssim_all);
+                out << "}";
+            }
+            out << "]}\n";
+
+            return static_cast<bool>(out);
+        }
+
+        bool runCompare(const JobSpec &job)
+        {
+            QualityOptions options;
+            options.psnr = job.getFlag("psnr", options.psnr);
+            options.ssim = job.getFlag("ssim", options.ssim);
+            options.threads = job.threads;
+            options.max_frames = job.getInteger("max_frames", -1);
+
+            QualityComparator comparator;
+            QualityReport report;
+            if (!comparator.compare(job.inputs[0], job.inputs[1], report, options))
+                return false;
+
+            if (job.output.empty())
+                return writeQualityJson(report, std::cout);
+
+            createParentDirectory(job.output);
+            std::ofstream out(job.output);
+            if (!out)
+            {
+                std::cerr << "Could not open quality output: " << job.output << std::endl;
+                return false;
+            }
+            return writeQualityJson(report, out);
+        }
+
+        bool writeSegmentsJson(const std::vector<EncodeSegment> &segments, std::ostream &out)
+        {
+            out << "{\"segments\": [";
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                out << (i == 0 ? "" : ", ")
+                    << "{\"start\": " << segments[i].start
+                    << ", \"duration\": " << segments[i].duration
+                    << ", \"frames\": " << segments[i].frames
+                    << ", \"complexity\": " << segments[i].complexity
+                    << ", \"crf\": " << segments[i].crf
+                    << ", \"bytes\": " << segments[i].bytes << "}";
+            }
+            out << "]}\n";
+
+            return static_cast<bool>(out);
+        }
+
+        bool runAdaptive(const JobSpec &job)
+        {
+            AdaptiveEncodeOptions options;
+            options.encoder_name = job.getOption("codec", options.encoder_name);
+            options.preset = job.getOption("preset", options.preset);
+            options.crf = job.getInteger("crf", options.crf);
+            options.crf_range = job.getInteger("crf_range", options.crf_range);
+            options.strength = job.getNumber("strength", options.strength);
+            options.max_bit_rate = static_cast<int64_t>(job.getInteger("max_bitrate", 0)) * 1000;
+            options.min_segment_length = job.getNumber("min_segment", options.min_segment_length);
+            options.scenes.threshold = job.getNumber("threshold", options.scenes.threshold);
+            options.analysis_lowres = job.getInteger("lowres", options.analysis_lowres);
+            options.threads = job.threads;
+            options.parallel_segments = job.getInteger("parallel", 0);
+            options.work_directory = job.getOption("work_dir");
+            options.keep_segments = job.getFlag("keep_segments");
+
+            createParentDirectory(job.output);
+            AdaptiveEncoder encoder;
+            bool result = encoder.encode(job.inputs[0], job.output, options);
+
+            // The plan is written on failure too, it tells which segment failed
+            std::string plan = job.getOption("plan");
+            if (!plan.empty() && !encoder.getSegments().empty())
+            {
+                createParentDirectory(plan);
+                std::ofstream out(plan);
+                if (!out || !writeSegmentsJson(encoder.getSegments(), out))
+                {
+                    std::cerr << "Could not write segment plan: " << plan << std::endl;
+                    result = false;
+                }
+            }
+            return result;
+        }
+
+        bool runLadder(const JobSpec &job)
+        {
+            LadderOptions options;
+            std::vector<double> values;
+            if (!job.getOption("heights").empty())
+            {
+                if (!parseNumberList(job.getOption("heights"), values) ||
+                    !std::all_of(values.begin(), values.end(), inIntRange))
+                {
+                    std::cerr << "--heights expects comma-separated heights" << std::endl;
+                    return false;
+                }
+                options.heights.assign(values.begin(), values.end());
+            }
+            if (!job.getOption("bitrates").empty())
+            {
+                if (!parseNumberList(job.getOption("bitrates"), values))
+                {
+                    std::cerr << "--bitrates expects comma-separated kb/s" << std::endl;
+                    return false;
+                }
+                for (double kbps : values)
+                {
+                    if (kbps < 0 || !inIntRange(kbps))
+                    {
+                        std::cerr << "--bitrates out of range: " << kbps << std::endl;
+                        return false;
+                    }
+                    options.bit_rates.push_back(static_cast<int64_t>(kbps * 1000));
+                }
+            }
+
+            std::string format = job.getOption("format", "mp4");
+            if (format == "hls")
+                options.segmented.mode = SegmentedOutputSettings::Mode::Hls;
+            else if (format == "fmp4")
+                options.segmented.mode = SegmentedOutputSettings::Mode::FragmentedMp4;
+            else if (format != "mp4")
+            {
+                std::cerr << "--format expects mp4, fmp4 or hls" << std::endl;
+                return false;
+            }
+            options.segmented.segment_duration = job.getNumber("segment_duration", options.segmented.segment_duration);
+            options.segmented.hls_mpegts = job.getFlag("hls_ts");
+
+            options.codec = job.getOption("codec", options.codec);
+            options.keyframe_interval = job.getNumber("keyframe_interval", options.keyframe_interval);
+            options.threads = job.threads;
+            options.max_frames = job.getInteger("max_frames", -1);
+
+            AbrLadderEncoder ladder;
+            return ladder.encode(job.inputs[0], job.output, options);
+        }
+
+        bool parseProcessor(const JsonValue &value, ProcessorSpec &processor, std::string &error)
+        {
+            if (!value.isObject())
+            {
+                error = "processors must be objects";
+                return false;
+            }
+
+            for (const auto &[key, member] : value.asObject())
+            {
+                if (member.isArray() || member.isObject() || member.isNull())
+                {
+                    error = "processor member " + key + " must be a string, number or boolean";
+                    return false;
+                }
+
+                if (key == "type")
+                    processor.type = member.toString();
+                else
+                    processor.params[key] = member.toString();
+            }
+            return true;
+        }
+
+        bool parseStringList(const JsonValue &value, std::vector<std::string> &list)
+        {
+            if (value.isString())
+            {
+                list.push_back(value.asString());
+                return true;
+            }
+
+            if (!value.isArray())
+                return false;
+
+            for (const auto &element : value.asArray())
+            {
+                if (!element.isString())
+                    return false;
+                list.push_back(element.asString());
+            }
+            return true;
+        }
+
+        bool parseJobMembers(const JsonValue &value, JobSpec &job, std::string &error)
+        {
+            if (!value.isObject())
+            {
+                error = "jobs must be objects";
+                return false;
+            }
+
+            for (const auto &[key, member] : value.asObject())
+            {
+                bool ok = true;
+                if (key == "name" || key == "command" || key == "output")
+                {
+                    ok = member.isString();
+                    if (key == "name")
+                        job.name = member.asString();
+                    else if (key == "command")
+                        job.command = member.asString();
+                    else
+                        job.output = member.asString();
+                }
+                else if (key == "input" || key == "inputs")
+                    ok = parseStringList(member, job.inputs);
+                else if (key == "depends_on")
+                    ok = parseStringList(member, job.depends_on);
+                else if (key == "threads")
+                    ok = member.isNumber() && parseThreads(member.toString(), job.threads);
+                else if (key == "processors")
+                {
+                    ok = member.isArray();
+                    for (size_t i = 0; ok && i < member.asArray().size(); ++i)
+                    {
+                        ProcessorSpec processor;
+                        if (!parseProcessor(member.asArray()[i], processor, error))
+                            return false;
+                        job.processors.push_back(std::move(processor));
+                    }
+                }
+                else if (member.isArray() || member.isObject() || member.isNull())
+                    ok = false;
+                else
+                    job.options[key] = member.toString();
+
+                if (!ok)
+                {
+                    error = "invalid value for " + key;
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    std::string JobSpec::getOption(const std::string &key, const std::string &fallback) const
+    {
+        auto it = options.find(key);
+        return it != options.end() ? it->second : fallback;
+    }
+
+    double JobSpec::getNumber(const std::string &key, double fallback) const
+    {
+        auto it = options.find(key);
+        if (it == options.end())
+            return fallback;
+
+        double value;
+        if (!parseNumber(it->second, value))
+        {
+            std::cerr << "Job " << name << ": ignoring non-numeric " << key << "=" << it->second << std::endl;
+            return fallback;
+        }
+        return value;
+    }
+
+    int JobSpec::getInteger(const std::string &key, int fallback) const
+    {
+        double value = getNumber(key, fallback);
+        if (!inIntRange(value))
+        {
+            std::cerr << "Job " << name << ": ignoring out-of-range " << key << "=" << getOption(key) << std::endl;
+            return fallback;
+        }
+        return static_cast<int>(value);
+    }
+
+    bool JobSpec::getFlag(const std::string &key, bool fallback) const
+    {
+        auto it = options.find(key);
+        if (it == options.end())
+            return fallback;
+
+        if (it->second == "true" || it->second == "1" || it->second == "yes")
+            return true;
+        if (it->second == "false" || it->second == "0" || it->second == "no")
+            return false;
+        return fallback;
+    }
+
+    bool parseInteger(const std::string &text, int &value)
+    {
+        double number;
+        if (!parseNumber(text, number) || !inIntRange(number) || number != std::floor(number))
+            return false;
+
+        value = static_cast<int>(number);
+        return true;
+    }
+
+    bool isJobCommand(const std::string &name)
+    {
+        for (const char *command : kCommands)
+        {
+            if (name == command)
+                return true;
+        }
+        return false;
+    }
+
+    bool parseJobArguments(const std::vector<std::string> &args, JobSpec &job, std::string &error)
+    {
+        job = JobSpec();
+        if (args.empty() || !isJobCommand(args[0]))
+        {
+            error = args.empty() ? "No command given" : "Unknown command: " + args[0];
+            return false;
+        }
+        job.command = args[0];
+
+        std::vector<std::string> positional;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            const std::string &arg = args[i];
+            if (arg.rfind("--", 0) != 0)
+            {
+                positional.push_back(arg);
+                continue;
+            }
+
+            // --key=value, or --key for a flag
+            size_t equals = arg.find('=');
+            std::string key = arg.substr(2, equals == std::string::npos ? std::string::npos : equals - 2);
+            std::string value = equals == std::string::npos ? "true" : arg.substr(equals + 1);
+            for (char &c : key)
+            {
+                if (c == '-')
+                    c = '_';
+            }
+
+            if (key == "grayscale")
+                job.processors.push_back({"grayscale", {}});
+            else if (key == "brightness_contrast")
+            {
+                size_t comma = value.find(',');
+                if (comma == std::string::npos)
+                {
+                    error = "--brightness-contrast expects BRIGHTNESS,CONTRAST";
+                    return false;
+                }
+                job.processors.push_back({"brightness_contrast",
+                                          {{"brightness", value.substr(0, comma)}, {"contrast", value.substr(comma + 1)}}});
+            }
+            else if (key == "filter")
+                job.processors.push_back({"filter", {{"graph", value}}});
+            else if (key == "output")
+                job.output = value;
+            else if (key == "name")
+                job.name = value;
+            else if (key == "threads")
+            {
+                if (!parseThreads(value, job.threads))
+                {
+                    error = "--threads expects a positive integer";
+                    return false;
+                }
+            }
+            else
+                job.options[key] = value;
+        }
+
+        if (writesOutput(job.command) && job.output.empty() && positional.size() > inputCount(job.command))
+        {
+            job.output = positional.back();
+            positional.pop_back();
+        }
+
+        job.inputs = std::move(positional);
+        if (job.name.empty())
+            job.name = job.command;
+
+        return validateJob(job, error);
+    }
+
+    bool loadJobManifest(const std::string &filename, JobManifest &manifest, std::string &error)
+    {
+        manifest = JobManifest();
+
+        std::ifstream file(filename);
+        if (!file)
+        {
+            error = "Could not open manifest: " + filename;
+            return false;
+        }
+
+        std::stringstream text;
+        text << file.rdbuf();
+
+        JsonValue root;
+        if (!JsonValue::parse(text.str(), root, error))
+        {
+            error = filename + ": " + error;
+            return false;
+        }
+
+        const JsonValue *jobs = root.find("jobs");
+        if (!jobs || !jobs->isArray())
+        {
+            error = filename + ": expected an object with a \"jobs\" array";
+            return false;
+        }
+
+        if (const JsonValue *threads = root.find("threads"))
+        {
+            if (!threads->isNumber() || !parseThreads(threads->toString(), manifest.threads))
+            {
+                error = filename + ": threads must be a positive integer";
+                return false;
+            }
+        }
+
+        std::set<std::string> names;
+        for (size_t i = 0; i < jobs->asArray().size(); ++i)
+        {
+            JobSpec job;
+            if (!parseJobJson(jobs->asArray()[i], job, error))
+            {
+                error = filename + ": job " + std::to_string(i + 1) + ": " + error;
+                return false;
+            }
+
+            if (job.name.empty())
+                job.name = "job " + std::to_string(i + 1);
+
+            if (!names.insert(job.name).second)
+            {
+                error = filename + ": duplicate job name " + job.name;
+                return false;
+            }
+
+            manifest.jobs.push_back(std::move(job));
+        }
+
+        // Dependencies may point forward, so check them once all names are known
+        for (const auto &job : manifest.jobs)
+        {
+            for (const auto &dependency : job.depends_on)
+            {
+                if (!names.count(dependency))
+                {
+                    error = filename + ": job " + job.name + " depends on unknown job " + dependency;
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool parseJobJson(const JsonValue &value, JobSpec &job, std::string &error)
+    {
+        job = JobSpec();
+        return parseJobMembers(value, job, error) && validateJob(job, error);
+    }
+
+    std::string jobToJson(const JobSpec &job)
+    {
+        auto quoted = [](const std::string &text)
+        { return "\"" + escapeJson(text) + "\""; };
+
+        auto list = [&](const std::vector<std::string> &items)
+        {
+            std::string out = "[";
+            for (size_t i = 0; i < items.size(); ++i)
+                out += (i > 0 ? ", " : "") + quoted(items[i]);
+            return out + "]";
+        };
+
+        std::ostringstream out;
+        out << "{\"name\": " << quoted(job.name)
+            << ", \"command\": " << quoted(job.command)
+            << ", \"inputs\": " << list(job.inputs)
+            << ", \"output\": " << quoted(job.output)
+            << ", \"threads\": " << job.threads
+            << ", \"depends_on\": " << list(job.depends_on)
+            << ", \"processors\": [";
+
+        for (size_t i = 0; i < job.processors.size(); ++i)
+        {
+            const ProcessorSpec &processor = job.processors[i];
+            out << (i > 0 ? ", " : "") << "{\"type\": " << quoted(processor.type);
+            for (const auto &[key, value] : processor.params)
+                out << ", " << quoted(key) << ": " << quoted(value);
+            out << "}";
+        }
+        out << "]";
+
+        // Options travel as strings; getNumber()/getFlag() parse them on use
+        for (const auto &[key, value] : job.options)
+            out << ", " << quoted(key) << ": " << quoted(value);
+        out << "}";
+
+        return out.str();
+    }
+
+    bool validateJob(const JobSpec &job, std::string &error)
+    {
+        if (!isJobCommand(job.command))
+        {
+            error = job.command.empty() ? "missing command" : "unknown command " + job.command;
+            return false;
+        }
+
+        if (job.inputs.empty())
+        {
+            error = job.command + " needs an input";
+            return false;
+        }
+
+        if (job.command == "concat" && job.inputs.size() < 2)
+        {
+            error = "concat needs at least two inputs";
+            return false;
+        }
+
+        if (job.command == "compare" && job.inputs.size() != 2)
+        {
+            error = "compare needs a reference and a distorted input";
+            return false;
+        }
+
+        if (job.output.empty() && (job.command == "transcode" || job.command == "cut" || job.command == "concat" ||
+                                   job.command == "adaptive" || job.command == "ladder"))
+        {
+            error = job.command + " needs an output";
+            return false;
+        }
+
+        if (job.threads < 1)
+        {
+            error = "threads must be at least 1";
+            return false;
+        }
+
+        if (!job.processors.empty() && job.command != "extract" && job.command != "transcode")
+        {
+            error = "processors apply to extract and transcode only";
+            return false;
+        }
+
+        std::string crop = job.getOption("crop", "");
+        if (!crop.empty())
+        {
+            int width = 0;
+            int height = 0;
+            if (job.command != "extract" && job.command != "transcode")
+            {
+                error = "--crop applies to extract and transcode only";
+                return false;
+            }
+            if (crop != "auto" && (std::sscanf(crop.c_str(), "%d:%d", &width, &height) != 2 || width <= 0 || height <= 0))
+            {
+                error = "--crop needs W:H[:X:Y] or auto";
+                return false;
+            }
+        }
+
+        for (const auto &processor : job.processors)
+        {
+            double value;
+            if (processor.type == "brightness_contrast")
+            {
+                auto brightness = processor.params.find("brightness");
+                auto contrast = processor.params.find("contrast");
+                if (brightness == processor.params.end() || contrast == processor.params.end() ||
+                    !parseNumber(brightness->second, value) || !parseNumber(contrast->second, value))
+                {
+                    error = "brightness_contrast needs numeric brightness and contrast";
+                    return false;
+                }
+            }
+            else if (processor.type == "filter")
+            {
+                auto graph = processor.params.find("graph");
+                if (graph == processor.params.end() || graph->second.empty())
+                {
+                    error = "filter needs a graph";
+                    return false;
+                }
+            }
+            else if (processor.type != "grayscale")
+            {
+                error = "unknown processor " + processor.type;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool runJob(const JobSpec &job, const ProgressCallback &progress)
+    {
+        std::cerr << "Running job " << job.name << " (" << job.command << ")" << std::endl;
+
+        if (job.command == "probe")
+            return runProbe(job);
+        if (job.command == "extract")
+            return runExtract(job, progress);
+        if (job.command == "transcode")
+            return runTranscode(job, progress);
+        if (job.command == "cut")
+            return runCut(job);
+        if (job.command == "concat")
+            return runConcat(job);
+        if (job.command == "proxy")
+            return runProxy(job);
+        if (job.command == "scenes")
+            return runScenes(job);
+        if (job.command == "qc")
+            return runQc(job);
+        if (job.command == "compare")
+            return runCompare(job);
+        if (job.command == "adaptive")
+            return runAdaptive(job);
+        if (job.command == "ladder")
+            return runLadder(job);
+
+        std::cerr << "Unknown command: " << job.command << std::endl;
+        return false;
+    }
+
+    void printJobUsage(const char *program)
+    {
+        std::cerr << "Usage: " << program << " <command> [arguments] [options]\n"
+                  << "\n"
+                  << "Commands:\n"
+                  << "  probe <input> [--output=info.json]\n"
+                  << "  extract <input> [output_dir] [--interval=N] [--format=jpg|png|bmp] [--max-frames=N]\n"
+                  << "  transcode <input> <output> [--codec=libx264] [--fps=N] [--audio=copy|none] [--max-frames=N]\n"
+                  << "    [--drop-duplicates]  skip encoding frames identical to the previous one\n"
+                  << "    [--fragmented] [--segment-duration=4] [--hls-ts]  fragmented MP4, or HLS/DASH for .m3u8/.mpd outputs\n"
+                  << "    an output ending in .vcraw stores the processed frames uncompressed for later passes;\n"
+                  << "    extract and transcode read .vcraw inputs without decoding\n"
+                  << "  cut <input> <output> --start=SECONDS [--duration=SECONDS] [--accurate] [--encoder=NAME]\n"
+                  << "  concat <input>... <output> [--encoder=NAME] [--allow-reencode=false] [--ignore-extradata]\n"
+                  << "  proxy <input> [output.mov] [--height=540] [--codec=mjpeg|libx264]  intra-only preview rendition\n"
+                  << "  scenes <input> [cuts.json] [--threshold=0.4] [--min-length=SECONDS] [--keyframes] [--lowres=N]\n"
+                  << "  qc <input> [report.json] [--min-freeze=2] [--freeze-difference=1] [--black-level=32] [--min-black=0] [--hashes]\n"
+                  << "  compare <reference> <distorted> [report.json] [--psnr=false] [--ssim=false] [--max-frames=N]\n"
+                  << "    per-frame and aggregate PSNR and SSIM of an encode against its source\n"
+                  << "  adaptive <input> <output> [--crf=23] [--crf-range=4] [--preset=medium] [--max-bitrate=KBPS]\n"
+                  << "    [--min-segment=2] [--parallel=N] [--plan=plan.json] [--keep-segments]  per-scene CRF, segments encoded in parallel\n"
+                  << "  ladder <input> <output_dir> [--heights=2160,1080,720,480] [--bitrates=KBPS,...] [--keyframe-interval=2]\n"
+                  << "    [--format=mp4|fmp4|hls] [--segment-duration=4] [--hls-ts]  ABR renditions from one decode\n"
+                  << "  run <manifest.json> [--threads=N]  run independent jobs in parallel within N threads\n"
+                  << "  serve [--socket=PATH] [--threads=N] [--queue-limit=N]  keep a job server running\n"
+                  << "  client [--socket=PATH] status|stop\n"
+                  << "  client [--socket=PATH] [--priority=N] submit <command> [arguments] [options]\n"
+                  << "\n"
+                  << "Processors for extract and transcode, applied in order:\n"
+                  << "  --grayscale  --brightness-contrast=B,C  --filter=GRAPH\n"
+                  << "  --crop=W:H[:X:Y]|auto  crop first, without copying; auto removes letterbox bars\n"
+                  << "    [--crop-limit=24] [--crop-samples=24]  luma threshold and frames sampled for auto\n"
+                  << "\n"
+                  << "Common options:\n"
+                  << "  --threads=N  decoder and encoder threads of the job\n"
+                  << "  --metrics[=file.json]  --trace=file.json  --memory-budget=MB\n"
+                  << "\n"
+                  << "Without a command, " << program << " <video_file> [output_dir] [max_frames] runs interactively."
+                  << std::endl;
+    }
+}
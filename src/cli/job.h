@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cli/json.h>
+#include <processing/progress_processor.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // One frame processor of a job's video chain, applied in order
+    struct ProcessorSpec
+    {
+        std::string type;                          // grayscale, brightness_contrast or filter
+        std::map<std::string, std::string> params; // brightness/contrast, graph (libavfilter description)
+    };
+
+    // A unit of batch work: one command with its inputs, outputs and options.
+    //
+    // Commands:
+    // - probe:     print stream information of inputs[0], or write it as JSON to output
+    // - extract:   save frames of inputs[0] as images into the output directory
+    //              (interval, format, max_frames)
+    // - transcode: re-encode inputs[0] into output through the processor chain
+    //              (codec, fps, max_frames, audio=copy|none)
+    // - cut:       cut [start, start + duration) seconds of inputs[0] into output
+    //              (start, duration, accurate, encoder)
+    // - concat:    join inputs into output (encoder, allow_reencode, ignore_extradata)
+    struct JobSpec
+    {
+        std::string name;
+        std::string command;
+        std::vector<std::string> inputs;
+        std::string output;
+        std::vector<ProcessorSpec> processors;
+        std::map<std::string, std::string> options;
+
+        // Names of jobs that have to finish successfully first
+        std::vector<std::string> depends_on;
+
+        // Threads the job may use (decoder and encoder), its share of the
+        // scheduler's thread budget
+        int threads{1};
+
+        std::string getOption(const std::string &key, const std::string &fallback = "") const;
+        double getNumber(const std::string &key, double fallback) const;
+        // Whole number that fits into an int (fractions are truncated); the
+        // fallback for missing, non-numeric and out-of-range values
+        int getInteger(const std::string &key, int fallback) const;
+        bool getFlag(const std::string &key, bool fallback = false) const;
+    };
+
+    // Jobs of a manifest file plus the thread budget it asks for (0 if none)
+    struct JobManifest
+    {
+        std::vector<JobSpec> jobs;
+        int threads{0};
+    };
+
+    // Whether name is one of the job commands above
+    bool isJobCommand(const std::string &name);
+
+    // Whole number within the int range, e.g. a command line count; false
+    // for anything else instead of throwing like std::stoi
+    bool parseInteger(const std::string &text, int &value);
+
+    // Parse "<command> <input>... [output] [--key=value]...".
+    // The last positional argument is the output for commands that write one,
+    // unless --output is given. Processor flags (--grayscale,
+    // --brightness-contrast=B,C, --filter=GRAPH) build the chain in order.
+    bool parseJobArguments(const std::vector<std::string> &args, JobSpec &job, std::string &error);
+
+    // Load a JSON manifest:
+    // {"threads": 8,
+    //  "jobs": [{"name": "...", "command": "transcode", "input": "in.mp4", "output": "out.mp4",
+    //            "processors": [{"type": "grayscale"}], "threads": 2, "depends_on": ["..."],
+    //            "codec": "libx264", ...}]}
+    // Scalar members other than the fixed ones become options.
+    bool loadJobManifest(const std::string &filename, JobManifest &manifest, std::string &error);
+
+    // One job object in the manifest format (parsed and validated), and back
+    bool parseJobJson(const JsonValue &value, JobSpec &job, std::string &error);
+    std::string jobToJson(const JobSpec &job);
+
+    // Check the fields the command needs
+    bool validateJob(const JobSpec &job, std::string &error);
+
+    // Run the job on the calling thread. progress is called after every
+    // frame (or batch) of extract and transcode jobs.
+    bool runJob(const JobSpec &job, const ProgressCallback &progress = {});
+
+    // Command line help for the subcommands
+    void printJobUsage(const char *program);
+}
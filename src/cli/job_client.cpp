@@ -0,0 +1,108 @@
+#include <cli/job_client.h>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace video_codec
+{
+    namespace
+    {
+        std::string absolutePath(const std::string &path)
+        {
+            if (path.empty())
+                return path;
+            std::error_code ec;
+            std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+            return ec ? path : absolute.lexically_normal().string();
+        }
+    }
+
+    bool sendJobServerRequest(const std::string &socket_path, const std::string &request, std::ostream &out)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path too long: " << socket_path << std::endl;
+            return false;
+        }
+        std::strcpy(address.sun_path, socket_path.c_str());
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            std::cerr << "Could not connect to job server at " << socket_path << ": " << std::strerror(errno) << std::endl;
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+
+        std::string data = request + "\n";
+        if (send(fd, data.data(), data.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(data.size()))
+        {
+            std::cerr << "Could not send request: " << std::strerror(errno) << std::endl;
+            close(fd);
+            return false;
+        }
+
+        // Each line is one event. A submission succeeds only on a finished
+        // event with status ok, so a server that goes away midway is a
+        // failure; status and stop succeed on their own reply.
+        JsonValue parsed_request;
+        std::string parse_error;
+        const JsonValue *request_type = nullptr;
+        bool is_submit = JsonValue::parse(request, parsed_request, parse_error) &&
+                         (request_type = parsed_request.find("type")) && request_type->isString() &&
+                         request_type->asString() == "submit";
+
+        bool ok = false;
+        std::string pending;
+        char buffer[4096];
+        ssize_t received;
+        while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        {
+            pending.append(buffer, received);
+
+            size_t end;
+            while ((end = pending.find('\n')) != std::string::npos)
+            {
+                std::string line = pending.substr(0, end);
+                pending.erase(0, end + 1);
+                out << line << std::endl;
+
+                JsonValue event;
+                std::string error;
+                if (!JsonValue::parse(line, event, error))
+                    continue;
+
+                const JsonValue *type = event.find("event");
+                const JsonValue *status = event.find("status");
+                if (type && type->isString())
+                {
+                    if (type->asString() == "rejected" || type->asString() == "error")
+                        ok = false;
+                    else if (type->asString() == "finished")
+                        ok = status && status->isString() && status->asString() == "ok";
+                    else if (!is_submit && (type->asString() == "status" || type->asString() == "stopping"))
+                        ok = true;
+                }
+            }
+        }
+        close(fd);
+
+        return ok;
+    }
+
+    std::string makeSubmitRequest(JobSpec job, int priority)
+    {
+        for (auto &input : job.inputs)
+            input = absolutePath(input);
+        job.output = absolutePath(job.output);
+
+        return "{\"type\": \"submit\", \"priority\": " + std::to_string(priority) + ", \"job\": " + jobToJson(job) + "}";
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cli/job.h>
+#include <ostream>
+#include <string>
+
+namespace video_codec
+{
+    // Send one request line to a JobServer and copy its event lines to out
+    // until the server closes the connection. False if the server cannot be
+    // reached, rejects the job or reports it as failed.
+    bool sendJobServerRequest(const std::string &socket_path, const std::string &request, std::ostream &out);
+
+    // Submit request for a job parsed from the command line. Relative paths
+    // are made absolute since the server has its own working directory.
+    std::string makeSubmitRequest(JobSpec job, int priority);
+}
@@ -0,0 +1,202 @@
+#include <cli/job_scheduler.h>
+#include <graph/thread_pool.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace video_codec
+{
+    JobScheduler::JobScheduler(unsigned thread_budget)
+        : thread_budget_(thread_budget > 0 ? thread_budget : std::max(1u, std::thread::hardware_concurrency())),
+          runner_([](const JobSpec &job)
+                  { return runJob(job); })
+    {
+    }
+
+    bool JobScheduler::resolveDependencies(const std::vector<JobSpec> &jobs,
+                                           std::vector<std::vector<size_t>> &dependencies)
+    {
+        std::map<std::string, size_t> index_of;
+        for (size_t i = 0; i < jobs.size(); ++i)
+            index_of[jobs[i].name] = i;
+
+        dependencies.assign(jobs.size(), {});
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            for (const auto &name : jobs[i].depends_on)
+            {
+                auto it = index_of.find(name);
+                if (it == index_of.end())
+                {
+                    std::cerr << "Job " << jobs[i].name << " depends on unknown job " << name << std::endl;
+                    return false;
+                }
+                dependencies[i].push_back(it->second);
+            }
+        }
+
+        // Kahn's algorithm: every job must become ready at some point
+        std::vector<size_t> waiting_on(jobs.size());
+        std::vector<std::vector<size_t>> dependents(jobs.size());
+        std::vector<size_t> ready;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            waiting_on[i] = dependencies[i].size();
+            for (size_t dependency : dependencies[i])
+                dependents[dependency].push_back(i);
+            if (waiting_on[i] == 0)
+                ready.push_back(i);
+        }
+
+        size_t visited = 0;
+        while (!ready.empty())
+        {
+            size_t job = ready.back();
+            ready.pop_back();
+            ++visited;
+
+            for (size_t dependent : dependents[job])
+            {
+                if (--waiting_on[dependent] == 0)
+                    ready.push_back(dependent);
+            }
+        }
+
+        if (visited != jobs.size())
+        {
+            std::cerr << "Job dependencies contain a cycle" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool JobScheduler::run(const std::vector<JobSpec> &jobs)
+    {
+        results_.clear();
+        for (const auto &job : jobs)
+            results_.push_back({job.name, JobResult::Status::Skipped, 0.0});
+
+        std::vector<std::vector<size_t>> dependencies;
+        if (!resolveDependencies(jobs, dependencies))
+            return false;
+
+        enum class State
+        {
+            Pending,
+            Running,
+            Done
+        };
+
+        std::vector<State> state(jobs.size(), State::Pending);
+        std::mutex mutex;
+        std::condition_variable job_done;
+        unsigned threads_in_use = 0;
+        size_t running = 0;
+        size_t finished = 0;
+
+        {
+            // Every running job holds at least one thread of the budget, so
+            // an admitted job always finds an idle worker
+            ThreadPool pool(thread_budget_);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            while (finished < jobs.size())
+            {
+                bool changed = false;
+                for (size_t i = 0; i < jobs.size(); ++i)
+                {
+                    if (state[i] != State::Pending)
+                        continue;
+
+                    bool ready = true;
+                    bool blocked = false;
+                    for (size_t dependency : dependencies[i])
+                    {
+                        if (state[dependency] != State::Done)
+                            ready = false;
+                        else if (results_[dependency].status != JobResult::Status::Succeeded)
+                            blocked = true;
+                    }
+
+                    if (blocked)
+                    {
+                        std::cerr << "Skipping job " << jobs[i].name << ": a dependency failed" << std::endl;
+                        state[i] = State::Done;
+                        ++finished;
+                        changed = true;
+                        continue;
+                    }
+
+                    unsigned threads = std::min<unsigned>(jobs[i].threads, thread_budget_);
+                    if (!ready || (running > 0 && threads_in_use + threads > thread_budget_))
+                        continue;
+
+                    state[i] = State::Running;
+                    threads_in_use += threads;
+                    ++running;
+                    changed = true;
+
+                    pool.submit([&, i, threads]
+                                {
+                        auto begin = std::chrono::steady_clock::now();
+
+                        bool ok = false;
+                        try
+                        {
+                            ok = runner_(jobs[i]);
+                        }
+                        catch (const std::exception &e)
+                        {
+                            std::cerr << "Job " << jobs[i].name << " threw: " << e.what() << std::endl;
+                        }
+
+                        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+                        std::lock_guard<std::mutex> done_lock(mutex);
+                        results_[i].status = ok ? JobResult::Status::Succeeded : JobResult::Status::Failed;
+                        results_[i].seconds = seconds;
+                        state[i] = State::Done;
+                        threads_in_use -= threads;
+                        --running;
+                        ++finished;
+                        job_done.notify_all(); });
+                }
+
+                // Nothing more can start until a running job finishes
+                if (!changed && finished < jobs.size())
+                {
+                    size_t seen = finished;
+                    job_done.wait(lock, [&]
+                                  { return finished != seen; });
+                }
+            }
+        }
+
+        return std::all_of(results_.begin(), results_.end(), [](const JobResult &result)
+                           { return result.status == JobResult::Status::Succeeded; });
+    }
+
+    void JobScheduler::printSummary(std::ostream &out) const
+    {
+        out << std::left << std::setw(32) << "job"
+            << std::setw(12) << "status"
+            << std::right << std::setw(12) << "seconds" << std::endl;
+
+        out << std::fixed << std::setprecision(2);
+        for (const auto &result : results_)
+        {
+            const char *status = result.status == JobResult::Status::Succeeded ? "ok"
+                                 : result.status == JobResult::Status::Failed  ? "failed"
+                                                                               : "skipped";
+            out << std::left << std::setw(32) << result.name
+                << std::setw(12) << status
+                << std::right << std::setw(12) << result.seconds << std::endl;
+        }
+        out << std::defaultfloat;
+    }
+}
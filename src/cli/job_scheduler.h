@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cli/job.h>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // Outcome of one scheduled job
+    struct JobResult
+    {
+        enum class Status
+        {
+            Succeeded,
+            Failed,
+            Skipped // A dependency failed
+        };
+
+        std::string name;
+        Status status{Status::Skipped};
+        double seconds{0.0};
+    };
+
+    // Runs a set of jobs in parallel under a global thread budget.
+    //
+    // A job becomes ready once every job in its depends_on succeeded, and is
+    // started when its threads fit into what the running jobs leave of the
+    // budget. Ready jobs start in manifest order; a later job that fits may
+    // start ahead of an earlier one that does not. A job that asks for more
+    // than the whole budget runs alone.
+    class JobScheduler
+    {
+    public:
+        // thread_budget == 0 uses the hardware concurrency
+        explicit JobScheduler(unsigned thread_budget = 0);
+
+        // Not Allowed to copy
+        JobScheduler(const JobScheduler &) = delete;
+        JobScheduler &operator=(const JobScheduler &) = delete;
+
+        // Job body, runJob() unless replaced
+        void setRunner(std::function<bool(const JobSpec &)> runner) { runner_ = std::move(runner); }
+
+        // Run all jobs and return true if every one succeeded.
+        // Fails up front on unknown or circular dependencies.
+        bool run(const std::vector<JobSpec> &jobs);
+
+        // Per-job outcome of the last run, in input order
+        const std::vector<JobResult> &getResults() const { return results_; }
+        void printSummary(std::ostream &out) const;
+
+        unsigned getThreadBudget() const { return thread_budget_; }
+
+    private:
+        unsigned thread_budget_;
+        std::function<bool(const JobSpec &)> runner_;
+        std::vector<JobResult> results_;
+
+        // Dependencies as job indices; false on unknown names or cycles
+        static bool resolveDependencies(const std::vector<JobSpec> &jobs,
+                                        std::vector<std::vector<size_t>> &dependencies);
+    };
+}
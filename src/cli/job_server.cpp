@@ -0,0 +1,412 @@
+#include <cli/job_server.h>
+#include <media/codec_cache.h>
+#include <media/video_encoder.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Heap order: highest priority on top, earliest submission first among equals
+        bool queueOrder(const auto &a, const auto &b)
+        {
+            if (a.priority != b.priority)
+                return a.priority < b.priority;
+            return a.id > b.id;
+        }
+
+        double toMilliseconds(std::chrono::steady_clock::duration duration)
+        {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        constexpr size_t kMaxRequestBytes = 1 << 20;
+
+        // Time a client has to send its whole request line
+        constexpr std::chrono::seconds kRequestTimeout{5};
+    }
+
+    JobServer::JobServer(const JobServerOptions &options)
+        : options_(options)
+    {
+        if (options_.thread_budget == 0)
+            options_.thread_budget = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    JobServer::~JobServer()
+    {
+        closeSocket();
+    }
+
+    bool JobServer::openSocket()
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (options_.socket_path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Socket path too long: " << options_.socket_path << std::endl;
+            return false;
+        }
+        std::strcpy(address.sun_path, options_.socket_path.c_str());
+
+        listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd_ < 0)
+        {
+            std::cerr << "Could not create socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        // A stale socket file of an earlier server is replaced, but nothing else
+        struct stat info{};
+        if (lstat(options_.socket_path.c_str(), &info) == 0)
+        {
+            if (!S_ISSOCK(info.st_mode))
+            {
+                std::cerr << "Refusing to replace " << options_.socket_path << ": not a socket" << std::endl;
+                closeSocket();
+                return false;
+            }
+            unlink(options_.socket_path.c_str());
+        }
+
+        // Jobs write arbitrary files, so only the owner may connect; the
+        // mode is set before listen(), so nobody can connect earlier
+        if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            chmod(options_.socket_path.c_str(), S_IRUSR | S_IWUSR) < 0 ||
+            listen(listen_fd_, 16) < 0)
+        {
+            std::cerr << "Could not listen on " << options_.socket_path << ": " << std::strerror(errno) << std::endl;
+            closeSocket();
+            return false;
+        }
+
+        return true;
+    }
+
+    void JobServer::closeSocket()
+    {
+        if (listen_fd_ >= 0)
+        {
+            close(listen_fd_);
+            listen_fd_ = -1;
+            unlink(options_.socket_path.c_str());
+        }
+    }
+
+    void JobServer::warmUp()
+    {
+        VideoEncoderSettings settings;
+        settings.codec_name = "libx264";
+        settings.width = 64;
+        settings.height = 64;
+
+        VideoEncoder encoder;
+        if (!encoder.open(settings))
+            std::cerr << "Warm-up skipped: " << encoder.getLastError() << std::endl;
+    }
+
+    bool JobServer::run()
+    {
+        if (!openSocket())
+            return false;
+
+        warmUp();
+        pool_ = std::make_unique<ThreadPool>(options_.thread_budget);
+
+        std::cout << "Job server listening on " << options_.socket_path
+                  << " (" << options_.thread_budget << " threads, queue limit " << options_.queue_limit << ")" << std::endl;
+
+        // Poll with a timeout so that stop() is noticed without a connection
+        while (!stopping_.load(std::memory_order_relaxed))
+        {
+            pollfd listener{listen_fd_, POLLIN, 0};
+            int ready = poll(&listener, 1, 200);
+            if (ready < 0 && errno != EINTR)
+            {
+                std::cerr << "poll failed: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            if (ready <= 0)
+                continue;
+
+            int client_fd = accept(listen_fd_, nullptr, nullptr);
+            if (client_fd < 0)
+                continue;
+
+            // Each request is read on its own thread, so a slow client holds up nobody else
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++connections_;
+            }
+            std::thread([this, client_fd]
+                        {
+                            handleConnection(client_fd);
+
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            --connections_;
+                            idle_.notify_all(); })
+                .detach();
+        }
+
+        closeSocket();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            std::cout << "Job server stopping, waiting for " << queue_.size() + running_ << " jobs" << std::endl;
+            idle_.wait(lock, [&]
+                       { return connections_ == 0 && queue_.empty() && running_ == 0; });
+        }
+        pool_.reset();
+
+        return true;
+    }
+
+    void JobServer::handleConnection(int client_fd)
+    {
+        // One deadline for the whole request, however slowly it trickles in
+        auto deadline = std::chrono::steady_clock::now() + kRequestTimeout;
+
+        std::string line;
+        char buffer[4096];
+        while (line.find('\n') == std::string::npos && line.size() < kMaxRequestBytes)
+        {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0)
+                break;
+
+            pollfd client{client_fd, POLLIN, 0};
+            int ready = poll(&client, 1, static_cast<int>(remaining.count()));
+            if (ready < 0 && errno == EINTR)
+                continue;
+            if (ready <= 0)
+                break;
+
+            ssize_t received = recv(client_fd, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                break;
+            line.append(buffer, received);
+        }
+        line = line.substr(0, line.find('\n'));
+
+        JsonValue request;
+        std::string error;
+        const JsonValue *type = nullptr;
+        if (!JsonValue::parse(line, request, error))
+            error = "invalid request: " + error;
+        else if (!(type = request.find("type")) || !type->isString())
+            error = "request has no type";
+
+        if (!error.empty())
+        {
+            sendLine(client_fd, "{\"event\": \"error\", \"message\": \"" + escapeJson(error) + "\"}");
+            close(client_fd);
+            return;
+        }
+
+        if (type->asString() == "submit")
+        {
+            submit(request, client_fd); // Takes over the connection
+            return;
+        }
+
+        if (type->asString() == "status")
+            sendLine(client_fd, statusJson());
+        else if (type->asString() == "stop")
+        {
+            sendLine(client_fd, "{\"event\": \"stopping\"}");
+            stop();
+        }
+        else
+            sendLine(client_fd, "{\"event\": \"error\", \"message\": \"unknown request type " + escapeJson(type->asString()) + "\"}");
+
+        close(client_fd);
+    }
+
+    void JobServer::submit(const JsonValue &request, int client_fd)
+    {
+        const JsonValue *job_value = request.find("job");
+        const JsonValue *priority = request.find("priority");
+
+        QueuedJob queued;
+        std::string error;
+        if (priority && priority->isNumber() &&
+            !(std::isfinite(priority->asNumber()) && priority->asNumber() >= INT_MIN && priority->asNumber() <= INT_MAX))
+        {
+            sendLine(client_fd, "{\"event\": \"rejected\", \"reason\": \"priority out of range\"}");
+            close(client_fd);
+            return;
+        }
+
+        if (!job_value || !parseJobJson(*job_value, queued.job, error))
+        {
+            sendLine(client_fd, "{\"event\": \"rejected\", \"reason\": \"" +
+                                    escapeJson(job_value ? error : "request has no job") + "\"}");
+            close(client_fd);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Admission control: refuse instead of queueing without bound
+        if (queue_.size() >= options_.queue_limit)
+        {
+            ++rejected_;
+            sendLine(client_fd, "{\"event\": \"rejected\", \"reason\": \"queue full\"}");
+            close(client_fd);
+            return;
+        }
+
+        queued.id = next_id_++;
+        queued.priority = priority && priority->isNumber() ? static_cast<int>(priority->asNumber()) : 0;
+        queued.client_fd = client_fd;
+        queued.queued_at = std::chrono::steady_clock::now();
+        if (queued.job.name.empty())
+            queued.job.name = queued.job.command + " #" + std::to_string(queued.id);
+
+        std::ostringstream event;
+        event << "{\"event\": \"queued\", \"id\": " << queued.id
+              << ", \"name\": \"" << escapeJson(queued.job.name) << "\""
+              << ", \"waiting\": " << queue_.size() << "}";
+        sendLine(client_fd, event.str());
+
+        queue_.push_back(std::move(queued));
+        std::push_heap(queue_.begin(), queue_.end(), queueOrder<QueuedJob, QueuedJob>);
+        dispatch();
+    }
+
+    void JobServer::dispatch()
+    {
+        while (!queue_.empty())
+        {
+            unsigned threads = std::min<unsigned>(queue_.front().job.threads, options_.thread_budget);
+            if (running_ > 0 && threads_in_use_ + threads > options_.thread_budget)
+                return;
+
+            std::pop_heap(queue_.begin(), queue_.end(), queueOrder<QueuedJob, QueuedJob>);
+            QueuedJob queued = std::move(queue_.back());
+            queue_.pop_back();
+
+            threads_in_use_ += threads;
+            ++running_;
+
+            auto task = std::make_shared<QueuedJob>(std::move(queued));
+            pool_->submit([this, task, threads]
+                          { runQueued(std::move(*task), threads); });
+        }
+    }
+
+    void JobServer::runQueued(QueuedJob queued, unsigned threads)
+    {
+        auto started_at = std::chrono::steady_clock::now();
+        auto queue_time = started_at - queued.queued_at;
+        int fd = queued.client_fd;
+
+        std::ostringstream started;
+        started << "{\"event\": \"started\", \"id\": " << queued.id
+                << ", \"queue_ms\": " << toMilliseconds(queue_time) << "}";
+        bool connected = sendLine(fd, started.str());
+
+        // At most a few progress lines per second
+        auto last_report = started_at;
+        auto progress = [&](int64_t frames_done, int64_t frames_total)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (!connected || (now - last_report < std::chrono::milliseconds(250) && frames_done != frames_total))
+                return;
+            last_report = now;
+
+            std::ostringstream event;
+            event << "{\"event\": \"progress\", \"id\": " << queued.id
+                  << ", \"frames\": " << frames_done << ", \"total_frames\": " << frames_total
+                  << ", \"elapsed_ms\": " << toMilliseconds(now - started_at) << "}";
+            connected = sendLine(fd, event.str());
+        };
+
+        bool ok = false;
+        try
+        {
+            ok = runJob(queued.job, progress);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Job " << queued.job.name << " threw: " << e.what() << std::endl;
+        }
+
+        auto run_time = std::chrono::steady_clock::now() - started_at;
+
+        std::ostringstream finished;
+        finished << "{\"event\": \"finished\", \"id\": " << queued.id
+                 << ", \"status\": \"" << (ok ? "ok" : "failed") << "\""
+                 << ", \"queue_ms\": " << toMilliseconds(queue_time)
+                 << ", \"run_ms\": " << toMilliseconds(run_time) << "}";
+        if (connected)
+            sendLine(fd, finished.str());
+        close(fd);
+
+        std::cout << "Job " << queued.job.name << (ok ? " finished" : " failed") << " in "
+                  << toMilliseconds(run_time) << " ms (queued " << toMilliseconds(queue_time) << " ms)" << std::endl;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_ns_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(queue_time).count());
+        run_ns_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(run_time).count());
+        ++(ok ? completed_ : failed_);
+        threads_in_use_ -= threads;
+        --running_;
+
+        dispatch();
+        idle_.notify_all();
+    }
+
+    std::string JobServer::statusJson()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream out;
+        out << "{\"event\": \"status\""
+            << ", \"running\": " << running_
+            << ", \"waiting\": " << queue_.size()
+            << ", \"threads_in_use\": " << threads_in_use_
+            << ", \"thread_budget\": " << options_.thread_budget
+            << ", \"completed\": " << completed_
+            << ", \"failed\": " << failed_
+            << ", \"rejected\": " << rejected_
+            << ", \"queue_ms_p50\": " << queue_ns_.getPercentile(0.5) / 1e6
+            << ", \"queue_ms_p95\": " << queue_ns_.getPercentile(0.95) / 1e6
+            << ", \"run_ms_p50\": " << run_ns_.getPercentile(0.5) / 1e6
+            << ", \"run_ms_p95\": " << run_ns_.getPercentile(0.95) / 1e6
+            << ", \"codec_cache_hits\": " << CodecCache::instance().getHits()
+            << ", \"codec_cache_misses\": " << CodecCache::instance().getMisses() << "}";
+        return out.str();
+    }
+
+    bool JobServer::sendLine(int fd, const std::string &line)
+    {
+        std::string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            // MSG_NOSIGNAL: a vanished client must not raise SIGPIPE
+            ssize_t written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            sent += written;
+        }
+        return true;
+    }
+}
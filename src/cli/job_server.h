@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cli/job.h>
+#include <graph/thread_pool.h>
+#include <profiling/pipeline_metrics.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    struct JobServerOptions
+    {
+        std::string socket_path{"/tmp/video_codec.sock"};
+        unsigned thread_budget{0}; // 0 uses the hardware concurrency
+        size_t queue_limit{64};    // Submissions beyond this many waiting jobs are rejected
+    };
+
+    // Long-running job server on a Unix domain socket.
+    //
+    // Protocol: one JSON object per line. A client connects, sends one request
+    //   {"type": "submit", "priority": 0, "job": {...}}  (job as in a manifest)
+    //   {"type": "status"}
+    //   {"type": "stop"}
+    // and reads event lines until the server closes the connection:
+    //   submit: queued, started, progress..., finished (or rejected)
+    //   status: status; stop: stopping
+    //
+    // Jobs run on a persistent ThreadPool, so a request pays neither process
+    // start nor codec library loading, and scaling contexts and image
+    // encoders stay warm in the CodecCache between jobs. Waiting jobs start
+    // by priority (higher first, FIFO among equals) while their threads fit
+    // into the budget. The head of the queue is never overtaken, so a large
+    // high-priority job cannot be starved by small ones.
+    class JobServer
+    {
+    public:
+        explicit JobServer(const JobServerOptions &options);
+        ~JobServer();
+
+        // Not Allowed to copy
+        JobServer(const JobServer &) = delete;
+        JobServer &operator=(const JobServer &) = delete;
+
+        // Serve until a stop request or stop(). Waiting and running jobs
+        // finish before it returns. False if the socket cannot be opened.
+        bool run();
+
+        // Ask run() to return; async-signal-safe
+        void stop() { stopping_.store(true, std::memory_order_relaxed); }
+
+    private:
+        struct QueuedJob
+        {
+            uint64_t id;
+            int priority;
+            JobSpec job;
+            int client_fd;
+            std::chrono::steady_clock::time_point queued_at;
+        };
+
+        JobServerOptions options_;
+        int listen_fd_{-1};
+        std::atomic<bool> stopping_{false};
+        std::unique_ptr<ThreadPool> pool_;
+
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::vector<QueuedJob> queue_; // Heap ordered by priority, then id
+        unsigned threads_in_use_{0};
+        size_t running_{0};
+        size_t connections_{0}; // Requests still being read or answered
+        uint64_t next_id_{1};
+        uint64_t completed_{0};
+        uint64_t failed_{0};
+        uint64_t rejected_{0};
+
+        // Time from submission to start and from start to finish
+        Log2Histogram queue_ns_;
+        Log2Histogram run_ns_;
+
+        bool openSocket();
+        void closeSocket();
+
+        // Load the default encoder once so the first job starts warm
+        void warmUp();
+
+        // Read one request from a new connection and answer it; runs on a
+        // thread of its own
+        void handleConnection(int client_fd);
+        void submit(const JsonValue &request, int client_fd);
+
+        // Start queued jobs while they fit; mutex_ must be held
+        void dispatch();
+        void runQueued(QueuedJob queued, unsigned threads);
+
+        std::string statusJson();
+
+        // Write line plus newline; false if the client went away
+        static bool sendLine(int fd, const std::string &line);
+    };
+}
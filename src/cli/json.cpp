@@ -0,0 +1,349 @@
+#include <cli/json.h>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace video_codec
+{
+    // Recursive descent parser over the whole document
+    class JsonValue::Parser
+    {
+    public:
+        explicit Parser(const std::string &text) : text_(text) {}
+
+        bool parseDocument(JsonValue &value)
+        {
+            skipWhitespace();
+            if (!parseValue(value, 0))
+                return false;
+
+            skipWhitespace();
+            if (pos_ != text_.size())
+                return fail("Unexpected trailing characters");
+            return true;
+        }
+
+        const std::string &getError() const { return error_; }
+
+    private:
+        static constexpr int kMaxDepth = 64;
+
+        const std::string &text_;
+        size_t pos_{0};
+        std::string error_;
+
+        bool fail(const std::string &message)
+        {
+            if (error_.empty())
+            {
+                size_t line = 1;
+                for (size_t i = 0; i < pos_ && i < text_.size(); ++i)
+                    line += text_[i] == '\n';
+                error_ = message + " at line " + std::to_string(line);
+            }
+            return false;
+        }
+
+        void skipWhitespace()
+        {
+            while (pos_ < text_.size() &&
+                   (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+                ++pos_;
+        }
+
+        bool consume(const char *literal)
+        {
+            size_t length = std::char_traits<char>::length(literal);
+            if (text_.compare(pos_, length, literal) != 0)
+                return false;
+            pos_ += length;
+            return true;
+        }
+
+        bool parseValue(JsonValue &value, int depth)
+        {
+            if (depth > kMaxDepth)
+                return fail("Nesting too deep");
+            if (pos_ >= text_.size())
+                return fail("Unexpected end of input");
+
+            char c = text_[pos_];
+            if (c == '{')
+                return parseObject(value, depth);
+            if (c == '[')
+                return parseArray(value, depth);
+            if (c == '"')
+            {
+                value.type_ = Type::String;
+                return parseString(value.string_);
+            }
+            if (c == '-' || (c >= '0' && c <= '9'))
+                return parseNumber(value);
+            if (consume("true") || consume("false"))
+            {
+                value.type_ = Type::Bool;
+                value.bool_ = c == 't';
+                return true;
+            }
+            if (consume("null"))
+            {
+                value.type_ = Type::Null;
+                return true;
+            }
+            return fail(std::string("Unexpected character '") + c + "'");
+        }
+
+        bool parseObject(JsonValue &value, int depth)
+        {
+            value.type_ = Type::Object;
+            ++pos_; // '{'
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == '}')
+            {
+                ++pos_;
+                return true;
+            }
+
+            while (true)
+            {
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != '"')
+                    return fail("Expected member name");
+
+                std::string key;
+                if (!parseString(key))
+                    return false;
+
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != ':')
+                    return fail("Expected ':'");
+                ++pos_;
+
+                skipWhitespace();
+                JsonValue member;
+                if (!parseValue(member, depth + 1))
+                    return false;
+                value.object_[key] = std::move(member);
+
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ',')
+                {
+                    ++pos_;
+                    continue;
+                }
+                if (pos_ < text_.size() && text_[pos_] == '}')
+                {
+                    ++pos_;
+                    return true;
+                }
+                return fail("Expected ',' or '}'");
+            }
+        }
+
+        bool parseArray(JsonValue &value, int depth)
+        {
+            value.type_ = Type::Array;
+            ++pos_; // '['
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ']')
+            {
+                ++pos_;
+                return true;
+            }
+
+            while (true)
+            {
+                skipWhitespace();
+                JsonValue element;
+                if (!parseValue(element, depth + 1))
+                    return false;
+                value.array_.push_back(std::move(element));
+
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ',')
+                {
+                    ++pos_;
+                    continue;
+                }
+                if (pos_ < text_.size() && text_[pos_] == ']')
+                {
+                    ++pos_;
+                    return true;
+                }
+                return fail("Expected ',' or ']'");
+            }
+        }
+
+        bool parseHex4(uint32_t &code)
+        {
+            if (pos_ + 4 > text_.size())
+                return fail("Truncated \\u escape");
+
+            code = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = text_[pos_++];
+                code <<= 4;
+                if (c >= '0' && c <= '9')
+                    code |= c - '0';
+                else if (c >= 'a' && c <= 'f')
+                    code |= c - 'a' + 10;
+                else if (c >= 'A' && c <= 'F')
+                    code |= c - 'A' + 10;
+                else
+                    return fail("Invalid \\u escape");
+            }
+            return true;
+        }
+
+        static void appendUtf8(std::string &out, uint32_t code)
+        {
+            if (code < 0x80)
+                out += static_cast<char>(code);
+            else if (code < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        bool parseString(std::string &out)
+        {
+            ++pos_; // '"'
+            while (pos_ < text_.size())
+            {
+                char c = text_[pos_++];
+                if (c == '"')
+                    return true;
+                if (static_cast<unsigned char>(c) < 0x20)
+                    return fail("Control character in string");
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+
+                if (pos_ >= text_.size())
+                    break;
+
+                char escape = text_[pos_++];
+                switch (escape)
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    out += escape;
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code;
+                    if (!parseHex4(code))
+                        return false;
+
+                    // Surrogate pair
+                    if (code >= 0xD800 && code <= 0xDBFF && text_.compare(pos_, 2, "\\u") == 0)
+                    {
+                        pos_ += 2;
+                        uint32_t low;
+                        if (!parseHex4(low))
+                            return false;
+                        if (low < 0xDC00 || low > 0xDFFF)
+                            return fail("Invalid surrogate pair");
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail(std::string("Invalid escape '\\") + escape + "'");
+                }
+            }
+            return fail("Unterminated string");
+        }
+
+        bool parseNumber(JsonValue &value)
+        {
+            const char *begin = text_.c_str() + pos_;
+            char *end = nullptr;
+            double number = std::strtod(begin, &end);
+            if (end == begin || !std::isfinite(number))
+                return fail("Invalid number");
+
+            pos_ += end - begin;
+            value.type_ = Type::Number;
+            value.number_ = number;
+            return true;
+        }
+    };
+
+    bool JsonValue::parse(const std::string &text, JsonValue &value, std::string &error)
+    {
+        Parser parser(text);
+        value = JsonValue();
+        if (parser.parseDocument(value))
+            return true;
+
+        error = parser.getError();
+        return false;
+    }
+
+    const JsonValue *JsonValue::find(const std::string &key) const
+    {
+        if (type_ != Type::Object)
+            return nullptr;
+
+        auto it = object_.find(key);
+        return it != object_.end() ? &it->second : nullptr;
+    }
+
+    std::string JsonValue::toString() const
+    {
+        switch (type_)
+        {
+        case Type::String:
+            return string_;
+        case Type::Bool:
+            return bool_ ? "true" : "false";
+        case Type::Number:
+        {
+            if (number_ == std::floor(number_) && std::fabs(number_) < 1e15)
+                return std::to_string(static_cast<int64_t>(number_));
+
+            std::ostringstream out;
+            out.precision(17);
+            out << number_;
+            return out.str();
+        }
+        default:
+            return "";
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // Minimal JSON document model for job manifests.
+    // Objects keep their members sorted by key; numbers are doubles.
+    class JsonValue
+    {
+    public:
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        JsonValue() = default;
+
+        // Parse a complete document. On failure error holds the message and
+        // the line it was found on.
+        static bool parse(const std::string &text, JsonValue &value, std::string &error);
+
+        Type getType() const { return type_; }
+        bool isNull() const { return type_ == Type::Null; }
+        bool isBool() const { return type_ == Type::Bool; }
+        bool isNumber() const { return type_ == Type::Number; }
+        bool isString() const { return type_ == Type::String; }
+        bool isArray() const { return type_ == Type::Array; }
+        bool isObject() const { return type_ == Type::Object; }
+
+        bool asBool() const { return bool_; }
+        double asNumber() const { return number_; }
+        const std::string &asString() const { return string_; }
+        const std::vector<JsonValue> &asArray() const { return array_; }
+        const std::map<std::string, JsonValue> &asObject() const { return object_; }
+
+        // Object member, or nullptr if this is no object or the key is missing
+        const JsonValue *find(const std::string &key) const;
+
+        // Scalar as text: strings verbatim, integral numbers without a
+        // fraction, booleans as "true"/"false", anything else empty
+        std::string toString() const;
+
+    private:
+        class Parser;
+
+        Type type_{Type::Null};
+        bool bool_{false};
+        double number_{0.0};
+        std::string string_;
+        std::vector<JsonValue> array_;
+        std::map<std::string, JsonValue> object_;
+    };
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace video_codec
+{
+    // Fixed-capacity FIFO shared between threads.
+    // A closed queue rejects new items but can still be drained.
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+        // Not Allowed to copy
+        BoundedQueue(const BoundedQueue &) = delete;
+        BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+        // Append item if there is room (item is moved from only on success)
+        bool tryPush(T &item)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closed_ || items_.size() >= capacity_)
+                    return false;
+
+                items_.push_back(std::move(item));
+            }
+            not_empty_.notify_one();
+            return true;
+        }
+
+        // Append item, waiting for room. Returns false once the queue is closed.
+        bool push(T item)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_full_.wait(lock, [this]
+                               { return closed_ || items_.size() < capacity_; });
+                if (closed_)
+                    return false;
+
+                items_.push_back(std::move(item));
+            }
+            not_empty_.notify_one();
+            return true;
+        }
+
+        bool tryPop(T &item)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (items_.empty())
+                    return false;
+
+                item = std::move(items_.front());
+                items_.pop_front();
+            }
+            not_full_.notify_one();
+            return true;
+        }
+
+        // Take the oldest item, waiting for one. Returns false once the queue
+        // is closed and drained.
+        bool pop(T &item)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_empty_.wait(lock, [this]
+                                { return closed_ || !items_.empty(); });
+                if (items_.empty())
+                    return false;
+
+                item = std::move(items_.front());
+                items_.pop_front();
+            }
+            not_full_.notify_one();
+            return true;
+        }
+
+        // Wait until there is room, the queue is closed or the timeout expires
+        template <typename Rep, typename Period>
+        void waitNotFull(std::chrono::duration<Rep, Period> timeout)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait_for(lock, timeout, [this]
+                               { return closed_ || items_.size() < capacity_; });
+        }
+
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+        // Closed and empty: no item will ever come out again
+        bool isDrained() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return closed_ && items_.empty();
+        }
+
+        bool isClosed() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return closed_;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return items_.size();
+        }
+
+        size_t capacity() const { return capacity_; }
+
+    private:
+        const size_t capacity_;
+        mutable std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<T> items_;
+        bool closed_{false};
+    };
+}
@@ -0,0 +1,352 @@
+#include <graph/processing_graph.h>
+#include <media/media_file.h>
+#include <profiling/memory_tracker.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Frames a node processes per task before yielding its worker
+        constexpr int kMaxFramesPerTask = 16;
+
+        // Pending tasks a blocked push may run nested on its own stack. A
+        // helped task can block on a full edge again, so unlimited nesting
+        // grows the stack without bound; beyond this the push just waits.
+        // Deep enough for a consumer chain to drain with a single worker.
+        constexpr int kMaxHelpDepth = 16;
+        thread_local int help_depth = 0;
+    }
+
+    bool ProcessingGraph::OutputPort::processFrame(AVFrame *frame, int frame_number)
+    {
+        FramePtr frame_ref = refFrame(frame);
+        if (!frame_ref)
+        {
+            std::cerr << "Could not reference frame of node " << node_.name << std::endl;
+            return false;
+        }
+
+        return graph_.emit(node_, std::move(frame_ref), frame_number);
+    }
+
+    bool ProcessingGraph::OutputPort::consumeFrame(FramePtr frame, int frame_number)
+    {
+        return graph_.emit(node_, std::move(frame), frame_number);
+    }
+
+    ProcessingGraph::ProcessingGraph(unsigned num_threads, size_t edge_capacity)
+        : edge_capacity_(edge_capacity), pool_(num_threads)
+    {
+        // Node 0 stands for the decoder output
+        nodes_.push_back(std::make_unique<Node>(*this, "decode", nullptr));
+    }
+
+    ProcessingGraph::~ProcessingGraph() = default;
+
+    ProcessingGraph::NodeId ProcessingGraph::addNode(const std::string &name, FrameProcessor &processor)
+    {
+        nodes_.push_back(std::make_unique<Node>(*this, name, &processor));
+        return static_cast<NodeId>(nodes_.size() - 1);
+    }
+
+    FrameProcessor *ProcessingGraph::outputOf(NodeId id)
+    {
+        if (id < 0 || static_cast<size_t>(id) >= nodes_.size())
+            return nullptr;
+
+        return &nodes_[id]->port;
+    }
+
+    bool ProcessingGraph::connect(NodeId from, NodeId to)
+    {
+        if (from < 0 || to <= kSource ||
+            static_cast<size_t>(from) >= nodes_.size() || static_cast<size_t>(to) >= nodes_.size())
+        {
+            std::cerr << "Invalid graph edge " << from << " -> " << to << std::endl;
+            return false;
+        }
+
+        Node *from_node = nodes_[from].get();
+        Node *to_node = nodes_[to].get();
+
+        for (const auto &edge : to_node->inputs)
+        {
+            if (edge->from == from_node)
+                return true; // Already connected
+        }
+
+        if (from == to || reaches(to_node, from_node))
+        {
+            std::cerr << "Edge " << from_node->name << " -> " << to_node->name
+                      << " would create a cycle" << std::endl;
+            return false;
+        }
+
+        to_node->inputs.push_back(std::make_unique<Edge>(from_node, to_node, edge_capacity_));
+        from_node->outputs.push_back(to_node->inputs.back().get());
+        return true;
+    }
+
+    bool ProcessingGraph::reaches(const Node *from, const Node *to) const
+    {
+        if (from == to)
+            return true;
+
+        for (const Edge *edge : from->outputs)
+        {
+            if (reaches(edge->to, to))
+                return true;
+        }
+        return false;
+    }
+
+    bool ProcessingGraph::run(MediaFile &media_file, int max_frames, int video_stream_index)
+    {
+        if (has_run_)
+        {
+            std::cerr << "Processing graph has already been run" << std::endl;
+            return false;
+        }
+
+        for (size_t i = 1; i < nodes_.size(); ++i)
+        {
+            if (nodes_[i]->inputs.empty())
+            {
+                std::cerr << "Graph node " << nodes_[i]->name << " has no input" << std::endl;
+                return false;
+            }
+        }
+
+        has_run_ = true;
+        failed_ = false;
+        running_nodes_ = nodes_.size() - 1;
+
+        // Decode on the calling thread; the source port fans the frames out
+        Node &source = *nodes_[kSource];
+        bool result = media_file.processVideoFrames(source.port, max_frames, video_stream_index);
+
+        // End of stream: close the decoder edges and let the nodes drain
+        source.finished = true;
+        finishNode(source);
+        waitForNodes();
+
+        return result && !failed_;
+    }
+
+    size_t ProcessingGraph::getQueuedFrames(NodeId id) const
+    {
+        if (id < 0 || static_cast<size_t>(id) >= nodes_.size())
+            return 0;
+
+        size_t queued = 0;
+        for (const auto &edge : nodes_[id]->inputs)
+            queued += edge->queue.size();
+
+        return queued;
+    }
+
+    bool ProcessingGraph::emit(Node &node, FramePtr frame, int frame_number)
+    {
+        if (failed_)
+            return false;
+
+        for (size_t i = 0; i < node.outputs.size(); ++i)
+        {
+            // The last edge takes over our reference, the others share the buffers
+            Item item;
+            item.frame = (i + 1 == node.outputs.size()) ? std::move(frame) : refFrame(frame.get());
+            item.frame_number = frame_number;
+
+            if (!item.frame)
+            {
+                std::cerr << "Could not reference frame of node " << node.name << std::endl;
+                failed_ = true;
+                return false;
+            }
+
+            if (!pushToEdge(*node.outputs[i], item))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool ProcessingGraph::pushToEdge(Edge &edge, Item &item)
+    {
+        // Over the memory budget an edge counts as full while its consumer
+        // still has frames to work through
+        auto can_push = [&]
+        { return !MemoryTracker::instance().isOverBudget() || edge.queue.size() == 0; };
+
+        if (can_push() && edge.queue.tryPush(item))
+        {
+            edge.depth.recordDepth(edge.queue.size());
+            schedule(*edge.to);
+            return true;
+        }
+
+        // The consumer is behind; the wait shows up as a stall on the timeline
+        static StageMetrics &backpressure_metrics = PipelineMetrics::instance().stage("graph backpressure");
+        ScopedStageTimer timer(backpressure_metrics, item.frame_number);
+
+        while (!failed_)
+        {
+            // A closed edge never takes frames again; its consumer has finished
+            if (edge.queue.isClosed())
+            {
+                std::cerr << "Graph edge " << edge.from->name << " -> " << edge.to->name
+                          << " is closed, frame #" << item.frame_number << " dropped" << std::endl;
+                failed_ = true;
+                return false;
+            }
+
+            if (can_push() && edge.queue.tryPush(item))
+            {
+                edge.depth.recordDepth(edge.queue.size());
+                schedule(*edge.to);
+                return true;
+            }
+
+            // Edge is full: make sure its consumer runs, and help with
+            // pending work instead of blocking a worker
+            schedule(*edge.to);
+            bool helped = false;
+            if (help_depth < kMaxHelpDepth)
+            {
+                ++help_depth;
+                helped = pool_.runPendingTask();
+                --help_depth;
+            }
+
+            if (!helped)
+            {
+                if (can_push())
+                    edge.queue.waitNotFull(std::chrono::milliseconds(1));
+                else
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        }
+        return false;
+    }
+
+    void ProcessingGraph::schedule(Node &node)
+    {
+        if (!node.processor)
+            return; // The source is driven by the decoder
+
+        if (!node.scheduled.exchange(true))
+            pool_.submit([this, &node]
+                         { runNode(node); });
+    }
+
+    void ProcessingGraph::runNode(Node &node)
+    {
+        for (int i = 0; i < kMaxFramesPerTask; ++i)
+        {
+            Item item;
+            if (!popInput(node, item))
+                break;
+
+            // After a failure frames are only drained
+            if (failed_)
+                continue;
+
+            node.metrics.addFrames(1);
+            if (!timeStage(node.metrics, item.frame_number, [&]
+                           { return node.processor->consumeFrame(std::move(item.frame), item.frame_number); }))
+            {
+                std::cerr << "Graph node " << node.name << " failed on frame #"
+                          << item.frame_number << std::endl;
+                failed_ = true;
+            }
+        }
+
+        // Clear the flag before checking the inputs again, so that a frame
+        // pushed in between either sees the flag cleared or is seen here
+        node.scheduled = false;
+
+        if (hasQueuedInput(node))
+        {
+            schedule(node);
+            return;
+        }
+
+        if (!inputsDrained(node))
+            return;
+
+        // Finish only while holding the flag: a run started in between may
+        // have taken the last frame and still be inside consumeFrame(), and
+        // that run finishes the node itself. The flag stays set afterwards,
+        // so a finished node is never run again.
+        if (node.scheduled.exchange(true))
+            return;
+
+        if (!node.finished.exchange(true))
+            finishNode(node);
+    }
+
+    bool ProcessingGraph::popInput(Node &node, Item &item)
+    {
+        // Round-robin over the input edges so no parent starves the others
+        for (size_t i = 0; i < node.inputs.size(); ++i)
+        {
+            Edge &edge = *node.inputs[node.next_input];
+            node.next_input = (node.next_input + 1) % node.inputs.size();
+
+            if (edge.queue.tryPop(item))
+                return true;
+        }
+        return false;
+    }
+
+    bool ProcessingGraph::hasQueuedInput(const Node &node) const
+    {
+        for (const auto &edge : node.inputs)
+        {
+            if (edge->queue.size() > 0)
+                return true;
+        }
+        return false;
+    }
+
+    bool ProcessingGraph::inputsDrained(const Node &node) const
+    {
+        for (const auto &edge : node.inputs)
+        {
+            if (!edge->queue.isDrained())
+                return false;
+        }
+        return true;
+    }
+
+    void ProcessingGraph::finishNode(Node &node)
+    {
+        for (Edge *edge : node.outputs)
+        {
+            edge->queue.close();
+            schedule(*edge->to);
+        }
+
+        if (node.processor && --running_nodes_ == 0)
+        {
+            std::lock_guard<std::mutex> lock(done_mutex_);
+            done_.notify_all();
+        }
+    }
+
+    void ProcessingGraph::waitForNodes()
+    {
+        while (running_nodes_ > 0)
+        {
+            if (pool_.runPendingTask())
+                continue;
+
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_.wait_for(lock, std::chrono::milliseconds(1), [this]
+                           { return running_nodes_ == 0; });
+        }
+    }
+}
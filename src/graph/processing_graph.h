@@ -0,0 +1,145 @@
+#pragma once
+
+#include <graph/bounded_queue.h>
+#include <graph/thread_pool.h>
+#include <media/frame_ref.h>
+#include <processing/frame_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    class MediaFile;
+
+    // DAG of frame processors fed by a single decode pass.
+    //
+    // Decoded frames enter at kSource and are fanned out to every connected
+    // node through per-edge bounded queues; fan-out shares the frame buffers
+    // (refFrame) instead of copying pixels. Each node runs on the
+    // work-stealing pool, one task at a time, so its processor sees frames in
+    // order and never concurrently. Transform nodes (e.g. FilterProcessor)
+    // forward their output by setting outputOf(node) as next processor.
+    //
+    //     ProcessingGraph graph;
+    //     auto full  = graph.addNode("full-res encode", writer);
+    //     auto thumb = graph.addNode("thumbnails", saver);
+    //     graph.connect(ProcessingGraph::kSource, full);
+    //     graph.connect(ProcessingGraph::kSource, thumb);
+    //     graph.run(media_file);
+    class ProcessingGraph
+    {
+    public:
+        using NodeId = int;
+        static constexpr NodeId kSource = 0;
+
+        // - num_threads: worker threads, 0 uses the hardware concurrency
+        // - edge_capacity: frames buffered per edge before the producer waits
+        explicit ProcessingGraph(unsigned num_threads = 0, size_t edge_capacity = 8);
+        ~ProcessingGraph();
+
+        // Not Allowed to copy
+        ProcessingGraph(const ProcessingGraph &) = delete;
+        ProcessingGraph &operator=(const ProcessingGraph &) = delete;
+
+        // Add a node; the processor must outlive the graph run
+        NodeId addNode(const std::string &name, FrameProcessor &processor);
+
+        // Output port of a node, to be set as next processor of transform nodes
+        FrameProcessor *outputOf(NodeId id);
+
+        // Add an edge; rejects unknown nodes and edges that would form a cycle
+        bool connect(NodeId from, NodeId to);
+
+        // Decode the video stream once and push every frame through the graph.
+        // Blocks until every node has processed all of its frames.
+        // A graph can be run once, since its edges are closed at end of stream.
+        bool run(MediaFile &media_file, int max_frames = -1, int video_stream_index = -1);
+
+        // Frames currently buffered on the edges feeding a node
+        size_t getQueuedFrames(NodeId id) const;
+
+    private:
+        struct Node;
+
+        struct Item
+        {
+            FramePtr frame;
+            int frame_number{0};
+        };
+
+        struct Edge
+        {
+            Edge(Node *from_node, Node *to_node, size_t capacity)
+                : from(from_node), to(to_node), queue(capacity),
+                  depth(PipelineMetrics::instance().queue("edge " + from_node->name + " -> " + to_node->name)) {}
+
+            Node *from;
+            Node *to;
+            BoundedQueue<Item> queue;
+            QueueMetrics &depth;
+        };
+
+        // Fans frames emitted by a node out to its output edges
+        class OutputPort : public FrameProcessor
+        {
+        public:
+            OutputPort(ProcessingGraph &graph, Node &node) : graph_(graph), node_(node) {}
+
+            bool processFrame(AVFrame *frame, int frame_number) override;
+            bool consumeFrame(FramePtr frame, int frame_number) override;
+
+        private:
+            ProcessingGraph &graph_;
+            Node &node_;
+        };
+
+        struct Node
+        {
+            Node(ProcessingGraph &graph, const std::string &node_name, FrameProcessor *node_processor)
+                : name(node_name), processor(node_processor), port(graph, *this),
+                  metrics(PipelineMetrics::instance().stage("node " + node_name)) {}
+
+            std::string name;
+            FrameProcessor *processor;
+            OutputPort port;
+            StageMetrics &metrics; // Includes forwarding into the output edges
+            std::vector<std::unique_ptr<Edge>> inputs;
+            std::vector<Edge *> outputs;
+            size_t next_input{0};
+            std::atomic<bool> scheduled{false};
+            std::atomic<bool> finished{false};
+        };
+
+        size_t edge_capacity_;
+        std::vector<std::unique_ptr<Node>> nodes_;
+        bool has_run_{false};
+
+        // Declared after the nodes so that workers are joined first
+        ThreadPool pool_;
+
+        std::mutex done_mutex_;
+        std::condition_variable done_;
+        std::atomic<size_t> running_nodes_{0};
+        std::atomic<bool> failed_{false};
+
+        bool reaches(const Node *from, const Node *to) const;
+
+        // Send a frame to every output edge of node
+        bool emit(Node &node, FramePtr frame, int frame_number);
+        bool pushToEdge(Edge &edge, Item &item);
+
+        void schedule(Node &node);
+        void runNode(Node &node);
+        bool popInput(Node &node, Item &item);
+        bool hasQueuedInput(const Node &node) const;
+        bool inputsDrained(const Node &node) const;
+        void finishNode(Node &node);
+
+        void waitForNodes();
+    };
+}
@@ -0,0 +1,136 @@
+#include <graph/thread_pool.h>
+#include <profiling/frame_tracer.h>
+#include <algorithm>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Pool and worker index of the current thread
+        thread_local const ThreadPool *current_pool = nullptr;
+        thread_local int current_index = -1;
+    }
+
+    ThreadPool::ThreadPool(unsigned num_threads)
+    {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned i = 0; i < num_threads; ++i)
+            workers_.push_back(std::make_unique<Worker>());
+
+        for (unsigned i = 0; i < num_threads; ++i)
+            threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+
+        // Workers drain the remaining tasks before they exit
+        for (auto &thread : threads_)
+            thread.join();
+    }
+
+    int ThreadPool::currentWorker() const
+    {
+        return current_pool == this ? current_index : -1;
+    }
+
+    void ThreadPool::submit(std::function<void()> task)
+    {
+        int index = currentWorker();
+        if (index < 0)
+            index = static_cast<int>(next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size());
+
+        // Count the task first so that takeTask() never sees a negative balance
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            pending_++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+            workers_[index]->tasks.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+    bool ThreadPool::popTask(unsigned index, std::function<void()> &task)
+    {
+        Worker &worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty())
+            return false;
+
+        task = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool ThreadPool::stealTask(unsigned thief, std::function<void()> &task)
+    {
+        for (unsigned offset = 1; offset <= workers_.size(); ++offset)
+        {
+            unsigned victim = (thief + offset) % workers_.size();
+            Worker &worker = *workers_[victim];
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty())
+                continue;
+
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    bool ThreadPool::takeTask(int index, std::function<void()> &task)
+    {
+        bool found = index >= 0 ? popTask(index, task) || stealTask(index, task)
+                                : stealTask(next_worker_.load(std::memory_order_relaxed) % workers_.size(), task);
+        if (found)
+            pending_--;
+
+        return found;
+    }
+
+    bool ThreadPool::runPendingTask()
+    {
+        std::function<void()> task;
+        if (!takeTask(currentWorker(), task))
+            return false;
+
+        task();
+        return true;
+    }
+
+    void ThreadPool::workerLoop(unsigned index)
+    {
+        current_pool = this;
+        current_index = static_cast<int>(index);
+        FrameTracer::setThreadName("worker " + std::to_string(index));
+
+        while (true)
+        {
+            std::function<void()> task;
+            if (takeTask(index, task))
+            {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [this]
+                       { return stopping_ || pending_ > 0; });
+
+            if (stopping_ && pending_ == 0)
+                break;
+        }
+    }
+}
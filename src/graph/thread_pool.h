@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace video_codec
+{
+    // Work-stealing thread pool.
+    // Every worker owns a task deque: it pops its own tasks LIFO (cache-warm)
+    // and steals FIFO from the other workers when it runs dry. Tasks submitted
+    // from a worker go to that worker's deque, others are spread round-robin.
+    class ThreadPool
+    {
+    public:
+        // num_threads == 0 uses the hardware concurrency
+        explicit ThreadPool(unsigned num_threads = 0);
+        ~ThreadPool();
+
+        // Not Allowed to copy or move
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        void submit(std::function<void()> task);
+
+        // Run one pending task on the calling thread.
+        // Threads that have to wait for other tasks call this to help instead
+        // of blocking a worker. Returns false when no task was available.
+        bool runPendingTask();
+
+        unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        std::atomic<bool> stopping_{false};
+        std::atomic<size_t> pending_{0};
+        std::atomic<unsigned> next_worker_{0};
+
+        // Index of the calling worker thread, -1 for foreign threads
+        int currentWorker() const;
+
+        bool popTask(unsigned index, std::function<void()> &task);
+        bool stealTask(unsigned thief, std::function<void()> &task);
+        bool takeTask(int index, std::function<void()> &task);
+
+        void workerLoop(unsigned index);
+    };
+}
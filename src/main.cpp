@@ -2,27 +2,301 @@
 #include <processing/frame_processor.h>
 #include <processing/simple_frame_processor.h>
 #include <processing/video_writer_processor.h>
+#include <processing/audio_processors.h>
+#include <processing/noise_reduction.h>
+#include <graph/processing_graph.h>
+#include <media/media_concat.h>
+#include <media/transition_renderer.h>
+#include <profiling/pipeline_metrics.h>
+#include <profiling/frame_tracer.h>
+#include <profiling/memory_tracker.h>
+#include <cli/job.h>
+#include <cli/job_scheduler.h>
+#include <cli/job_server.h>
+#include <cli/job_client.h>
+#include <algorithm>
+#include <csignal>
 #include <iostream>
 #include <string>
 #include <memory>
+#include <vector>
+
+namespace
+{
+    struct ProfilingOptions
+    {
+        bool metrics_enabled{false};
+        int64_t memory_budget_mb{0};
+        std::string metrics_filename;
+        std::string trace_filename;
+    };
+
+    void startProfiling(const ProfilingOptions &options)
+    {
+        video_codec::PipelineMetrics::instance().setEnabled(options.metrics_enabled);
+        video_codec::MemoryTracker::instance().setEnabled(options.metrics_enabled || options.memory_budget_mb > 0);
+        video_codec::MemoryTracker::instance().setBudget(options.memory_budget_mb * 1024 * 1024);
+        video_codec::FrameTracer::setThreadName("main");
+        video_codec::FrameTracer::instance().setEnabled(!options.trace_filename.empty());
+    }
+
+    void finishProfiling(const ProfilingOptions &options)
+    {
+        if (options.metrics_enabled)
+        {
+            video_codec::PipelineMetrics::instance().printSummary(std::cout);
+            if (!options.metrics_filename.empty() && video_codec::PipelineMetrics::instance().writeJson(options.metrics_filename))
+                std::cout << "Metrics written to " << options.metrics_filename << std::endl;
+        }
+
+        if (!options.trace_filename.empty())
+        {
+            video_codec::FrameTracer &tracer = video_codec::FrameTracer::instance();
+            tracer.setEnabled(false);
+            if (tracer.writeChromeTrace(options.trace_filename))
+            {
+                std::cout << "Trace written to " << options.trace_filename << " (open in https://ui.perfetto.dev)" << std::endl;
+                if (tracer.getDroppedEvents() > 0)
+                    std::cout << "  " << tracer.getDroppedEvents() << " oldest events were overwritten" << std::endl;
+            }
+        }
+    }
+
+    video_codec::JobServer *running_server = nullptr;
+
+    void stopServer(int)
+    {
+        if (running_server)
+            running_server->stop();
+    }
+
+    // serve [--socket=PATH] [--threads=N] [--queue-limit=N]
+    int runServe(const std::vector<std::string> &args, const char *program)
+    {
+        video_codec::JobServerOptions options;
+        for (size_t i = 1; i < args.size(); ++i)
+        {
+            int value = 0;
+            if (args[i].rfind("--socket=", 0) == 0)
+                options.socket_path = args[i].substr(9);
+            else if (args[i].rfind("--threads=", 0) == 0 && video_codec::parseInteger(args[i].substr(10), value) && value >= 0)
+                options.thread_budget = static_cast<unsigned>(value);
+            else if (args[i].rfind("--queue-limit=", 0) == 0 && video_codec::parseInteger(args[i].substr(14), value) && value >= 0)
+                options.queue_limit = static_cast<size_t>(value);
+            else
+            {
+                std::cerr << "Unknown or invalid serve option: " << args[i] << std::endl;
+                video_codec::printJobUsage(program);
+                return 1;
+            }
+        }
+
+        video_codec::JobServer server(options);
+        running_server = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+
+        bool result = server.run();
+        running_server = nullptr;
+        return result ? 0 : 1;
+    }
+
+    // client [--socket=PATH] status|stop
+    // client [--socket=PATH] [--priority=N] submit <command> ...
+    int runClient(const std::vector<std::string> &args, const char *program)
+    {
+        std::string socket_path = video_codec::JobServerOptions().socket_path;
+        int priority = 0;
+        size_t i = 1;
+        for (; i < args.size() && args[i].rfind("--", 0) == 0; ++i)
+        {
+            if (args[i].rfind("--socket=", 0) == 0)
+                socket_path = args[i].substr(9);
+            else if (args[i].rfind("--priority=", 0) == 0)
+            {
+                if (!video_codec::parseInteger(args[i].substr(11), priority))
+                {
+                    std::cerr << "--priority expects a whole number in the int range: " << args[i] << std::endl;
+                    video_codec::printJobUsage(program);
+                    return 1;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown client option: " << args[i] << std::endl;
+                video_codec::printJobUsage(program);
+                return 1;
+            }
+        }
+
+        if (i >= args.size())
+        {
+            video_codec::printJobUsage(program);
+            return 1;
+        }
+
+        std::string request;
+        if (args[i] == "status" || args[i] == "stop")
+            request = "{\"type\": \"" + args[i] + "\"}";
+        else if (args[i] == "submit")
+        {
+            std::string error;
+            video_codec::JobSpec job;
+            std::vector<std::string> job_args(args.begin() + i + 1, args.end());
+            if (job_args.empty() || !video_codec::isJobCommand(job_args[0]) ||
+                !video_codec::parseJobArguments(job_args, job, error))
+            {
+                std::cerr << (error.empty() ? "submit needs a job command" : error) << std::endl;
+                video_codec::printJobUsage(program);
+                return 1;
+            }
+            request = video_codec::makeSubmitRequest(job, priority);
+        }
+        else
+        {
+            std::cerr << "Unknown client request: " << args[i] << std::endl;
+            video_codec::printJobUsage(program);
+            return 1;
+        }
+
+        return video_codec::sendJobServerRequest(socket_path, request, std::cout) ? 0 : 1;
+    }
+
+    // Non-interactive mode: one subcommand, or "run" for a job manifest
+    int runCommand(const std::vector<std::string> &args, const ProfilingOptions &profiling, const char *program)
+    {
+        bool result = false;
+
+        if (args[0] == "run")
+        {
+            if (args.size() < 2)
+            {
+                video_codec::printJobUsage(program);
+                return 1;
+            }
+
+            std::string error;
+            video_codec::JobManifest manifest;
+            if (!video_codec::loadJobManifest(args[1], manifest, error))
+            {
+                std::cerr << error << std::endl;
+                return 1;
+            }
+
+            // The command line budget overrides the manifest
+            unsigned thread_budget = manifest.threads;
+            for (size_t i = 2; i < args.size(); ++i)
+            {
+                int threads = 0;
+                if (args[i].rfind("--threads=", 0) == 0 && video_codec::parseInteger(args[i].substr(10), threads) && threads >= 0)
+                    thread_budget = threads;
+                else if (args[i].rfind("--threads=", 0) == 0)
+                {
+                    std::cerr << "--threads expects a thread count: " << args[i] << std::endl;
+                    video_codec::printJobUsage(program);
+                    return 1;
+                }
+                else
+                {
+                    std::cerr << "Unknown run option: " << args[i] << std::endl;
+                    return 1;
+                }
+            }
+
+            video_codec::JobScheduler scheduler(thread_budget);
+            std::cout << "Running " << manifest.jobs.size() << " jobs with " << scheduler.getThreadBudget() << " threads" << std::endl;
+
+            startProfiling(profiling);
+            result = scheduler.run(manifest.jobs);
+            scheduler.printSummary(std::cout);
+        }
+        else
+        {
+            std::string error;
+            video_codec::JobSpec job;
+            if (!video_codec::parseJobArguments(args, job, error))
+            {
+                std::cerr << error << std::endl;
+                video_codec::printJobUsage(program);
+                return 1;
+            }
+
+            startProfiling(profiling);
+            result = video_codec::runJob(job);
+        }
+
+        finishProfiling(profiling);
+
+        if (!result)
+        {
+            std::cerr << "Job failed" << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+}
 
 int main(int argc, char *argv[])
 {
-    if (argc < 2)
+    // --metrics[=file.json] prints per-stage timings at the end of the run
+    // and optionally writes them as JSON.
+    // --trace=file.json writes a per-frame timeline in Chrome trace format.
+    // --memory-budget=MB slows decoding down while buffered frames exceed the budget.
+    ProfilingOptions profiling;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--metrics")
+            profiling.metrics_enabled = true;
+        else if (arg.rfind("--metrics=", 0) == 0)
+        {
+            profiling.metrics_enabled = true;
+            profiling.metrics_filename = arg.substr(10);
+        }
+        else if (arg.rfind("--trace=", 0) == 0)
+            profiling.trace_filename = arg.substr(8);
+        else if (arg.rfind("--memory-budget=", 0) == 0)
+            profiling.memory_budget_mb = std::stoll(arg.substr(16));
+        else
+            args.push_back(arg);
+    }
+
+    if (args.empty())
     {
-        std::cerr << "Usage: " << argv[0] << " <video_file> [output_dir] [max_frames]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <video_file> [output_dir] [max_frames] [--metrics[=file.json]] [--trace=file.json] [--memory-budget=MB]" << std::endl;
+        std::cerr << "   or: " << argv[0] << " <command> ... (probe, extract, transcode, cut, concat, proxy, scenes, qc, compare, adaptive, ladder, run, serve, client; see --help)" << std::endl;
         return 1;
     }
 
-    const char *input_filename = argv[1];
+    if (args[0] == "--help" || args[0] == "help")
+    {
+        video_codec::printJobUsage(argv[0]);
+        return 0;
+    }
+
+    if (args[0] == "serve")
+        return runServe(args, argv[0]);
+
+    if (args[0] == "client")
+        return runClient(args, argv[0]);
+
+    if (args[0] == "run" || video_codec::isJobCommand(args[0]))
+        return runCommand(args, profiling, argv[0]);
+
+    const char *input_filename = args[0].c_str();
 
     std::string output_dir = "./frames";
-    if (argc > 2)
-        output_dir = argv[2];
+    if (args.size() > 1)
+        output_dir = args[1];
 
     int max_frames = -1;
-    if (argc > 3)
-        max_frames = std::stoi(argv[3]);
+    if (args.size() > 2 && !video_codec::parseInteger(args[2], max_frames))
+    {
+        std::cerr << "max_frames expects a whole number: " << args[2] << std::endl;
+        video_codec::printJobUsage(argv[0]);
+        return 1;
+    }
 
     video_codec::MediaFile media_file;
     if (!media_file.open(input_filename))
@@ -32,17 +306,26 @@ int main(int argc, char *argv[])
 
     media_file.printInfo();
 
+    // Hand frames to the processors in groups to keep per-frame overhead low
+    media_file.setFrameBatchSize(16);
+
     std::cout << "\nSelect frame processing option:" << std::endl;
     std::cout << "1. Display frame information only" << std::endl;
     std::cout << "2. Save frames as JPG images" << std::endl;
     std::cout << "3. Convert to grayscale and save frames" << std::endl;
     std::cout << "4. Adjust brightness/contrast and save frames" << std::endl;
     std::cout << "5. Create MP4 video output" << std::endl;
+    std::cout << "6. Create MP4 video output and save frames in one decode pass" << std::endl;
+    std::cout << "7. Concatenate videos" << std::endl;
+    std::cout << "8. Join with a transition" << std::endl;
+    std::cout << "9. Create MP4 video output with audio processing (volume, noise reduction, BGM)" << std::endl;
     std::cout << "Option: ";
 
     int option;
     std::cin >> option;
 
+    startProfiling(profiling);
+
     bool result = false;
 
     switch (option)
@@ -149,22 +432,34 @@ int main(int argc, char *argv[])
         int filter_option;
         std::cin >> filter_option;
 
+        // The source audio is not processed, so it is stream-copied
+        video_codec::AudioOutputSettings audio;
+        int audio_index = media_file.findAudioStreamIndex();
+        if (audio_index >= 0)
+        {
+            const AVStream *audio_stream = media_file.getFormatContext()->streams[audio_index];
+            audio.mode = video_codec::AudioOutputSettings::Mode::Copy;
+            audio.copy_parameters = audio_stream->codecpar;
+            audio.copy_time_base = audio_stream->time_base;
+            audio.start_time = media_file.getVideoStartTime();
+        }
+
         std::unique_ptr<video_codec::VideoWriterProcessor> video_writer;
         video_writer = std::make_unique<video_codec::VideoWriterProcessor>(
-            output_filename, width, height, fps);
+            output_filename, width, height, fps, "libx264", audio);
 
         switch (filter_option)
         {
         case 1:
             // No filters
-            result = media_file.processVideoFrames(*video_writer, max_frames);
+            result = media_file.processMediaFrames(*video_writer, *video_writer, max_frames);
             break;
 
         case 2:
             // Grayscale
             {
                 auto grayscale = std::make_unique<video_codec::GrayscaleProcessor>(video_writer.get());
-                result = media_file.processVideoFrames(*grayscale, max_frames);
+                result = media_file.processMediaFrames(*grayscale, *video_writer, max_frames);
                 break;
             }
 
@@ -179,7 +474,7 @@ int main(int argc, char *argv[])
 
                 auto brightness_contrast = std::make_unique<video_codec::BrightnessContrastProcessor>(
                     brightness, contrast, video_writer.get());
-                result = media_file.processVideoFrames(*brightness_contrast, max_frames);
+                result = media_file.processMediaFrames(*brightness_contrast, *video_writer, max_frames);
                 break;
             }
 
@@ -196,11 +491,209 @@ int main(int argc, char *argv[])
         }
         break;
     }
+    case 6:
+    {
+        std::string raw_filename;
+        std::cout << "Enter output video filename (e.g., output.mp4): ";
+        std::cin >> raw_filename;
+
+        int save_interval;
+        std::cout << "Enter frame save interval: ";
+        std::cin >> save_interval;
+
+        std::string output_directory = "output_videos";
+        if (!std::filesystem::exists(output_directory))
+            std::filesystem::create_directories(output_directory);
+
+        video_codec::VideoStream stream = media_file.getVideoStream();
+        if (!stream.getCodecContext())
+        {
+            std::cerr << "Failed to get video stream information" << std::endl;
+            return 1;
+        }
+
+        double fps = stream.getFrameRate() > 0 ? stream.getFrameRate() : 30.0;
+        video_codec::VideoWriterProcessor video_writer(
+            output_directory + "/" + raw_filename, stream.getWidth(), stream.getHeight(), fps);
+        video_codec::FrameSaverProcessor saver(output_dir, save_interval, "jpg");
+
+        // One decode feeds both outputs, which run in parallel
+        video_codec::ProcessingGraph graph;
+        auto encode_node = graph.addNode("encode", video_writer);
+        auto saver_node = graph.addNode("save frames", saver);
+        graph.connect(video_codec::ProcessingGraph::kSource, encode_node);
+        graph.connect(video_codec::ProcessingGraph::kSource, saver_node);
+
+        result = graph.run(media_file, max_frames);
+
+        if (result && !video_writer.finalize())
+        {
+            std::cerr << "Failed to finalize video output" << std::endl;
+            result = false;
+        }
+        break;
+    }
+    case 7:
+    {
+        int num_others;
+        std::cout << "Enter number of videos to append: ";
+        std::cin >> num_others;
+
+        video_codec::MediaConcatenator concatenator;
+        result = concatenator.addInput(input_filename);
+        for (int i = 0; result && i < num_others; ++i)
+        {
+            std::string filename;
+            std::cout << "Enter video filename #" << i + 1 << ": ";
+            std::cin >> filename;
+            result = concatenator.addInput(filename);
+        }
+
+        std::string raw_filename;
+        std::cout << "Enter output video filename (e.g., joined.mp4): ";
+        std::cin >> raw_filename;
+
+        std::string output_directory = "output_videos";
+        if (!std::filesystem::exists(output_directory))
+            std::filesystem::create_directories(output_directory);
+
+        // Inputs matching the first one are stream-copied, the rest re-encoded
+        if (result)
+            result = concatenator.concatenate(output_directory + "/" + raw_filename);
+        break;
+    }
+    case 8:
+    {
+        std::string second_filename;
+        std::cout << "Enter second video filename: ";
+        std::cin >> second_filename;
+
+        int type;
+        std::cout << "Select transition (1: cross-dissolve, 2: fade through black): ";
+        std::cin >> type;
+
+        video_codec::TransitionOptions options;
+        options.type = type == 2 ? video_codec::TransitionType::FadeThroughBlack
+                                 : video_codec::TransitionType::CrossDissolve;
+        std::cout << "Enter transition duration in seconds: ";
+        std::cin >> options.duration;
+
+        std::string raw_filename;
+        std::cout << "Enter output video filename (e.g., transition.mp4): ";
+        std::cin >> raw_filename;
+
+        std::string output_directory = "output_videos";
+        if (!std::filesystem::exists(output_directory))
+            std::filesystem::create_directories(output_directory);
+
+        // Only the GOPs around the overlap are decoded and re-encoded
+        video_codec::TransitionRenderer renderer;
+        result = renderer.render(input_filename, second_filename,
+                                 output_directory + "/" + raw_filename, options);
+        break;
+    }
+    case 9:
+    {
+        int audio_index = media_file.findAudioStreamIndex();
+        if (audio_index < 0)
+        {
+            std::cerr << "Input has no audio stream" << std::endl;
+            return 1;
+        }
+
+        std::string raw_filename;
+        std::cout << "Enter output video filename (e.g., output.mp4): ";
+        std::cin >> raw_filename;
+
+        double gain_db;
+        std::cout << "Enter volume adjustment in dB (0 keeps the volume): ";
+        std::cin >> gain_db;
+
+        double reduction_db;
+        std::cout << "Enter noise reduction in dB (0 disables it): ";
+        std::cin >> reduction_db;
+
+        std::string bgm_filename;
+        std::cout << "Enter BGM filename (- for none): ";
+        std::cin >> bgm_filename;
+
+        double bgm_gain_db = -6.0;
+        if (bgm_filename != "-")
+        {
+            std::cout << "Enter BGM level in dB (e.g., -12): ";
+            std::cin >> bgm_gain_db;
+        }
+
+        std::string output_directory = "output_videos";
+        if (!std::filesystem::exists(output_directory))
+            std::filesystem::create_directories(output_directory);
+
+        video_codec::VideoStream stream = media_file.getVideoStream();
+        if (!stream.getCodecContext())
+        {
+            std::cerr << "Failed to get video stream information" << std::endl;
+            return 1;
+        }
+
+        // Processed audio is re-encoded at the source rate and channel count
+        const AVCodecParameters *audio_params = media_file.getFormatContext()->streams[audio_index]->codecpar;
+        video_codec::AudioOutputSettings audio;
+        audio.mode = video_codec::AudioOutputSettings::Mode::Encode;
+        audio.sample_rate = audio_params->sample_rate;
+        audio.channels = audio_params->ch_layout.nb_channels;
+        audio.start_time = media_file.getVideoStartTime();
+        if (media_file.getFormatContext()->start_time != AV_NOPTS_VALUE)
+            audio.frame_start_time = media_file.getFormatContext()->start_time;
+
+        double fps = stream.getFrameRate() > 0 ? stream.getFrameRate() : 30.0;
+        video_codec::VideoWriterProcessor video_writer(
+            output_directory + "/" + raw_filename, stream.getWidth(), stream.getHeight(), fps, "libx264", audio);
+
+        // gain -> noise reduction -> BGM (ducked under the program) -> limiter -> writer
+        // Noise reduction delays its output, so it pushes blocks into the
+        // rest of the chain itself instead of working in place.
+        video_codec::GainProcessor gain(gain_db);
+        std::unique_ptr<video_codec::NoiseReductionProcessor> denoise;
+        std::unique_ptr<video_codec::BgmMixProcessor> bgm;
+        video_codec::LimiterProcessor limiter;
+
+        video_codec::AudioProcessorChain output_chain;
+        if (bgm_filename != "-")
+        {
+            bgm = std::make_unique<video_codec::BgmMixProcessor>(bgm_filename, bgm_gain_db);
+            output_chain.add(*bgm);
+        }
+        output_chain.add(limiter);
+        output_chain.add(video_writer);
+
+        video_codec::AudioProcessorChain audio_chain;
+        audio_chain.add(gain);
+        if (reduction_db > 0.0)
+        {
+            video_codec::NoiseReductionSettings settings;
+            settings.reduction_db = reduction_db;
+            denoise = std::make_unique<video_codec::NoiseReductionProcessor>(settings, &output_chain);
+            audio_chain.add(*denoise);
+        }
+        else
+            audio_chain.add(output_chain);
+
+        result = media_file.processMediaFrames(video_writer, audio_chain, max_frames);
+
+        if (result && !video_writer.finalize())
+        {
+            std::cerr << "Failed to finalize video output" << std::endl;
+            result = false;
+        }
+        break;
+    }
     default:
         std::cerr << "Invalid option" << std::endl;
         return 1;
     }
 
+    finishProfiling(profiling);
+
     if (!result)
     {
         std::cerr << "Frame processing failed" << std::endl;
@@ -0,0 +1,192 @@
+#include <media/abr_ladder.h>
+#include <graph/processing_graph.h>
+#include <media/media_file.h>
+#include <media/video_stream.h>
+#include <processing/scale_processor.h>
+#include <processing/video_writer_processor.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace video_codec
+{
+    bool AbrLadderEncoder::encode(const std::string &input_filename, const std::string &output_directory,
+                                  const LadderOptions &options)
+    {
+        renditions_.clear();
+
+        unsigned budget = options.threads > 0 ? static_cast<unsigned>(options.threads)
+                                              : std::max(1u, std::thread::hardware_concurrency());
+
+        MediaFile file;
+        if (!file.open(input_filename))
+        {
+            setError("Could not open " + input_filename);
+            return false;
+        }
+
+        VideoStream stream = file.getVideoStream();
+        if (!stream.getCodecContext())
+        {
+            setError("No video stream in " + input_filename);
+            return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::create_directories(output_directory, ec);
+        if (!planRenditions(stream.getWidth(), stream.getHeight(), output_directory, options))
+            return false;
+
+        double fps = stream.getFrameRate() > 0 ? stream.getFrameRate() : 30.0;
+
+        // Graph workers run one node each at a time; the rest of the budget is
+        // shared by the decoder and the encoders, at least one thread each
+        size_t graph_threads = std::clamp<size_t>(budget / 2, 1, renditions_.size());
+        int encoder_threads = static_cast<int>(std::max<size_t>(1, (budget - graph_threads) / (renditions_.size() + 1)));
+        file.setDecoderThreads(encoder_threads);
+        file.setFrameBatchSize(16);
+
+        VideoEncodeSettings encode;
+        encode.keyframe_interval = options.keyframe_interval;
+
+        // Writers open their outputs on construction
+        std::vector<std::unique_ptr<VideoWriterProcessor>> writers;
+        std::vector<std::unique_ptr<ScaleProcessor>> scalers;
+        ProcessingGraph graph(static_cast<unsigned>(graph_threads));
+
+        ProcessingGraph::NodeId parent = ProcessingGraph::kSource;
+        for (const Rendition &rendition : renditions_)
+        {
+            encode.bit_rate = rendition.bit_rate;
+            writers.push_back(std::make_unique<VideoWriterProcessor>(rendition.filename, rendition.width, rendition.height, fps,
+                                                                     options.codec, AudioOutputSettings{}, encoder_threads,
+                                                                     options.segmented, encode));
+            std::string name = std::to_string(rendition.height) + "p";
+
+            // Cascade: each smaller rung is scaled from the previous one
+            if (rendition.width != stream.getWidth() || rendition.height != stream.getHeight())
+            {
+                scalers.push_back(std::make_unique<ScaleProcessor>(rendition.width, rendition.height));
+                ProcessingGraph::NodeId scale = graph.addNode("scale " + name, *scalers.back());
+                scalers.back()->setNextProcessor(graph.outputOf(scale));
+                graph.connect(parent, scale);
+                parent = scale;
+            }
+
+            ProcessingGraph::NodeId writer = graph.addNode("encode " + name, *writers.back());
+            graph.connect(parent, writer);
+        }
+
+        bool result = graph.run(file, options.max_frames);
+
+        for (auto &writer : writers)
+        {
+            if (!writer->finalize())
+            {
+                setError("Failed to finalize rendition: " + writer->getLastError());
+                result = false;
+            }
+        }
+
+        if (result && options.segmented.mode == SegmentedOutputSettings::Mode::Hls)
+            result = writeMasterPlaylist((std::filesystem::path(output_directory) / "master.m3u8").string(), fps, options);
+
+        if (result)
+            std::cout << "Encoded " << renditions_.size() << " renditions into " << output_directory << std::endl;
+        return result;
+    }
+
+    bool AbrLadderEncoder::planRenditions(int source_width, int source_height, const std::string &output_directory,
+                                          const LadderOptions &options)
+    {
+        if (source_width <= 0 || source_height <= 0)
+        {
+            setError("Invalid source size");
+            return false;
+        }
+
+        // Every DASH muxer writes a manifest of its own rendition only, so
+        // players would see separate streams instead of a ladder
+        if (options.segmented.mode == SegmentedOutputSettings::Mode::Dash)
+        {
+            setError("DASH ladders are not supported; use HLS, whose master playlist lists the renditions");
+            return false;
+        }
+
+        const char *extension = options.segmented.mode == SegmentedOutputSettings::Mode::Hls ? ".m3u8" : ".mp4";
+
+        // Tallest first: the cascade scales every rung from the previous one.
+        // Scaled rungs are even for YUV 4:2:0, so duplicates are removed
+        // after rounding.
+        std::vector<std::pair<int, int64_t>> rungs;
+        for (size_t i = 0; i < options.heights.size(); ++i)
+        {
+            int64_t bit_rate = i < options.bit_rates.size() ? options.bit_rates[i] : 0;
+            int height = options.heights[i];
+            if (height <= 0 || height > source_height)
+                continue;
+            if (height != source_height)
+                height = std::max(2, height & ~1);
+            rungs.emplace_back(height, bit_rate);
+        }
+        if (rungs.empty())
+            rungs.emplace_back(source_height, 0);
+
+        std::sort(rungs.begin(), rungs.end(), std::greater<>());
+        rungs.erase(std::unique(rungs.begin(), rungs.end(), [](const auto &a, const auto &b)
+                                { return a.first == b.first; }),
+                    rungs.end());
+
+        for (const auto &[height, bit_rate] : rungs)
+        {
+            Rendition rendition;
+            rendition.height = height;
+
+            // Keep the aspect ratio; YUV 4:2:0 needs even sizes
+            rendition.width = static_cast<int>(static_cast<int64_t>(source_width) * height / source_height);
+            if (height != source_height)
+                rendition.width = std::max(2, rendition.width & ~1);
+            else
+                rendition.width = source_width;
+
+            rendition.bit_rate = bit_rate > 0 ? bit_rate : static_cast<int64_t>(rendition.width) * rendition.height * 4;
+            rendition.filename = (std::filesystem::path(output_directory) / (std::to_string(rendition.height) + "p" + extension)).string();
+            renditions_.push_back(rendition);
+        }
+        return true;
+    }
+
+    bool AbrLadderEncoder::writeMasterPlaylist(const std::string &filename, double fps, const LadderOptions &options)
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            setError("Could not write master playlist: " + filename);
+            return false;
+        }
+
+        // fMP4 segments need playlist version 7
+        out << "#EXTM3U\n"
+            << "#EXT-X-VERSION:" << (options.segmented.hls_mpegts ? 3 : 7) << "\n"
+            << "#EXT-X-INDEPENDENT-SEGMENTS\n";
+        for (const Rendition &rendition : renditions_)
+        {
+            out << "#EXT-X-STREAM-INF:BANDWIDTH=" << rendition.bit_rate
+                << ",RESOLUTION=" << rendition.width << "x" << rendition.height
+                << ",FRAME-RATE=" << fps << "\n"
+                << std::filesystem::path(rendition.filename).filename().string() << "\n";
+        }
+
+        return static_cast<bool>(out);
+    }
+
+    void AbrLadderEncoder::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
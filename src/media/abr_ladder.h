@@ -0,0 +1,77 @@
+#pragma once
+
+#include <media/video_writer.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    struct LadderOptions
+    {
+        // Rendition heights; heights above the source are dropped
+        std::vector<int> heights{2160, 1080, 720, 480};
+
+        // Video bit rate per rendition in bits per second, in the order of
+        // heights; missing or 0 entries use the VideoWriter default
+        std::vector<int64_t> bit_rates;
+
+        std::string codec{"libx264"};
+
+        // Keyframe interval of every rendition in seconds; segmented outputs
+        // use the segment duration instead
+        double keyframe_interval{2.0};
+
+        // One file per rendition, or fMP4/HLS segments. HLS also gets a
+        // master playlist over the renditions; DASH is rejected, since its
+        // muxer writes one manifest per rendition.
+        SegmentedOutputSettings segmented;
+
+        int threads{0};      // Graph workers, decoder and encoder threads in total (at least one each), 0 uses the hardware concurrency
+        int max_frames{-1};
+    };
+
+    struct Rendition
+    {
+        int width{0};
+        int height{0};
+        int64_t bit_rate{0}; // Nominal video bit rate (bits per second)
+        std::string filename;
+    };
+
+    // Adaptive bitrate ladder from a single decode.
+    //
+    // Decoded frames go through a ProcessingGraph: every rendition has its
+    // own VideoWriterProcessor node, and the scaled sizes are produced by a
+    // chain of ScaleProcessor nodes, each rung scaled from the one above
+    // (cascaded downscaling), so the expensive full-size scale runs once.
+    // All renditions force keyframes at the same frame numbers, which keeps
+    // their GOPs and segments aligned for switching between them.
+    class AbrLadderEncoder
+    {
+    public:
+        AbrLadderEncoder() = default;
+
+        // Not Allowed to copy
+        AbrLadderEncoder(const AbrLadderEncoder &) = delete;
+        AbrLadderEncoder &operator=(const AbrLadderEncoder &) = delete;
+
+        // Encode input into output_directory: <height>p.mp4, or .m3u8 with
+        // master.m3u8, depending on options.segmented
+        bool encode(const std::string &input_filename, const std::string &output_directory,
+                    const LadderOptions &options = {});
+
+        const std::vector<Rendition> &getRenditions() const { return renditions_; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        std::vector<Rendition> renditions_;
+        std::string last_error_;
+
+        bool planRenditions(int source_width, int source_height, const std::string &output_directory,
+                            const LadderOptions &options);
+        bool writeMasterPlaylist(const std::string &filename, double fps, const LadderOptions &options);
+
+        void setError(const std::string &message);
+    };
+}
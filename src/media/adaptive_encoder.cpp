@@ -0,0 +1,258 @@
+#include <media/adaptive_encoder.h>
+#include <graph/thread_pool.h>
+#include <media/media_concat.h>
+#include <media/media_cut.h>
+#include <media/media_file.h>
+#include <media/video_stream.h>
+#include <processing/scene_complexity_processor.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Complexity floor for black or blank scenes, keeps log2() finite
+        constexpr double kMinComplexity = 0.01;
+
+        // Segment being collected from consecutive scenes
+        struct PlannedSegment
+        {
+            double start{0.0};
+            double length{0.0};
+            int64_t frames{0};
+            double complexity_sum{0.0}; // Weighted by frames
+        };
+    }
+
+    bool AdaptiveEncoder::analyze(const std::string &input_filename, const AdaptiveEncodeOptions &options)
+    {
+        segments_.clear();
+        analyzed_filename_.clear();
+
+        MediaFile file;
+        if (!file.open(input_filename))
+        {
+            setError("Could not open " + input_filename);
+            return false;
+        }
+
+        AVFormatContext *ctx = file.getFormatContext();
+        int index = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        VideoStream stream;
+        stream.setLowres(options.analysis_lowres);
+        if (index < 0 || !stream.initialize(ctx, index, options.threads))
+        {
+            setError("No decodable video stream in " + input_filename);
+            return false;
+        }
+
+        SceneComplexityProcessor analyzer(stream.getTimeBase(), options.scenes);
+        if (!stream.processNativeFrames(analyzer))
+        {
+            setError(analyzer.getLastError().empty() ? "Pre-pass failed on " + input_filename : analyzer.getLastError());
+            return false;
+        }
+        analyzer.finish();
+
+        const std::vector<SceneComplexity> &scenes = analyzer.getScenes();
+        if (scenes.empty())
+        {
+            setError("No frames to encode in " + input_filename);
+            return false;
+        }
+
+        // Cut times relative to the input start, half a frame early so that
+        // rounding never moves the first frame of a scene into the previous segment
+        double file_start = ctx->start_time != AV_NOPTS_VALUE ? static_cast<double>(ctx->start_time) / AV_TIME_BASE : 0.0;
+        double half_frame = stream.getFrameRate() > 0 ? 0.5 / stream.getFrameRate() : 0.0;
+
+        std::vector<PlannedSegment> planned;
+        for (const SceneComplexity &scene : scenes)
+        {
+            bool split = !planned.empty() && planned.back().length >= options.min_segment_length &&
+                         scene.duration >= options.min_segment_length;
+            if (planned.empty() || split)
+            {
+                PlannedSegment segment;
+                segment.start = planned.empty() ? 0.0 : std::max(scene.start - file_start - half_frame, 0.0);
+                planned.push_back(segment);
+            }
+
+            PlannedSegment &segment = planned.back();
+            segment.length += scene.duration;
+            segment.frames += scene.frames;
+            segment.complexity_sum += std::max(scene.complexity, kMinComplexity) * static_cast<double>(scene.frames);
+        }
+
+        // Average complexity of the input: geometric mean over frames
+        double log_sum = 0.0;
+        int64_t frames = 0;
+        for (const PlannedSegment &segment : planned)
+        {
+            if (segment.frames == 0)
+                continue;
+            log_sum += std::log2(segment.complexity_sum / static_cast<double>(segment.frames)) * static_cast<double>(segment.frames);
+            frames += segment.frames;
+        }
+        double average = frames > 0 ? log_sum / static_cast<double>(frames) : 0.0;
+
+        for (size_t i = 0; i < planned.size(); ++i)
+        {
+            EncodeSegment segment;
+            segment.start = planned[i].start;
+            segment.duration = i + 1 < planned.size() ? planned[i + 1].start - planned[i].start : 0.0;
+            segment.frames = planned[i].frames;
+            segment.complexity = planned[i].frames > 0 ? planned[i].complexity_sum / static_cast<double>(planned[i].frames) : kMinComplexity;
+
+            long offset = std::lround(options.strength * (std::log2(segment.complexity) - average));
+            offset = std::clamp<long>(offset, -options.crf_range, options.crf_range);
+            segment.crf = std::max(options.crf + static_cast<int>(offset), 0);
+            segments_.push_back(segment);
+        }
+
+        analyzed_filename_ = input_filename;
+        std::cout << "Planned " << segments_.size() << " segments from " << scenes.size() << " scenes" << std::endl;
+        return true;
+    }
+
+    bool AdaptiveEncoder::encode(const std::string &input_filename, const std::string &output_filename,
+                                 const AdaptiveEncodeOptions &options)
+    {
+        if (analyzed_filename_ != input_filename && !analyze(input_filename, options))
+            return false;
+
+        std::filesystem::path directory = options.work_directory.empty() ? std::filesystem::path(output_filename + ".segments")
+                                                                         : std::filesystem::path(options.work_directory);
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            setError("Could not create segment directory " + directory.string());
+            return false;
+        }
+
+        char name[32];
+        for (size_t i = 0; i < segments_.size(); ++i)
+        {
+            std::snprintf(name, sizeof(name), "segment_%04zu.ts", i);
+            segments_[i].filename = (directory / name).string();
+        }
+
+        bool result = encodeSegments(input_filename, options);
+        if (result)
+        {
+            MediaConcatenator concatenator;
+            for (const EncodeSegment &segment : segments_)
+            {
+                if (!concatenator.addInput(segment.filename))
+                {
+                    result = false;
+                    break;
+                }
+            }
+
+            ConcatOptions concat_options;
+            concat_options.allow_reencode = false;
+            concat_options.ignore_extradata = true;
+            if (result && !concatenator.concatenate(output_filename, concat_options))
+                result = false;
+            if (!result)
+                setError(concatenator.getLastError().empty() ? "Could not join the segments" : concatenator.getLastError());
+        }
+
+        if (!options.keep_segments)
+        {
+            for (const EncodeSegment &segment : segments_)
+                std::filesystem::remove(segment.filename, ec);
+            std::filesystem::remove(directory, ec); // Only when empty
+        }
+
+        if (result)
+            std::cout << "Encoded " << segments_.size() << " segments into " << output_filename << std::endl;
+        return result;
+    }
+
+    bool AdaptiveEncoder::encodeSegments(const std::string &input_filename, const AdaptiveEncodeOptions &options)
+    {
+        // Many small encoders scale better than a few wide ones
+        unsigned budget = options.threads > 0 ? static_cast<unsigned>(options.threads)
+                                              : std::max(1u, std::thread::hardware_concurrency());
+        unsigned parallel = options.parallel_segments > 0 ? static_cast<unsigned>(options.parallel_segments)
+                                                          : std::max(1u, budget / 2);
+        parallel = std::min<unsigned>(parallel, static_cast<unsigned>(segments_.size()));
+        int segment_threads = static_cast<int>(std::max(1u, budget / parallel));
+
+        std::vector<char> succeeded(segments_.size(), 0);
+        auto encodeSegment = [&](size_t i)
+        {
+            EncodeSegment &segment = segments_[i];
+
+            CutOptions cut_options;
+            cut_options.stream_copy = false;
+            cut_options.encoder_name = options.encoder_name;
+            cut_options.threads = segment_threads;
+            cut_options.bit_rate = 0;
+            cut_options.max_bit_rate = options.max_bit_rate;
+            cut_options.encoder_options = {{"preset", options.preset}, {"crf", std::to_string(segment.crf)}};
+
+            MediaCutter cutter;
+            if (cutter.cut(input_filename, segment.filename, segment.start, segment.duration, cut_options))
+            {
+                std::error_code ec;
+                std::uintmax_t bytes = std::filesystem::file_size(segment.filename, ec);
+                segment.bytes = ec ? 0 : static_cast<int64_t>(bytes);
+                succeeded[i] = 1;
+            }
+        };
+
+        std::cout << "Encoding " << segments_.size() << " segments, " << parallel << " at a time with "
+                  << segment_threads << " threads each" << std::endl;
+
+        if (parallel <= 1)
+        {
+            for (size_t i = 0; i < segments_.size(); ++i)
+                encodeSegment(i);
+        }
+        else
+        {
+            // The calling thread encodes segments too
+            ThreadPool pool(parallel - 1);
+            std::atomic<size_t> remaining{segments_.size()};
+            for (size_t i = 0; i < segments_.size(); ++i)
+            {
+                pool.submit([&, i]
+                            {
+                                encodeSegment(i);
+                                remaining.fetch_sub(1, std::memory_order_release); });
+            }
+
+            while (remaining.load(std::memory_order_acquire) > 0)
+            {
+                if (!pool.runPendingTask())
+                    std::this_thread::yield();
+            }
+        }
+
+        for (size_t i = 0; i < segments_.size(); ++i)
+        {
+            if (!succeeded[i])
+            {
+                setError("Could not encode segment " + std::to_string(i) + " at " + std::to_string(segments_[i].start) + "s");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void AdaptiveEncoder::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
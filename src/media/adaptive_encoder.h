@@ -0,0 +1,84 @@
+#pragma once
+
+#include <processing/scene_detect_processor.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    struct AdaptiveEncodeOptions
+    {
+        std::string encoder_name{"libx264"}; // Any encoder with a crf option (libx264, libx265, libvpx-vp9, ...)
+        std::string preset{"medium"};
+        int crf{23};                // CRF of a scene of average complexity
+        int crf_range{4};           // Largest change of the CRF of one segment
+        double strength{2.0};       // CRF steps per doubling of the complexity against the average
+        int64_t max_bit_rate{0};    // VBV cap of every segment in bits per second, 0 for none
+        double min_segment_length{2.0}; // Seconds; shorter scenes join the previous segment
+
+        SceneDetectOptions scenes;
+        int analysis_lowres{1};     // Pre-pass decodes at 1/2^N size where the codec supports it
+
+        int threads{0};             // Thread budget of the whole encode, 0 uses the hardware concurrency
+        int parallel_segments{0};   // Segments encoded at once, 0 derives it from threads
+        std::string work_directory; // Segment files; empty uses <output>.segments
+        bool keep_segments{false};
+    };
+
+    // One independently encoded range of the input
+    struct EncodeSegment
+    {
+        double start{0.0};    // Seconds from the start of the input
+        double duration{0.0}; // 0 runs to the end of the input
+        int64_t frames{0};
+        double complexity{0.0};
+        int crf{0};
+        std::string filename;
+        int64_t bytes{0}; // Encoded size, set by encode()
+    };
+
+    // Constant-quality encode with per-scene rate control.
+    //
+    // A low resolution pre-pass splits the input into scenes and measures
+    // their complexity (SceneComplexityProcessor). Every segment then gets
+    // its own CRF around the base value: busy, high-motion scenes hide
+    // artifacts and cost the most bits, so they get a higher CRF; flat,
+    // static ones show banding and blocking first and are cheap, so they
+    // get a lower one.
+    //
+    // Segments start on scene cuts and are encoded in parallel with a
+    // frame-accurate MediaCutter re-encode each (audio stream-copied), into
+    // MPEG-TS files that carry their codec headers in-band. The segments
+    // are then joined by stream copy with MediaConcatenator; their headers
+    // differ only in rate control parameters, which is why extradata is
+    // not compared.
+    class AdaptiveEncoder
+    {
+    public:
+        AdaptiveEncoder() = default;
+
+        // Not Allowed to copy
+        AdaptiveEncoder(const AdaptiveEncoder &) = delete;
+        AdaptiveEncoder &operator=(const AdaptiveEncoder &) = delete;
+
+        // Pre-pass only: fill getSegments() with the ranges and their CRFs
+        bool analyze(const std::string &input_filename, const AdaptiveEncodeOptions &options = {});
+
+        // Analyze (unless analyze() ran on the same input), encode the segments and join them into output
+        bool encode(const std::string &input_filename, const std::string &output_filename,
+                    const AdaptiveEncodeOptions &options = {});
+
+        const std::vector<EncodeSegment> &getSegments() const { return segments_; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        std::string analyzed_filename_;
+        std::vector<EncodeSegment> segments_;
+        std::string last_error_;
+
+        bool encodeSegments(const std::string &input_filename, const AdaptiveEncodeOptions &options);
+
+        void setError(const std::string &message);
+    };
+}
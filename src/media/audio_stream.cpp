@@ -0,0 +1,361 @@
+#include <media/audio_stream.h>
+#include <processing/audio_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <iostream>
+
+namespace video_codec
+{
+    AudioStream::~AudioStream()
+    {
+        cleanup();
+    }
+
+    AudioStream::AudioStream(AudioStream &&other) noexcept
+        : format_ctx_(other.format_ctx_),
+          codec_ctx_(other.codec_ctx_),
+          stream_index_(other.stream_index_),
+          sample_rate_(other.sample_rate_),
+          ch_layout_(other.ch_layout_),
+          frame_(other.frame_),
+          swr_ctx_(other.swr_ctx_),
+          next_pts_(other.next_pts_),
+          started_(other.started_)
+    {
+        other.format_ctx_ = nullptr;
+        other.codec_ctx_ = nullptr;
+        other.ch_layout_ = AVChannelLayout{};
+        other.frame_ = nullptr;
+        other.swr_ctx_ = nullptr;
+    }
+
+    AudioStream &AudioStream::operator=(AudioStream &&other) noexcept
+    {
+        if (this != &other)
+        {
+            cleanup();
+
+            format_ctx_ = other.format_ctx_;
+            codec_ctx_ = other.codec_ctx_;
+            stream_index_ = other.stream_index_;
+            sample_rate_ = other.sample_rate_;
+            ch_layout_ = other.ch_layout_;
+            frame_ = other.frame_;
+            swr_ctx_ = other.swr_ctx_;
+            next_pts_ = other.next_pts_;
+            started_ = other.started_;
+
+            other.format_ctx_ = nullptr;
+            other.codec_ctx_ = nullptr;
+            other.ch_layout_ = AVChannelLayout{};
+            other.frame_ = nullptr;
+            other.swr_ctx_ = nullptr;
+        }
+        return *this;
+    }
+
+    bool AudioStream::initialize(AVFormatContext *format_ctx, int stream_index, int sample_rate, int channels)
+    {
+        cleanup();
+
+        if (!format_ctx || stream_index < 0 ||
+            static_cast<unsigned int>(stream_index) >= format_ctx->nb_streams)
+        {
+            std::cerr << "Invalid format context or stream index" << std::endl;
+            return false;
+        }
+
+        format_ctx_ = format_ctx;
+        stream_index_ = stream_index;
+
+        // Find and open decoder
+        AVStream *stream = format_ctx_->streams[stream_index_];
+        const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+        if (!codec)
+        {
+            std::cerr << "Codec not found for stream" << stream_index_ << std::endl;
+            return false;
+        }
+
+        codec_ctx_ = avcodec_alloc_context3(codec);
+        if (!codec_ctx_)
+        {
+            std::cerr << "Could not allocate codec context" << std::endl;
+            return false;
+        }
+
+        if (avcodec_parameters_to_context(codec_ctx_, stream->codecpar) < 0)
+        {
+            std::cerr << "Could not copy codec params to context" << std::endl;
+            avcodec_free_context(&codec_ctx_);
+            return false;
+        }
+
+        codec_ctx_->pkt_timebase = stream->time_base;
+
+        if (avcodec_open2(codec_ctx_, codec, nullptr) < 0)
+        {
+            std::cerr << "Could not open codec" << std::endl;
+            avcodec_free_context(&codec_ctx_);
+            return false;
+        }
+
+        // Output format
+        sample_rate_ = sample_rate > 0 ? sample_rate : codec_ctx_->sample_rate;
+        if (channels > 0)
+            av_channel_layout_default(&ch_layout_, channels);
+        else if (av_channel_layout_copy(&ch_layout_, &codec_ctx_->ch_layout) < 0)
+        {
+            std::cerr << "Could not copy channel layout" << std::endl;
+            cleanup();
+            return false;
+        }
+
+        frame_ = av_frame_alloc();
+        if (!frame_)
+        {
+            std::cerr << "Could not allocate frame" << std::endl;
+            cleanup();
+            return false;
+        }
+
+        if (!initializeResampler())
+        {
+            cleanup();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AudioStream::initializeResampler()
+    {
+        if (codec_ctx_->sample_fmt == AV_SAMPLE_FMT_FLTP &&
+            codec_ctx_->sample_rate == sample_rate_ &&
+            av_channel_layout_compare(&codec_ctx_->ch_layout, &ch_layout_) == 0)
+            return true;
+
+        int ret = swr_alloc_set_opts2(&swr_ctx_,
+                                      &ch_layout_, AV_SAMPLE_FMT_FLTP, sample_rate_,
+                                      &codec_ctx_->ch_layout, codec_ctx_->sample_fmt, codec_ctx_->sample_rate,
+                                      0, nullptr);
+        if (ret < 0 || swr_init(swr_ctx_) < 0)
+        {
+            std::cerr << "Could not initialize audio resampler" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AudioStream::deliverFrame(AudioProcessor &processor, const AVFrame *decoded)
+    {
+        // Audio that starts late keeps its offset to the start of the file
+        if (!started_ && decoded)
+        {
+            started_ = true;
+
+            int64_t ts = decoded->best_effort_timestamp;
+            int64_t start = format_ctx_->start_time != AV_NOPTS_VALUE
+                                ? av_rescale_q(format_ctx_->start_time, AV_TIME_BASE_Q, format_ctx_->streams[stream_index_]->time_base)
+                                : 0;
+            if (ts != AV_NOPTS_VALUE && ts > start)
+                next_pts_ = av_rescale_q(ts - start, format_ctx_->streams[stream_index_]->time_base, getTimeBase());
+        }
+
+        FramePtr out;
+        if (!swr_ctx_)
+        {
+            if (!decoded)
+                return true;
+
+            // The decoder output is already planar float; take over its buffers
+            out = refFrame(decoded);
+            if (!out || av_frame_make_writable(out.get()) < 0)
+            {
+                std::cerr << "Could not reference audio frame" << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            out = makeFrame();
+            if (!out)
+            {
+                std::cerr << "Could not allocate audio frame" << std::endl;
+                return false;
+            }
+
+            // Room for the converted samples plus what the resampler buffered
+            out->format = AV_SAMPLE_FMT_FLTP;
+            out->sample_rate = sample_rate_;
+            out->nb_samples = swr_get_out_samples(swr_ctx_, decoded ? decoded->nb_samples : 0);
+            if (out->nb_samples <= 0)
+                return true;
+
+            if (av_channel_layout_copy(&out->ch_layout, &ch_layout_) < 0 ||
+                av_frame_get_buffer(out.get(), 0) < 0)
+            {
+                std::cerr << "Could not allocate audio frame buffer" << std::endl;
+                return false;
+            }
+
+            static StageMetrics &resample_metrics = PipelineMetrics::instance().stage("audio resample");
+            int converted = timeStage(resample_metrics, [&]
+                                      { return swr_convert(swr_ctx_, out->extended_data, out->nb_samples,
+                                                           decoded ? const_cast<const uint8_t **>(decoded->extended_data) : nullptr,
+                                                           decoded ? decoded->nb_samples : 0); });
+            if (converted < 0)
+            {
+                std::cerr << "Error during audio resampling" << std::endl;
+                return false;
+            }
+            if (converted == 0)
+                return true;
+
+            out->nb_samples = converted;
+        }
+
+        out->pts = next_pts_;
+        out->time_base = getTimeBase();
+        next_pts_ += out->nb_samples;
+
+        static StageMetrics &process_metrics = PipelineMetrics::instance().stage("audio process");
+        process_metrics.addFrames(1);
+        return timeStage(process_metrics, [&]
+                         { return processor.processAudioFrame(out.get()); });
+    }
+
+    bool AudioStream::decodePacket(const AVPacket *packet, AudioProcessor &processor)
+    {
+        if (!codec_ctx_)
+        {
+            std::cerr << "AudioStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        static StageMetrics &decode_metrics = PipelineMetrics::instance().stage("audio decode");
+
+        int ret = timeStage(decode_metrics, [&]
+                            { return avcodec_send_packet(codec_ctx_, packet); });
+        if (ret < 0 && !(packet == nullptr && ret == AVERROR_EOF))
+        {
+            std::cerr << "Error sending audio packet for decoding" << std::endl;
+            return false;
+        }
+
+        while (true)
+        {
+            ret = timeStage(decode_metrics, [&]
+                            { return avcodec_receive_frame(codec_ctx_, frame_); });
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+            {
+                std::cerr << "Error during audio decoding" << std::endl;
+                return false;
+            }
+            decode_metrics.addFrames(1);
+
+            bool ok = deliverFrame(processor, frame_);
+            av_frame_unref(frame_);
+            if (!ok)
+            {
+                std::cerr << "Audio processing error" << std::endl;
+                return false;
+            }
+        }
+
+        // Samples still buffered in the resampler
+        if (!packet && swr_ctx_ && !deliverFrame(processor, nullptr))
+        {
+            std::cerr << "Audio processing error during flushing" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool AudioStream::processFrames(AudioProcessor &processor)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "AudioStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        AVPacket *packet = av_packet_alloc();
+        if (!packet)
+        {
+            std::cerr << "Could not allocate packet" << std::endl;
+            return false;
+        }
+
+        // Seek to the beginning of the stream
+        av_seek_frame(format_ctx_, stream_index_, 0, AVSEEK_FLAG_BACKWARD);
+        avcodec_flush_buffers(codec_ctx_);
+        next_pts_ = 0;
+        started_ = false;
+
+        static StageMetrics &demux_metrics = PipelineMetrics::instance().stage("demux");
+
+        bool result = true;
+        while (result && timeStage(demux_metrics, [&]
+                                   { return av_read_frame(format_ctx_, packet); }) >= 0)
+        {
+            demux_metrics.addBytesRead(packet->size);
+
+            if (packet->stream_index == stream_index_)
+                result = decodePacket(packet, processor);
+
+            av_packet_unref(packet);
+        }
+
+        // Flush the decoder and the processors
+        if (result)
+            result = decodePacket(nullptr, processor);
+        if (!processor.finishAudio())
+            result = false;
+
+        av_packet_free(&packet);
+        std::cout << "Processed " << next_pts_ << " audio samples" << std::endl;
+        return result;
+    }
+
+    bool AudioStream::seek(int64_t timestamp)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "AudioStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        if (av_seek_frame(format_ctx_, stream_index_, timestamp, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            std::cerr << "Could not seek to " << timestamp << std::endl;
+            return false;
+        }
+
+        avcodec_flush_buffers(codec_ctx_);
+        return true;
+    }
+
+    void AudioStream::cleanup()
+    {
+        if (swr_ctx_)
+            swr_free(&swr_ctx_);
+
+        if (frame_)
+            av_frame_free(&frame_);
+
+        if (codec_ctx_)
+            avcodec_free_context(&codec_ctx_);
+
+        av_channel_layout_uninit(&ch_layout_);
+
+        // Note: format_ctx_ is managed externally, so it should not be freed here.
+        format_ctx_ = nullptr;
+        stream_index_ = -1;
+        next_pts_ = 0;
+        started_ = false;
+    }
+}
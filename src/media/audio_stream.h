@@ -0,0 +1,81 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+#include <libswresample/swresample.h>
+}
+
+#include <media/frame_ref.h>
+#include <string>
+
+namespace video_codec
+{
+    class AudioProcessor;
+
+    // Decodes an audio stream to planar float (AV_SAMPLE_FMT_FLTP) frames,
+    // resampled to the requested rate and channel layout
+    class AudioStream
+    {
+    public:
+        AudioStream() = default;
+        ~AudioStream();
+
+        // Not Allowed to copy
+        AudioStream(const AudioStream &) = delete;
+        AudioStream &operator=(const AudioStream &) = delete;
+
+        // Can move
+        AudioStream(AudioStream &&) noexcept;
+        AudioStream &operator=(AudioStream &&) noexcept;
+
+        // Initialize Stream
+        // - sample_rate: output rate, 0 keeps the source rate
+        // - channels: output channel count with the default layout, 0 keeps the source layout
+        bool initialize(AVFormatContext *format_ctx, int stream_index, int sample_rate = 0, int channels = 0);
+
+        // Processing all frames of the stream
+        bool processFrames(AudioProcessor &processor);
+
+        // Packet-level decoding for callers that demux themselves.
+        // nullptr drains the decoder and the resampler.
+        bool decodePacket(const AVPacket *packet, AudioProcessor &processor);
+
+        // Position the stream on timestamp (stream time base), e.g. 0 to loop it.
+        // Output timestamps keep counting up.
+        bool seek(int64_t timestamp);
+
+        // Getter
+        int getSampleRate() const { return sample_rate_; }
+        int getChannels() const { return ch_layout_.nb_channels; }
+        const AVChannelLayout &getChannelLayout() const { return ch_layout_; }
+        AVRational getTimeBase() const { return AVRational{1, sample_rate_ > 0 ? sample_rate_ : 1}; }
+        AVCodecContext *getCodecContext() const { return codec_ctx_; }
+
+    private:
+        AVFormatContext *format_ctx_{nullptr};
+        AVCodecContext *codec_ctx_{nullptr};
+        int stream_index_{-1};
+
+        // Output format
+        int sample_rate_{0};
+        AVChannelLayout ch_layout_{};
+
+        // Resource for processing frames
+        AVFrame *frame_{nullptr};
+        SwrContext *swr_ctx_{nullptr}; // nullptr when the decoder output is used as is
+        int64_t next_pts_{0};          // pts of the next output sample (1/sample_rate)
+        bool started_{false};
+
+        // Create the resampler unless the decoder already produces the output format
+        bool initializeResampler();
+
+        // Convert the decoded frame (nullptr drains the resampler) and hand it over
+        bool deliverFrame(AudioProcessor &processor, const AVFrame *decoded);
+
+        // Free Resource
+        void cleanup();
+    };
+}
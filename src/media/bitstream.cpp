@@ -0,0 +1,97 @@
+#include <media/bitstream.h>
+#include <cstring>
+#include <vector>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Length of the start code at data[pos], 0 if there is none
+        size_t startCodeLength(const uint8_t *data, size_t size, size_t pos)
+        {
+            if (pos + 3 <= size && data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 1)
+                return 3;
+            if (pos + 4 <= size && data[pos] == 0 && data[pos + 1] == 0 && data[pos + 2] == 0 && data[pos + 3] == 1)
+                return 4;
+            return 0;
+        }
+    }
+
+    bool usesLengthPrefixedNals(const AVCodecParameters *codecpar, int &length_size)
+    {
+        // avcC and hvcC both begin with configurationVersion = 1
+        if (!codecpar->extradata || codecpar->extradata_size < 1 || codecpar->extradata[0] != 1)
+            return false;
+
+        if (codecpar->codec_id == AV_CODEC_ID_H264 && codecpar->extradata_size >= 7)
+        {
+            length_size = (codecpar->extradata[4] & 0x03) + 1;
+            return true;
+        }
+
+        if (codecpar->codec_id == AV_CODEC_ID_HEVC && codecpar->extradata_size >= 23)
+        {
+            length_size = (codecpar->extradata[21] & 0x03) + 1;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool convertAnnexBToLengthPrefixed(AVPacket *pkt, int length_size)
+    {
+        const uint8_t *data = pkt->data;
+        size_t size = static_cast<size_t>(pkt->size);
+
+        if (size == 0 || startCodeLength(data, size, 0) == 0)
+            return true; // Already length-prefixed
+
+        std::vector<uint8_t> converted;
+        converted.reserve(size + 16);
+
+        size_t pos = startCodeLength(data, size, 0);
+        while (pos < size)
+        {
+            // Find the start code of the next NAL unit
+            size_t end = pos;
+            size_t code = 0;
+            while (end + 3 <= size && (code = startCodeLength(data, size, end)) == 0)
+                end++;
+
+            size_t next_start = size;
+            if (code > 0)
+                next_start = end + code;
+            else
+                end = size;
+
+            // Trailing zero bytes before a start code are padding
+            size_t nal_end = end;
+            while (code > 0 && nal_end > pos && data[nal_end - 1] == 0)
+                nal_end--;
+
+            size_t nal_size = nal_end - pos;
+            for (int i = length_size - 1; i >= 0; --i)
+                converted.push_back(static_cast<uint8_t>(nal_size >> (8 * i)));
+            converted.insert(converted.end(), data + pos, data + nal_end);
+
+            pos = next_start;
+        }
+
+        AVPacket *out = av_packet_alloc();
+        if (!out)
+            return false;
+
+        if (av_new_packet(out, static_cast<int>(converted.size())) < 0 || av_packet_copy_props(out, pkt) < 0)
+        {
+            av_packet_free(&out);
+            return false;
+        }
+
+        std::memcpy(out->data, converted.data(), converted.size());
+
+        av_packet_unref(pkt);
+        av_packet_move_ref(pkt, out);
+        av_packet_free(&out);
+        return true;
+    }
+}
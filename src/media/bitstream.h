@@ -0,0 +1,22 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace video_codec
+{
+    // Helpers for mixing stream-copied and freshly encoded packets in one track
+
+    // Whether the stream stores H.264/HEVC NAL units with length prefixes
+    // (avcC/hvcC extradata, as in MP4/MKV). On success length_size receives
+    // the size of the prefix in bytes.
+    bool usesLengthPrefixedNals(const AVCodecParameters *codecpar, int &length_size);
+
+    // Rewrite an Annex B packet (start codes, as produced by encoders without
+    // global headers) into length-prefixed NAL units. Parameter sets stay
+    // in-band, so decoders pick them up even if they differ from the extradata.
+    // Packets that do not start with a start code are left untouched.
+    bool convertAnnexBToLengthPrefixed(AVPacket *pkt, int length_size);
+}
@@ -0,0 +1,157 @@
+#include <media/codec_cache.h>
+#include <iostream>
+
+namespace video_codec
+{
+    CodecCache &CodecCache::instance()
+    {
+        static CodecCache cache;
+        return cache;
+    }
+
+    CodecCache::~CodecCache()
+    {
+        clear();
+    }
+
+    SwsContext *CodecCache::acquireScaler(int src_width, int src_height, AVPixelFormat src_format,
+                                          int dst_width, int dst_height, AVPixelFormat dst_format, int flags)
+    {
+        ScalerKey key{src_width, src_height, src_format, dst_width, dst_height, dst_format, flags};
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = idle_scalers_.rbegin(); it != idle_scalers_.rend(); ++it)
+            {
+                if (it->key == key)
+                {
+                    SwsContext *ctx = it->ctx;
+                    idle_scalers_.erase(std::next(it).base());
+                    active_scalers_[ctx] = key;
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    return ctx;
+                }
+            }
+        }
+
+        // Build outside the lock, this is the expensive part
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        SwsContext *ctx = sws_getContext(src_width, src_height, src_format,
+                                         dst_width, dst_height, dst_format,
+                                         flags, nullptr, nullptr, nullptr);
+        if (!ctx)
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_scalers_[ctx] = key;
+        return ctx;
+    }
+
+    void CodecCache::releaseScaler(SwsContext *ctx)
+    {
+        if (!ctx)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = active_scalers_.find(ctx);
+        if (it == active_scalers_.end())
+        {
+            // Not from acquireScaler()
+            sws_freeContext(ctx);
+            return;
+        }
+
+        idle_scalers_.push_back({it->second, ctx});
+        active_scalers_.erase(it);
+        trim();
+    }
+
+    AVCodecContext *CodecCache::acquireImageEncoder(AVCodecID codec_id, int width, int height, AVPixelFormat pix_fmt)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = idle_encoders_.rbegin(); it != idle_encoders_.rend(); ++it)
+            {
+                AVCodecContext *ctx = *it;
+                if (ctx->codec_id == codec_id && ctx->width == width && ctx->height == height && ctx->pix_fmt == pix_fmt)
+                {
+                    idle_encoders_.erase(std::next(it).base());
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    return ctx;
+                }
+            }
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+
+        const AVCodec *codec = avcodec_find_encoder(codec_id);
+        if (!codec)
+        {
+            std::cerr << "Encoder not found: " << avcodec_get_name(codec_id) << std::endl;
+            return nullptr;
+        }
+
+        AVCodecContext *ctx = avcodec_alloc_context3(codec);
+        if (!ctx)
+            return nullptr;
+
+        ctx->width = width;
+        ctx->height = height;
+        ctx->pix_fmt = pix_fmt;
+        ctx->time_base = {1, 25};
+        ctx->compression_level = 5; // Medium compression
+
+        if (avcodec_open2(ctx, codec, nullptr) < 0)
+        {
+            std::cerr << "Could not open encoder " << codec->name << std::endl;
+            avcodec_free_context(&ctx);
+            return nullptr;
+        }
+
+        return ctx;
+    }
+
+    void CodecCache::releaseImageEncoder(AVCodecContext *ctx)
+    {
+        if (!ctx)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_encoders_.push_back(ctx);
+        trim();
+    }
+
+    void CodecCache::setCapacity(size_t idle_contexts)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = idle_contexts;
+        trim();
+    }
+
+    void CodecCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &scaler : idle_scalers_)
+            sws_freeContext(scaler.ctx);
+        idle_scalers_.clear();
+
+        for (AVCodecContext *ctx : idle_encoders_)
+            avcodec_free_context(&ctx);
+        idle_encoders_.clear();
+    }
+
+    void CodecCache::trim()
+    {
+        while (idle_scalers_.size() > capacity_)
+        {
+            sws_freeContext(idle_scalers_.front().ctx);
+            idle_scalers_.pop_front();
+        }
+
+        while (idle_encoders_.size() > capacity_)
+        {
+            avcodec_free_context(&idle_encoders_.front());
+            idle_encoders_.pop_front();
+        }
+    }
+}
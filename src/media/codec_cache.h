@@ -0,0 +1,94 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace video_codec
+{
+    // Process-wide cache of idle scaling contexts and image encoders.
+    //
+    // Building a SwsContext (filter tables) or opening an encoder costs far
+    // more than using it for one frame. Streams, writers and frame savers
+    // hand their contexts back here instead of freeing them, so the next
+    // stream or job with the same parameters - in a long-running job server,
+    // the next request - starts warm. Only stateless contexts are cached:
+    // scalers, and intra-only image encoders (PNG, MJPEG) between frames.
+    // Video encoders and filter graphs carry per-stream state and are still
+    // built per job.
+    class CodecCache
+    {
+    public:
+        static CodecCache &instance();
+
+        // Not Allowed to copy
+        CodecCache(const CodecCache &) = delete;
+        CodecCache &operator=(const CodecCache &) = delete;
+
+        // Scaling context for the conversion, reusing an idle one with the
+        // same parameters. Returns nullptr if it cannot be created.
+        SwsContext *acquireScaler(int src_width, int src_height, AVPixelFormat src_format,
+                                  int dst_width, int dst_height, AVPixelFormat dst_format, int flags);
+
+        // Hand a context from acquireScaler() back (nullptr is ignored)
+        void releaseScaler(SwsContext *ctx);
+
+        // Opened image encoder for frames of the given size and format
+        AVCodecContext *acquireImageEncoder(AVCodecID codec_id, int width, int height, AVPixelFormat pix_fmt);
+
+        // Hand back an encoder whose last frame was fully received.
+        // Encoders left in an unknown state must be freed by the caller instead.
+        void releaseImageEncoder(AVCodecContext *ctx);
+
+        // Idle contexts kept per kind; the least recently released are freed first
+        void setCapacity(size_t idle_contexts);
+
+        // Free every idle context
+        void clear();
+
+        uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+        uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+
+    private:
+        struct ScalerKey
+        {
+            int src_width;
+            int src_height;
+            AVPixelFormat src_format;
+            int dst_width;
+            int dst_height;
+            AVPixelFormat dst_format;
+            int flags;
+
+            bool operator==(const ScalerKey &other) const = default;
+        };
+
+        struct IdleScaler
+        {
+            ScalerKey key;
+            SwsContext *ctx;
+        };
+
+        CodecCache() = default;
+        ~CodecCache();
+
+        void trim();
+
+        std::mutex mutex_;
+        size_t capacity_{8};
+        std::deque<IdleScaler> idle_scalers_;
+        std::unordered_map<SwsContext *, ScalerKey> active_scalers_;
+        std::deque<AVCodecContext *> idle_encoders_;
+
+        std::atomic<uint64_t> hits_{0};
+        std::atomic<uint64_t> misses_{0};
+    };
+}
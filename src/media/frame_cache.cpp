@@ -0,0 +1,86 @@
+#include <media/frame_cache.h>
+
+namespace video_codec
+{
+    namespace
+    {
+        size_t frameBytes(const AVFrame *frame)
+        {
+            size_t bytes = 0;
+            for (AVBufferRef *buffer : frame->buf)
+            {
+                if (buffer)
+                    bytes += buffer->size;
+            }
+            return bytes;
+        }
+    }
+
+    FrameCache::FrameCache(size_t budget_bytes)
+        : budget_bytes_(budget_bytes)
+    {
+    }
+
+    void FrameCache::setBudget(size_t budget_bytes)
+    {
+        budget_bytes_ = budget_bytes;
+        evict();
+    }
+
+    FramePtr FrameCache::find(int64_t timestamp)
+    {
+        // Last frame starting at or before timestamp
+        auto it = entries_.upper_bound(timestamp);
+        if (it == entries_.begin())
+        {
+            ++misses_;
+            return nullptr;
+        }
+        --it;
+
+        if (timestamp >= it->first + it->second.duration)
+        {
+            ++misses_;
+            return nullptr;
+        }
+
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        ++hits_;
+        return refFrame(it->second.frame.get());
+    }
+
+    void FrameCache::insert(const AVFrame *frame, int64_t pts, int64_t duration)
+    {
+        if (entries_.count(pts))
+            return;
+
+        FramePtr reference = refFrame(frame);
+        if (!reference)
+            return;
+
+        size_t bytes = frameBytes(reference.get());
+        lru_.push_front(pts);
+        entries_.emplace(pts, Entry{std::move(reference), duration > 0 ? duration : 1, bytes, lru_.begin()});
+        bytes_ += bytes;
+
+        evict();
+    }
+
+    void FrameCache::clear()
+    {
+        entries_.clear();
+        lru_.clear();
+        bytes_ = 0;
+    }
+
+    void FrameCache::evict()
+    {
+        while (bytes_ > budget_bytes_ && !lru_.empty())
+        {
+            auto it = entries_.find(lru_.back());
+            bytes_ -= it->second.bytes;
+            entries_.erase(it);
+            lru_.pop_back();
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+#include <media/frame_ref.h>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+
+namespace video_codec
+{
+    // Memory-bounded LRU cache of decoded frames of one stream, keyed by
+    // presentation timestamp. Each frame covers [pts, pts + duration), so a
+    // lookup between two frames finds the one on screen at that time.
+    // Cached frames are shared by reference, never copied.
+    // Not thread-safe; it belongs to one VideoStream.
+    class FrameCache
+    {
+    public:
+        explicit FrameCache(size_t budget_bytes = 256 * 1024 * 1024);
+
+        // Not Allowed to copy
+        FrameCache(const FrameCache &) = delete;
+        FrameCache &operator=(const FrameCache &) = delete;
+
+        // Can move
+        FrameCache(FrameCache &&) noexcept = default;
+        FrameCache &operator=(FrameCache &&) noexcept = default;
+
+        // Evicts least recently used frames until the rest fits
+        void setBudget(size_t budget_bytes);
+        size_t getBudget() const { return budget_bytes_; }
+
+        // New reference to the frame shown at timestamp, nullptr on a miss
+        FramePtr find(int64_t timestamp);
+
+        // True if a frame starting at pts is cached (does not touch the LRU order)
+        bool contains(int64_t pts) const { return entries_.count(pts) > 0; }
+
+        // Takes a reference to frame, which must carry its pts
+        void insert(const AVFrame *frame, int64_t pts, int64_t duration);
+
+        void clear();
+
+        // Getter
+        size_t getFrameCount() const { return entries_.size(); }
+        size_t getBytes() const { return bytes_; }
+        uint64_t getHits() const { return hits_; }
+        uint64_t getMisses() const { return misses_; }
+
+    private:
+        struct Entry
+        {
+            FramePtr frame;
+            int64_t duration;
+            size_t bytes;
+            std::list<int64_t>::iterator lru;
+        };
+
+        std::map<int64_t, Entry> entries_;
+        std::list<int64_t> lru_; // Most recently used first
+        size_t budget_bytes_;
+        size_t bytes_{0};
+        uint64_t hits_{0};
+        uint64_t misses_{0};
+
+        void evict();
+    };
+}
@@ -0,0 +1,103 @@
+#include <media/frame_pool.h>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+}
+
+namespace video_codec
+{
+    FramePool::~FramePool()
+    {
+        cleanup();
+    }
+
+    FramePool::FramePool(FramePool &&other) noexcept
+        : pool_(other.pool_),
+          width_(other.width_),
+          height_(other.height_),
+          pix_fmt_(other.pix_fmt_),
+          align_(other.align_)
+    {
+        other.pool_ = nullptr;
+    }
+
+    FramePool &FramePool::operator=(FramePool &&other) noexcept
+    {
+        if (this != &other)
+        {
+            cleanup();
+
+            pool_ = other.pool_;
+            width_ = other.width_;
+            height_ = other.height_;
+            pix_fmt_ = other.pix_fmt_;
+            align_ = other.align_;
+
+            other.pool_ = nullptr;
+        }
+        return *this;
+    }
+
+    bool FramePool::initialize(int width, int height, AVPixelFormat pix_fmt, int align)
+    {
+        cleanup();
+
+        int size = av_image_get_buffer_size(pix_fmt, width, height, align);
+        if (size < 0)
+        {
+            std::cerr << "Invalid frame pool geometry" << std::endl;
+            return false;
+        }
+
+        pool_ = av_buffer_pool_init(size, nullptr);
+        if (!pool_)
+        {
+            std::cerr << "Could not allocate frame pool" << std::endl;
+            return false;
+        }
+
+        width_ = width;
+        height_ = height;
+        pix_fmt_ = pix_fmt;
+        align_ = align;
+        return true;
+    }
+
+    FramePtr FramePool::acquire()
+    {
+        if (!pool_)
+            return nullptr;
+
+        FramePtr frame = makeFrame();
+        if (!frame)
+            return nullptr;
+
+        frame->buf[0] = av_buffer_pool_get(pool_);
+        if (!frame->buf[0])
+            return nullptr;
+
+        // Every plane lives in the single pooled buffer
+        int ret = av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data,
+                                       pix_fmt_, width_, height_, align_);
+        if (ret < 0)
+            return nullptr;
+
+        frame->format = pix_fmt_;
+        frame->width = width_;
+        frame->height = height_;
+        return frame;
+    }
+
+    void FramePool::cleanup()
+    {
+        // Buffers still referenced elsewhere keep the pool alive until released
+        if (pool_)
+            av_buffer_pool_uninit(&pool_);
+
+        width_ = 0;
+        height_ = 0;
+        pix_fmt_ = AV_PIX_FMT_NONE;
+    }
+}
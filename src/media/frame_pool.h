@@ -0,0 +1,52 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+#include <media/frame_ref.h>
+
+namespace video_codec
+{
+    // Pool of reference-counted frame buffers with a fixed geometry.
+    // Buffers go back to the pool when the last reference is dropped, on
+    // whatever thread that happens, so frames can be retained or handed to
+    // other threads without copying pixel data.
+    class FramePool
+    {
+    public:
+        FramePool() = default;
+        ~FramePool();
+
+        // Not Allowed to copy
+        FramePool(const FramePool &) = delete;
+        FramePool &operator=(const FramePool &) = delete;
+
+        // Can move
+        FramePool(FramePool &&) noexcept;
+        FramePool &operator=(FramePool &&) noexcept;
+
+        bool initialize(int width, int height, AVPixelFormat pix_fmt, int align = 32);
+
+        // Fetch a frame backed by a pooled buffer (nullptr on failure)
+        FramePtr acquire();
+
+        // Getter
+        bool isInitialized() const { return pool_ != nullptr; }
+        int getWidth() const { return width_; }
+        int getHeight() const { return height_; }
+        AVPixelFormat getPixelFormat() const { return pix_fmt_; }
+
+    private:
+        AVBufferPool *pool_{nullptr};
+        int width_{0};
+        int height_{0};
+        AVPixelFormat pix_fmt_{AV_PIX_FMT_NONE};
+        int align_{32};
+
+        void cleanup();
+    };
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+#include <memory>
+
+namespace video_codec
+{
+    // Deleter so that AVFrame can be owned by std::unique_ptr
+    struct FrameDeleter
+    {
+        void operator()(AVFrame *frame) const { av_frame_free(&frame); }
+    };
+
+    // Owning handle of a reference-counted frame.
+    // Moving the handle transfers ownership; the pixel buffers are shared
+    // with every other reference created by refFrame().
+    using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+
+    // Allocate an empty frame (no buffers attached)
+    inline FramePtr makeFrame()
+    {
+        return FramePtr(av_frame_alloc());
+    }
+
+    // Create a new reference to the buffers of src.
+    // When src is reference-counted only the buffer refcounts are bumped,
+    // otherwise av_frame_ref() falls back to a single copy.
+    inline FramePtr refFrame(const AVFrame *src)
+    {
+        FramePtr frame = makeFrame();
+        if (!frame || av_frame_ref(frame.get(), src) < 0)
+            return nullptr;
+
+        return frame;
+    }
+}
@@ -0,0 +1,483 @@
+#include <media/media_concat.h>
+#include <media/bitstream.h>
+#include <media/frame_pool.h>
+#include <media/video_encoder.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libswscale/swscale.h>
+}
+
+namespace video_codec
+{
+    namespace
+    {
+        // Decoding resources of an input that has to be re-encoded
+        struct DecodeContext
+        {
+            AVCodecContext *codec_ctx{nullptr};
+            SwsContext *sws_ctx{nullptr};
+            AVFrame *frame{nullptr};
+            AVPacket *packet{nullptr};
+
+            ~DecodeContext()
+            {
+                if (sws_ctx)
+                    sws_freeContext(sws_ctx);
+                if (frame)
+                    av_frame_free(&frame);
+                if (packet)
+                    av_packet_free(&packet);
+                if (codec_ctx)
+                    avcodec_free_context(&codec_ctx);
+            }
+        };
+
+        // Duration of one frame of stream in its own time base
+        int64_t frameDuration(const AVStream *stream)
+        {
+            AVRational frame_rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+            if (frame_rate.num <= 0 || frame_rate.den <= 0)
+                return 1;
+
+            return std::max<int64_t>(1, av_rescale_q(1, av_inv_q(frame_rate), stream->time_base));
+        }
+    }
+
+    bool codecParametersMatch(const AVCodecParameters *a, const AVCodecParameters *b,
+                              bool compare_extradata)
+    {
+        if (a->codec_type != b->codec_type || a->codec_id != b->codec_id)
+            return false;
+
+        if (a->codec_type == AVMEDIA_TYPE_VIDEO)
+        {
+            if (a->width != b->width || a->height != b->height ||
+                a->format != b->format || a->profile != b->profile)
+                return false;
+        }
+        else if (a->codec_type == AVMEDIA_TYPE_AUDIO)
+        {
+            if (a->sample_rate != b->sample_rate || a->format != b->format ||
+                av_channel_layout_compare(&a->ch_layout, &b->ch_layout) != 0)
+                return false;
+        }
+
+        if (compare_extradata)
+        {
+            if (a->extradata_size != b->extradata_size)
+                return false;
+            if (a->extradata_size > 0 && std::memcmp(a->extradata, b->extradata, a->extradata_size) != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    bool MediaConcatenator::addInput(const std::string &filename)
+    {
+        Input input;
+        if (!input.file.open(filename))
+        {
+            setError("Could not open concat input: " + filename);
+            return false;
+        }
+
+        AVFormatContext *ctx = input.file.getFormatContext();
+        input.video_index = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (input.video_index < 0)
+        {
+            setError("Concat input has no video stream: " + filename);
+            return false;
+        }
+
+        int audio_index = av_find_best_stream(ctx, AVMEDIA_TYPE_AUDIO, -1, input.video_index, nullptr, 0);
+        input.audio_index = audio_index >= 0 ? audio_index : -1;
+
+        inputs_.push_back(std::move(input));
+        return true;
+    }
+
+    bool MediaConcatenator::isStreamCopyCompatible(size_t index, const ConcatOptions &options) const
+    {
+        if (index >= inputs_.size())
+            return false;
+
+        const Input &reference = inputs_[0];
+        const Input &input = inputs_[index];
+
+        return codecParametersMatch(
+            reference.file.getFormatContext()->streams[reference.video_index]->codecpar,
+            input.file.getFormatContext()->streams[input.video_index]->codecpar,
+            !options.ignore_extradata);
+    }
+
+    bool MediaConcatenator::concatenate(const std::string &output_filename, const ConcatOptions &options)
+    {
+        if (inputs_.empty())
+        {
+            setError("No concat inputs");
+            return false;
+        }
+
+        const Input &reference = inputs_[0];
+        AVFormatContext *ref_ctx = reference.file.getFormatContext();
+        const AVStream *ref_video = ref_ctx->streams[reference.video_index];
+
+        // Audio is stream-copied, so it is kept only if every input matches
+        bool include_audio = reference.audio_index >= 0;
+        for (size_t i = 0; i < inputs_.size(); ++i)
+        {
+            const Input &input = inputs_[i];
+
+            if (include_audio &&
+                (input.audio_index < 0 ||
+                 !codecParametersMatch(ref_ctx->streams[reference.audio_index]->codecpar,
+                                       input.file.getFormatContext()->streams[input.audio_index]->codecpar)))
+            {
+                std::cerr << "Audio of " << input.file.getFilename()
+                          << " does not match the first input, output will have no audio" << std::endl;
+                include_audio = false;
+            }
+
+            if (!options.allow_reencode && !isStreamCopyCompatible(i, options))
+            {
+                setError("Video parameters of " + input.file.getFilename() + " do not match the first input");
+                return false;
+            }
+        }
+
+        // Inputs are read to the end below; rewind them in case an earlier
+        // call or other code already read from them
+        for (Input &input : inputs_)
+        {
+            AVFormatContext *ctx = input.file.getFormatContext();
+            if (av_seek_frame(ctx, input.video_index, inputStart(input, input.video_index), AVSEEK_FLAG_BACKWARD) < 0)
+            {
+                setError("Could not rewind concat input " + input.file.getFilename());
+                return false;
+            }
+        }
+
+        // Output tracks take the parameters of the first input
+        video_track_ = OutputTrack();
+        audio_track_ = OutputTrack();
+
+        if (!muxer_.create(output_filename))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        video_track_.index = muxer_.addStream(ref_video->codecpar, ref_video->time_base);
+        if (include_audio)
+        {
+            const AVStream *ref_audio = ref_ctx->streams[reference.audio_index];
+            audio_track_.index = muxer_.addStream(ref_audio->codecpar, ref_audio->time_base);
+        }
+
+        if (video_track_.index < 0 || (include_audio && audio_track_.index < 0) || !muxer_.writeHeader())
+        {
+            setError(muxer_.getLastError());
+            muxer_.close();
+            return false;
+        }
+
+        end_time_ = 0;
+        for (size_t i = 0; i < inputs_.size(); ++i)
+        {
+            Input &input = inputs_[i];
+
+            // Each input starts where the previous one ended
+            int64_t offset = end_time_;
+            bool copy = isStreamCopyCompatible(i, options);
+
+            std::cout << (copy ? "Copying " : "Re-encoding ") << input.file.getFilename() << std::endl;
+
+            bool ok = copy ? copyInput(input, offset, include_audio)
+                           : transcodeInput(input, offset, include_audio, options);
+            if (!ok)
+            {
+                muxer_.close();
+                return false;
+            }
+        }
+
+        if (!muxer_.close())
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        std::cout << "Concatenated " << inputs_.size() << " inputs into " << output_filename << std::endl;
+        return true;
+    }
+
+    bool MediaConcatenator::copyInput(Input &input, int64_t offset, bool include_audio)
+    {
+        AVFormatContext *ctx = input.file.getFormatContext();
+        const AVStream *video = ctx->streams[input.video_index];
+        int64_t video_start = inputStart(input, input.video_index);
+        int64_t audio_start = input.audio_index >= 0 ? inputStart(input, input.audio_index) : 0;
+        int64_t video_duration = frameDuration(video);
+
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt)
+        {
+            setError("Could not allocate packet");
+            return false;
+        }
+
+        bool result = true;
+        while (result && av_read_frame(ctx, pkt) >= 0)
+        {
+            if (pkt->stream_index == input.video_index)
+            {
+                if (pkt->duration <= 0)
+                    pkt->duration = video_duration;
+
+                result = writeShifted(pkt, video_track_, video->time_base, video_start, offset);
+            }
+            else if (include_audio && pkt->stream_index == input.audio_index)
+            {
+                result = writeShifted(pkt, audio_track_, ctx->streams[input.audio_index]->time_base,
+                                      audio_start, offset);
+            }
+            else
+                av_packet_unref(pkt);
+        }
+
+        av_packet_free(&pkt);
+        return result;
+    }
+
+    bool MediaConcatenator::transcodeInput(Input &input, int64_t offset, bool include_audio,
+                                           const ConcatOptions &options)
+    {
+        AVFormatContext *ctx = input.file.getFormatContext();
+        const AVStream *video = ctx->streams[input.video_index];
+        const AVStream *ref_video = inputs_[0].file.getFormatContext()->streams[inputs_[0].video_index];
+        const AVCodecParameters *ref_par = ref_video->codecpar;
+
+        int64_t video_start = inputStart(input, input.video_index);
+        int64_t audio_start = input.audio_index >= 0 ? inputStart(input, input.audio_index) : 0;
+        int64_t frame_duration = frameDuration(video);
+
+        // Decoder of the mismatched input
+        DecodeContext decode;
+        const AVCodec *decoder = avcodec_find_decoder(video->codecpar->codec_id);
+        if (!decoder)
+        {
+            setError("Decoder not found for " + input.file.getFilename());
+            return false;
+        }
+
+        decode.codec_ctx = avcodec_alloc_context3(decoder);
+        decode.frame = av_frame_alloc();
+        decode.packet = av_packet_alloc();
+        if (!decode.codec_ctx || !decode.frame || !decode.packet ||
+            avcodec_parameters_to_context(decode.codec_ctx, video->codecpar) < 0)
+        {
+            setError("Could not allocate decoder for " + input.file.getFilename());
+            return false;
+        }
+
+        decode.codec_ctx->pkt_timebase = video->time_base;
+        if (avcodec_open2(decode.codec_ctx, decoder, nullptr) < 0)
+        {
+            setError("Could not open decoder for " + input.file.getFilename());
+            return false;
+        }
+
+        // Convert to the geometry and pixel format of the first input
+        AVPixelFormat ref_pix_fmt = static_cast<AVPixelFormat>(ref_par->format);
+        decode.sws_ctx = sws_getContext(
+            decode.codec_ctx->width, decode.codec_ctx->height, decode.codec_ctx->pix_fmt,
+            ref_par->width, ref_par->height, ref_pix_fmt,
+            SWS_BICUBIC, nullptr, nullptr, nullptr);
+
+        FramePool scaled_pool;
+        if (!decode.sws_ctx || !scaled_pool.initialize(ref_par->width, ref_par->height, ref_pix_fmt))
+        {
+            setError("Could not initialize scaling for " + input.file.getFilename());
+            return false;
+        }
+
+        // Encode with the codec of the first input. Parameter sets stay
+        // in-band since the track keeps the extradata of the first input.
+        VideoEncoderSettings settings;
+        settings.codec_name = options.encoder_name;
+        settings.codec_id = ref_par->codec_id;
+        settings.width = ref_par->width;
+        settings.height = ref_par->height;
+        settings.pix_fmt = ref_pix_fmt;
+        settings.time_base = video->time_base;
+        settings.framerate = ref_video->avg_frame_rate.num > 0 ? ref_video->avg_frame_rate : ref_video->r_frame_rate;
+        settings.bit_rate = ref_par->bit_rate;
+        settings.global_header = false;
+
+        VideoEncoder encoder;
+        if (!encoder.open(settings))
+        {
+            setError(encoder.getLastError());
+            return false;
+        }
+
+        int length_size = 0;
+        bool length_prefixed = usesLengthPrefixedNals(ref_par, length_size);
+
+        auto write_packet = [&](AVPacket *pkt)
+        {
+            if (length_prefixed && !convertAnnexBToLengthPrefixed(pkt, length_size))
+            {
+                setError("Could not convert encoded packet");
+                return false;
+            }
+
+            if (pkt->duration <= 0)
+                pkt->duration = frame_duration;
+
+            return writeShifted(pkt, video_track_, encoder.getTimeBase(), 0, offset);
+        };
+
+        int64_t next_pts = 0;
+        auto encode_frame = [&]()
+        {
+            FramePtr scaled = scaled_pool.acquire();
+            if (!scaled)
+            {
+                setError("Could not allocate scaled frame");
+                return false;
+            }
+
+            sws_scale(decode.sws_ctx, decode.frame->data, decode.frame->linesize, 0,
+                      decode.codec_ctx->height, scaled->data, scaled->linesize);
+
+            int64_t ts = decode.frame->best_effort_timestamp;
+            scaled->pts = ts != AV_NOPTS_VALUE ? std::max(ts - video_start, next_pts) : next_pts;
+            next_pts = scaled->pts + frame_duration;
+
+            return encoder.encode(scaled.get(), write_packet);
+        };
+
+        auto receive_frames = [&]()
+        {
+            while (true)
+            {
+                int ret = avcodec_receive_frame(decode.codec_ctx, decode.frame);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                    return true;
+                else if (ret < 0)
+                {
+                    setError("Error during decoding of " + input.file.getFilename());
+                    return false;
+                }
+
+                bool ok = encode_frame();
+                av_frame_unref(decode.frame);
+                if (!ok)
+                    return false;
+            }
+        };
+
+        bool result = true;
+        while (result && av_read_frame(ctx, decode.packet) >= 0)
+        {
+            if (decode.packet->stream_index == input.video_index)
+            {
+                if (avcodec_send_packet(decode.codec_ctx, decode.packet) < 0)
+                {
+                    setError("Error sending packet for decoding");
+                    result = false;
+                }
+                av_packet_unref(decode.packet);
+
+                if (result)
+                    result = receive_frames();
+            }
+            else if (include_audio && decode.packet->stream_index == input.audio_index)
+            {
+                result = writeShifted(decode.packet, audio_track_, ctx->streams[input.audio_index]->time_base,
+                                      audio_start, offset);
+            }
+            else
+                av_packet_unref(decode.packet);
+        }
+
+        // Flush the decoder, then the encoder
+        if (result)
+        {
+            avcodec_send_packet(decode.codec_ctx, nullptr);
+            result = receive_frames();
+        }
+
+        if (result && !encoder.flush(write_packet))
+        {
+            setError(encoder.getLastError());
+            result = false;
+        }
+
+        return result;
+    }
+
+    bool MediaConcatenator::writeShifted(AVPacket *pkt, OutputTrack &track, AVRational src_time_base,
+                                         int64_t src_start, int64_t offset)
+    {
+        AVRational out_time_base = muxer_.getTimeBase(track.index);
+        int64_t shift = av_rescale_q(offset, AV_TIME_BASE_Q, out_time_base);
+
+        if (pkt->pts != AV_NOPTS_VALUE)
+            pkt->pts -= src_start;
+        if (pkt->dts != AV_NOPTS_VALUE)
+            pkt->dts -= src_start;
+
+        av_packet_rescale_ts(pkt, src_time_base, out_time_base);
+
+        if (pkt->pts != AV_NOPTS_VALUE)
+            pkt->pts += shift;
+        if (pkt->dts != AV_NOPTS_VALUE)
+            pkt->dts += shift;
+
+        // Keep dts strictly increasing across the joins
+        if (pkt->dts != AV_NOPTS_VALUE && track.last_dts != AV_NOPTS_VALUE && pkt->dts <= track.last_dts)
+        {
+            pkt->dts = track.last_dts + 1;
+            if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts)
+                pkt->pts = pkt->dts;
+        }
+
+        if (pkt->dts != AV_NOPTS_VALUE)
+            track.last_dts = pkt->dts;
+
+        int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        if (ts != AV_NOPTS_VALUE)
+            end_time_ = std::max(end_time_, av_rescale_q(ts + pkt->duration, out_time_base, AV_TIME_BASE_Q));
+
+        if (!muxer_.writePacket(pkt, track.index, out_time_base))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    int64_t MediaConcatenator::inputStart(const Input &input, int stream_index)
+    {
+        const AVFormatContext *ctx = input.file.getFormatContext();
+        if (ctx->start_time == AV_NOPTS_VALUE)
+            return 0;
+
+        return av_rescale_q(ctx->start_time, AV_TIME_BASE_Q, ctx->streams[stream_index]->time_base);
+    }
+
+    void MediaConcatenator::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <media/media_file.h>
+#include <media/packet_muxer.h>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // Whether packets of both streams can share one output track.
+    // compare_extradata can be disabled for inputs that carry their codec
+    // headers in-band (e.g. segments encoded without global headers).
+    bool codecParametersMatch(const AVCodecParameters *a, const AVCodecParameters *b,
+                              bool compare_extradata = true);
+
+    struct ConcatOptions
+    {
+        // Re-encode inputs whose video parameters differ from the first input.
+        // When false such inputs make concatenate() fail.
+        bool allow_reencode{true};
+
+        // Encoder for mismatched inputs; empty picks the default encoder of
+        // the first input's codec
+        std::string encoder_name;
+
+        // Accept inputs whose codec extradata differs
+        bool ignore_extradata{false};
+    };
+
+    // Joins several media files into one output.
+    // Inputs whose codec parameters match the first input are remuxed packet
+    // by packet with continuous timestamps; only mismatched inputs are decoded
+    // and re-encoded to the parameters of the first input.
+    class MediaConcatenator
+    {
+    public:
+        MediaConcatenator() = default;
+
+        // Not Allowed to copy
+        MediaConcatenator(const MediaConcatenator &) = delete;
+        MediaConcatenator &operator=(const MediaConcatenator &) = delete;
+
+        bool addInput(const std::string &filename);
+        size_t getNumInputs() const { return inputs_.size(); }
+
+        // Whether the video of input index can be stream-copied
+        bool isStreamCopyCompatible(size_t index, const ConcatOptions &options = {}) const;
+
+        bool concatenate(const std::string &output_filename, const ConcatOptions &options = {});
+
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        struct Input
+        {
+            MediaFile file;
+            int video_index{-1};
+            int audio_index{-1};
+        };
+
+        // Output track of one input stream kind
+        struct OutputTrack
+        {
+            int index{-1};
+            int64_t last_dts{AV_NOPTS_VALUE};
+        };
+
+        std::vector<Input> inputs_;
+        PacketMuxer muxer_;
+        OutputTrack video_track_;
+        OutputTrack audio_track_;
+        int64_t end_time_{0}; // End of the written content in AV_TIME_BASE units
+        std::string last_error_;
+
+        bool copyInput(Input &input, int64_t offset, bool include_audio);
+        bool transcodeInput(Input &input, int64_t offset, bool include_audio,
+                            const ConcatOptions &options);
+
+        // Shift pkt (relative to its input start) by offset and write it
+        bool writeShifted(AVPacket *pkt, OutputTrack &track, AVRational src_time_base,
+                          int64_t src_start, int64_t offset);
+
+        // Start of the input in the time base of one of its streams
+        static int64_t inputStart(const Input &input, int stream_index);
+
+        void setError(const std::string &message);
+    };
+}
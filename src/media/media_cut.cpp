@@ -0,0 +1,379 @@
+#include <media/media_cut.h>
+#include <media/video_encoder.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Decoder of the video stream for frame-accurate cuts
+        struct DecodeContext
+        {
+            AVCodecContext *codec_ctx{nullptr};
+            AVFrame *frame{nullptr};
+
+            ~DecodeContext()
+            {
+                if (frame)
+                    av_frame_free(&frame);
+                if (codec_ctx)
+                    avcodec_free_context(&codec_ctx);
+            }
+        };
+
+        int64_t packetTime(const AVPacket *pkt)
+        {
+            return pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+        }
+    }
+
+    bool MediaCutter::cut(const std::string &input_filename, const std::string &output_filename,
+                          double start, double duration, const CutOptions &options)
+    {
+        if (start < 0.0)
+        {
+            setError("Cut start must not be negative");
+            return false;
+        }
+
+        if (!file_.open(input_filename))
+        {
+            setError("Could not open cut input: " + input_filename);
+            return false;
+        }
+
+        AVFormatContext *ctx = file_.getFormatContext();
+        video_index_ = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (video_index_ < 0)
+        {
+            setError("Cut input has no video stream: " + input_filename);
+            return false;
+        }
+        audio_index_ = file_.findAudioStreamIndex();
+
+        // Range on the file timeline
+        int64_t file_start = ctx->start_time != AV_NOPTS_VALUE ? ctx->start_time : 0;
+        int64_t range_start = file_start + std::llround(start * AV_TIME_BASE);
+        int64_t range_end = duration > 0.0 ? range_start + std::llround(duration * AV_TIME_BASE) : INT64_MAX;
+
+        AVRational video_time_base = ctx->streams[video_index_]->time_base;
+        if (av_seek_frame(ctx, video_index_, av_rescale_q(range_start, AV_TIME_BASE_Q, video_time_base),
+                          AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            setError("Could not seek to the cut start");
+            return false;
+        }
+
+        if (!muxer_.create(output_filename))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        bool result = options.stream_copy ? copyRange(range_start, range_end)
+                                          : transcodeRange(range_start, range_end, options);
+
+        if (!muxer_.close() && result)
+        {
+            setError(muxer_.getLastError());
+            result = false;
+        }
+
+        if (result)
+            std::cout << "Cut " << start << "s" << (duration > 0.0 ? " +" + std::to_string(duration) + "s" : " to end")
+                      << " of " << input_filename << " into " << output_filename << std::endl;
+        return result;
+    }
+
+    bool MediaCutter::openOutput(const AVCodecParameters *video_parameters)
+    {
+        AVFormatContext *ctx = file_.getFormatContext();
+
+        video_track_ = muxer_.addStream(video_parameters, ctx->streams[video_index_]->time_base);
+        audio_track_ = -1;
+        if (audio_index_ >= 0)
+        {
+            const AVStream *audio = ctx->streams[audio_index_];
+            audio_track_ = muxer_.addStream(audio->codecpar, audio->time_base);
+        }
+
+        if (video_track_ < 0 || (audio_index_ >= 0 && audio_track_ < 0) || !muxer_.writeHeader())
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool MediaCutter::copyRange(int64_t start, int64_t end)
+    {
+        AVFormatContext *ctx = file_.getFormatContext();
+        const AVStream *video = ctx->streams[video_index_];
+
+        if (!openOutput(video->codecpar))
+            return false;
+
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt)
+        {
+            setError("Could not allocate packet");
+            return false;
+        }
+
+        // The output starts at the first keyframe read after the seek
+        int64_t origin = AV_NOPTS_VALUE;
+        bool video_done = false;
+        bool audio_done = audio_index_ < 0;
+        bool result = true;
+
+        while (result && !(video_done && audio_done) && av_read_frame(ctx, pkt) >= 0)
+        {
+            int64_t ts = packetTime(pkt);
+            if (ts == AV_NOPTS_VALUE)
+            {
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            if (pkt->stream_index == video_index_ && !video_done)
+            {
+                int64_t time = av_rescale_q(ts, video->time_base, AV_TIME_BASE_Q);
+                if (origin == AV_NOPTS_VALUE)
+                {
+                    if (!(pkt->flags & AV_PKT_FLAG_KEY))
+                    {
+                        av_packet_unref(pkt);
+                        continue;
+                    }
+                    origin = time;
+                }
+
+                if (time >= end)
+                {
+                    video_done = true;
+                    av_packet_unref(pkt);
+                    continue;
+                }
+
+                result = writeShifted(pkt, video_track_, video->time_base, origin);
+            }
+            else if (pkt->stream_index == audio_index_ && !audio_done && origin != AV_NOPTS_VALUE)
+            {
+                AVRational audio_time_base = ctx->streams[audio_index_]->time_base;
+                int64_t time = av_rescale_q(ts, audio_time_base, AV_TIME_BASE_Q);
+                if (time >= end)
+                    audio_done = true;
+
+                if (time < origin || time >= end)
+                    av_packet_unref(pkt);
+                else
+                    result = writeShifted(pkt, audio_track_, audio_time_base, origin);
+            }
+            else
+                av_packet_unref(pkt);
+        }
+
+        av_packet_free(&pkt);
+
+        if (result && origin == AV_NOPTS_VALUE)
+        {
+            setError("No keyframe found in the cut range");
+            result = false;
+        }
+        else if (result && origin < start)
+        {
+            std::cout << "Cut starts " << (start - origin) / static_cast<double>(AV_TIME_BASE)
+                      << "s early at the previous keyframe (re-encode for a frame-accurate start)" << std::endl;
+        }
+
+        return result;
+    }
+
+    bool MediaCutter::transcodeRange(int64_t start, int64_t end, const CutOptions &options)
+    {
+        AVFormatContext *ctx = file_.getFormatContext();
+        const AVStream *video = ctx->streams[video_index_];
+
+        DecodeContext decode;
+        const AVCodec *decoder = avcodec_find_decoder(video->codecpar->codec_id);
+        if (!decoder)
+        {
+            setError("Decoder not found for " + file_.getFilename());
+            return false;
+        }
+
+        decode.codec_ctx = avcodec_alloc_context3(decoder);
+        decode.frame = av_frame_alloc();
+        if (!decode.codec_ctx || !decode.frame ||
+            avcodec_parameters_to_context(decode.codec_ctx, video->codecpar) < 0)
+        {
+            setError("Could not allocate decoder for " + file_.getFilename());
+            return false;
+        }
+
+        decode.codec_ctx->pkt_timebase = video->time_base;
+        decode.codec_ctx->thread_count = options.threads;
+        if (avcodec_open2(decode.codec_ctx, decoder, nullptr) < 0)
+        {
+            setError("Could not open decoder for " + file_.getFilename());
+            return false;
+        }
+
+        // Same codec and geometry as the source, in the source time base
+        VideoEncoderSettings settings;
+        settings.codec_name = options.encoder_name;
+        settings.codec_id = video->codecpar->codec_id;
+        settings.width = decode.codec_ctx->width;
+        settings.height = decode.codec_ctx->height;
+        settings.pix_fmt = decode.codec_ctx->pix_fmt;
+        settings.time_base = video->time_base;
+        settings.framerate = video->avg_frame_rate.num > 0 ? video->avg_frame_rate : video->r_frame_rate;
+        settings.bit_rate = options.bit_rate < 0 ? video->codecpar->bit_rate : options.bit_rate;
+        settings.max_bit_rate = options.max_bit_rate;
+        settings.options = options.encoder_options;
+        settings.thread_count = options.threads;
+        settings.global_header = (muxer_.getFormatContext()->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+
+        VideoEncoder encoder;
+        if (!encoder.open(settings))
+        {
+            setError(encoder.getLastError());
+            return false;
+        }
+
+        AVCodecParameters *encoded_parameters = avcodec_parameters_alloc();
+        bool opened = encoded_parameters &&
+                      avcodec_parameters_from_context(encoded_parameters, encoder.getCodecContext()) >= 0 &&
+                      openOutput(encoded_parameters);
+        avcodec_parameters_free(&encoded_parameters);
+        if (!opened)
+        {
+            if (last_error_.empty())
+                setError("Could not copy encoder parameters");
+            return false;
+        }
+
+        int64_t start_pts = av_rescale_q(start, AV_TIME_BASE_Q, video->time_base);
+        int64_t end_pts = end == INT64_MAX ? INT64_MAX : av_rescale_q(end, AV_TIME_BASE_Q, video->time_base);
+        bool video_done = false;
+        bool audio_done = audio_index_ < 0;
+
+        auto write_packet = [&](AVPacket *pkt)
+        { return writeShifted(pkt, video_track_, encoder.getTimeBase(), 0); };
+
+        // Frames before the start only prime the decoder
+        auto receive_frames = [&]()
+        {
+            while (!video_done)
+            {
+                int ret = avcodec_receive_frame(decode.codec_ctx, decode.frame);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                    return true;
+                else if (ret < 0)
+                {
+                    setError("Error during decoding of " + file_.getFilename());
+                    return false;
+                }
+
+                int64_t ts = decode.frame->best_effort_timestamp;
+                bool ok = true;
+                if (ts != AV_NOPTS_VALUE && ts >= end_pts)
+                    video_done = true;
+                else if (ts != AV_NOPTS_VALUE && ts >= start_pts)
+                {
+                    decode.frame->pts = ts - start_pts;
+                    decode.frame->pict_type = AV_PICTURE_TYPE_NONE;
+                    ok = encoder.encode(decode.frame, write_packet);
+                    if (!ok && last_error_.empty())
+                        setError(encoder.getLastError());
+                }
+                av_frame_unref(decode.frame);
+                if (!ok)
+                    return false;
+            }
+            return true;
+        };
+
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt)
+        {
+            setError("Could not allocate packet");
+            return false;
+        }
+
+        bool result = true;
+        while (result && !(video_done && audio_done) && av_read_frame(ctx, pkt) >= 0)
+        {
+            if (pkt->stream_index == video_index_ && !video_done)
+            {
+                if (avcodec_send_packet(decode.codec_ctx, pkt) < 0)
+                {
+                    setError("Error sending packet for decoding");
+                    result = false;
+                }
+                av_packet_unref(pkt);
+
+                if (result)
+                    result = receive_frames();
+            }
+            else if (pkt->stream_index == audio_index_ && !audio_done && packetTime(pkt) != AV_NOPTS_VALUE)
+            {
+                // Audio starts at the exact cut start
+                AVRational audio_time_base = ctx->streams[audio_index_]->time_base;
+                int64_t time = av_rescale_q(packetTime(pkt), audio_time_base, AV_TIME_BASE_Q);
+                if (time >= end)
+                    audio_done = true;
+
+                if (time < start || time >= end)
+                    av_packet_unref(pkt);
+                else
+                    result = writeShifted(pkt, audio_track_, audio_time_base, start);
+            }
+            else
+                av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+
+        // Flush the decoder, then the encoder
+        if (result && !video_done)
+        {
+            avcodec_send_packet(decode.codec_ctx, nullptr);
+            result = receive_frames();
+        }
+
+        if (result && !encoder.flush(write_packet))
+        {
+            if (last_error_.empty())
+                setError(encoder.getLastError());
+            result = false;
+        }
+
+        return result;
+    }
+
+    bool MediaCutter::writeShifted(AVPacket *pkt, int track, AVRational src_time_base, int64_t origin)
+    {
+        int64_t shift = av_rescale_q(origin, AV_TIME_BASE_Q, src_time_base);
+        if (pkt->pts != AV_NOPTS_VALUE)
+            pkt->pts -= shift;
+        if (pkt->dts != AV_NOPTS_VALUE)
+            pkt->dts -= shift;
+
+        if (!muxer_.writePacket(pkt, track, src_time_base))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    void MediaCutter::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <media/media_file.h>
+#include <media/packet_muxer.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace video_codec
+{
+    struct CutOptions
+    {
+        // Copy packets starting at the keyframe at or before the start. No
+        // quality loss, but the cut may begin up to one GOP early. When
+        // false the video is decoded from that keyframe and re-encoded from
+        // the exact start frame; audio is always stream-copied.
+        bool stream_copy{true};
+
+        // Encoder for re-encoding; empty picks the default encoder of the
+        // source codec
+        std::string encoder_name;
+
+        // Decoder and encoder threads when re-encoding, 0 lets FFmpeg decide
+        int threads{0};
+
+        // Rate control when re-encoding: bit_rate -1 keeps the source bit rate
+        // and 0 the encoder default; encoder_options are private encoder
+        // options (preset, crf, ...)
+        int64_t bit_rate{-1};
+        int64_t max_bit_rate{0};
+        std::vector<std::pair<std::string, std::string>> encoder_options;
+    };
+
+    // Extracts a time range of a media file into a new file
+    class MediaCutter
+    {
+    public:
+        MediaCutter() = default;
+
+        // Not Allowed to copy
+        MediaCutter(const MediaCutter &) = delete;
+        MediaCutter &operator=(const MediaCutter &) = delete;
+
+        // Cut [start, start + duration) seconds of input into output.
+        // duration <= 0 cuts to the end of the input.
+        bool cut(const std::string &input_filename, const std::string &output_filename,
+                 double start, double duration, const CutOptions &options = {});
+
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        MediaFile file_;
+        PacketMuxer muxer_;
+        int video_index_{-1};
+        int audio_index_{-1};
+        int video_track_{-1};
+        int audio_track_{-1};
+        std::string last_error_;
+
+        // Add the video track (with the given parameters) and the copied
+        // audio track, then write the header
+        bool openOutput(const AVCodecParameters *video_parameters);
+
+        // Range in AV_TIME_BASE units on the file timeline
+        bool copyRange(int64_t start, int64_t end);
+        bool transcodeRange(int64_t start, int64_t end, const CutOptions &options);
+
+        // Shift pkt so that origin (AV_TIME_BASE units) becomes 0 and write it
+        bool writeShifted(AVPacket *pkt, int track, AVRational src_time_base, int64_t origin);
+
+        void setError(const std::string &message);
+    };
+}
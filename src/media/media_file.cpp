@@ -1,4 +1,9 @@
 #include <media/media_file.h>
+#include <processing/audio_processor.h>
+#include <processing/proxy_writer_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
 namespace video_codec
@@ -13,7 +18,12 @@ namespace video_codec
           format_name_(std::move(other.format_name_)),
           format_long_name_(std::move(other.format_long_name_)),
           format_ctx_(other.format_ctx_),
-          stream_info_(std::move(other.stream_info_))
+          stream_info_(std::move(other.stream_info_)),
+          frame_batch_size_(other.frame_batch_size_),
+          decoder_threads_(other.decoder_threads_),
+          preview_file_(std::move(other.preview_file_)),
+          preview_stream_(std::move(other.preview_stream_)),
+          preview_is_proxy_(other.preview_is_proxy_)
     {
         other.format_ctx_ = nullptr;
     }
@@ -29,6 +39,11 @@ namespace video_codec
             format_long_name_ = (std::move(other.format_long_name_));
             format_ctx_ = (other.format_ctx_);
             stream_info_ = (std::move(other.stream_info_));
+            frame_batch_size_ = other.frame_batch_size_;
+            decoder_threads_ = other.decoder_threads_;
+            preview_stream_ = std::move(other.preview_stream_);
+            preview_file_ = std::move(other.preview_file_);
+            preview_is_proxy_ = other.preview_is_proxy_;
 
             other.format_ctx_ = nullptr;
         }
@@ -75,6 +90,8 @@ namespace video_codec
 
     void MediaFile::close()
     {
+        detachProxy();
+
         if (format_ctx_)
         {
             avformat_close_input(&format_ctx_);
@@ -122,7 +139,7 @@ namespace video_codec
             return stream;
         }
 
-        if (!stream.initialize(format_ctx_, video_index))
+        if (!stream.initialize(format_ctx_, video_index, decoder_threads_))
         {
             std::cerr << "Failed to initialize video stream" << std::endl;
         }
@@ -138,9 +155,263 @@ namespace video_codec
             return false;
         }
 
+        stream.setBatchSize(frame_batch_size_);
         return stream.processFrames(processor, max_frames);
     }
 
+    bool MediaFile::generateProxy(const std::string &proxy_filename, const ProxyOptions &options)
+    {
+        VideoStream stream = getVideoStream();
+        if (!stream.getCodecContext())
+            return false;
+
+        const AVStream *video = format_ctx_->streams[stream.getStreamIndex()];
+        ProxySource source;
+        source.filename = filename_;
+        source.width = stream.getWidth();
+        source.height = stream.getHeight();
+        source.time_base = video->time_base;
+        source.frame_rate = video->avg_frame_rate.num > 0 ? video->avg_frame_rate : video->r_frame_rate;
+
+        ProxyWriterProcessor writer(proxy_filename.empty() ? ProxyWriter::getProxyFilename(filename_) : proxy_filename,
+                                    source, options);
+        if (!writer.isInitialized())
+            return false;
+
+        stream.setBatchSize(frame_batch_size_);
+        bool result = stream.processFrames(writer);
+        return writer.finalize() && result;
+    }
+
+    bool MediaFile::attachProxy(const std::string &proxy_filename)
+    {
+        std::string filename = proxy_filename.empty() ? ProxyWriter::getProxyFilename(filename_) : proxy_filename;
+        int video_index = findVideoStreamIndex();
+        if (video_index < 0)
+        {
+            std::cerr << "No video stream found" << std::endl;
+            return false;
+        }
+
+        auto proxy = std::make_unique<MediaFile>();
+        if (!proxy->open(filename))
+            return false;
+
+        // The proxy must have been made from this file, or timestamps would not map
+        const AVStream *video = format_ctx_->streams[video_index];
+        ProxySource source;
+        if (!ProxyWriter::readSource(proxy->getFormatContext(), source) ||
+            source.filename != std::filesystem::path(filename_).filename().string() ||
+            source.width != video->codecpar->width || source.height != video->codecpar->height ||
+            av_cmp_q(source.time_base, video->time_base) != 0)
+        {
+            std::cerr << filename << " is not a proxy of " << filename_ << std::endl;
+            return false;
+        }
+
+        VideoStream stream = proxy->getVideoStream();
+        if (!stream.getCodecContext())
+            return false;
+
+        preview_stream_ = std::move(stream);
+        preview_file_ = std::move(proxy);
+        preview_is_proxy_ = true;
+        return true;
+    }
+
+    void MediaFile::detachProxy()
+    {
+        preview_stream_ = VideoStream();
+        preview_file_.reset();
+        preview_is_proxy_ = false;
+    }
+
+    FramePtr MediaFile::getPreviewFrame(int64_t timestamp)
+    {
+        if (!preview_stream_.getCodecContext())
+        {
+            if (!format_ctx_)
+            {
+                std::cerr << "MediaFile not open" << std::endl;
+                return nullptr;
+            }
+
+            // No proxy: previews decode the original through their own handle
+            auto preview = std::make_unique<MediaFile>();
+            preview->setDecoderThreads(decoder_threads_);
+            if (!preview->open(filename_))
+                return nullptr;
+
+            preview_stream_ = preview->getVideoStream();
+            preview_file_ = std::move(preview);
+            if (!preview_stream_.getCodecContext())
+                return nullptr;
+        }
+
+        FramePtr frame = preview_stream_.getFrame(toProxyTimestamp(timestamp));
+        if (frame && preview_is_proxy_)
+        {
+            frame->pts = toSourceTimestamp(frame->pts);
+            frame->best_effort_timestamp = frame->pts;
+            frame->duration = av_rescale_q(frame->duration, preview_stream_.getTimeBase(), getVideoTimeBase());
+            frame->time_base = getVideoTimeBase();
+        }
+        return frame;
+    }
+
+    int64_t MediaFile::toProxyTimestamp(int64_t timestamp) const
+    {
+        if (!preview_is_proxy_ || timestamp == AV_NOPTS_VALUE)
+            return timestamp;
+        return av_rescale_q(timestamp, getVideoTimeBase(), preview_stream_.getTimeBase());
+    }
+
+    int64_t MediaFile::toSourceTimestamp(int64_t proxy_timestamp) const
+    {
+        if (!preview_is_proxy_ || proxy_timestamp == AV_NOPTS_VALUE)
+            return proxy_timestamp;
+        return av_rescale_q(proxy_timestamp, preview_stream_.getTimeBase(), getVideoTimeBase());
+    }
+
+    AVRational MediaFile::getVideoTimeBase() const
+    {
+        int video_index = findVideoStreamIndex();
+        return video_index >= 0 ? format_ctx_->streams[video_index]->time_base : AVRational{1, AV_TIME_BASE};
+    }
+
+    int64_t MediaFile::getVideoStartTime() const
+    {
+        int video_index = findVideoStreamIndex();
+        if (video_index < 0)
+            return AV_NOPTS_VALUE;
+
+        const AVStream *stream = format_ctx_->streams[video_index];
+        if (stream->start_time != AV_NOPTS_VALUE)
+            return av_rescale_q(stream->start_time, stream->time_base, AV_TIME_BASE_Q);
+        return format_ctx_->start_time;
+    }
+
+    int MediaFile::findAudioStreamIndex(int index) const
+    {
+        if (!format_ctx_)
+            return -1;
+
+        if (index >= 0)
+        {
+            if (static_cast<unsigned int>(index) < format_ctx_->nb_streams &&
+                format_ctx_->streams[index]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+            {
+                return index;
+            }
+            return -1;
+        }
+
+        // Prefer the audio stream that belongs to the video
+        return std::max(-1, av_find_best_stream(format_ctx_, AVMEDIA_TYPE_AUDIO, -1, findVideoStreamIndex(), nullptr, 0));
+    }
+
+    AudioStream MediaFile::getAudioStream(int index, int sample_rate, int channels)
+    {
+        AudioStream stream;
+
+        int audio_index = findAudioStreamIndex(index);
+        if (audio_index < 0)
+        {
+            std::cerr << "No audio stream found" << std::endl;
+            return stream;
+        }
+
+        if (!stream.initialize(format_ctx_, audio_index, sample_rate, channels))
+        {
+            std::cerr << "Failed to initialize audio stream" << std::endl;
+        }
+
+        return stream;
+    }
+
+    bool MediaFile::processAudioFrames(AudioProcessor &processor, int audio_stream_index)
+    {
+        AudioStream stream = getAudioStream(audio_stream_index);
+        if (!stream.getCodecContext())
+        {
+            return false;
+        }
+
+        return stream.processFrames(processor);
+    }
+
+    bool MediaFile::processMediaFrames(FrameProcessor &video_processor, AudioProcessor &audio_processor,
+                                       int max_frames)
+    {
+        VideoStream video = getVideoStream();
+        if (!video.getCodecContext())
+        {
+            return false;
+        }
+        video.setBatchSize(frame_batch_size_);
+
+        // Audio is optional; stream copy needs no decoder
+        int audio_index = findAudioStreamIndex();
+        bool copy_audio = audio_index >= 0 && audio_processor.acceptsPackets();
+        AudioStream audio;
+        if (audio_index >= 0 && !copy_audio)
+        {
+            audio = getAudioStream(audio_index);
+            if (!audio.getCodecContext())
+                audio_index = -1;
+        }
+
+        AVPacket *packet = av_packet_alloc();
+        if (!packet)
+        {
+            std::cerr << "Could not allocate packet" << std::endl;
+            return false;
+        }
+
+        int video_index = video.getStreamIndex();
+        AVRational audio_time_base = audio_index >= 0 ? format_ctx_->streams[audio_index]->time_base : AVRational{0, 1};
+        int frame_cnt = 0;
+        bool result = true;
+
+        // Seek to the beginning of the file
+        av_seek_frame(format_ctx_, video_index, 0, AVSEEK_FLAG_BACKWARD);
+
+        static StageMetrics &demux_metrics = PipelineMetrics::instance().stage("demux");
+
+        // Packets of both streams arrive in file order, so the outputs advance
+        // together and the muxer can interleave them
+        while (result && timeStage(demux_metrics, [&]
+                                   { return av_read_frame(format_ctx_, packet); }) >= 0)
+        {
+            demux_metrics.addBytesRead(packet->size);
+
+            if (packet->stream_index == video_index)
+                result = video.decodePacket(packet, video_processor, frame_cnt, max_frames);
+            else if (packet->stream_index == audio_index && copy_audio)
+                result = audio_processor.processAudioPacket(packet, audio_time_base);
+            else if (packet->stream_index == audio_index)
+                result = audio.decodePacket(packet, audio_processor);
+
+            av_packet_unref(packet);
+
+            // Terminate when the maximum frame count is reached
+            if (max_frames > 0 && frame_cnt >= max_frames)
+                break;
+        }
+
+        // Flush the decoders and the processors
+        if (!video.decodePacket(nullptr, video_processor, frame_cnt, max_frames))
+            result = false;
+        if (audio_index >= 0 && !copy_audio && !audio.decodePacket(nullptr, audio_processor))
+            result = false;
+        if (audio_index >= 0 && !audio_processor.finishAudio())
+            result = false;
+
+        av_packet_free(&packet);
+        std::cout << "Processed " << frame_cnt << " frames" << (audio_index >= 0 ? " with audio" : "") << std::endl;
+        return result;
+    }
+
     // clang-format off
     int64_t MediaFile::getDuration() const
     {
@@ -7,6 +7,8 @@ extern "C"
 #include <libavutil/avutil.h>
 }
 
+#include <media/audio_stream.h>
+#include <media/proxy_writer.h>
 #include <media/video_stream.h>
 #include <string>
 #include <memory>
@@ -50,6 +52,49 @@ namespace video_codec
         VideoStream getVideoStream(int index = -1);
         bool processVideoFrames(FrameProcessor &processor, int max_frames = -1, int video_stream_index = -1);
 
+        // Fetch audio stream, decoding to planar float at the given rate and channel count (0 keeps the source)
+        AudioStream getAudioStream(int index = -1, int sample_rate = 0, int channels = 0);
+        bool processAudioFrames(AudioProcessor &processor, int audio_stream_index = -1);
+
+        // Decode video and audio in one demux pass.
+        // Audio goes to audio_processor as decoded frames, or as the source
+        // packets when audio_processor.acceptsPackets() (stream copy).
+        bool processMediaFrames(FrameProcessor &video_processor, AudioProcessor &audio_processor,
+                                int max_frames = -1);
+
+        // Retrieve an index of audio stream (-1 if there is none)
+        int findAudioStreamIndex(int index = -1) const;
+
+        // Source time of the first video frame in AV_TIME_BASE units, the
+        // origin of written outputs (AudioOutputSettings::start_time);
+        // AV_NOPTS_VALUE if unknown
+        int64_t getVideoStartTime() const;
+
+        // Number of frames handed to the processor at once (see VideoStream::setBatchSize)
+        void setFrameBatchSize(int batch_size) { frame_batch_size_ = batch_size; }
+
+        // Threads of the video decoders opened from now on (0 keeps the decoder default)
+        void setDecoderThreads(int thread_count) { decoder_threads_ = thread_count; }
+
+        // Proxies (see ProxyWriter). Decoding and processing above always read
+        // the original, so final renders are unaffected; previews go through
+        // getPreviewFrame(), which uses an attached proxy.
+        // - generateProxy: write a proxy in one decode pass ("" = getProxyFilename())
+        // - attachProxy: use a proxy for previews; false if it was made from another file
+        bool generateProxy(const std::string &proxy_filename = "", const ProxyOptions &options = {});
+        bool attachProxy(const std::string &proxy_filename = "");
+        void detachProxy();
+        bool hasProxy() const { return preview_is_proxy_; }
+
+        // RGB frame shown at timestamp (original video time base) for previews,
+        // from the proxy if one is attached, else from the original. The
+        // frame's timestamps are in the original time base as well.
+        FramePtr getPreviewFrame(int64_t timestamp);
+
+        // Timestamp mapping between the original video and the attached proxy
+        int64_t toProxyTimestamp(int64_t timestamp) const;
+        int64_t toSourceTimestamp(int64_t proxy_timestamp) const;
+
         bool open(const std::string &filename);
         void close();
 
@@ -59,6 +104,7 @@ namespace video_codec
         int64_t getBitRate() const;  // in bits per second
         const std::string &getFormatName() const { return format_name_; }
         const std::string &getFormatLongName() const { return format_long_name_; }
+        AVFormatContext *getFormatContext() const { return format_ctx_; }
 
         // Stream information
         int32_t getNumStreams() const;
@@ -73,10 +119,21 @@ namespace video_codec
         std::string format_long_name_;
         AVFormatContext *format_ctx_{nullptr};
         std::vector<StreamInfo> stream_info_;
+        int frame_batch_size_{1};
+        int decoder_threads_{0};
+
+        // Preview source: the attached proxy, or a second handle of this file
+        // so that previews never move the demuxer used by renders
+        std::unique_ptr<MediaFile> preview_file_;
+        VideoStream preview_stream_;
+        bool preview_is_proxy_{false};
 
         // Retrieve an index of video stream
         int findVideoStreamIndex(int index = -1) const;
 
+        // Time base of the first video stream
+        AVRational getVideoTimeBase() const;
+
         void analyzeStreams();
     };
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include <media/packet_muxer.h>
+#include <profiling/memory_tracker.h>
+#include <profiling/pipeline_metrics.h>
+#include <iostream>
+#include <sstream>
+
+namespace video_codec
+{
+    PacketMuxer::~PacketMuxer()
+    {
+        cleanup();
+    }
+
+    void PacketMuxer::cleanup()
+    {
+        if (format_ctx_)
+        {
+            if (!(format_ctx_->oformat->flags & AVFMT_NOFILE))
+                avio_closep(&format_ctx_->pb);
+
+            avformat_free_context(format_ctx_);
+            format_ctx_ = nullptr;
+        }
+
+        header_written_ = false;
+    }
+
+    bool PacketMuxer::create(const std::string &filename, const std::string &format_name)
+    {
+        cleanup();
+
+        filename_ = filename;
+
+        int ret = avformat_alloc_output_context2(&format_ctx_, nullptr,
+                                                 format_name.empty() ? nullptr : format_name.c_str(),
+                                                 filename.c_str());
+        if (ret < 0 || !format_ctx_)
+        {
+            setError("Could not allocate output format context", ret);
+            return false;
+        }
+
+        return true;
+    }
+
+    int PacketMuxer::addStream(const AVCodecParameters *codecpar, AVRational time_base)
+    {
+        if (!format_ctx_ || header_written_)
+        {
+            setError("Streams must be added before the header is written");
+            return -1;
+        }
+
+        AVStream *stream = avformat_new_stream(format_ctx_, nullptr);
+        if (!stream)
+        {
+            setError("Could not allocate output stream");
+            return -1;
+        }
+
+        int ret = avcodec_parameters_copy(stream->codecpar, codecpar);
+        if (ret < 0)
+        {
+            setError("Could not copy stream parameters", ret);
+            return -1;
+        }
+
+        // Let the muxer pick the tag that fits the container
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = time_base;
+        stream->id = static_cast<int>(format_ctx_->nb_streams) - 1;
+
+        return stream->index;
+    }
+
+    bool PacketMuxer::writeHeader(AVDictionary **options)
+    {
+        if (!format_ctx_)
+        {
+            setError("PacketMuxer not created");
+            return false;
+        }
+
+        if (!(format_ctx_->oformat->flags & AVFMT_NOFILE))
+        {
+            int ret = avio_open(&format_ctx_->pb, filename_.c_str(), AVIO_FLAG_WRITE);
+            if (ret < 0)
+            {
+                setError("Could not open output file", ret);
+                return false;
+            }
+        }
+
+        int ret = avformat_write_header(format_ctx_, options);
+        if (ret < 0)
+        {
+            setError("Could not write header", ret);
+            return false;
+        }
+
+        header_written_ = true;
+        return true;
+    }
+
+    bool PacketMuxer::writePacket(AVPacket *pkt, int stream_index, AVRational src_time_base)
+    {
+        if (!header_written_)
+        {
+            av_packet_unref(pkt);
+            setError("Header not written");
+            return false;
+        }
+
+        AVStream *stream = format_ctx_->streams[stream_index];
+        av_packet_rescale_ts(pkt, src_time_base, stream->time_base);
+        pkt->stream_index = stream_index;
+        pkt->pos = -1;
+
+        static StageMetrics &mux_metrics = PipelineMetrics::instance().stage("mux");
+        static MemoryAccount &mux_memory = MemoryTracker::instance().account("muxer");
+        mux_metrics.addBytesWritten(pkt->size);
+        MemoryTracker::instance().trackPacket(pkt, mux_memory);
+
+        // av_interleaved_write_frame() takes over the packet reference
+        int ret = timeStage(mux_metrics, [&]
+                            { return av_interleaved_write_frame(format_ctx_, pkt); });
+        if (ret < 0)
+        {
+            setError("Error writing packet", ret);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PacketMuxer::close()
+    {
+        if (!format_ctx_)
+            return true; // Already closed
+
+        if (header_written_)
+        {
+            int ret = av_write_trailer(format_ctx_);
+            if (ret < 0)
+            {
+                setError("Error writing trailer", ret);
+                cleanup();
+                return false;
+            }
+        }
+
+        cleanup();
+        return true;
+    }
+
+    AVRational PacketMuxer::getTimeBase(int stream_index) const
+    {
+        if (!format_ctx_ || stream_index < 0 || static_cast<unsigned int>(stream_index) >= format_ctx_->nb_streams)
+            return {0, 1};
+
+        return format_ctx_->streams[stream_index]->time_base;
+    }
+
+    int64_t PacketMuxer::getBytesWritten() const
+    {
+        if (!format_ctx_ || !format_ctx_->pb)
+            return 0;
+
+        return avio_tell(format_ctx_->pb);
+    }
+
+    void PacketMuxer::setError(const std::string &message, int error_code)
+    {
+        std::ostringstream oss;
+        oss << message;
+
+        if (error_code != 0)
+        {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(error_code, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            oss << ": " << errbuf;
+        }
+
+        last_error_ = oss.str();
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // Writes already encoded packets (stream copy or encoder output) into a
+    // container. Usage: create() -> addStream()... -> writeHeader() ->
+    // writePacket()... -> close().
+    class PacketMuxer
+    {
+    public:
+        PacketMuxer() = default;
+        ~PacketMuxer();
+
+        // Not Allowed to copy
+        PacketMuxer(const PacketMuxer &) = delete;
+        PacketMuxer &operator=(const PacketMuxer &) = delete;
+
+        // Allocate the output context; the container is guessed from the
+        // filename unless format_name is given
+        bool create(const std::string &filename, const std::string &format_name = "");
+
+        // Add an output stream with the given parameters.
+        // Returns the output stream index or -1.
+        int addStream(const AVCodecParameters *codecpar, AVRational time_base);
+
+        // Open the file and write the container header
+        bool writeHeader(AVDictionary **options = nullptr);
+
+        // Rescale pkt from src_time_base and write it to output stream stream_index.
+        // The packet is unreferenced in any case.
+        bool writePacket(AVPacket *pkt, int stream_index, AVRational src_time_base);
+
+        // Write the trailer and close the file
+        bool close();
+
+        // Time base chosen by the muxer (valid after writeHeader())
+        AVRational getTimeBase(int stream_index) const;
+        AVFormatContext *getFormatContext() const { return format_ctx_; }
+        int getNumStreams() const { return format_ctx_ ? static_cast<int>(format_ctx_->nb_streams) : 0; }
+
+        // Bytes written to the output so far
+        int64_t getBytesWritten() const;
+
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        AVFormatContext *format_ctx_{nullptr};
+        std::string filename_;
+        bool header_written_{false};
+        std::string last_error_;
+
+        void cleanup();
+
+        void setError(const std::string &message, int error_code = 0);
+    };
+}
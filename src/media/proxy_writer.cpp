@@ -0,0 +1,240 @@
+#include <media/proxy_writer.h>
+#include <media/codec_cache.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+extern "C"
+{
+#include <libavutil/dict.h>
+}
+
+namespace video_codec
+{
+    namespace
+    {
+        // Tag names; MOV keeps custom tags with movflags=use_metadata_tags
+        const char *const kSourceTag = "video_codec_proxy_source";
+        const char *const kSizeTag = "video_codec_proxy_source_size";
+        const char *const kTimeBaseTag = "video_codec_proxy_source_time_base";
+        const char *const kFrameRateTag = "video_codec_proxy_source_frame_rate";
+
+        std::string formatRational(AVRational value)
+        {
+            return std::to_string(value.num) + "/" + std::to_string(value.den);
+        }
+
+        bool parsePair(const char *text, char separator, int &first, int &second)
+        {
+            std::istringstream in(text ? text : "");
+            char sep = 0;
+            return static_cast<bool>(in >> first >> sep >> second) && sep == separator;
+        }
+    }
+
+    ProxyWriter::~ProxyWriter()
+    {
+        if (isOpen())
+            close();
+        cleanup();
+    }
+
+    bool ProxyWriter::open(const std::string &proxy_filename, const ProxySource &source, const ProxyOptions &options)
+    {
+        if (isOpen())
+            close();
+
+        if (source.width <= 0 || source.height <= 0 || source.time_base.num <= 0)
+        {
+            setError("Invalid proxy source");
+            return false;
+        }
+
+        // Downscale to the proxy height with even dimensions for 4:2:0
+        source_width_ = source.width;
+        source_height_ = source.height;
+        height_ = std::min(options.height > 0 ? options.height : source.height, source.height) & ~1;
+        width_ = static_cast<int>(static_cast<int64_t>(source.width) * height_ / source.height) & ~1;
+        if (width_ <= 0 || height_ <= 0)
+        {
+            setError("Proxy size too small");
+            return false;
+        }
+
+        if (!muxer_.create(proxy_filename, "mov"))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        bool mjpeg = options.codec == "mjpeg";
+        VideoEncoderSettings settings;
+        settings.codec_name = options.codec;
+        settings.width = width_;
+        settings.height = height_;
+        settings.pix_fmt = mjpeg ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_YUV420P; // MJPEG is full range
+        settings.time_base = source.time_base;
+        settings.framerate = source.frame_rate.num > 0 ? source.frame_rate : AVRational{30, 1};
+        settings.gop_size = 1; // Intra only
+        settings.max_b_frames = 0;
+        settings.thread_count = options.threads;
+        settings.global_header = (muxer_.getFormatContext()->oformat->flags & AVFMT_GLOBALHEADER) != 0;
+        if (mjpeg)
+            settings.bit_rate = static_cast<int64_t>(width_) * height_ * av_q2d(settings.framerate) / 2; // ~0.5 bit per pixel
+        else
+            settings.options = {{"preset", "veryfast"}, {"crf", "23"}};
+
+        if (!encoder_.open(settings))
+        {
+            setError(encoder_.getLastError());
+            return false;
+        }
+
+        AVCodecParameters *parameters = avcodec_parameters_alloc();
+        if (parameters && avcodec_parameters_from_context(parameters, encoder_.getCodecContext()) >= 0)
+            track_ = muxer_.addStream(parameters, source.time_base);
+        avcodec_parameters_free(&parameters);
+        if (track_ < 0)
+        {
+            setError("Could not add the proxy stream");
+            encoder_.close();
+            return false;
+        }
+
+        AVDictionary **metadata = &muxer_.getFormatContext()->metadata;
+        av_dict_set(metadata, kSourceTag, std::filesystem::path(source.filename).filename().string().c_str(), 0);
+        av_dict_set(metadata, kSizeTag, (std::to_string(source.width) + "x" + std::to_string(source.height)).c_str(), 0);
+        av_dict_set(metadata, kTimeBaseTag, formatRational(source.time_base).c_str(), 0);
+        av_dict_set(metadata, kFrameRateTag, formatRational(source.frame_rate).c_str(), 0);
+
+        AVDictionary *mux_options = nullptr;
+        av_dict_set(&mux_options, "movflags", "use_metadata_tags", 0);
+        bool header_written = muxer_.writeHeader(&mux_options);
+        av_dict_free(&mux_options);
+        if (!header_written)
+        {
+            setError(muxer_.getLastError());
+            encoder_.close();
+            return false;
+        }
+
+        if (!pool_.initialize(width_, height_, settings.pix_fmt))
+        {
+            setError("Could not allocate proxy frames");
+            encoder_.close();
+            return false;
+        }
+
+        sws_ctx_ = CodecCache::instance().acquireScaler(source.width, source.height, AV_PIX_FMT_RGB24,
+                                                        width_, height_, settings.pix_fmt, SWS_BILINEAR);
+        if (!sws_ctx_)
+        {
+            setError("Could not initialize proxy scaling context");
+            encoder_.close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ProxyWriter::writeFrame(const AVFrame *frame)
+    {
+        if (!isOpen())
+        {
+            setError("Proxy not open");
+            return false;
+        }
+
+        if (frame->width != source_width_ || frame->height != source_height_ || frame->format != AV_PIX_FMT_RGB24)
+        {
+            setError("Frame does not match the proxy source");
+            return false;
+        }
+
+        FramePtr scaled = pool_.acquire();
+        if (!scaled)
+        {
+            setError("Could not allocate proxy frame");
+            return false;
+        }
+
+        static StageMetrics &scale_metrics = PipelineMetrics::instance().stage("proxy scale");
+        timeStage(scale_metrics, frame->pts, [&]
+                  { return sws_scale(sws_ctx_, frame->data, frame->linesize, 0, source_height_,
+                                     scaled->data, scaled->linesize); });
+        scale_metrics.addFrames(1);
+
+        // Original timestamps are the mapping back to the source
+        scaled->pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        scaled->pict_type = AV_PICTURE_TYPE_I;
+
+        if (!encoder_.encode(scaled.get(), [&](AVPacket *pkt)
+                             { return muxer_.writePacket(pkt, track_, encoder_.getTimeBase()); }))
+        {
+            setError(encoder_.getLastError().empty() ? muxer_.getLastError() : encoder_.getLastError());
+            return false;
+        }
+        return true;
+    }
+
+    bool ProxyWriter::close()
+    {
+        if (!isOpen())
+            return true;
+
+        bool result = encoder_.flush([&](AVPacket *pkt)
+                                     { return muxer_.writePacket(pkt, track_, encoder_.getTimeBase()); });
+        result = muxer_.close() && result;
+        encoder_.close();
+        if (!result)
+            setError("Could not finish proxy: " + muxer_.getLastError());
+
+        cleanup();
+        return result;
+    }
+
+    void ProxyWriter::cleanup()
+    {
+        if (sws_ctx_)
+        {
+            CodecCache::instance().releaseScaler(sws_ctx_);
+            sws_ctx_ = nullptr;
+        }
+        pool_ = FramePool();
+        track_ = -1;
+    }
+
+    bool ProxyWriter::readSource(const AVFormatContext *format_ctx, ProxySource &source)
+    {
+        if (!format_ctx)
+            return false;
+
+        const AVDictionaryEntry *name = av_dict_get(format_ctx->metadata, kSourceTag, nullptr, 0);
+        const AVDictionaryEntry *size = av_dict_get(format_ctx->metadata, kSizeTag, nullptr, 0);
+        const AVDictionaryEntry *time_base = av_dict_get(format_ctx->metadata, kTimeBaseTag, nullptr, 0);
+        const AVDictionaryEntry *frame_rate = av_dict_get(format_ctx->metadata, kFrameRateTag, nullptr, 0);
+        if (!name || !size || !time_base)
+            return false;
+
+        source.filename = name->value;
+        if (!frame_rate || !parsePair(frame_rate->value, '/', source.frame_rate.num, source.frame_rate.den))
+            source.frame_rate = AVRational{0, 1};
+
+        return parsePair(size->value, 'x', source.width, source.height) &&
+               parsePair(time_base->value, '/', source.time_base.num, source.time_base.den) &&
+               source.time_base.num > 0 && source.time_base.den > 0;
+    }
+
+    std::string ProxyWriter::getProxyFilename(const std::string &filename)
+    {
+        return std::filesystem::path(filename).replace_extension(".proxy.mov").string();
+    }
+
+    void ProxyWriter::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/rational.h>
+#include <libswscale/swscale.h>
+}
+
+#include <media/frame_pool.h>
+#include <media/packet_muxer.h>
+#include <media/video_encoder.h>
+#include <string>
+
+namespace video_codec
+{
+    struct ProxyOptions
+    {
+        int height{540};            // Proxy height; the width keeps the aspect ratio. Never upscaled.
+        std::string codec{"mjpeg"}; // "mjpeg", or "libx264" for all-intra H.264
+        int threads{0};             // Encoder threads, 0 lets the encoder decide
+    };
+
+    // The original a proxy was made from, stored as container tags
+    struct ProxySource
+    {
+        std::string filename; // File name without directories
+        int width{0};
+        int height{0};
+        AVRational time_base{0, 1};
+        AVRational frame_rate{0, 1};
+    };
+
+    // Proxy: a downscaled, intra-only rendition for editing previews. Every
+    // frame is a keyframe, so any seek decodes a single small frame instead
+    // of a long GOP at full resolution.
+    //
+    // Frames keep the pts of the original in its time base, and the MOV
+    // container keeps that time base (timescale), so proxy and original
+    // timestamps map onto each other exactly.
+    class ProxyWriter
+    {
+    public:
+        ProxyWriter() = default;
+        ~ProxyWriter();
+
+        // Not Allowed to copy
+        ProxyWriter(const ProxyWriter &) = delete;
+        ProxyWriter &operator=(const ProxyWriter &) = delete;
+
+        bool open(const std::string &proxy_filename, const ProxySource &source, const ProxyOptions &options = {});
+
+        // RGB24 frame at the source size, pts in the source time base
+        bool writeFrame(const AVFrame *frame);
+
+        // Flush the encoder and write the trailer
+        bool close();
+
+        bool isOpen() const { return encoder_.isOpen(); }
+        int getWidth() const { return width_; }
+        int getHeight() const { return height_; }
+        const std::string &getLastError() const { return last_error_; }
+
+        // Read the source tags of a proxy; false if it has none
+        static bool readSource(const AVFormatContext *format_ctx, ProxySource &source);
+
+        // Proxy file name next to the original: video.mp4 -> video.proxy.mov
+        static std::string getProxyFilename(const std::string &filename);
+
+    private:
+        PacketMuxer muxer_;
+        VideoEncoder encoder_;
+        FramePool pool_;
+        SwsContext *sws_ctx_{nullptr};
+        int track_{-1};
+        int width_{0};
+        int height_{0};
+        int source_width_{0};
+        int source_height_{0};
+        std::string last_error_;
+
+        void cleanup();
+
+        void setError(const std::string &message);
+    };
+}
@@ -0,0 +1,402 @@
+#include <media/quality_compare.h>
+#include <media/codec_cache.h>
+#include <processing/quality_kernels.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+extern "C"
+{
+#include <libavutil/pixdesc.h>
+}
+
+namespace video_codec
+{
+    namespace
+    {
+        // PSNR of identical planes; JSON has no infinity
+        constexpr double kMaxPsnr = 100.0;
+
+        double psnrFromError(uint64_t squared_error, uint64_t pixels)
+        {
+            if (squared_error == 0 || pixels == 0)
+                return kMaxPsnr;
+            double mse = static_cast<double>(squared_error) / static_cast<double>(pixels);
+            return std::min(10.0 * std::log10(255.0 * 255.0 / mse), kMaxPsnr);
+        }
+
+        // Planar 8-bit YUV or gray, where every plane can be measured as is
+        bool isMetricFormat(AVPixelFormat format)
+        {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+            if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)))
+                return false;
+            if (desc->nb_components > 1 && !(desc->flags & AV_PIX_FMT_FLAG_PLANAR))
+                return false;
+
+            for (int c = 0; c < desc->nb_components; ++c)
+            {
+                if (desc->comp[c].depth != 8 || desc->comp[c].step != 1 || desc->comp[c].plane != c)
+                    return false;
+            }
+            return true;
+        }
+
+        // Run tasks on pool and help with them until all are done
+        void runTasks(ThreadPool &pool, std::vector<std::function<void()>> &tasks)
+        {
+            std::atomic<size_t> remaining{tasks.size()};
+            for (auto &task : tasks)
+            {
+                pool.submit([&task, &remaining]
+                            {
+                                task();
+                                remaining.fetch_sub(1, std::memory_order_release); });
+            }
+
+            while (remaining.load(std::memory_order_acquire) > 0)
+            {
+                if (!pool.runPendingTask())
+                    std::this_thread::yield();
+            }
+        }
+    }
+
+    bool QualityComparator::compare(const std::string &reference_filename, const std::string &distorted_filename,
+                                    QualityReport &report, const QualityOptions &options)
+    {
+        report = QualityReport();
+        release(reference_);
+        release(distorted_);
+
+        if (!openInput(reference_, reference_filename, options.threads) ||
+            !openInput(distorted_, distorted_filename, options.threads))
+            return false;
+
+        width_ = reference_.stream.getWidth();
+        height_ = reference_.stream.getHeight();
+        format_ = isMetricFormat(reference_.stream.getPixelFormat()) ? reference_.stream.getPixelFormat() : AV_PIX_FMT_YUV420P;
+
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format_);
+        report.planes = std::min<int>(desc->nb_components, 3);
+        report.width = width_;
+        report.height = height_;
+        report.pix_fmt = desc->name;
+        report.has_psnr = options.psnr;
+        report.has_ssim = options.ssim;
+
+        if (!pool_ || (options.threads > 0 && pool_->size() != static_cast<unsigned>(options.threads)))
+            pool_ = std::make_unique<ThreadPool>(options.threads > 0 ? options.threads : 0);
+
+        FramePtr reference = makeFrame();
+        FramePtr current = makeFrame();
+        FramePtr pending = makeFrame();
+        if (!reference || !current || !pending)
+        {
+            setError("Could not allocate frames");
+            return false;
+        }
+
+        // Half a reference frame absorbs timestamp rounding between time bases
+        double frame_rate = reference_.stream.getFrameRate();
+        double tolerance = frame_rate > 0 ? 0.5 / frame_rate : 0.001;
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("quality");
+        uint64_t squared_error[3] = {};
+        bool has_current = false;
+        bool has_pending = false;
+        bool distorted_ended = false;
+        double current_end = 0.0;
+        int64_t unmatched = 0;
+
+        while ((options.max_frames < 0 || static_cast<int>(report.frames.size()) < options.max_frames) &&
+               reference_.stream.readFrame(reference.get()))
+        {
+            double time = frameTime(reference_, reference.get());
+
+            // Bring the distorted side to the frame shown at time
+            while (!distorted_ended)
+            {
+                if (!has_pending)
+                {
+                    av_frame_unref(pending.get());
+                    has_pending = distorted_.stream.readFrame(pending.get());
+                    if (!has_pending)
+                    {
+                        distorted_ended = true;
+                        break;
+                    }
+                }
+
+                double pending_time = frameTime(distorted_, pending.get());
+                if (has_current && pending_time > time + tolerance)
+                    break;
+
+                std::swap(current, pending);
+                current_end = pending_time + (current->duration > 0 ? av_q2d(distorted_.stream.getTimeBase()) * static_cast<double>(current->duration) : 0.0);
+                has_current = true;
+                has_pending = false;
+            }
+
+            if (!has_current)
+            {
+                setError("Distorted video has no frames");
+                return false;
+            }
+            if (distorted_ended && time > current_end + tolerance)
+                ++unmatched;
+
+            const AVFrame *ref = toMetricFormat(reference_, reference.get());
+            const AVFrame *dist = toMetricFormat(distorted_, current.get());
+            if (!ref || !dist)
+                return false;
+
+            FrameQuality quality;
+            quality.frame = static_cast<int64_t>(report.frames.size());
+            quality.time = time;
+            uint64_t frame_error[3] = {};
+            if (!timeStage(metrics, quality.frame, [&]
+                           { return measure(ref, dist, options, quality, frame_error); }))
+                return false;
+            metrics.addFrames(1);
+
+            for (int p = 0; p < report.planes; ++p)
+                squared_error[p] += frame_error[p];
+            report.frames.push_back(quality);
+            av_frame_unref(reference.get());
+        }
+
+        if (report.frames.empty())
+        {
+            setError("Reference video has no frames");
+            return false;
+        }
+
+        if (unmatched > 0)
+            std::cerr << "Warning: distorted video ended " << unmatched
+                      << " frames before the reference; its last frame was compared to the rest" << std::endl;
+
+        // Aggregates
+        uint64_t total_error = 0;
+        uint64_t total_pixels = 0;
+        double ssim_weight = 0.0;
+        for (int p = 0; p < report.planes; ++p)
+        {
+            bool chroma = p > 0;
+            uint64_t plane_pixels = static_cast<uint64_t>(chroma ? AV_CEIL_RSHIFT(width_, desc->log2_chroma_w) : width_) *
+                                    static_cast<uint64_t>(chroma ? AV_CEIL_RSHIFT(height_, desc->log2_chroma_h) : height_);
+            uint64_t pixels = plane_pixels * report.frames.size();
+
+            report.psnr[p] = psnrFromError(squared_error[p], pixels);
+            total_error += squared_error[p];
+            total_pixels += pixels;
+
+            double ssim_sum = 0.0;
+            for (const auto &frame : report.frames)
+                ssim_sum += frame.ssim[p];
+            report.ssim[p] = ssim_sum / static_cast<double>(report.frames.size());
+            report.ssim_all += report.ssim[p] * static_cast<double>(plane_pixels);
+            ssim_weight += static_cast<double>(plane_pixels);
+        }
+        report.psnr_all = psnrFromError(total_error, total_pixels);
+        report.ssim_all = ssim_weight > 0 ? report.ssim_all / ssim_weight : 0.0;
+
+        std::cerr << "Compared " << report.frames.size() << " frames";
+        if (report.has_psnr)
+            std::cerr << ", PSNR " << report.psnr_all << " dB";
+        if (report.has_ssim)
+            std::cerr << ", SSIM " << report.ssim_all;
+        std::cerr << std::endl;
+        return true;
+    }
+
+    bool QualityComparator::openInput(Input &input, const std::string &filename, int threads)
+    {
+        if (!input.file.open(filename))
+        {
+            setError("Could not open " + filename);
+            return false;
+        }
+
+        int index = av_find_best_stream(input.file.getFormatContext(), AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (index < 0 || !input.stream.initialize(input.file.getFormatContext(), index, threads))
+        {
+            setError("No decodable video stream in " + filename);
+            return false;
+        }
+        return true;
+    }
+
+    const AVFrame *QualityComparator::toMetricFormat(Input &input, const AVFrame *frame)
+    {
+        if (frame->format == format_ && frame->width == width_ && frame->height == height_)
+            return frame;
+
+        if (!input.sws_ctx)
+        {
+            input.sws_ctx = CodecCache::instance().acquireScaler(frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                                                 width_, height_, format_, SWS_BICUBIC);
+            input.converted = makeFrame();
+            if (!input.sws_ctx || !input.converted)
+            {
+                setError("Could not initialize conversion to the metric format");
+                return nullptr;
+            }
+
+            input.converted->format = format_;
+            input.converted->width = width_;
+            input.converted->height = height_;
+            if (av_frame_get_buffer(input.converted.get(), 32) < 0)
+            {
+                setError("Could not allocate converted frame");
+                return nullptr;
+            }
+        }
+
+        sws_scale(input.sws_ctx, frame->data, frame->linesize, 0, frame->height,
+                  input.converted->data, input.converted->linesize);
+        return input.converted.get();
+    }
+
+    double QualityComparator::frameTime(Input &input, const AVFrame *frame) const
+    {
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (pts == AV_NOPTS_VALUE)
+            return 0.0;
+
+        if (input.origin == AV_NOPTS_VALUE)
+            input.origin = pts;
+        return av_q2d(input.stream.getTimeBase()) * static_cast<double>(pts - input.origin);
+    }
+
+    bool QualityComparator::measure(const AVFrame *reference, const AVFrame *distorted, const QualityOptions &options,
+                                    FrameQuality &quality, uint64_t squared_error[3])
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format_);
+        int planes = std::min<int>(desc->nb_components, 3);
+
+        // Bands of rows per plane and metric; every task writes its own slot
+        struct Band
+        {
+            int plane;
+            int first;
+            int last;
+            uint64_t squared_error{0};
+            double ssim_sum{0.0};
+        };
+        std::vector<Band> psnr_bands;
+        std::vector<Band> ssim_bands;
+        int plane_width[3] = {};
+        int plane_height[3] = {};
+        int bands_per_plane = static_cast<int>(std::max(pool_->size(), 1u));
+
+        for (int p = 0; p < planes; ++p)
+        {
+            plane_width[p] = p > 0 ? AV_CEIL_RSHIFT(width_, desc->log2_chroma_w) : width_;
+            plane_height[p] = p > 0 ? AV_CEIL_RSHIFT(height_, desc->log2_chroma_h) : height_;
+
+            if (options.psnr)
+            {
+                int bands = std::clamp(plane_height[p] / 16, 1, bands_per_plane);
+                for (int b = 0; b < bands; ++b)
+                    psnr_bands.push_back({p, plane_height[p] * b / bands, plane_height[p] * (b + 1) / bands});
+            }
+
+            // Window rows: one per pair of consecutive 4-pixel block rows
+            int window_rows = plane_height[p] / 4 - 1;
+            if (options.ssim && window_rows > 0 && plane_width[p] / 4 > 1)
+            {
+                int bands = std::clamp(window_rows / 8, 1, bands_per_plane);
+                for (int b = 0; b < bands; ++b)
+                    ssim_bands.push_back({p, window_rows * b / bands, window_rows * (b + 1) / bands});
+            }
+        }
+
+        std::vector<std::function<void()>> tasks;
+        for (Band &band : psnr_bands)
+        {
+            tasks.emplace_back([&, &band = band]
+                               {
+                                   int p = band.plane;
+                                   for (int y = band.first; y < band.last; ++y)
+                                   {
+                                       band.squared_error += sumSquaredDiff(reference->data[p] + static_cast<ptrdiff_t>(y) * reference->linesize[p],
+                                                                            distorted->data[p] + static_cast<ptrdiff_t>(y) * distorted->linesize[p],
+                                                                            plane_width[p]);
+                                   } });
+        }
+        for (Band &band : ssim_bands)
+        {
+            tasks.emplace_back([&, &band = band]
+                               {
+                                   int p = band.plane;
+                                   int blocks = plane_width[p] / 4;
+                                   std::vector<int32_t> top(static_cast<size_t>(blocks) * 4);
+                                   std::vector<int32_t> bottom(top.size());
+                                   auto blockRow = [&](int row, std::vector<int32_t> &sums)
+                                   {
+                                       ssimBlockSums(reference->data[p] + static_cast<ptrdiff_t>(row) * 4 * reference->linesize[p], reference->linesize[p],
+                                                     distorted->data[p] + static_cast<ptrdiff_t>(row) * 4 * distorted->linesize[p], distorted->linesize[p],
+                                                     blocks, reinterpret_cast<int32_t(*)[4]>(sums.data()));
+                                   };
+
+                                   blockRow(band.first, top);
+                                   for (int row = band.first; row < band.last; ++row)
+                                   {
+                                       blockRow(row + 1, bottom);
+                                       band.ssim_sum += ssimWindowRow(reinterpret_cast<const int32_t(*)[4]>(top.data()),
+                                                                      reinterpret_cast<const int32_t(*)[4]>(bottom.data()), blocks - 1);
+                                       top.swap(bottom);
+                                   } });
+        }
+        runTasks(*pool_, tasks);
+
+        uint64_t total_error = 0;
+        uint64_t total_pixels = 0;
+        double ssim_sum[3] = {};
+        for (const Band &band : psnr_bands)
+            squared_error[band.plane] += band.squared_error;
+        for (const Band &band : ssim_bands)
+            ssim_sum[band.plane] += band.ssim_sum;
+
+        double ssim_weight = 0.0;
+        for (int p = 0; p < planes; ++p)
+        {
+            uint64_t pixels = static_cast<uint64_t>(plane_width[p]) * static_cast<uint64_t>(plane_height[p]);
+            quality.psnr[p] = psnrFromError(squared_error[p], pixels);
+            total_error += squared_error[p];
+            total_pixels += pixels;
+
+            int64_t windows = static_cast<int64_t>(plane_width[p] / 4 - 1) * (plane_height[p] / 4 - 1);
+            quality.ssim[p] = windows > 0 ? ssim_sum[p] / static_cast<double>(windows) : 1.0;
+            quality.ssim_all += quality.ssim[p] * static_cast<double>(pixels);
+            ssim_weight += static_cast<double>(pixels);
+        }
+        quality.psnr_all = psnrFromError(total_error, total_pixels);
+        quality.ssim_all = ssim_weight > 0 ? quality.ssim_all / ssim_weight : 0.0;
+        return true;
+    }
+
+    void QualityComparator::release(Input &input)
+    {
+        if (input.sws_ctx)
+        {
+            CodecCache::instance().releaseScaler(input.sws_ctx);
+            input.sws_ctx = nullptr;
+        }
+        input.converted.reset();
+        input.stream = VideoStream();
+        input.file.close();
+        input.origin = AV_NOPTS_VALUE;
+    }
+
+    void QualityComparator::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+}
+
+#include <graph/thread_pool.h>
+#include <media/frame_ref.h>
+#include <media/media_file.h>
+#include <media/video_stream.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    struct QualityOptions
+    {
+        bool psnr{true};
+        bool ssim{true};
+        int threads{0};      // Metric and decoder threads, 0 uses the hardware concurrency
+        int max_frames{-1};  // Reference frames to compare, -1 for all
+    };
+
+    // Metrics of one reference frame. Index 0 is luma, 1 and 2 chroma;
+    // "all" weights the planes by their pixel counts.
+    struct FrameQuality
+    {
+        int64_t frame{0};
+        double time{0.0}; // Seconds from the first reference frame
+        double psnr[3]{};
+        double psnr_all{0.0};
+        double ssim[3]{};
+        double ssim_all{0.0};
+    };
+
+    struct QualityReport
+    {
+        // Metrics that were measured (QualityOptions); the fields of the
+        // others, also in the frames, hold no values
+        bool has_psnr{false};
+        bool has_ssim{false};
+
+        int planes{0};
+        int width{0};
+        int height{0};
+        std::string pix_fmt;
+        std::vector<FrameQuality> frames;
+
+        // Aggregates: PSNR from the mean squared error of all frames,
+        // SSIM as the mean of the frame values
+        double psnr[3]{};
+        double psnr_all{0.0};
+        double ssim[3]{};
+        double ssim_all{0.0};
+    };
+
+    // Full-reference quality metrics of an encode against its source.
+    //
+    // Both files are decoded in lockstep and matched by presentation time,
+    // relative to their first frames: every reference frame is compared
+    // with the distorted frame shown at the same time, so outputs with
+    // dropped duplicates or other frame rate changes still line up.
+    //
+    // Metrics are computed on planar 8-bit YUV: the reference's own format
+    // when it is one, else yuv420p. The distorted video is converted to the
+    // reference's format and size when they differ. Planes are split into
+    // bands computed in parallel on a ThreadPool.
+    class QualityComparator
+    {
+    public:
+        QualityComparator() = default;
+
+        // Not Allowed to copy
+        QualityComparator(const QualityComparator &) = delete;
+        QualityComparator &operator=(const QualityComparator &) = delete;
+
+        bool compare(const std::string &reference_filename, const std::string &distorted_filename,
+                     QualityReport &report, const QualityOptions &options = {});
+
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        // Decoded input converted to the metric format on demand
+        struct Input
+        {
+            MediaFile file;
+            VideoStream stream;
+            SwsContext *sws_ctx{nullptr};
+            FramePtr converted;
+            int64_t origin{AV_NOPTS_VALUE};
+        };
+
+        Input reference_;
+        Input distorted_;
+        std::unique_ptr<ThreadPool> pool_;
+        AVPixelFormat format_{AV_PIX_FMT_NONE};
+        int width_{0};
+        int height_{0};
+        std::string last_error_;
+
+        bool openInput(Input &input, const std::string &filename, int threads);
+
+        // frame in the metric format: itself, or converted into input.converted
+        const AVFrame *toMetricFormat(Input &input, const AVFrame *frame);
+
+        // Seconds of frame since the first frame of input
+        double frameTime(Input &input, const AVFrame *frame) const;
+
+        bool measure(const AVFrame *reference, const AVFrame *distorted, const QualityOptions &options,
+                     FrameQuality &quality, uint64_t squared_error[3]);
+
+        void release(Input &input);
+
+        void setError(const std::string &message);
+    };
+}
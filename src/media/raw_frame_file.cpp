@@ -0,0 +1,386 @@
+#include <media/raw_frame_file.h>
+#include <processing/frame_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/pixdesc.h>
+}
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace video_codec
+{
+    namespace
+    {
+        constexpr char kMagic[8] = {'V', 'C', 'R', 'A', 'W', 'F', 'R', '1'};
+        constexpr uint32_t kVersion = 1;
+        constexpr uint64_t kSlotAlignment = 4096; // Page size, so slots map on page boundaries
+        constexpr int kLineAlignment = 64;        // Cache line, and enough for SIMD loads
+
+        uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // Rows of plane i, chroma planes are subsampled
+        int planeHeight(const AVPixFmtDescriptor *desc, int plane, int height)
+        {
+            if (plane == 1 || plane == 2)
+                return -((-height) >> desc->log2_chroma_h);
+            return height;
+        }
+
+        // Slot layout of a frame geometry: fixed-stride planes one after another.
+        // Fills plane_count, linesize, plane_offset, frame_size and data_offset
+        // of header, and the unpadded row bytes and rows of every plane.
+        bool computeLayout(AVPixelFormat pix_fmt, int width, int height, RawFrameHeader &header,
+                           int row_bytes[4], int plane_height[4])
+        {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(pix_fmt);
+            int linesize[4] = {};
+            if (!desc || width <= 0 || height <= 0 || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) ||
+                av_image_fill_linesizes(linesize, pix_fmt, width) < 0)
+                return false;
+
+            header.plane_count = av_pix_fmt_count_planes(pix_fmt);
+            if (header.plane_count <= 0 || header.plane_count > 4)
+                return false;
+
+            uint64_t offset = 0;
+            for (int i = 0; i < header.plane_count; ++i)
+            {
+                row_bytes[i] = linesize[i];
+                header.linesize[i] = static_cast<int32_t>(alignUp(linesize[i], kLineAlignment));
+                header.plane_offset[i] = offset;
+                plane_height[i] = planeHeight(desc, i, height);
+                offset += alignUp(static_cast<uint64_t>(header.linesize[i]) * plane_height[i], kLineAlignment);
+            }
+            header.frame_size = alignUp(offset, kSlotAlignment);
+            header.data_offset = alignUp(sizeof(RawFrameHeader), kSlotAlignment);
+            return true;
+        }
+    }
+
+    struct RawFrameReader::Mapping
+    {
+        uint8_t *data{nullptr};
+        size_t size{0};
+
+        ~Mapping()
+        {
+            if (data)
+                munmap(data, size);
+        }
+    };
+
+    RawFrameWriter::~RawFrameWriter()
+    {
+        if (file_)
+            close();
+    }
+
+    bool RawFrameWriter::open(const std::string &filename, int width, int height, AVPixelFormat pix_fmt,
+                              AVRational time_base, AVRational frame_rate)
+    {
+        if (file_)
+            close();
+
+        header_ = RawFrameHeader{};
+        if (!computeLayout(pix_fmt, width, height, header_, row_bytes_, plane_height_))
+        {
+            setError("Unsupported raw frame geometry or pixel format");
+            return false;
+        }
+
+        std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+        header_.version = kVersion;
+        header_.header_size = sizeof(RawFrameHeader);
+        header_.width = width;
+        header_.height = height;
+        std::strncpy(header_.pix_fmt, av_get_pix_fmt_name(pix_fmt), sizeof(header_.pix_fmt) - 1);
+        header_.time_base = time_base;
+        header_.frame_rate = frame_rate;
+
+        file_ = std::fopen(filename.c_str(), "wb");
+        if (!file_)
+        {
+            setError("Could not open raw frame output: " + filename);
+            return false;
+        }
+
+        // Placeholder header, completed by close()
+        slot_.assign(header_.frame_size, 0);
+        index_.clear();
+        std::vector<uint8_t> head(header_.data_offset, 0);
+        std::memcpy(head.data(), &header_, sizeof(header_));
+        if (std::fwrite(head.data(), 1, head.size(), file_) != head.size())
+        {
+            setError("Could not write raw frame header");
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool RawFrameWriter::writeFrame(const AVFrame *frame)
+    {
+        if (!file_)
+        {
+            setError("Raw frame output is not open");
+            return false;
+        }
+
+        if (frame->width != header_.width || frame->height != header_.height ||
+            frame->format != av_get_pix_fmt(header_.pix_fmt))
+        {
+            setError("Frame does not match the raw frame output");
+            return false;
+        }
+
+        for (int i = 0; i < header_.plane_count; ++i)
+        {
+            av_image_copy_plane(slot_.data() + header_.plane_offset[i], header_.linesize[i],
+                                frame->data[i], frame->linesize[i], row_bytes_[i], plane_height_[i]);
+        }
+
+        if (std::fwrite(slot_.data(), 1, slot_.size(), file_) != slot_.size())
+        {
+            setError("Could not write raw frame");
+            return false;
+        }
+
+        int64_t default_duration = header_.frame_rate.num > 0
+                                       ? av_rescale_q(1, av_inv_q(header_.frame_rate), header_.time_base)
+                                       : 1;
+        int64_t pts = frame->pts != AV_NOPTS_VALUE ? frame->pts
+                                                   : static_cast<int64_t>(index_.size()) * default_duration;
+        index_.push_back({pts, frame->duration > 0 ? frame->duration : default_duration});
+        return true;
+    }
+
+    bool RawFrameWriter::close()
+    {
+        if (!file_)
+            return true;
+
+        header_.frame_count = index_.size();
+        header_.index_offset = header_.data_offset + header_.frame_count * header_.frame_size;
+
+        bool result = std::fwrite(index_.data(), sizeof(RawFrameIndexEntry), index_.size(), file_) == index_.size() &&
+                      std::fseek(file_, 0, SEEK_SET) == 0 &&
+                      std::fwrite(&header_, sizeof(header_), 1, file_) == 1;
+        result = std::fclose(file_) == 0 && result;
+        file_ = nullptr;
+        slot_.clear();
+
+        if (!result)
+            setError("Could not finish raw frame output");
+        return result;
+    }
+
+    void RawFrameWriter::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+
+    bool RawFrameReader::open(const std::string &filename)
+    {
+        mapping_.reset();
+        index_ = nullptr;
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            setError("Could not open raw frame input: " + filename);
+            return false;
+        }
+
+        struct stat info{};
+        auto mapping = std::make_shared<Mapping>();
+        if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(RawFrameHeader)))
+        {
+            // Private and writable: in-place processors get copy-on-write pages
+            void *data = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                mapping->data = static_cast<uint8_t *>(data);
+                mapping->size = info.st_size;
+            }
+        }
+        ::close(fd);
+
+        if (!mapping->data)
+        {
+            setError("Could not map raw frame input: " + filename);
+            return false;
+        }
+
+        std::memcpy(&header_, mapping->data, sizeof(header_));
+        pix_fmt_ = av_get_pix_fmt(std::string(header_.pix_fmt, strnlen(header_.pix_fmt, sizeof(header_.pix_fmt))).c_str());
+
+        // The layout must be exactly what the writer derives from the
+        // geometry, so that every plane lies inside its slot
+        RawFrameHeader layout{};
+        int row_bytes[4] = {};
+        int plane_height[4] = {};
+        bool valid = std::memcmp(header_.magic, kMagic, sizeof(kMagic)) == 0 &&
+                     header_.version == kVersion &&
+                     header_.header_size == sizeof(RawFrameHeader) &&
+                     pix_fmt_ != AV_PIX_FMT_NONE &&
+                     computeLayout(pix_fmt_, header_.width, header_.height, layout, row_bytes, plane_height) &&
+                     header_.plane_count == layout.plane_count &&
+                     header_.frame_size == layout.frame_size &&
+                     header_.data_offset == layout.data_offset;
+        for (int i = 0; valid && i < layout.plane_count; ++i)
+            valid = header_.linesize[i] == layout.linesize[i] && header_.plane_offset[i] == layout.plane_offset[i];
+
+        // Everything the header points to must lie inside the file
+        uint64_t size = mapping->size;
+        valid = valid &&
+                header_.frame_count <= (size - std::min(size, header_.data_offset)) / header_.frame_size &&
+                header_.index_offset == header_.data_offset + header_.frame_count * header_.frame_size &&
+                header_.frame_count <= (size - std::min(size, header_.index_offset)) / sizeof(RawFrameIndexEntry);
+
+        if (!valid)
+        {
+            setError("Invalid or incomplete raw frame file: " + filename);
+            return false;
+        }
+
+        mapping_ = std::move(mapping);
+        index_ = reinterpret_cast<const RawFrameIndexEntry *>(mapping_->data + header_.index_offset);
+        return true;
+    }
+
+    FramePtr RawFrameReader::getFrame(uint64_t index) const
+    {
+        if (!mapping_ || index >= header_.frame_count)
+            return nullptr;
+
+        FramePtr frame = makeFrame();
+        if (!frame)
+            return nullptr;
+
+        uint8_t *slot = mapping_->data + header_.data_offset + index * header_.frame_size;
+
+        // The buffer holds a reference to the mapping instead of owning memory
+        auto *owner = new std::shared_ptr<Mapping>(mapping_);
+        frame->buf[0] = av_buffer_create(
+            slot, header_.frame_size, [](void *opaque, uint8_t *)
+            { delete static_cast<std::shared_ptr<Mapping> *>(opaque); },
+            owner, 0);
+        if (!frame->buf[0])
+        {
+            delete owner;
+            return nullptr;
+        }
+
+        frame->width = header_.width;
+        frame->height = header_.height;
+        frame->format = pix_fmt_;
+        for (int i = 0; i < header_.plane_count; ++i)
+        {
+            frame->data[i] = slot + header_.plane_offset[i];
+            frame->linesize[i] = header_.linesize[i];
+        }
+        frame->pts = index_[index].pts;
+        frame->best_effort_timestamp = index_[index].pts;
+        frame->duration = index_[index].duration;
+        frame->time_base = header_.time_base;
+
+        return frame;
+    }
+
+    void RawFrameReader::readAhead(uint64_t index, uint64_t count) const
+    {
+        if (index >= header_.frame_count)
+            return;
+
+        count = std::min(count, header_.frame_count - index);
+        madvise(mapping_->data + header_.data_offset + index * header_.frame_size,
+                count * header_.frame_size, MADV_WILLNEED);
+    }
+
+    bool RawFrameReader::processFrames(FrameProcessor &processor, int max_frames, int batch_size)
+    {
+        if (!mapping_)
+        {
+            setError("Raw frame input is not open");
+            return false;
+        }
+
+        uint64_t frame_count = header_.frame_count;
+        if (max_frames > 0)
+            frame_count = std::min<uint64_t>(frame_count, max_frames);
+        batch_size = std::max(1, batch_size);
+
+        // Sequential pass: aggressive kernel readahead, plus an explicit
+        // window since one frame is often larger than the default readahead
+        constexpr uint64_t kReadAheadFrames = 4;
+        madvise(mapping_->data, mapping_->size, MADV_SEQUENTIAL);
+        readAhead(0, kReadAheadFrames);
+
+        static StageMetrics &process_metrics = PipelineMetrics::instance().stage("process");
+
+        std::vector<FramePtr> batch;
+        std::vector<AVFrame *> batch_view;
+        for (uint64_t i = 0; i < frame_count; i += batch_size)
+        {
+            uint64_t count = std::min<uint64_t>(batch_size, frame_count - i);
+            readAhead(i + kReadAheadFrames, count);
+
+            batch.clear();
+            batch_view.clear();
+            for (uint64_t j = i; j < i + count; ++j)
+            {
+                batch.push_back(getFrame(j));
+                if (!batch.back())
+                {
+                    setError("Could not create frame " + std::to_string(j));
+                    return false;
+                }
+                batch_view.push_back(batch.back().get());
+            }
+
+            int first = static_cast<int>(i);
+            process_metrics.addFrames(count);
+            bool ok = batch_size == 1
+                          ? timeStage(process_metrics, first, [&]
+                                      { return processor.consumeFrame(std::move(batch.front()), first); })
+                          : timeStage(process_metrics, first, [&]
+                                      { return processor.processFrames(batch_view, first); });
+            if (!ok)
+            {
+                setError("Frame processing error at frame " + std::to_string(i));
+                return false;
+            }
+        }
+
+        std::cout << "Processed " << frame_count << " frames" << std::endl;
+        return true;
+    }
+
+    void RawFrameReader::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+
+    bool isRawFrameFile(const std::string &filename)
+    {
+        return std::filesystem::path(filename).extension() == ".vcraw";
+    }
+}
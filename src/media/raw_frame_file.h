@@ -0,0 +1,142 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libavutil/rational.h>
+}
+
+#include <media/frame_ref.h>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    class FrameProcessor;
+
+    // Intermediate file of decoded frames for multi-pass workflows (.vcraw).
+    //
+    // Layout, in native byte order:
+    //   RawFrameHeader                   at 0
+    //   frame slots                      from data_offset, frame_size bytes each
+    //   RawFrameIndexEntry[frame_count]  at index_offset
+    //
+    // Every slot holds the planes of one frame with fixed linesizes at
+    // fixed offsets and starts on a page boundary, so a reader maps the
+    // file and points AVFrame planes straight into the mapping.
+    // frame_count stays 0 until the writer is closed; an incomplete file
+    // is rejected.
+    struct RawFrameHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        int32_t width;
+        int32_t height;
+        char pix_fmt[32]; // av_get_pix_fmt_name()
+        AVRational time_base;
+        AVRational frame_rate;
+        int32_t plane_count;
+        int32_t linesize[4];
+        uint64_t plane_offset[4];
+        uint64_t frame_size;
+        uint64_t data_offset;
+        uint64_t frame_count;
+        uint64_t index_offset;
+    };
+
+    struct RawFrameIndexEntry
+    {
+        int64_t pts;
+        int64_t duration;
+    };
+
+    // Writes frames of one geometry and pixel format
+    class RawFrameWriter
+    {
+    public:
+        RawFrameWriter() = default;
+        ~RawFrameWriter();
+
+        // Not Allowed to copy
+        RawFrameWriter(const RawFrameWriter &) = delete;
+        RawFrameWriter &operator=(const RawFrameWriter &) = delete;
+
+        bool open(const std::string &filename, int width, int height, AVPixelFormat pix_fmt,
+                  AVRational time_base, AVRational frame_rate);
+
+        // Frames without pts are numbered in frame_rate steps
+        bool writeFrame(const AVFrame *frame);
+
+        // Write the index and the final header
+        bool close();
+
+        bool isOpen() const { return file_ != nullptr; }
+        uint64_t getFrameCount() const { return index_.size(); }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        FILE *file_{nullptr};
+        RawFrameHeader header_{};
+        std::vector<uint8_t> slot_;
+        std::vector<RawFrameIndexEntry> index_;
+        int row_bytes_[4]{};
+        int plane_height_[4]{};
+        std::string last_error_;
+
+        void setError(const std::string &message);
+    };
+
+    // Memory-mapped reader. Frames reference the mapping, which stays
+    // alive as long as any frame does. The mapping is private, so
+    // processors that modify frames in place only copy the pages they touch
+    // and never change the file.
+    class RawFrameReader
+    {
+    public:
+        RawFrameReader() = default;
+
+        // Not Allowed to copy
+        RawFrameReader(const RawFrameReader &) = delete;
+        RawFrameReader &operator=(const RawFrameReader &) = delete;
+
+        bool open(const std::string &filename);
+
+        // Frame at index without copying pixel data (nullptr if out of range)
+        FramePtr getFrame(uint64_t index) const;
+
+        // Hand frames to processor in order, like VideoStream::processFrames().
+        // batch_size > 1 uses FrameProcessor::processFrames().
+        bool processFrames(FrameProcessor &processor, int max_frames = -1, int batch_size = 1);
+
+        // Getter
+        int getWidth() const { return header_.width; }
+        int getHeight() const { return header_.height; }
+        AVPixelFormat getPixelFormat() const { return pix_fmt_; }
+        AVRational getTimeBase() const { return header_.time_base; }
+        double getFrameRate() const { return av_q2d(header_.frame_rate); }
+        uint64_t getFrameCount() const { return header_.frame_count; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        struct Mapping;
+
+        std::shared_ptr<Mapping> mapping_;
+        RawFrameHeader header_{};
+        AVPixelFormat pix_fmt_{AV_PIX_FMT_NONE};
+        const RawFrameIndexEntry *index_{nullptr};
+        std::string last_error_;
+
+        // Ask the kernel to read the slots after index ahead
+        void readAhead(uint64_t index, uint64_t count) const;
+
+        void setError(const std::string &message);
+    };
+
+    // Extension of raw frame files
+    bool isRawFrameFile(const std::string &filename);
+}
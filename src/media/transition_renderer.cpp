@@ -0,0 +1,499 @@
+#include <media/transition_renderer.h>
+#include <media/bitstream.h>
+#include <media/media_concat.h>
+#include <processing/blend_kernels.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace video_codec
+{
+    TransitionRenderer::Clip::~Clip()
+    {
+        if (sws_ctx)
+            sws_freeContext(sws_ctx);
+    }
+
+    bool TransitionRenderer::render(const std::string &first_filename, const std::string &second_filename,
+                                    const std::string &output_filename, const TransitionOptions &options)
+    {
+        Clip first, second;
+        if (!openClip(first_filename, first) || !openClip(second_filename, second))
+            return false;
+
+        const AVCodecParameters *out_par = first.file.getFormatContext()->streams[first.video_index]->codecpar;
+        const AVCodecParameters *second_par = second.file.getFormatContext()->streams[second.video_index]->codecpar;
+        out_time_base_ = first.time_base;
+        last_dts_ = AV_NOPTS_VALUE;
+
+        // Overlap, limited to the shorter clip
+        int64_t duration_us = std::llround(options.duration * AV_TIME_BASE);
+        int64_t overlap = std::min({av_rescale_q(duration_us, AV_TIME_BASE_Q, first.time_base),
+                                    first.end - first.start,
+                                    av_rescale_q(second.end - second.start, second.time_base, first.time_base)});
+        if (overlap <= 0)
+        {
+            setError("Transition duration must be positive");
+            return false;
+        }
+
+        // Overlap start relative to the first clip, which is where the second clip starts
+        int64_t overlap_start = first.end - first.start - overlap;
+
+        // Last keyframe of the first clip at or before the overlap
+        int64_t first_keyframe = first.start;
+        for (int64_t ts : first.keyframes)
+        {
+            if (ts - first.start <= overlap_start)
+                first_keyframe = ts;
+        }
+
+        // First keyframe of the second clip after the overlap. Its packets can
+        // only share the output track if the codec parameters match exactly;
+        // otherwise the whole second clip is re-encoded.
+        int64_t second_keyframe = std::numeric_limits<int64_t>::max();
+        if (codecParametersMatch(out_par, second_par))
+        {
+            int64_t overlap_end = second.start + av_rescale_q(overlap, first.time_base, second.time_base);
+            auto it = std::lower_bound(second.keyframes.begin(), second.keyframes.end(), overlap_end);
+            if (it != second.keyframes.end())
+                second_keyframe = *it;
+        }
+        else
+            std::cerr << "Second clip does not match the first one and will be re-encoded" << std::endl;
+
+        // Output track with the parameters of the first clip
+        if (!muxer_.create(output_filename) || muxer_.addStream(out_par, first.time_base) < 0 || !muxer_.writeHeader())
+        {
+            setError(muxer_.getLastError());
+            muxer_.close();
+            return false;
+        }
+
+        AVPixelFormat work_format = static_cast<AVPixelFormat>(out_par->format);
+        if (!work_pool_.initialize(out_par->width, out_par->height, work_format))
+        {
+            setError("Could not allocate transition frames");
+            muxer_.close();
+            return false;
+        }
+
+        // Encoder for the overlap. Parameter sets stay in-band since the
+        // track keeps the extradata of the first clip.
+        const AVStream *first_stream = first.file.getFormatContext()->streams[first.video_index];
+        VideoEncoderSettings settings;
+        settings.codec_name = options.encoder_name;
+        settings.codec_id = out_par->codec_id;
+        settings.width = out_par->width;
+        settings.height = out_par->height;
+        settings.pix_fmt = work_format;
+        settings.time_base = first.time_base;
+        settings.framerate = first_stream->avg_frame_rate.num > 0 ? first_stream->avg_frame_rate : first_stream->r_frame_rate;
+        settings.bit_rate = out_par->bit_rate;
+        settings.global_header = false;
+        settings.max_b_frames = 0; // dts == pts, so encoded packets line up with the copied ones
+
+        if (!encoder_.open(settings))
+        {
+            setError(encoder_.getLastError());
+            muxer_.close();
+            return false;
+        }
+
+        length_size_ = 0;
+        if (!usesLengthPrefixedNals(out_par, length_size_))
+            length_size_ = 0;
+
+        int64_t second_offset = overlap_start;
+        bool copy_second = second_keyframe != std::numeric_limits<int64_t>::max();
+
+        std::cout << "Copying " << first_filename << " up to "
+                  << av_q2d(first.time_base) * (first_keyframe - first.start) << "s" << std::endl;
+
+        // Leading pictures of an open GOP follow the keyframe in decode order
+        // but are shown before it; they are re-encoded from where the copy ends
+        int64_t copied_end = first.start;
+        bool result = copyPackets(first, first.start, first_keyframe, 0, &copied_end);
+
+        if (result)
+        {
+            std::cout << "Rendering transition of " << av_q2d(first.time_base) * overlap << "s" << std::endl;
+            result = renderOverlap(first, second, std::min(copied_end, first_keyframe), second_keyframe,
+                                   overlap_start, overlap, options);
+        }
+
+        if (result && copy_second)
+        {
+            std::cout << "Copying " << second_filename << " from "
+                      << av_q2d(second.time_base) * (second_keyframe - second.start) << "s" << std::endl;
+            result = copyPackets(second, second_keyframe, std::numeric_limits<int64_t>::max(), second_offset);
+        }
+
+        encoder_.close();
+
+        if (!muxer_.close() && result)
+        {
+            setError(muxer_.getLastError());
+            result = false;
+        }
+
+        if (result)
+            std::cout << "Transition written to " << output_filename << std::endl;
+
+        return result;
+    }
+
+    bool TransitionRenderer::openClip(const std::string &filename, Clip &clip)
+    {
+        if (!clip.file.open(filename))
+        {
+            setError("Could not open clip: " + filename);
+            return false;
+        }
+
+        AVFormatContext *ctx = clip.file.getFormatContext();
+        clip.video_index = av_find_best_stream(ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (clip.video_index < 0)
+        {
+            setError("Clip has no video stream: " + filename);
+            return false;
+        }
+
+        clip.stream = clip.file.getVideoStream(clip.video_index);
+        if (!clip.stream.getCodecContext())
+        {
+            setError("Could not open the video decoder of " + filename);
+            return false;
+        }
+
+        const AVStream *stream = ctx->streams[clip.video_index];
+        clip.time_base = stream->time_base;
+        clip.start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+
+        AVRational frame_rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+        if (frame_rate.num > 0 && frame_rate.den > 0)
+            clip.frame_duration = std::max<int64_t>(1, av_rescale_q(1, av_inv_q(frame_rate), clip.time_base));
+
+        // Index keyframes and the end of the clip from the packets alone
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt)
+        {
+            setError("Could not allocate packet");
+            return false;
+        }
+
+        clip.end = clip.start;
+        while (av_read_frame(ctx, pkt) >= 0)
+        {
+            if (pkt->stream_index == clip.video_index)
+            {
+                int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+                if (ts != AV_NOPTS_VALUE)
+                {
+                    if (pkt->flags & AV_PKT_FLAG_KEY)
+                        clip.keyframes.push_back(ts);
+
+                    clip.end = std::max(clip.end, ts + (pkt->duration > 0 ? pkt->duration : clip.frame_duration));
+                }
+            }
+            av_packet_unref(pkt);
+        }
+        av_packet_free(&pkt);
+
+        std::sort(clip.keyframes.begin(), clip.keyframes.end());
+
+        if (clip.keyframes.empty())
+        {
+            setError("Clip has no keyframes: " + filename);
+            return false;
+        }
+
+        return clip.stream.seek(clip.start);
+    }
+
+    bool TransitionRenderer::copyPackets(Clip &clip, int64_t from, int64_t until, int64_t offset, int64_t *copied_end)
+    {
+        AVFormatContext *ctx = clip.file.getFormatContext();
+        if (av_seek_frame(ctx, clip.video_index, from, AVSEEK_FLAG_BACKWARD) < 0)
+        {
+            setError("Could not seek in " + clip.file.getFilename());
+            return false;
+        }
+
+        AVPacket *pkt = av_packet_alloc();
+        if (!pkt)
+        {
+            setError("Could not allocate packet");
+            return false;
+        }
+
+        bool result = true;
+        while (result && av_read_frame(ctx, pkt) >= 0)
+        {
+            int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+            if (pkt->stream_index != clip.video_index || ts == AV_NOPTS_VALUE || ts < from)
+            {
+                // Other streams and leading pictures of the previous GOP
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            if ((pkt->flags & AV_PKT_FLAG_KEY) && ts >= until)
+            {
+                av_packet_unref(pkt);
+                break;
+            }
+
+            if (pkt->duration <= 0)
+                pkt->duration = clip.frame_duration;
+
+            // Presentation end of the copied pictures
+            if (copied_end && pkt->pts != AV_NOPTS_VALUE)
+                *copied_end = std::max(*copied_end, pkt->pts + pkt->duration);
+
+            if (pkt->pts != AV_NOPTS_VALUE)
+                pkt->pts = toOutput(clip, pkt->pts, offset);
+            if (pkt->dts != AV_NOPTS_VALUE)
+                pkt->dts = toOutput(clip, pkt->dts, offset);
+            pkt->duration = av_rescale_q(pkt->duration, clip.time_base, out_time_base_);
+
+            result = writePacket(pkt);
+        }
+
+        av_packet_free(&pkt);
+        return result;
+    }
+
+    bool TransitionRenderer::renderOverlap(Clip &first, Clip &second, int64_t first_from, int64_t second_keyframe,
+                                           int64_t overlap_start, int64_t overlap_duration,
+                                           const TransitionOptions &options)
+    {
+        if (!first.stream.seek(first_from) || !second.stream.seek(second.start))
+        {
+            setError("Could not seek to the transition");
+            return false;
+        }
+
+        FramePtr decoded = makeFrame();
+        if (!decoded)
+        {
+            setError("Could not allocate frame");
+            return false;
+        }
+
+        // Next frame of the second clip with its output timestamp in pts
+        bool second_failed = false;
+        auto pull_second = [&]() -> FramePtr
+        {
+            if (!second.stream.readFrame(decoded.get()))
+                return nullptr;
+
+            int64_t ts = decoded->best_effort_timestamp != AV_NOPTS_VALUE ? decoded->best_effort_timestamp : decoded->pts;
+            FramePtr frame = toWorkFormat(second, decoded.get());
+            av_frame_unref(decoded.get());
+            if (frame)
+                frame->pts = toOutput(second, ts != AV_NOPTS_VALUE ? ts : second.start, overlap_start);
+            else
+                second_failed = true;
+            return frame;
+        };
+
+        FramePtr second_current, second_next;
+        bool second_started = false;
+        int64_t last_out = AV_NOPTS_VALUE;
+
+        // Frames of the first clip drive the overlap
+        while (first.stream.readFrame(decoded.get()))
+        {
+            int64_t ts = decoded->best_effort_timestamp != AV_NOPTS_VALUE ? decoded->best_effort_timestamp : decoded->pts;
+            if (ts == AV_NOPTS_VALUE || ts < first_from)
+            {
+                av_frame_unref(decoded.get());
+                continue;
+            }
+
+            FramePtr frame = toWorkFormat(first, decoded.get());
+            av_frame_unref(decoded.get());
+            if (!frame)
+                return false;
+
+            int64_t out = ts - first.start;
+            if (last_out != AV_NOPTS_VALUE && out <= last_out)
+                continue;
+            last_out = out;
+            frame->pts = out;
+
+            if (out < overlap_start)
+            {
+                if (!encodeFrame(frame.get()))
+                    return false;
+                continue;
+            }
+
+            // Latest frame of the second clip shown at this time
+            if (!second_started)
+            {
+                second_next = pull_second();
+                second_started = true;
+            }
+            while (second_next && (!second_current || second_next->pts <= out))
+            {
+                second_current = std::move(second_next);
+                second_next = pull_second();
+            }
+
+            if (second_failed)
+                return false;
+            if (!second_current)
+            {
+                setError("Second clip has no frames");
+                return false;
+            }
+
+            FramePtr mixed = work_pool_.acquire();
+            if (!mixed)
+            {
+                setError("Could not allocate transition frame");
+                return false;
+            }
+
+            int weight = blendWeight(out - overlap_start, overlap_duration);
+            bool ok;
+            if (options.type == TransitionType::CrossDissolve)
+                ok = blendFrames(frame.get(), second_current.get(), mixed.get(), weight);
+            else if (weight < 128)
+                ok = fadeFrame(frame.get(), mixed.get(), weight * 2);
+            else
+                ok = fadeFrame(second_current.get(), mixed.get(), 512 - weight * 2);
+
+            if (!ok)
+            {
+                setError("Could not blend transition frame");
+                return false;
+            }
+
+            mixed->pts = out;
+            if (!encodeFrame(mixed.get()))
+                return false;
+        }
+
+        // The rest of the second clip up to its first copied keyframe
+        if (!second_started)
+            second_next = pull_second();
+
+        int64_t copy_from = second_keyframe == std::numeric_limits<int64_t>::max()
+                                ? std::numeric_limits<int64_t>::max()
+                                : toOutput(second, second_keyframe, overlap_start);
+
+        while (second_next && second_next->pts < copy_from)
+        {
+            if (last_out == AV_NOPTS_VALUE || second_next->pts > last_out)
+            {
+                last_out = second_next->pts;
+                if (!encodeFrame(second_next.get()))
+                    return false;
+            }
+            second_next = pull_second();
+        }
+
+        if (second_failed)
+            return false;
+
+        // Drain the encoder before the copied packets continue
+        if (!encodeFrame(nullptr))
+            return false;
+
+        return true;
+    }
+
+    FramePtr TransitionRenderer::toWorkFormat(Clip &clip, const AVFrame *frame)
+    {
+        if (frame->format == work_pool_.getPixelFormat() &&
+            frame->width == work_pool_.getWidth() && frame->height == work_pool_.getHeight())
+        {
+            FramePtr ref = refFrame(frame);
+            if (!ref)
+                setError("Could not reference frame");
+            return ref;
+        }
+
+        clip.sws_ctx = sws_getCachedContext(
+            clip.sws_ctx,
+            frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+            work_pool_.getWidth(), work_pool_.getHeight(), work_pool_.getPixelFormat(),
+            SWS_BICUBIC, nullptr, nullptr, nullptr);
+
+        FramePtr converted = work_pool_.acquire();
+        if (!clip.sws_ctx || !converted)
+        {
+            setError("Could not convert frame of " + clip.file.getFilename());
+            return nullptr;
+        }
+
+        sws_scale(clip.sws_ctx, frame->data, frame->linesize, 0, frame->height,
+                  converted->data, converted->linesize);
+        av_frame_copy_props(converted.get(), frame);
+        return converted;
+    }
+
+    bool TransitionRenderer::encodeFrame(AVFrame *frame)
+    {
+        auto on_packet = [this](AVPacket *pkt)
+        {
+            if (length_size_ > 0 && !convertAnnexBToLengthPrefixed(pkt, length_size_))
+            {
+                setError("Could not convert encoded packet");
+                return false;
+            }
+
+            av_packet_rescale_ts(pkt, encoder_.getTimeBase(), out_time_base_);
+            return writePacket(pkt);
+        };
+
+        if (!encoder_.encode(frame, on_packet))
+        {
+            if (last_error_.empty())
+                setError(encoder_.getLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TransitionRenderer::writePacket(AVPacket *pkt)
+    {
+        AVRational mux_time_base = muxer_.getTimeBase(0);
+        av_packet_rescale_ts(pkt, out_time_base_, mux_time_base);
+
+        // Keep dts strictly increasing where copied and encoded packets meet
+        if (pkt->dts != AV_NOPTS_VALUE && last_dts_ != AV_NOPTS_VALUE && pkt->dts <= last_dts_)
+        {
+            pkt->dts = last_dts_ + 1;
+            if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts)
+                pkt->pts = pkt->dts;
+        }
+
+        if (pkt->dts != AV_NOPTS_VALUE)
+            last_dts_ = pkt->dts;
+
+        if (!muxer_.writePacket(pkt, 0, mux_time_base))
+        {
+            setError(muxer_.getLastError());
+            return false;
+        }
+
+        return true;
+    }
+
+    int64_t TransitionRenderer::toOutput(const Clip &clip, int64_t timestamp, int64_t offset) const
+    {
+        return av_rescale_q(timestamp - clip.start, clip.time_base, out_time_base_) + offset;
+    }
+
+    void TransitionRenderer::setError(const std::string &message)
+    {
+        last_error_ = message;
+        std::cerr << last_error_ << std::endl;
+    }
+}
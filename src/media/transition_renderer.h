@@ -0,0 +1,112 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+#include <media/frame_pool.h>
+#include <media/media_file.h>
+#include <media/packet_muxer.h>
+#include <media/video_encoder.h>
+#include <media/video_stream.h>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    enum class TransitionType
+    {
+        CrossDissolve,   // Blend the end of the first clip into the start of the second
+        FadeThroughBlack // Fade the first clip out to black, then the second one in
+    };
+
+    struct TransitionOptions
+    {
+        TransitionType type{TransitionType::CrossDissolve};
+
+        // Length of the overlap in seconds
+        double duration{1.0};
+
+        // Encoder for the overlap; empty picks the default encoder of the
+        // first clip's codec
+        std::string encoder_name;
+    };
+
+    // Joins two clips with a transition over the last seconds of the first clip.
+    // Both clips are decoded in lockstep only around the overlap: the first
+    // clip is stream-copied up to the keyframe before the overlap and the
+    // second one from its first keyframe after it. The frames in between are
+    // blended and re-encoded with the parameters of the first clip.
+    // The output carries the video track only.
+    class TransitionRenderer
+    {
+    public:
+        TransitionRenderer() = default;
+
+        // Not Allowed to copy
+        TransitionRenderer(const TransitionRenderer &) = delete;
+        TransitionRenderer &operator=(const TransitionRenderer &) = delete;
+
+        bool render(const std::string &first_filename, const std::string &second_filename,
+                    const std::string &output_filename, const TransitionOptions &options = {});
+
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        struct Clip
+        {
+            MediaFile file;
+            VideoStream stream;
+            int video_index{-1};
+            AVRational time_base{0, 1};
+            int64_t start{0};              // First timestamp (stream time base)
+            int64_t end{0};                // End of the last frame (stream time base)
+            int64_t frame_duration{1};
+            std::vector<int64_t> keyframes; // Keyframe timestamps in ascending order
+            SwsContext *sws_ctx{nullptr};
+
+            Clip() = default;
+            ~Clip();
+
+            Clip(const Clip &) = delete;
+            Clip &operator=(const Clip &) = delete;
+        };
+
+        PacketMuxer muxer_;
+        VideoEncoder encoder_;
+        FramePool work_pool_;
+        AVRational out_time_base_{0, 1}; // Time base of the first clip
+        int length_size_{0};             // NAL length size of the output track, 0 for Annex B
+        int64_t last_dts_{AV_NOPTS_VALUE};
+        std::string last_error_;
+
+        // Open a clip and index its keyframes
+        bool openClip(const std::string &filename, Clip &clip);
+
+        // Copy the packets of clip from the keyframe at from up to the keyframe
+        // at until (exclusive, in decode order), shifted by offset (output time
+        // base). copied_end receives the presentation end of the copied frames.
+        bool copyPackets(Clip &clip, int64_t from, int64_t until, int64_t offset, int64_t *copied_end = nullptr);
+
+        // Decode, blend and re-encode the frames of the first clip from
+        // first_from (the first one not copied) up to the second keyframe
+        bool renderOverlap(Clip &first, Clip &second, int64_t first_from, int64_t second_keyframe,
+                           int64_t overlap_start, int64_t overlap_duration, const TransitionOptions &options);
+
+        // Bring a decoded frame to the geometry and pixel format of the output
+        FramePtr toWorkFormat(Clip &clip, const AVFrame *frame);
+
+        bool encodeFrame(AVFrame *frame);
+
+        // Write a packet in the output time base, keeping dts increasing
+        bool writePacket(AVPacket *pkt);
+
+        // Map a timestamp of clip to the output time base
+        int64_t toOutput(const Clip &clip, int64_t timestamp, int64_t offset) const;
+
+        void setError(const std::string &message);
+    };
+}
@@ -0,0 +1,141 @@
+#include <media/video_encoder.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <sstream>
+
+namespace video_codec
+{
+    VideoEncoder::~VideoEncoder()
+    {
+        close();
+    }
+
+    void VideoEncoder::close()
+    {
+        if (packet_)
+            av_packet_free(&packet_);
+
+        if (codec_ctx_)
+            avcodec_free_context(&codec_ctx_);
+    }
+
+    bool VideoEncoder::open(const VideoEncoderSettings &settings)
+    {
+        close();
+
+        const AVCodec *codec = settings.codec_name.empty()
+                                   ? avcodec_find_encoder(settings.codec_id)
+                                   : avcodec_find_encoder_by_name(settings.codec_name.c_str());
+        if (!codec)
+        {
+            setError("Encoder not found: " +
+                     (settings.codec_name.empty() ? std::string(avcodec_get_name(settings.codec_id)) : settings.codec_name));
+            return false;
+        }
+
+        codec_ctx_ = avcodec_alloc_context3(codec);
+        packet_ = av_packet_alloc();
+        if (!codec_ctx_ || !packet_)
+        {
+            setError("Could not allocate encoding context");
+            close();
+            return false;
+        }
+
+        codec_ctx_->width = settings.width;
+        codec_ctx_->height = settings.height;
+        codec_ctx_->pix_fmt = settings.pix_fmt;
+        codec_ctx_->time_base = settings.time_base;
+        codec_ctx_->framerate = settings.framerate;
+        codec_ctx_->thread_count = settings.thread_count;
+
+        if (settings.bit_rate > 0)
+            codec_ctx_->bit_rate = settings.bit_rate;
+        if (settings.max_bit_rate > 0)
+        {
+            codec_ctx_->rc_max_rate = settings.max_bit_rate;
+            codec_ctx_->rc_buffer_size = static_cast<int>(std::min<int64_t>(settings.max_bit_rate * 2, INT_MAX));
+        }
+        if (settings.gop_size >= 0)
+            codec_ctx_->gop_size = settings.gop_size;
+        if (settings.max_b_frames >= 0)
+            codec_ctx_->max_b_frames = settings.max_b_frames;
+        if (settings.global_header)
+            codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        for (const auto &[key, value] : settings.options)
+        {
+            if (av_opt_set(codec_ctx_->priv_data, key.c_str(), value.c_str(), 0) < 0)
+                std::cerr << "Ignoring unsupported encoder option " << key << "=" << value << std::endl;
+        }
+
+        int ret = avcodec_open2(codec_ctx_, codec, nullptr);
+        if (ret < 0)
+        {
+            setError("Could not open encoder " + std::string(codec->name), ret);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    bool VideoEncoder::encode(const AVFrame *frame, const std::function<bool(AVPacket *)> &on_packet)
+    {
+        if (!codec_ctx_)
+        {
+            setError("VideoEncoder not opened");
+            return false;
+        }
+
+        static StageMetrics &encode_metrics = PipelineMetrics::instance().stage("encode");
+        if (frame)
+            encode_metrics.addFrames(1);
+
+        int ret = timeStage(encode_metrics, [&]
+                            { return avcodec_send_frame(codec_ctx_, frame); });
+        if (ret < 0 && !(frame == nullptr && ret == AVERROR_EOF))
+        {
+            setError("Error sending frame to encoder", ret);
+            return false;
+        }
+
+        while (true)
+        {
+            ret = timeStage(encode_metrics, [&]
+                            { return avcodec_receive_packet(codec_ctx_, packet_); });
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+            {
+                setError("Error receiving packet from encoder", ret);
+                return false;
+            }
+
+            bool ok = on_packet(packet_);
+            av_packet_unref(packet_);
+            if (!ok)
+                return false;
+        }
+
+        return true;
+    }
+
+    void VideoEncoder::setError(const std::string &message, int error_code)
+    {
+        std::ostringstream oss;
+        oss << message;
+
+        if (error_code != 0)
+        {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(error_code, errbuf, AV_ERROR_MAX_STRING_SIZE);
+            oss << ": " << errbuf;
+        }
+
+        last_error_ = oss.str();
+        std::cerr << last_error_ << std::endl;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/opt.h>
+}
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace video_codec
+{
+    struct VideoEncoderSettings
+    {
+        std::string codec_name;                // Encoder name, e.g. "libx264"
+        AVCodecID codec_id{AV_CODEC_ID_NONE};  // Used when codec_name is empty
+        int width{0};
+        int height{0};
+        AVPixelFormat pix_fmt{AV_PIX_FMT_YUV420P};
+        AVRational time_base{1, 30};
+        AVRational framerate{30, 1};
+        int64_t bit_rate{0};                   // 0 keeps the encoder default
+        int64_t max_bit_rate{0};               // VBV cap with a two-second buffer, 0 for none
+        int gop_size{-1};                      // -1 keeps the encoder default
+        int max_b_frames{-1};                  // -1 keeps the encoder default
+        int thread_count{0};                   // 0 lets the encoder decide
+        bool global_header{false};             // Codec headers in extradata instead of in-band
+
+        // Private encoder options (preset, crf, x264-params, ...)
+        std::vector<std::pair<std::string, std::string>> options;
+    };
+
+    // Encoder without a container, for callers that mux packets themselves
+    // (PacketMuxer) or mix encoded and stream-copied packets.
+    class VideoEncoder
+    {
+    public:
+        VideoEncoder() = default;
+        ~VideoEncoder();
+
+        // Not Allowed to copy
+        VideoEncoder(const VideoEncoder &) = delete;
+        VideoEncoder &operator=(const VideoEncoder &) = delete;
+
+        bool open(const VideoEncoderSettings &settings);
+        void close();
+
+        // Send a frame (nullptr flushes the encoder) and hand every packet
+        // produced to on_packet. Packets are in the encoder time base and
+        // unreferenced after the callback returns.
+        bool encode(const AVFrame *frame, const std::function<bool(AVPacket *)> &on_packet);
+
+        bool flush(const std::function<bool(AVPacket *)> &on_packet) { return encode(nullptr, on_packet); }
+
+        // Getter
+        bool isOpen() const { return codec_ctx_ != nullptr; }
+        AVCodecContext *getCodecContext() const { return codec_ctx_; }
+        AVRational getTimeBase() const { return codec_ctx_ ? codec_ctx_->time_base : AVRational{0, 1}; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        AVCodecContext *codec_ctx_{nullptr};
+        AVPacket *packet_{nullptr};
+        std::string last_error_;
+
+        void setError(const std::string &message, int error_code = 0);
+    };
+}
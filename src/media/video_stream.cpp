@@ -1,5 +1,9 @@
 #include <media/video_stream.h>
+#include <media/codec_cache.h>
 #include <processing/frame_processor.h>
+#include <profiling/memory_tracker.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
 #include <iostream>
 
 namespace video_codec
@@ -14,18 +18,24 @@ namespace video_codec
           codec_ctx_(other.codec_ctx_),
           codec_(other.codec_),
           stream_index_(other.stream_index_),
+          keyframes_only_(other.keyframes_only_),
+          lowres_(other.lowres_),
           frame_(other.frame_),
-          frame_rgb_(other.frame_rgb_),
+          rgb_pool_(std::move(other.rgb_pool_)),
           sws_ctx_(other.sws_ctx_),
-          buffer_(other.buffer_)
+          pull_packet_(other.pull_packet_),
+          draining_(other.draining_),
+          batch_size_(other.batch_size_),
+          frame_cache_(std::move(other.frame_cache_)),
+          prefetch_frames_(other.prefetch_frames_),
+          next_access_pts_(other.next_access_pts_)
     {
         other.format_ctx_ = nullptr;
         other.codec_ctx_ = nullptr;
         other.codec_ = nullptr;
         other.frame_ = nullptr;
-        other.frame_rgb_ = nullptr;
         other.sws_ctx_ = nullptr;
-        other.buffer_ = nullptr;
+        other.pull_packet_ = nullptr;
     }
 
     VideoStream &VideoStream::operator=(VideoStream &&other) noexcept
@@ -38,23 +48,29 @@ namespace video_codec
             codec_ctx_ = other.codec_ctx_;
             codec_ = other.codec_;
             stream_index_ = other.stream_index_;
+            keyframes_only_ = other.keyframes_only_;
+            lowres_ = other.lowres_;
             frame_ = other.frame_;
-            frame_rgb_ = other.frame_rgb_;
+            rgb_pool_ = std::move(other.rgb_pool_);
             sws_ctx_ = other.sws_ctx_;
-            buffer_ = other.buffer_;
+            pull_packet_ = other.pull_packet_;
+            draining_ = other.draining_;
+            batch_size_ = other.batch_size_;
+            frame_cache_ = std::move(other.frame_cache_);
+            prefetch_frames_ = other.prefetch_frames_;
+            next_access_pts_ = other.next_access_pts_;
 
             other.format_ctx_ = nullptr;
             other.codec_ctx_ = nullptr;
             other.codec_ = nullptr;
             other.frame_ = nullptr;
-            other.frame_rgb_ = nullptr;
             other.sws_ctx_ = nullptr;
-            other.buffer_ = nullptr;
+            other.pull_packet_ = nullptr;
         }
         return *this;
     }
 
-    bool VideoStream::initialize(AVFormatContext *format_ctx, int stream_index)
+    bool VideoStream::initialize(AVFormatContext *format_ctx, int stream_index, int thread_count)
     {
         cleanup();
 
@@ -95,6 +111,14 @@ namespace video_codec
             return false;
         }
 
+        if (thread_count > 0)
+            codec_ctx_->thread_count = thread_count;
+
+        // Analysis shortcuts; lowres beyond what the decoder supports is an error in avcodec_open2()
+        codec_ctx_->lowres = std::min<int>(lowres_, codec_->max_lowres);
+        if (keyframes_only_)
+            codec_ctx_->skip_frame = AVDISCARD_NONKEY;
+
         // Open codec
         if (avcodec_open2(codec_ctx_, codec_, nullptr) < 0)
         {
@@ -124,47 +148,25 @@ namespace video_codec
             return false;
         }
 
-        // Allocate an RGB frame for conversion
-        frame_rgb_ = av_frame_alloc();
-        if (!frame_rgb_)
-        {
-            std::cerr << "Could not allocate RGB frame" << std::endl;
-            av_frame_free(&frame_);
-            return false;
-        }
-
-        // Set RGB frame properties
-        frame_rgb_->format = AV_PIX_FMT_RGB24;
-        frame_rgb_->width = codec_ctx_->width;
-        frame_rgb_->height = codec_ctx_->height;
-
-        // Allocate the buffer using av_image_alloc for proper alignment
-        int ret = av_image_alloc(
-            frame_rgb_->data, frame_rgb_->linesize,
-            codec_ctx_->width, codec_ctx_->height,
-            AV_PIX_FMT_RGB24, 32); // 32-byte alignment
-
-        if (ret < 0)
+        // Pool of RGB buffers for conversion.
+        // Each delivered frame owns a pooled buffer, so processors may keep
+        // references while decoding continues into a fresh buffer.
+        if (!rgb_pool_.initialize(codec_ctx_->width, codec_ctx_->height, AV_PIX_FMT_RGB24, 32)) // 32-byte alignment
         {
             std::cerr << "Could not allocate RGB buffer" << std::endl;
-            av_frame_free(&frame_rgb_);
             av_frame_free(&frame_);
             return false;
         }
 
-        buffer_ = frame_rgb_->data[0]; // Store the buffer pointer for cleanup
-
         // Initialize scaling context
-        sws_ctx_ = sws_getContext(
+        sws_ctx_ = CodecCache::instance().acquireScaler(
             codec_ctx_->width, codec_ctx_->height, codec_ctx_->pix_fmt,
             codec_ctx_->width, codec_ctx_->height, AV_PIX_FMT_RGB24,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
+            SWS_BILINEAR);
 
         if (!sws_ctx_)
         {
             std::cerr << "Could not initialize scaling context" << std::endl;
-            av_freep(&frame_rgb_->data[0]);
-            av_frame_free(&frame_rgb_);
             av_frame_free(&frame_);
             return false;
         }
@@ -172,6 +174,148 @@ namespace video_codec
         return true;
     }
 
+    FramePtr VideoStream::convertFrame(int64_t frame_number)
+    {
+        FramePtr frame_rgb = rgb_pool_.acquire();
+        if (!frame_rgb)
+        {
+            std::cerr << "Could not allocate RGB frame" << std::endl;
+            return nullptr;
+        }
+
+        // Convert a frame with RGB
+        static StageMetrics &sws_metrics = PipelineMetrics::instance().stage("sws to rgb");
+        timeStage(sws_metrics, frame_number, [&]
+                  { return sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0,
+                                     codec_ctx_->height, frame_rgb->data, frame_rgb->linesize); });
+        sws_metrics.addFrames(1);
+
+        // Carry timestamps over to the converted frame
+        av_frame_copy_props(frame_rgb.get(), frame_);
+        frame_rgb->time_base = format_ctx_->streams[stream_index_]->time_base;
+        return frame_rgb;
+    }
+
+    bool VideoStream::deliverFrame(FrameProcessor &processor, int frame_number)
+    {
+        // Backpressure: let downstream stages release frames before adding one
+        MemoryTracker &memory = MemoryTracker::instance();
+        memory.waitForRoom(av_image_get_buffer_size(AV_PIX_FMT_RGB24, codec_ctx_->width, codec_ctx_->height, 32));
+
+        FramePtr frame_rgb = convertFrame(frame_number);
+        if (!frame_rgb)
+            return false;
+
+        static MemoryAccount &decoder_memory = memory.account("decoder");
+        if (!memory.trackFrame(frame_rgb.get(), decoder_memory))
+        {
+            std::cerr << "Could not track RGB frame" << std::endl;
+            return false;
+        }
+
+        // Hand the frame over to the processor
+        if (batch_size_ <= 1)
+        {
+            static StageMetrics &process_metrics = PipelineMetrics::instance().stage("process");
+            ScopedStageTimer timer(process_metrics, frame_number);
+            process_metrics.addFrames(1);
+            return processor.consumeFrame(std::move(frame_rgb), frame_number);
+        }
+
+        // Or collect it for the next batch
+        if (batch_.empty())
+            batch_first_ = frame_number;
+        batch_.push_back(std::move(frame_rgb));
+
+        if (static_cast<int>(batch_.size()) >= batch_size_)
+            return flushBatch(processor);
+
+        return true;
+    }
+
+    bool VideoStream::flushBatch(FrameProcessor &processor)
+    {
+        if (batch_.empty())
+            return true;
+
+        batch_view_.clear();
+        for (const auto &frame : batch_)
+            batch_view_.push_back(frame.get());
+
+        static StageMetrics &process_metrics = PipelineMetrics::instance().stage("process");
+        process_metrics.addFrames(batch_view_.size());
+        bool result = timeStage(process_metrics, batch_first_, [&]
+                                { return processor.processFrames(batch_view_, batch_first_); });
+
+        // Release the references so that the buffers go back to the pool
+        batch_.clear();
+        batch_view_.clear();
+        return result;
+    }
+
+    bool VideoStream::decodePacket(const AVPacket *packet, FrameProcessor &processor, int &frame_count, int max_frames)
+    {
+        if (!codec_ctx_)
+        {
+            std::cerr << "VideoStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        bool limit_reached = max_frames > 0 && frame_count >= max_frames;
+        if (packet && limit_reached)
+            return true;
+
+        static StageMetrics &decode_metrics = PipelineMetrics::instance().stage("decode");
+
+        // Decode packet, or flush the decoder to retrieve remaining frames
+        int ret = limit_reached ? 0 : timeStage(decode_metrics, [&]
+                                                { return avcodec_send_packet(codec_ctx_, packet); });
+        if (ret < 0 && !(packet == nullptr && ret == AVERROR_EOF))
+        {
+            std::cerr << (packet ? "Error sending packet for decoding" : "Error during flushing") << std::endl;
+            return false;
+        }
+
+        bool result = true;
+        while (!limit_reached)
+        {
+            ret = timeStage(decode_metrics, frame_count, [&]
+                            { return avcodec_receive_frame(codec_ctx_, frame_); });
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+            {
+                std::cerr << (packet ? "Error during decoding" : "Error during flushing") << std::endl;
+                result = false;
+                break;
+            }
+
+            decode_metrics.addFrames(1);
+
+            // Process frame
+            if (!deliverFrame(processor, frame_count))
+            {
+                std::cerr << (packet ? "Frame processing error" : "Frame processing error during flushing") << std::endl;
+                result = false;
+                break;
+            }
+
+            frame_count++;
+
+            // Terminate when the maximum frame count is reached
+            limit_reached = max_frames > 0 && frame_count >= max_frames;
+        }
+
+        // Hand over the frames of an incomplete batch
+        if (!packet && !flushBatch(processor))
+        {
+            std::cerr << "Frame processing error" << std::endl;
+            result = false;
+        }
+
+        return result;
+    }
+
     bool VideoStream::processFrames(FrameProcessor &processor, int max_frames)
     {
         if (!codec_ctx_ || !format_ctx_)
@@ -193,57 +337,24 @@ namespace video_codec
         // Seek to the beginning of the stream
         av_seek_frame(format_ctx_, stream_index_, 0, AVSEEK_FLAG_BACKWARD);
         avcodec_flush_buffers(codec_ctx_);
+        draining_ = false;
+        next_access_pts_ = AV_NOPTS_VALUE;
+
+        static StageMetrics &demux_metrics = PipelineMetrics::instance().stage("demux");
 
         // Read packets
-        while (av_read_frame(format_ctx_, packet) >= 0)
+        while (timeStage(demux_metrics, [&]
+                         { return av_read_frame(format_ctx_, packet); }) >= 0)
         {
+            demux_metrics.addBytesRead(packet->size);
+
             // Check if the packet belongs to the target video stream
-            if (packet->stream_index == stream_index_)
+            if (packet->stream_index == stream_index_ &&
+                !decodePacket(packet, processor, frame_cnt, max_frames))
             {
-                // Decode packet
-                int ret = avcodec_send_packet(codec_ctx_, packet);
-                if (ret < 0)
-                {
-                    std::cerr << "Error sending packet for decoding" << std::endl;
-                    result = false;
-                    break;
-                }
-
-                while (ret >= 0)
-                {
-                    ret = avcodec_receive_frame(codec_ctx_, frame_);
-                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-                        break;
-                    else if (ret < 0)
-                    {
-                        std::cerr << "Error during decoding" << std::endl;
-                        result = false;
-                        break;
-                    }
-
-                    /// Convert a frame with RGB
-                    sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0,
-                              codec_ctx_->height, frame_rgb_->data, frame_rgb_->linesize);
-
-                    // Set the frame dimensions
-                    frame_rgb_->width = codec_ctx_->width;
-                    frame_rgb_->height = codec_ctx_->height;
-                    frame_rgb_->format = AV_PIX_FMT_RGB24;
-
-                    // Process frame
-                    if (!processor.processFrame(frame_rgb_, frame_cnt))
-                    {
-                        std::cerr << "Frame processing error" << std::endl;
-                        result = false;
-                        break;
-                    }
-
-                    frame_cnt++;
-
-                    // Terminate when the maximum frame count is reached
-                    if (max_frames > 0 && frame_cnt >= max_frames)
-                        break;
-                }
+                result = false;
+                av_packet_unref(packet);
+                break;
             }
 
             // Free packet
@@ -254,47 +365,257 @@ namespace video_codec
                 break;
         }
 
-        // Flush the decoder to retrieve remaining frames
-        avcodec_send_packet(codec_ctx_, nullptr);
-        int ret = 0;
-        while (ret >= 0)
+        // Flush the decoder and the pending batch
+        if (!decodePacket(nullptr, processor, frame_cnt, max_frames))
+            result = false;
+
+        av_packet_free(&packet);
+        std::cout << "Processed " << frame_cnt << " frames" << std::endl;
+        return result;
+    }
+
+    void VideoStream::setKeyframesOnly(bool keyframes_only)
+    {
+        keyframes_only_ = keyframes_only;
+        if (codec_ctx_)
+            codec_ctx_->skip_frame = keyframes_only ? AVDISCARD_NONKEY : AVDISCARD_DEFAULT;
+    }
+
+    bool VideoStream::seek(int64_t timestamp)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "VideoStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        if (av_seek_frame(format_ctx_, stream_index_, timestamp, AVSEEK_FLAG_BACKWARD) < 0)
         {
-            ret = avcodec_receive_frame(codec_ctx_, frame_);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            std::cerr << "Could not seek to " << timestamp << std::endl;
+            return false;
+        }
+
+        avcodec_flush_buffers(codec_ctx_);
+        draining_ = false;
+        next_access_pts_ = AV_NOPTS_VALUE;
+        return true;
+    }
+
+    bool VideoStream::readFrame(AVFrame *frame)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "VideoStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        next_access_pts_ = AV_NOPTS_VALUE;
+        return decodeNextFrame(frame);
+    }
+
+    bool VideoStream::processNativeFrames(FrameProcessor &processor, int max_frames)
+    {
+        AVFrame *frame = av_frame_alloc();
+        if (!frame)
+        {
+            std::cerr << "Could not allocate frame" << std::endl;
+            return false;
+        }
+
+        bool result = true;
+        int frame_count = 0;
+        while ((max_frames < 0 || frame_count < max_frames) && readFrame(frame))
+        {
+            result = processor.processFrame(frame, frame_count++);
+            av_frame_unref(frame);
+            if (!result)
                 break;
-            else if (ret < 0)
+        }
+
+        av_frame_free(&frame);
+        std::cout << "Analyzed " << frame_count << " frames" << std::endl;
+        return result;
+    }
+
+    bool VideoStream::processSampledFrames(FrameProcessor &processor, int samples)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "VideoStream not properly initialized" << std::endl;
+            return false;
+        }
+
+        const AVStream *stream = format_ctx_->streams[stream_index_];
+        int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        int64_t duration = stream->duration;
+        if (duration == AV_NOPTS_VALUE && format_ctx_->duration != AV_NOPTS_VALUE)
+            duration = av_rescale_q(format_ctx_->duration, AV_TIME_BASE_Q, stream->time_base);
+        if (duration == AV_NOPTS_VALUE || duration <= 0)
+            return processNativeFrames(processor, samples);
+
+        AVFrame *frame = av_frame_alloc();
+        if (!frame)
+        {
+            std::cerr << "Could not allocate frame" << std::endl;
+            return false;
+        }
+
+        bool result = true;
+        int frame_count = 0;
+        for (int i = 0; result && i < samples; ++i)
+        {
+            // Middle of the i-th of samples equal parts
+            int64_t timestamp = start + av_rescale(duration, 2 * i + 1, 2 * static_cast<int64_t>(samples));
+            if (!seek(timestamp) || !readFrame(frame))
+                continue;
+
+            result = processor.processFrame(frame, frame_count++);
+            av_frame_unref(frame);
+        }
+
+        av_frame_free(&frame);
+        std::cout << "Analyzed " << frame_count << " sampled frames" << std::endl;
+        return result;
+    }
+
+    bool VideoStream::decodeNextFrame(AVFrame *frame)
+    {
+        if (!pull_packet_)
+        {
+            pull_packet_ = av_packet_alloc();
+            if (!pull_packet_)
             {
-                std::cerr << "Error during flushing" << std::endl;
-                result = false;
-                break;
+                std::cerr << "Could not allocate packet" << std::endl;
+                return false;
             }
+        }
 
-            // Convert a frame with RGB
-            sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0,
-                      codec_ctx_->height, frame_rgb_->data, frame_rgb_->linesize);
+        while (true)
+        {
+            int ret = avcodec_receive_frame(codec_ctx_, frame);
+            if (ret >= 0)
+                return true;
+            else if (ret == AVERROR_EOF)
+                return false;
+            else if (ret != AVERROR(EAGAIN))
+            {
+                std::cerr << "Error during decoding" << std::endl;
+                return false;
+            }
 
-            // Set the frame dimensions
-            frame_rgb_->width = codec_ctx_->width;
-            frame_rgb_->height = codec_ctx_->height;
-            frame_rgb_->format = AV_PIX_FMT_RGB24;
+            if (draining_)
+                return false;
 
-            // Process frame
-            if (!processor.processFrame(frame_rgb_, frame_cnt))
+            // Feed the next packet of this stream, or start draining at the end
+            while (true)
             {
-                std::cerr << "Frame processing error during flushing" << std::endl;
-                result = false;
+                if (av_read_frame(format_ctx_, pull_packet_) < 0)
+                {
+                    avcodec_send_packet(codec_ctx_, nullptr);
+                    draining_ = true;
+                    break;
+                }
+
+                if (pull_packet_->stream_index != stream_index_)
+                {
+                    av_packet_unref(pull_packet_);
+                    continue;
+                }
+
+                ret = avcodec_send_packet(codec_ctx_, pull_packet_);
+                av_packet_unref(pull_packet_);
+                if (ret < 0)
+                {
+                    std::cerr << "Error sending packet for decoding" << std::endl;
+                    return false;
+                }
                 break;
             }
+        }
+    }
 
-            frame_cnt++;
+    bool VideoStream::canDecodeForwardTo(int64_t timestamp)
+    {
+        if (next_access_pts_ == AV_NOPTS_VALUE || timestamp < next_access_pts_ || draining_)
+            return false;
 
-            // Terminate when the maximum frame count is reached
-            if (max_frames > 0 && frame_cnt >= max_frames)
+        // Without a keyframe in between, decoding on is never more work than a seek
+        AVStream *stream = format_ctx_->streams[stream_index_];
+        int index = av_index_search_timestamp(stream, timestamp, AVSEEK_FLAG_BACKWARD);
+        const AVIndexEntry *keyframe = index >= 0 ? avformat_index_get_entry(stream, index) : nullptr;
+        if (keyframe)
+            return keyframe->timestamp <= next_access_pts_;
+
+        // No index: only short distances, a seek may land much closer
+        return timestamp - next_access_pts_ <= av_rescale_q(1, AVRational{1, 1}, stream->time_base);
+    }
+
+    FramePtr VideoStream::getFrame(int64_t timestamp)
+    {
+        if (!codec_ctx_ || !format_ctx_)
+        {
+            std::cerr << "VideoStream not properly initialized" << std::endl;
+            return nullptr;
+        }
+
+        if (FramePtr cached = frame_cache_.find(timestamp))
+            return cached;
+
+        if (!canDecodeForwardTo(timestamp) && !seek(timestamp))
+            return nullptr;
+
+        AVStream *stream = format_ctx_->streams[stream_index_];
+        AVRational frame_rate = stream->avg_frame_rate.num > 0 ? stream->avg_frame_rate : stream->r_frame_rate;
+        int64_t default_duration = frame_rate.num > 0 ? av_rescale_q(1, av_inv_q(frame_rate), stream->time_base) : 1;
+
+        MemoryTracker &memory = MemoryTracker::instance();
+        static MemoryAccount &cache_memory = memory.account("frame cache");
+
+        FramePtr result;
+        int prefetched = 0;
+        next_access_pts_ = AV_NOPTS_VALUE;
+        while (decodeNextFrame(frame_))
+        {
+            int64_t pts = frame_->best_effort_timestamp != AV_NOPTS_VALUE ? frame_->best_effort_timestamp : frame_->pts;
+            int64_t duration = frame_->duration > 0 ? frame_->duration : default_duration;
+            next_access_pts_ = pts + duration;
+
+            bool found = false;
+            if (!frame_cache_.contains(pts))
+            {
+                FramePtr frame_rgb = convertFrame(pts);
+                if (!frame_rgb || !memory.trackFrame(frame_rgb.get(), cache_memory))
+                {
+                    next_access_pts_ = AV_NOPTS_VALUE;
+                    return nullptr;
+                }
+                frame_cache_.insert(frame_rgb.get(), pts, duration);
+
+                // The first frame ending after timestamp also covers a gap before it
+                if (!result && timestamp < pts + duration)
+                {
+                    result = std::move(frame_rgb);
+                    found = true;
+                }
+            }
+            else if (!result && timestamp < pts + duration)
+            {
+                result = frame_cache_.find(pts);
+                found = true;
+            }
+
+            if (found && prefetch_frames_ == 0)
+                break;
+            if (!result || found)
+                continue;
+
+            // Prefetch stops at the count or with the next keyframe, where a
+            // seek would land anyway
+            bool keyframe = frame_->flags & AV_FRAME_FLAG_KEY;
+            if (++prefetched >= prefetch_frames_ || keyframe)
                 break;
         }
 
-        av_packet_free(&packet);
-        std::cout << "Processed " << frame_cnt << " frames" << std::endl;
         return result;
     }
 
@@ -309,25 +630,39 @@ namespace video_codec
         return av_q2d(stream->r_frame_rate);
     }
 
+    AVRational VideoStream::getTimeBase() const
+    {
+        if (!format_ctx_ || stream_index_ < 0)
+            return AVRational{0, 1};
+
+        return format_ctx_->streams[stream_index_]->time_base;
+    }
+
     void VideoStream::cleanup()
     {
         if (sws_ctx_)
         {
-            sws_freeContext(sws_ctx_);
+            CodecCache::instance().releaseScaler(sws_ctx_);
             sws_ctx_ = nullptr;
         }
 
-        if (frame_rgb_)
-        {
-            av_freep(&frame_rgb_->data[0]);
-            av_frame_free(&frame_rgb_);
-        }
+        // Frames still held by processors keep their pooled buffers alive
+        batch_.clear();
+        batch_view_.clear();
+        rgb_pool_ = FramePool();
 
         if (frame_)
         {
             av_frame_free(&frame_);
         }
 
+        if (pull_packet_)
+            av_packet_free(&pull_packet_);
+        draining_ = false;
+
+        frame_cache_.clear();
+        next_access_pts_ = AV_NOPTS_VALUE;
+
         if (codec_ctx_)
         {
             avcodec_close(codec_ctx_);
@@ -337,6 +672,5 @@ namespace video_codec
         // Note: format_ctx_ is managed externally, so it should not be freed here.
         format_ctx_ = nullptr;
         stream_index_ = -1;
-        buffer_ = nullptr;
     }
 }
\ No newline at end of file
@@ -8,9 +8,12 @@ extern "C"
 #include <libswscale/swscale.h>
 }
 
+#include <media/frame_cache.h>
+#include <media/frame_pool.h>
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
 
 namespace video_codec
 {
@@ -30,17 +33,69 @@ namespace video_codec
         VideoStream(VideoStream &&) noexcept;
         VideoStream &operator=(VideoStream &&) noexcept;
 
-        // Initialize Stream
-        bool initialize(AVFormatContext *format_ctx, int stream_index);
+        // Initialize Stream (thread_count 0 keeps the decoder default)
+        bool initialize(AVFormatContext *format_ctx, int stream_index, int thread_count = 0);
+
+        int getStreamIndex() const { return stream_index_; }
 
         // Processing frames
         bool processFrames(FrameProcessor &processor, int max_frames = -1);
 
+        // Packet-level decoding for callers that demux themselves.
+        // Decodes a packet of this stream and hands its frames to the processor,
+        // counting them in frame_count up to max_frames. nullptr drains the
+        // decoder and hands over the incomplete batch.
+        bool decodePacket(const AVPacket *packet, FrameProcessor &processor, int &frame_count, int max_frames = -1);
+
+        // Pull-style decoding, for callers that walk several streams in lockstep.
+        // Frames come out in the decoder's native pixel format.
+        // - seek: position the stream on the keyframe at or before timestamp (stream time base)
+        // - readFrame: decode the next frame into frame; false at the end of the stream or on error
+        bool seek(int64_t timestamp);
+        bool readFrame(AVFrame *frame);
+
+        // Hand frames to processor in the decoder's native pixel format, for
+        // analysis passes that work on the luma plane (scene detection, QC)
+        bool processNativeFrames(FrameProcessor &processor, int max_frames = -1);
+
+        // Same for samples frames spread evenly over the stream: each is the
+        // keyframe at or before its position, so a sample costs one seek and
+        // one decoded frame. Falls back to the first frames when the stream
+        // duration is unknown.
+        bool processSampledFrames(FrameProcessor &processor, int samples);
+
+        // Random access for previews and scrubbing: the RGB frame shown at
+        // timestamp (stream time base), nullptr past the end or on error.
+        // Served from the frame cache when possible. A miss keeps decoding
+        // forward if no keyframe lies between the decoder and timestamp,
+        // and otherwise seeks to the keyframe at or before it. Every frame
+        // decoded on the way is cached, plus up to the prefetch count of
+        // frames after timestamp within the same GOP.
+        FramePtr getFrame(int64_t timestamp);
+
+        // Memory bound of the frame cache in bytes
+        void setFrameCacheBudget(size_t budget_bytes) { frame_cache_.setBudget(budget_bytes); }
+        void setPrefetchFrames(int frames) { prefetch_frames_ = frames > 0 ? frames : 0; }
+        const FrameCache &getFrameCache() const { return frame_cache_; }
+
+        // Decoder shortcuts for analysis passes that need neither every frame nor full size
+        // - setKeyframesOnly: the decoder drops everything but keyframes
+        // - setLowres: decode at 1/2^lowres of the size where the decoder supports it
+        //   (JPEG, MPEG-4 part 2, ...; others decode at full size). Takes effect on initialize().
+        void setKeyframesOnly(bool keyframes_only);
+        void setLowres(int lowres) { lowres_ = lowres > 0 ? lowres : 0; }
+
+        // Number of frames handed to FrameProcessor::processFrames() at once.
+        // 1 (default) hands every frame over by ownership through consumeFrame().
+        void setBatchSize(int batch_size) { batch_size_ = batch_size > 1 ? batch_size : 1; }
+        int getBatchSize() const { return batch_size_; }
+
         // Getter
         int getWidth() const { return codec_ctx_ ? codec_ctx_->width : 0; }
         int getHeight() const { return codec_ctx_ ? codec_ctx_->height : 0; }
         AVPixelFormat getPixelFormat() const { return codec_ctx_ ? codec_ctx_->pix_fmt : AV_PIX_FMT_NONE; }
         double getFrameRate() const;
+        AVRational getTimeBase() const;
         AVCodecContext *getCodecContext() const { return codec_ctx_; }
 
     private:
@@ -48,16 +103,48 @@ namespace video_codec
         AVCodecContext *codec_ctx_{nullptr};
         AVCodec *codec_{nullptr};
         int stream_index_{-1};
+        bool keyframes_only_{false};
+        int lowres_{0};
 
         // Resource for processing frames
         AVFrame *frame_{nullptr};
-        AVFrame *frame_rgb_{nullptr};
+        FramePool rgb_pool_;
         SwsContext *sws_ctx_{nullptr};
-        uint8_t *buffer_{nullptr};
+
+        // Resource for pull-style decoding
+        AVPacket *pull_packet_{nullptr};
+        bool draining_{false};
+
+        // Frames waiting to be handed over as one batch
+        int batch_size_{1};
+        int batch_first_{0};
+        std::vector<FramePtr> batch_;
+        std::vector<AVFrame *> batch_view_;
+
+        // Random access state: cached RGB frames and the timestamp the
+        // decoder continues at (AV_NOPTS_VALUE after any other use)
+        FrameCache frame_cache_;
+        int prefetch_frames_{8};
+        int64_t next_access_pts_{AV_NOPTS_VALUE};
 
         // Initialize Resource
         bool initializeFrameBuffers();
 
+        // Convert the decoded frame to a pooled RGB frame with its timestamps
+        FramePtr convertFrame(int64_t frame_number);
+
+        // Convert the decoded frame to RGB and hand it over to the processor
+        bool deliverFrame(FrameProcessor &processor, int frame_number);
+
+        // readFrame() without resetting the random access state
+        bool decodeNextFrame(AVFrame *frame);
+
+        // Whether getFrame() can reach timestamp without seeking
+        bool canDecodeForwardTo(int64_t timestamp);
+
+        // Hand the pending batch over to the processor
+        bool flushBatch(FrameProcessor &processor);
+
         // Free Resource
         void cleanup();
     };
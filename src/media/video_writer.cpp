@@ -1,9 +1,43 @@
 #include <media/video_writer.h>
+#include <media/codec_cache.h>
+#include <processing/luma_kernels.h>
+#include <profiling/memory_tracker.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
 #include <sstream>
 
 namespace video_codec
 {
+    namespace
+    {
+        StageMetrics &encodeMetrics()
+        {
+            static StageMetrics &metrics = PipelineMetrics::instance().stage("encode");
+            return metrics;
+        }
+
+        StageMetrics &audioEncodeMetrics()
+        {
+            static StageMetrics &metrics = PipelineMetrics::instance().stage("audio encode");
+            return metrics;
+        }
+
+        // パケットを書き込み、書き込みバイト数を記録する
+        // インターリーブ待ちのパケットは muxer のメモリとして計上する
+        int writePacket(AVFormatContext *format_ctx, AVPacket *pkt)
+        {
+            static StageMetrics &mux_metrics = PipelineMetrics::instance().stage("mux");
+            static MemoryAccount &mux_memory = MemoryTracker::instance().account("muxer");
+            mux_metrics.addBytesWritten(pkt->size);
+            MemoryTracker::instance().trackPacket(pkt, mux_memory);
+            return timeStage(mux_metrics, [&]
+                             { return av_interleaved_write_frame(format_ctx, pkt); });
+        }
+    }
+
     VideoWriter::VideoWriter()
     {
     }
@@ -17,13 +51,35 @@ namespace video_codec
     {
         if (sws_ctx_)
         {
-            sws_freeContext(sws_ctx_);
+            CodecCache::instance().releaseScaler(sws_ctx_);
             sws_ctx_ = nullptr;
         }
 
         if (yuv_frame_)
             av_frame_free(&yuv_frame_);
 
+        if (last_input_)
+            av_frame_free(&last_input_);
+        last_dropped_ = false;
+
+        if (audio_swr_ctx_)
+            swr_free(&audio_swr_ctx_);
+
+        if (audio_fifo_)
+        {
+            av_audio_fifo_free(audio_fifo_);
+            audio_fifo_ = nullptr;
+        }
+
+        if (audio_frame_)
+            av_frame_free(&audio_frame_);
+
+        if (audio_packet_)
+            av_packet_free(&audio_packet_);
+
+        if (audio_codec_ctx_)
+            avcodec_free_context(&audio_codec_ctx_);
+
         if (codec_ctx_)
         {
             avcodec_close(codec_ctx_);
@@ -40,25 +96,51 @@ namespace video_codec
         }
 
         frame_count_ = 0;
+        video_packets_ = 0;
+        updateEncoderMemory();
+
+        audio_stream_ = nullptr;
+        audio_mode_ = AudioOutputSettings::Mode::None;
+        audio_samples_ = 0;
+        audio_started_ = false;
+        audio_start_time_ = AV_NOPTS_VALUE;
+        audio_frame_start_time_ = 0;
+        audio_copy_start_ = AV_NOPTS_VALUE;
     }
 
     bool VideoWriter::open(const std::string &filename, int width, int height,
-                           double fps, const std::string &codec)
+                           double fps, const std::string &codec,
+                           const AudioOutputSettings &audio)
     {
         cleanup();
 
         width_ = width;
         height_ = height;
         fps_ = fps;
-
-        // 出力フォーマットコンテキストの作成
-        int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, nullptr, filename.c_str());
+        dropped_frames_ = 0;
+        next_keyframe_ = 0;
+        keyframe_index_ = 0;
+
+        // 出力フォーマットコンテキストの作成（HLS/DASH は拡張子によらずそのマルチプレクサー）
+        const char *format_name = segmented_.mode == SegmentedOutputSettings::Mode::Hls    ? "hls"
+                                  : segmented_.mode == SegmentedOutputSettings::Mode::Dash ? "dash"
+                                                                                           : nullptr;
+        int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, format_name, filename.c_str());
         if (ret < 0)
         {
             setError("Could not allocate output format context", ret);
             return false;
         }
 
+        const AVClass *muxer_class = format_ctx_->oformat->priv_class;
+        if (segmented_.mode == SegmentedOutputSettings::Mode::FragmentedMp4 &&
+            (!muxer_class || !av_opt_find(&muxer_class, "movflags", nullptr, 0, AV_OPT_SEARCH_FAKE_OBJ)))
+        {
+            setError("Fragmented output needs an MP4 or MOV file: " + filename);
+            cleanup();
+            return false;
+        }
+
         // エンコーダーの初期化
         if (!initializeEncoder(codec))
         {
@@ -66,6 +148,13 @@ namespace video_codec
             return false;
         }
 
+        // 音声トラックの初期化
+        if (!initializeAudio(audio))
+        {
+            cleanup();
+            return false;
+        }
+
         // スケーラーの初期化
         if (!initializeScaler())
         {
@@ -93,7 +182,15 @@ namespace video_codec
         }
 
         // ヘッダーを書き込む
-        ret = avformat_write_header(format_ctx_, nullptr);
+        AVDictionary *mux_options = nullptr;
+        if (!segmentedMuxerOptions(filename, &mux_options))
+        {
+            av_dict_free(&mux_options);
+            cleanup();
+            return false;
+        }
+        ret = avformat_write_header(format_ctx_, &mux_options);
+        av_dict_free(&mux_options);
         if (ret < 0)
         {
             setError("Could not write header", ret);
@@ -147,6 +244,20 @@ namespace video_codec
             av_opt_set(codec_ctx_->priv_data, "tune", "zerolatency", 0);
         }
 
+        if (encode_settings_.bit_rate > 0)
+            codec_ctx_->bit_rate = encode_settings_.bit_rate;
+
+        // キーフレームを強制する場合は GOP をその間隔に合わせ、強制したキーフレームを IDR にする
+        if (keyframeInterval() > 0.0)
+        {
+            codec_ctx_->gop_size = std::max(1, static_cast<int>(std::lround(keyframeInterval() * fps_)));
+            if (codec->id == AV_CODEC_ID_H264 || codec->id == AV_CODEC_ID_HEVC)
+                av_opt_set(codec_ctx_->priv_data, "forced-idr", "1", 0);
+        }
+
+        if (encoder_threads_ > 0)
+            codec_ctx_->thread_count = encoder_threads_;
+
         // グローバルヘッダーフラグの設定
         if (format_ctx_->oformat->flags & AVFMT_GLOBALHEADER)
             codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
@@ -170,13 +281,177 @@ namespace video_codec
         return true;
     }
 
+    double VideoWriter::keyframeInterval() const
+    {
+        if (segmented_.mode != SegmentedOutputSettings::Mode::None)
+            return segmented_.segment_duration;
+        return encode_settings_.keyframe_interval;
+    }
+
+    bool VideoWriter::segmentedMuxerOptions(const std::string &filename, AVDictionary **options)
+    {
+        if (segmented_.segment_duration <= 0.0)
+        {
+            setError("Segment duration must be positive");
+            return false;
+        }
+
+        // セグメントは出力と同じディレクトリに、出力のファイル名を付けて置く
+        std::filesystem::path path(filename);
+        std::string stem = path.stem().string();
+        std::string duration = std::to_string(segmented_.segment_duration);
+
+        switch (segmented_.mode)
+        {
+        case SegmentedOutputSettings::Mode::None:
+            break;
+
+        case SegmentedOutputSettings::Mode::FragmentedMp4:
+            // 書き込んだ断片はすぐに読めるよう、パケットごとにフラッシュする
+            av_dict_set(options, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+            av_dict_set(options, "flush_packets", "1", 0);
+            break;
+
+        case SegmentedOutputSettings::Mode::Hls:
+        {
+            // event プレイリストはセグメントごとに追記され、close() で ENDLIST が付く
+            const char *extension = segmented_.hls_mpegts ? ".ts" : ".m4s";
+            av_dict_set(options, "hls_time", duration.c_str(), 0);
+            av_dict_set(options, "hls_list_size", "0", 0);
+            av_dict_set(options, "hls_playlist_type", "event", 0);
+            av_dict_set(options, "hls_flags", "independent_segments", 0);
+            av_dict_set(options, "hls_segment_type", segmented_.hls_mpegts ? "mpegts" : "fmp4", 0);
+            av_dict_set(options, "hls_segment_filename", (path.parent_path() / (stem + "_%05d" + extension)).string().c_str(), 0);
+            if (!segmented_.hls_mpegts)
+                av_dict_set(options, "hls_fmp4_init_filename", (stem + "_init.mp4").c_str(), 0);
+            break;
+        }
+
+        case SegmentedOutputSettings::Mode::Dash:
+            // マニフェストはセグメントを書くたびに更新される
+            av_dict_set(options, "seg_duration", duration.c_str(), 0);
+            av_dict_set(options, "use_template", "1", 0);
+            av_dict_set(options, "use_timeline", "1", 0);
+            av_dict_set(options, "init_seg_name", (stem + "_init_$RepresentationID$.$ext$").c_str(), 0);
+            av_dict_set(options, "media_seg_name", (stem + "_$RepresentationID$_$Number%05d$.$ext$").c_str(), 0);
+            break;
+        }
+
+        return true;
+    }
+
+    bool VideoWriter::initializeAudio(const AudioOutputSettings &audio)
+    {
+        audio_mode_ = audio.mode;
+        audio_start_time_ = audio.start_time;
+        audio_frame_start_time_ = audio.frame_start_time;
+        if (audio.mode == AudioOutputSettings::Mode::None)
+            return true;
+
+        // 音声ストリームを追加
+        audio_stream_ = avformat_new_stream(format_ctx_, nullptr);
+        audio_packet_ = av_packet_alloc();
+        if (!audio_stream_ || !audio_packet_)
+        {
+            setError("Could not allocate audio stream");
+            return false;
+        }
+
+        audio_stream_->id = format_ctx_->nb_streams - 1;
+
+        // ストリームコピー：元のパラメータをそのまま使う
+        if (audio.mode == AudioOutputSettings::Mode::Copy)
+        {
+            if (!audio.copy_parameters)
+            {
+                setError("No audio parameters to copy");
+                return false;
+            }
+
+            int ret = avcodec_parameters_copy(audio_stream_->codecpar, audio.copy_parameters);
+            if (ret < 0)
+            {
+                setError("Could not copy audio parameters", ret);
+                return false;
+            }
+
+            // コンテナに合わせてタグを選び直させる
+            audio_stream_->codecpar->codec_tag = 0;
+            audio_stream_->time_base = audio.copy_time_base;
+            return true;
+        }
+
+        // エンコーダーを見つける
+        const AVCodec *codec = avcodec_find_encoder_by_name(audio.codec.c_str());
+        if (!codec)
+        {
+            setError("Audio codec not found: " + audio.codec);
+            return false;
+        }
+
+        audio_codec_ctx_ = avcodec_alloc_context3(codec);
+        if (!audio_codec_ctx_)
+        {
+            setError("Could not allocate audio encoding context");
+            return false;
+        }
+
+        audio_codec_ctx_->sample_rate = audio.sample_rate;
+        audio_codec_ctx_->bit_rate = audio.bit_rate;
+        audio_codec_ctx_->time_base = {1, audio.sample_rate};
+        av_channel_layout_default(&audio_codec_ctx_->ch_layout, audio.channels);
+
+        // planar float を優先し、非対応ならエンコーダーの最初の形式
+        audio_codec_ctx_->sample_fmt = AV_SAMPLE_FMT_FLTP;
+        if (codec->sample_fmts)
+        {
+            audio_codec_ctx_->sample_fmt = codec->sample_fmts[0];
+            for (const AVSampleFormat *fmt = codec->sample_fmts; *fmt != AV_SAMPLE_FMT_NONE; ++fmt)
+            {
+                if (*fmt == AV_SAMPLE_FMT_FLTP)
+                    audio_codec_ctx_->sample_fmt = AV_SAMPLE_FMT_FLTP;
+            }
+        }
+
+        if (format_ctx_->oformat->flags & AVFMT_GLOBALHEADER)
+            audio_codec_ctx_->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+        int ret = avcodec_open2(audio_codec_ctx_, codec, nullptr);
+        if (ret < 0)
+        {
+            setError("Could not open audio codec", ret);
+            return false;
+        }
+
+        ret = avcodec_parameters_from_context(audio_stream_->codecpar, audio_codec_ctx_);
+        if (ret < 0)
+        {
+            setError("Could not copy audio stream parameters", ret);
+            return false;
+        }
+
+        audio_stream_->time_base = audio_codec_ctx_->time_base;
+
+        int frame_size = audio_codec_ctx_->frame_size > 0 ? audio_codec_ctx_->frame_size : 1024;
+        audio_fifo_ = av_audio_fifo_alloc(audio_codec_ctx_->sample_fmt, audio.channels, frame_size);
+        audio_frame_ = av_frame_alloc();
+        if (!audio_fifo_ || !audio_frame_)
+        {
+            setError("Could not allocate audio buffers");
+            return false;
+        }
+
+        return true;
+    }
+
     bool VideoWriter::initializeScaler()
     {
         // RGB24 から YUV420P への変換コンテキストを作成
-        sws_ctx_ = sws_getContext(
+        // 同じ解像度の変換コンテキストはキャッシュから再利用する
+        sws_ctx_ = CodecCache::instance().acquireScaler(
             width_, height_, AV_PIX_FMT_RGB24,
             width_, height_, AV_PIX_FMT_YUV420P,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
+            SWS_BILINEAR);
 
         if (!sws_ctx_)
         {
@@ -219,6 +494,45 @@ namespace video_codec
             return false;
         }
 
+        // 切り抜いたフレームはポインタをずらしただけなので、サイズだけ合えばそのまま変換できる
+        if (frame->width != width_ || frame->height != height_)
+        {
+            setError("Frame size " + std::to_string(frame->width) + "x" + std::to_string(frame->height) +
+                     " does not match the output size " + std::to_string(width_) + "x" + std::to_string(height_));
+            return false;
+        }
+
+        if (!drop_duplicates_)
+            return encodeVideoFrame(frame);
+
+        // 直前の入力と同じなら時刻だけ進める（変換とエンコードを省く）
+        if (last_input_ && framesEqual(frame, last_input_))
+        {
+            frame_count_++;
+            dropped_frames_++;
+            last_dropped_ = true;
+            return true;
+        }
+
+        if (!last_input_)
+            last_input_ = av_frame_alloc();
+        else
+            av_frame_unref(last_input_);
+
+        // 参照カウント付きのフレームならコピーは発生しない
+        int ret = last_input_ ? av_frame_ref(last_input_, frame) : AVERROR(ENOMEM);
+        if (ret < 0)
+        {
+            setError("Could not reference input frame", ret);
+            return false;
+        }
+
+        last_dropped_ = false;
+        return encodeVideoFrame(frame);
+    }
+
+    bool VideoWriter::encodeVideoFrame(AVFrame *frame)
+    {
         // フレームが書き込み可能か確認
         int ret = av_frame_make_writable(yuv_frame_);
         if (ret < 0)
@@ -228,10 +542,12 @@ namespace video_codec
         }
 
         // RGB24 から YUV420P に変換
-        ret = sws_scale(
-            sws_ctx_,
-            frame->data, frame->linesize, 0, height_,
-            yuv_frame_->data, yuv_frame_->linesize);
+        static StageMetrics &sws_metrics = PipelineMetrics::instance().stage("sws to yuv");
+        sws_metrics.addFrames(1);
+        ret = timeStage(sws_metrics, frame_count_, [&]
+                        { return sws_scale(sws_ctx_,
+                                           frame->data, frame->linesize, 0, height_,
+                                           yuv_frame_->data, yuv_frame_->linesize); });
 
         if (ret <= 0)
         {
@@ -242,8 +558,19 @@ namespace video_codec
         // タイムスタンプを設定
         yuv_frame_->pts = frame_count_;
 
+        // 間隔ごと（セグメント境界）にキーフレームを強制（境界のフレームが間引かれていたら次のフレーム）
+        yuv_frame_->pict_type = AV_PICTURE_TYPE_NONE;
+        if (keyframeInterval() > 0.0 && frame_count_ >= next_keyframe_)
+        {
+            yuv_frame_->pict_type = AV_PICTURE_TYPE_I;
+            while (next_keyframe_ <= frame_count_)
+                next_keyframe_ = std::llround(static_cast<double>(++keyframe_index_) * keyframeInterval() * fps_);
+        }
+
         // フレームをエンコーダーに送信
-        ret = avcodec_send_frame(codec_ctx_, yuv_frame_);
+        encodeMetrics().addFrames(1);
+        ret = timeStage(encodeMetrics(), frame_count_, [&]
+                        { return avcodec_send_frame(codec_ctx_, yuv_frame_); });
         if (ret < 0)
         {
             setError("Error sending frame to encoder", ret);
@@ -258,7 +585,8 @@ namespace video_codec
 
         while (ret >= 0)
         {
-            ret = avcodec_receive_packet(codec_ctx_, &pkt);
+            ret = timeStage(encodeMetrics(), [&]
+                            { return avcodec_receive_packet(codec_ctx_, &pkt); });
             if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
                 break;
             else if (ret < 0)
@@ -268,12 +596,14 @@ namespace video_codec
                 return false;
             }
 
+            video_packets_++;
+
             // タイムスタンプを調整
             av_packet_rescale_ts(&pkt, codec_ctx_->time_base, video_stream_->time_base);
             pkt.stream_index = video_stream_->index;
 
             // パケットをファイルに書き込む
-            ret = av_interleaved_write_frame(format_ctx_, &pkt);
+            ret = writePacket(format_ctx_, &pkt);
             if (ret < 0)
             {
                 setError("Error writing packet", ret);
@@ -285,6 +615,236 @@ namespace video_codec
         }
 
         frame_count_++;
+        updateEncoderMemory();
+        return true;
+    }
+
+    void VideoWriter::updateEncoderMemory()
+    {
+        // 送信済みでパケットになっていないフレームはエンコーダーが保持している
+        int64_t bytes = 0;
+        int64_t encoded_frames = frame_count_ - dropped_frames_;
+        if (codec_ctx_ && encoded_frames > video_packets_)
+            bytes = (encoded_frames - video_packets_) *
+                    av_image_get_buffer_size(codec_ctx_->pix_fmt, width_, height_, 1);
+
+        static MemoryAccount &encoder_memory = MemoryTracker::instance().account("encoder (estimated)");
+        MemoryTracker::instance().adjustEstimate(encoder_memory, bytes - encoder_memory_bytes_);
+        encoder_memory_bytes_ = bytes;
+    }
+
+    bool VideoWriter::writeAudioFrame(const AVFrame *frame)
+    {
+        if (audio_mode_ != AudioOutputSettings::Mode::Encode || !audio_codec_ctx_)
+        {
+            setError("VideoWriter has no audio encoder");
+            return false;
+        }
+
+        // 最初のフレームの時刻から始め、以降はサンプル数で進める
+        if (!audio_started_ && frame)
+        {
+            audio_started_ = true;
+
+            AVRational samples_time_base{1, audio_codec_ctx_->sample_rate};
+            AVRational frame_time_base = frame->time_base.num > 0 ? frame->time_base : AVRational{1, frame->sample_rate};
+            audio_samples_ = frame->pts != AV_NOPTS_VALUE ? av_rescale_q(frame->pts, frame_time_base, samples_time_base) : 0;
+
+            // 映像の開始時刻を 0 とする
+            if (audio_start_time_ != AV_NOPTS_VALUE)
+                audio_samples_ += av_rescale_q(audio_frame_start_time_ - audio_start_time_, AV_TIME_BASE_Q, samples_time_base);
+        }
+
+        return bufferAudio(frame) && encodeBufferedAudio(false);
+    }
+
+    bool VideoWriter::bufferAudio(const AVFrame *frame)
+    {
+        bool convert = audio_swr_ctx_ != nullptr;
+        if (frame && !convert)
+        {
+            convert = frame->format != audio_codec_ctx_->sample_fmt ||
+                      frame->sample_rate != audio_codec_ctx_->sample_rate ||
+                      av_channel_layout_compare(&frame->ch_layout, &audio_codec_ctx_->ch_layout) != 0;
+        }
+
+        // そのまま FIFO へ
+        if (!convert)
+        {
+            if (frame && av_audio_fifo_write(audio_fifo_, reinterpret_cast<void **>(frame->extended_data),
+                                             frame->nb_samples) < frame->nb_samples)
+            {
+                setError("Could not buffer audio samples");
+                return false;
+            }
+            return true;
+        }
+
+        // 最初のフレームの形式からリサンプラーを作成
+        if (!audio_swr_ctx_)
+        {
+            int ret = swr_alloc_set_opts2(&audio_swr_ctx_,
+                                          &audio_codec_ctx_->ch_layout, audio_codec_ctx_->sample_fmt, audio_codec_ctx_->sample_rate,
+                                          &frame->ch_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
+                                          0, nullptr);
+            if (ret < 0 || (ret = swr_init(audio_swr_ctx_)) < 0)
+            {
+                setError("Could not initialize audio resampler", ret);
+                return false;
+            }
+        }
+
+        int out_count = swr_get_out_samples(audio_swr_ctx_, frame ? frame->nb_samples : 0);
+        if (out_count <= 0)
+            return true;
+
+        uint8_t **converted = nullptr;
+        int ret = av_samples_alloc_array_and_samples(&converted, nullptr, audio_codec_ctx_->ch_layout.nb_channels,
+                                                     out_count, audio_codec_ctx_->sample_fmt, 0);
+        if (ret < 0)
+        {
+            setError("Could not allocate audio conversion buffer", ret);
+            return false;
+        }
+
+        ret = swr_convert(audio_swr_ctx_, converted, out_count,
+                          frame ? const_cast<const uint8_t **>(frame->extended_data) : nullptr,
+                          frame ? frame->nb_samples : 0);
+
+        bool result = true;
+        if (ret < 0)
+        {
+            setError("Error during audio resampling", ret);
+            result = false;
+        }
+        else if (ret > 0 && av_audio_fifo_write(audio_fifo_, reinterpret_cast<void **>(converted), ret) < ret)
+        {
+            setError("Could not buffer audio samples");
+            result = false;
+        }
+
+        av_freep(&converted[0]);
+        av_freep(&converted);
+        return result;
+    }
+
+    bool VideoWriter::encodeBufferedAudio(bool flush)
+    {
+        int frame_size = audio_codec_ctx_->frame_size > 0 ? audio_codec_ctx_->frame_size : 1024;
+
+        while (av_audio_fifo_size(audio_fifo_) >= frame_size || (flush && av_audio_fifo_size(audio_fifo_) > 0))
+        {
+            int nb_samples = std::min(av_audio_fifo_size(audio_fifo_), frame_size);
+
+            // エンコーダーが参照を保持できるよう毎回新しいバッファを使う
+            av_frame_unref(audio_frame_);
+            audio_frame_->nb_samples = nb_samples;
+            audio_frame_->format = audio_codec_ctx_->sample_fmt;
+            audio_frame_->sample_rate = audio_codec_ctx_->sample_rate;
+
+            int ret = av_channel_layout_copy(&audio_frame_->ch_layout, &audio_codec_ctx_->ch_layout);
+            if (ret >= 0)
+                ret = av_frame_get_buffer(audio_frame_, 0);
+            if (ret < 0)
+            {
+                setError("Could not allocate audio frame buffer", ret);
+                return false;
+            }
+
+            if (av_audio_fifo_read(audio_fifo_, reinterpret_cast<void **>(audio_frame_->data), nb_samples) < nb_samples)
+            {
+                setError("Could not read buffered audio samples");
+                return false;
+            }
+
+            audio_frame_->pts = audio_samples_;
+            audio_samples_ += nb_samples;
+
+            if (!encodeAudioFrame(audio_frame_))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool VideoWriter::encodeAudioFrame(AVFrame *frame)
+    {
+        if (frame)
+            audioEncodeMetrics().addFrames(1);
+        int ret = timeStage(audioEncodeMetrics(), [&]
+                            { return avcodec_send_frame(audio_codec_ctx_, frame); });
+        if (ret < 0 && !(frame == nullptr && ret == AVERROR_EOF))
+        {
+            setError("Error sending frame to audio encoder", ret);
+            return false;
+        }
+
+        while (true)
+        {
+            ret = timeStage(audioEncodeMetrics(), [&]
+                            { return avcodec_receive_packet(audio_codec_ctx_, audio_packet_); });
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                break;
+            else if (ret < 0)
+            {
+                setError("Error receiving packet from audio encoder", ret);
+                return false;
+            }
+
+            av_packet_rescale_ts(audio_packet_, audio_codec_ctx_->time_base, audio_stream_->time_base);
+            audio_packet_->stream_index = audio_stream_->index;
+
+            // 映像パケットとインターリーブして書き込む
+            ret = writePacket(format_ctx_, audio_packet_);
+            if (ret < 0)
+            {
+                setError("Error writing audio packet", ret);
+                av_packet_unref(audio_packet_);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool VideoWriter::writeAudioPacket(AVPacket *packet, AVRational time_base)
+    {
+        if (audio_mode_ != AudioOutputSettings::Mode::Copy || !audio_stream_)
+        {
+            setError("VideoWriter has no audio track to copy into");
+            av_packet_unref(packet);
+            return false;
+        }
+
+        // 映像の開始時刻を 0 とする（不明なら音声の先頭を 0 にする）
+        if (audio_copy_start_ == AV_NOPTS_VALUE)
+        {
+            if (audio_start_time_ != AV_NOPTS_VALUE)
+                audio_copy_start_ = av_rescale_q(audio_start_time_, AV_TIME_BASE_Q, time_base);
+            else
+                audio_copy_start_ = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        }
+
+        if (audio_copy_start_ != AV_NOPTS_VALUE)
+        {
+            if (packet->pts != AV_NOPTS_VALUE)
+                packet->pts -= audio_copy_start_;
+            if (packet->dts != AV_NOPTS_VALUE)
+                packet->dts -= audio_copy_start_;
+        }
+
+        av_packet_rescale_ts(packet, time_base, audio_stream_->time_base);
+        packet->stream_index = audio_stream_->index;
+        packet->pos = -1;
+
+        int ret = writePacket(format_ctx_, packet);
+        if (ret < 0)
+        {
+            setError("Error writing audio packet", ret);
+            av_packet_unref(packet);
+            return false;
+        }
+
         return true;
     }
 
@@ -293,8 +853,19 @@ namespace video_codec
         if (!format_ctx_)
             return true; // 既に閉じている
 
+        // 末尾の重複を捨てたままだと最後のフレームの表示時間が失われるので、最後の1枚はエンコードする
+        if (last_dropped_ && last_input_)
+        {
+            frame_count_--;
+            dropped_frames_--;
+            last_dropped_ = false;
+            if (!encodeVideoFrame(last_input_))
+                return false;
+        }
+
         // 残りのフレームをフラッシュ
-        int ret = avcodec_send_frame(codec_ctx_, nullptr);
+        int ret = timeStage(encodeMetrics(), [&]
+                            { return avcodec_send_frame(codec_ctx_, nullptr); });
         if (ret < 0)
         {
             setError("Error flushing encoder", ret);
@@ -308,7 +879,8 @@ namespace video_codec
 
         while (true)
         {
-            ret = avcodec_receive_packet(codec_ctx_, &pkt);
+            ret = timeStage(encodeMetrics(), [&]
+                            { return avcodec_receive_packet(codec_ctx_, &pkt); });
             if (ret == AVERROR_EOF)
                 break;
             else if (ret < 0)
@@ -318,10 +890,11 @@ namespace video_codec
                 return false;
             }
 
+            video_packets_++;
             av_packet_rescale_ts(&pkt, codec_ctx_->time_base, video_stream_->time_base);
             pkt.stream_index = video_stream_->index;
 
-            ret = av_interleaved_write_frame(format_ctx_, &pkt);
+            ret = writePacket(format_ctx_, &pkt);
             if (ret < 0)
             {
                 setError("Error writing packet during flush", ret);
@@ -332,6 +905,13 @@ namespace video_codec
             av_packet_unref(&pkt);
         }
 
+        // 音声の残りをエンコードしてフラッシュ
+        if (audio_codec_ctx_)
+        {
+            if (!bufferAudio(nullptr) || !encodeBufferedAudio(true) || !encodeAudioFrame(nullptr))
+                return false;
+        }
+
         // トレーラーを書き込む
         ret = av_write_trailer(format_ctx_);
         if (ret < 0)
@@ -6,6 +6,9 @@ extern "C"
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
 #include <libswscale/swscale.h>
+#include <libswresample/swresample.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/imgutils.h>
 }
 
 #include <string>
@@ -13,6 +16,69 @@ extern "C"
 
 namespace video_codec
 {
+    // 音声トラックの設定
+    struct AudioOutputSettings
+    {
+        enum class Mode
+        {
+            None,   // 音声なし
+            Encode, // writeAudioFrame() のフレームをエンコード
+            Copy    // writeAudioPacket() のパケットをそのまま書き込む
+        };
+
+        Mode mode{Mode::None};
+
+        // Encode 用
+        std::string codec{"aac"};
+        int sample_rate{48000};
+        int channels{2};
+        int64_t bit_rate{128000};
+
+        // Copy 用（元ストリームのパラメータとタイムベース）
+        const AVCodecParameters *copy_parameters{nullptr};
+        AVRational copy_time_base{0, 1};
+
+        // 映像の 0 に対応する元ファイルの時刻（AV_TIME_BASE 単位、MediaFile::getVideoStartTime()）。
+        // 音声も同じ基準で 0 からの時刻に直すので、映像と音声の開始のずれが保たれる。
+        // AV_NOPTS_VALUE なら音声の先頭を 0 にする。
+        int64_t start_time{AV_NOPTS_VALUE};
+
+        // Encode 用: writeAudioFrame() の pts が 0 となる元ファイルの時刻（AV_TIME_BASE 単位）。
+        // AudioStream の pts はファイルの開始時刻 (AVFormatContext::start_time) からのサンプル数。
+        int64_t frame_start_time{0};
+    };
+
+    // 分割出力の設定
+    // どのモードでもセグメント境界（segment_duration 秒ごと）にキーフレームを強制する。
+    // 境界はフレーム番号だけで決まるので、同じ設定で時間範囲ごとに別々に
+    // エンコードしても GOP とセグメントの位置が揃う。
+    struct SegmentedOutputSettings
+    {
+        enum class Mode
+        {
+            None,          // 1つのファイル（トレーラーは close() で書き込む）
+            FragmentedMp4, // 先頭に空の moov を書き、キーフレームごとに moof+mdat を追記（mp4/mov）
+            Hls,           // セグメントとプレイリスト (.m3u8)
+            Dash           // CMAF セグメントとマニフェスト (.mpd)
+        };
+
+        Mode mode{Mode::None};
+        double segment_duration{4.0}; // 秒
+
+        // HLS のセグメントを MPEG-TS にする（既定は fMP4/CMAF）
+        bool hls_mpegts{false};
+    };
+
+    // 映像エンコーダーの追加設定
+    struct VideoEncodeSettings
+    {
+        int64_t bit_rate{0}; // 0 なら width * height * 4
+
+        // キーフレームを強制する間隔（秒、0 なら強制しない、分割出力ではセグメント長が優先）
+        // 同じ間隔とフレームレートの出力同士は GOP の位置が揃う（ABR ラダーのレンディション間など）
+        double keyframe_interval{0.0};
+    };
+
     class VideoWriter
     {
     public:
@@ -21,11 +87,35 @@ namespace video_codec
 
         // 動画ファイルとして出力開始
         bool open(const std::string &filename, int width, int height,
-                  double fps = 30.0, const std::string &codec = "libx264");
+                  double fps = 30.0, const std::string &codec = "libx264",
+                  const AudioOutputSettings &audio = {});
 
         // フレームを書き込む
         bool writeFrame(AVFrame *frame);
 
+        // 音声フレーム（planar float）を書き込む
+        bool writeAudioFrame(const AVFrame *frame);
+
+        // 元ファイルの音声パケットをそのまま書き込む
+        bool writeAudioPacket(AVPacket *packet, AVRational time_base);
+
+        bool hasAudio() const { return audio_stream_ != nullptr; }
+
+        // エンコーダーのスレッド数（open() の前に設定、0 ならエンコーダーの既定値）
+        void setEncoderThreads(int thread_count) { encoder_threads_ = thread_count; }
+
+        // ビットレートとキーフレーム間隔（open() の前に設定）
+        void setEncodeSettings(const VideoEncodeSettings &settings) { encode_settings_ = settings; }
+
+        // 分割出力（open() の前に設定）
+        // 書き込み中もセグメントとプレイリストが順次完成するので、後段はエンコード終了を待たずに読み始められる
+        void setSegmentedOutput(const SegmentedOutputSettings &settings) { segmented_ = settings; }
+
+        // 直前のフレームと完全に同じフレームをエンコードせずに捨てる（間引き）
+        // 捨てたフレームの時間は直前のフレームの表示時間に含まれる（可変フレームレート）
+        void setDropDuplicates(bool drop_duplicates) { drop_duplicates_ = drop_duplicates; }
+        int64_t getDroppedFrames() const { return dropped_frames_; }
+
         // 動画ファイルを閉じて出力完了
         bool close();
 
@@ -43,14 +133,64 @@ namespace video_codec
         int width_{0};
         int height_{0};
         double fps_{30.0};
+        int encoder_threads_{0};
 
         int64_t frame_count_{0};
 
+        VideoEncodeSettings encode_settings_;
+
+        // 分割出力
+        SegmentedOutputSettings segmented_;
+
+        // キーフレームの強制
+        int64_t next_keyframe_{0}; // 次にキーフレームを強制するフレーム番号
+        int64_t keyframe_index_{0};
+        double keyframeInterval() const;
+
+        // 重複フレームの間引き
+        bool drop_duplicates_{false};
+        AVFrame *last_input_{nullptr}; // 最後にエンコードした入力フレームの参照
+        int64_t dropped_frames_{0};
+        bool last_dropped_{false};
+
+        // エンコーダー内部に滞留しているフレーム分のメモリ見積もり
+        int64_t video_packets_{0};
+        int64_t encoder_memory_bytes_{0};
+        void updateEncoderMemory();
+
+        // 音声トラック
+        AudioOutputSettings::Mode audio_mode_{AudioOutputSettings::Mode::None};
+        AVStream *audio_stream_{nullptr};
+        AVCodecContext *audio_codec_ctx_{nullptr};
+        SwrContext *audio_swr_ctx_{nullptr}; // 入力とエンコーダーの形式が異なる場合のみ
+        AVAudioFifo *audio_fifo_{nullptr};   // エンコーダーのフレームサイズ単位にまとめる
+        AVFrame *audio_frame_{nullptr};
+        AVPacket *audio_packet_{nullptr};
+        int64_t audio_samples_{0};
+        bool audio_started_{false};
+        int64_t audio_start_time_{AV_NOPTS_VALUE};       // AudioOutputSettings::start_time
+        int64_t audio_frame_start_time_{0};              // AudioOutputSettings::frame_start_time
+        int64_t audio_copy_start_{AV_NOPTS_VALUE};
+
         std::string last_error_;
 
         bool initializeEncoder(const std::string &codec_name);
         bool initializeScaler();
         bool initializeYUVFrame();
+        bool initializeAudio(const AudioOutputSettings &audio);
+
+        // 分割出力のマルチプレクサーオプション（avformat_write_header() に渡す）
+        bool segmentedMuxerOptions(const std::string &filename, AVDictionary **options);
+
+        // YUV に変換してエンコードし、frame_count_ を進める
+        bool encodeVideoFrame(AVFrame *frame);
+
+        // エンコーダーの形式に変換して FIFO に貯める（nullptr ならリサンプラーの残り）
+        bool bufferAudio(const AVFrame *frame);
+
+        // FIFO から frame_size 単位でエンコード（flush なら残りもすべて）
+        bool encodeBufferedAudio(bool flush);
+        bool encodeAudioFrame(AVFrame *frame);
 
         void cleanup();
 
@@ -0,0 +1,301 @@
+#include <processing/audio_kernels.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace video_codec
+{
+    void applyGain(float *samples, size_t count, float gain)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 8 <= count; i += 8)
+        {
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+            _mm_storeu_ps(samples + i + 4, _mm_mul_ps(_mm_loadu_ps(samples + i + 4), g));
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 8 <= count; i += 8)
+        {
+            vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), gain));
+            vst1q_f32(samples + i + 4, vmulq_n_f32(vld1q_f32(samples + i + 4), gain));
+        }
+#endif
+
+        for (; i < count; ++i)
+            samples[i] *= gain;
+    }
+
+    void applyGainRamp(float *samples, size_t count, float start_gain, float end_gain)
+    {
+        if (count == 0)
+            return;
+
+        if (start_gain == end_gain)
+        {
+            applyGain(samples, count, start_gain);
+            return;
+        }
+
+        const float step = (end_gain - start_gain) / static_cast<float>(count);
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        __m128 g = _mm_setr_ps(start_gain, start_gain + step, start_gain + 2 * step, start_gain + 3 * step);
+        const __m128 g_step = _mm_set1_ps(4 * step);
+        for (; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+            g = _mm_add_ps(g, g_step);
+        }
+#elif defined(__ARM_NEON)
+        const float init[4] = {start_gain, start_gain + step, start_gain + 2 * step, start_gain + 3 * step};
+        float32x4_t g = vld1q_f32(init);
+        const float32x4_t g_step = vdupq_n_f32(4 * step);
+        for (; i + 4 <= count; i += 4)
+        {
+            vst1q_f32(samples + i, vmulq_f32(vld1q_f32(samples + i), g));
+            g = vaddq_f32(g, g_step);
+        }
+#endif
+
+        for (; i < count; ++i)
+            samples[i] *= start_gain + step * static_cast<float>(i);
+    }
+
+    void mixInto(float *dst, const float *src, size_t count, float gain)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128 g = _mm_set1_ps(gain);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 mixed = _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g));
+            _mm_storeu_ps(dst + i, mixed);
+        }
+#elif defined(__ARM_NEON)
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+#endif
+
+        for (; i < count; ++i)
+            dst[i] += src[i] * gain;
+    }
+
+    float peakLevel(const float *samples, size_t count)
+    {
+        float peak = 0.0f;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        // Clearing the sign bit gives the absolute value
+        const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 vpeak = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+            vpeak = _mm_max_ps(vpeak, _mm_and_ps(_mm_loadu_ps(samples + i), abs_mask));
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, vpeak);
+        peak = std::max({lanes[0], lanes[1], lanes[2], lanes[3]});
+#elif defined(__ARM_NEON)
+        float32x4_t vpeak = vdupq_n_f32(0.0f);
+        for (; i + 4 <= count; i += 4)
+            vpeak = vmaxq_f32(vpeak, vabsq_f32(vld1q_f32(samples + i)));
+
+        float lanes[4];
+        vst1q_f32(lanes, vpeak);
+        peak = std::max({lanes[0], lanes[1], lanes[2], lanes[3]});
+#endif
+
+        for (; i < count; ++i)
+            peak = std::max(peak, std::fabs(samples[i]));
+
+        return peak;
+    }
+
+    float sumSquares(const float *samples, size_t count)
+    {
+        float sum = 0.0f;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        __m128 vsum = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 v = _mm_loadu_ps(samples + i);
+            vsum = _mm_add_ps(vsum, _mm_mul_ps(v, v));
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, vsum);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__ARM_NEON)
+        float32x4_t vsum = vdupq_n_f32(0.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            float32x4_t v = vld1q_f32(samples + i);
+            vsum = vmlaq_f32(vsum, v, v);
+        }
+
+        float lanes[4];
+        vst1q_f32(lanes, vsum);
+        sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+        for (; i < count; ++i)
+            sum += samples[i] * samples[i];
+
+        return sum;
+    }
+
+    void clipSamples(float *samples, size_t count, float limit)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128 hi = _mm_set1_ps(limit);
+        const __m128 lo = _mm_set1_ps(-limit);
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lo), hi));
+#elif defined(__ARM_NEON)
+        const float32x4_t hi = vdupq_n_f32(limit);
+        const float32x4_t lo = vdupq_n_f32(-limit);
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(samples + i, vminq_f32(vmaxq_f32(vld1q_f32(samples + i), lo), hi));
+#endif
+
+        for (; i < count; ++i)
+            samples[i] = std::clamp(samples[i], -limit, limit);
+    }
+
+    void complexPower(const float *bins, float *power, size_t count)
+    {
+        size_t k = 0;
+
+#if defined(__SSE2__)
+        for (; k + 4 <= count; k += 4)
+        {
+            __m128 a = _mm_loadu_ps(bins + 2 * k);
+            __m128 b = _mm_loadu_ps(bins + 2 * k + 4);
+            __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(power + k, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+        }
+#elif defined(__ARM_NEON)
+        for (; k + 4 <= count; k += 4)
+        {
+            float32x4x2_t v = vld2q_f32(bins + 2 * k);
+            vst1q_f32(power + k, vmlaq_f32(vmulq_f32(v.val[0], v.val[0]), v.val[1], v.val[1]));
+        }
+#endif
+
+        for (; k < count; ++k)
+            power[k] = bins[2 * k] * bins[2 * k] + bins[2 * k + 1] * bins[2 * k + 1];
+    }
+
+    void applyComplexGains(float *bins, const float *gains, size_t count)
+    {
+        size_t k = 0;
+
+#if defined(__SSE2__)
+        for (; k + 4 <= count; k += 4)
+        {
+            __m128 g = _mm_loadu_ps(gains + k);
+            _mm_storeu_ps(bins + 2 * k, _mm_mul_ps(_mm_loadu_ps(bins + 2 * k), _mm_unpacklo_ps(g, g)));
+            _mm_storeu_ps(bins + 2 * k + 4, _mm_mul_ps(_mm_loadu_ps(bins + 2 * k + 4), _mm_unpackhi_ps(g, g)));
+        }
+#elif defined(__ARM_NEON)
+        for (; k + 4 <= count; k += 4)
+        {
+            float32x4_t g = vld1q_f32(gains + k);
+            float32x4x2_t v = vld2q_f32(bins + 2 * k);
+            v.val[0] = vmulq_f32(v.val[0], g);
+            v.val[1] = vmulq_f32(v.val[1], g);
+            vst2q_f32(bins + 2 * k, v);
+        }
+#endif
+
+        for (; k < count; ++k)
+        {
+            bins[2 * k] *= gains[k];
+            bins[2 * k + 1] *= gains[k];
+        }
+    }
+
+    void spectralGateGains(const float *power, const float *noise_power, float *gains, size_t count,
+                           float over_subtraction, float floor, float attack, float release)
+    {
+        // Keeps silent bins from dividing by zero
+        constexpr float kEpsilon = 1e-20f;
+        size_t k = 0;
+
+#if defined(__SSE2__)
+        const __m128 over = _mm_set1_ps(over_subtraction);
+        const __m128 vfloor = _mm_set1_ps(floor);
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 eps = _mm_set1_ps(kEpsilon);
+        const __m128 vattack = _mm_set1_ps(attack);
+        const __m128 vrelease = _mm_set1_ps(release);
+
+        for (; k + 4 <= count; k += 4)
+        {
+            __m128 ratio = _mm_div_ps(_mm_mul_ps(over, _mm_loadu_ps(noise_power + k)),
+                                      _mm_add_ps(_mm_loadu_ps(power + k), eps));
+            __m128 g = _mm_max_ps(_mm_sub_ps(one, ratio), vfloor);
+            g = _mm_min_ps(g, one);
+
+            // Rising gains use the release coefficient, falling ones the attack coefficient
+            __m128 prev = _mm_loadu_ps(gains + k);
+            __m128 rising = _mm_cmpgt_ps(g, prev);
+            __m128 coef = _mm_or_ps(_mm_and_ps(rising, vrelease), _mm_andnot_ps(rising, vattack));
+            _mm_storeu_ps(gains + k, _mm_add_ps(prev, _mm_mul_ps(_mm_sub_ps(g, prev), coef)));
+        }
+#elif defined(__ARM_NEON)
+        const float32x4_t vfloor = vdupq_n_f32(floor);
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        const float32x4_t vattack = vdupq_n_f32(attack);
+        const float32x4_t vrelease = vdupq_n_f32(release);
+
+        for (; k + 4 <= count; k += 4)
+        {
+            float32x4_t p = vaddq_f32(vld1q_f32(power + k), vdupq_n_f32(kEpsilon));
+            float32x4_t n = vmulq_n_f32(vld1q_f32(noise_power + k), over_subtraction);
+
+            // Reciprocal estimate refined with one Newton-Raphson step
+            float32x4_t inv = vrecpeq_f32(p);
+            inv = vmulq_f32(vrecpsq_f32(p, inv), inv);
+
+            float32x4_t g = vminq_f32(vmaxq_f32(vsubq_f32(one, vmulq_f32(n, inv)), vfloor), one);
+
+            float32x4_t prev = vld1q_f32(gains + k);
+            float32x4_t coef = vbslq_f32(vcgtq_f32(g, prev), vrelease, vattack);
+            vst1q_f32(gains + k, vmlaq_f32(prev, vsubq_f32(g, prev), coef));
+        }
+#endif
+
+        for (; k < count; ++k)
+        {
+            float g = std::clamp(1.0f - over_subtraction * noise_power[k] / (power[k] + kEpsilon), floor, 1.0f);
+            float coef = g > gains[k] ? release : attack;
+            gains[k] += (g - gains[k]) * coef;
+        }
+    }
+
+    float dbToGain(float db)
+    {
+        return std::pow(10.0f, db / 20.0f);
+    }
+
+    float gainToDb(float gain)
+    {
+        return gain > 0.0f ? 20.0f * std::log10(gain) : -144.0f;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+namespace video_codec
+{
+    // Kernels on planar float samples.
+    // SSE and NEON versions are picked at compile time, with a scalar fallback.
+
+    // samples[i] *= gain
+    void applyGain(float *samples, size_t count, float gain);
+
+    // samples[i] *= gain moving linearly from start_gain to end_gain over count samples,
+    // so block-wise gain changes do not click
+    void applyGainRamp(float *samples, size_t count, float start_gain, float end_gain);
+
+    // dst[i] += src[i] * gain
+    void mixInto(float *dst, const float *src, size_t count, float gain);
+
+    // Largest absolute sample value
+    float peakLevel(const float *samples, size_t count);
+
+    // Sum of squared samples (for RMS)
+    float sumSquares(const float *samples, size_t count);
+
+    // Clamp samples to [-limit, limit]
+    void clipSamples(float *samples, size_t count, float limit);
+
+    // Spectral kernels on interleaved complex bins (re, im), e.g. AVComplexFloat
+
+    // power[k] = re[k]^2 + im[k]^2
+    void complexPower(const float *bins, float *power, size_t count);
+
+    // bins[k] *= gains[k]
+    void applyComplexGains(float *bins, const float *gains, size_t count);
+
+    // Spectral gate: per-bin gain max(floor, 1 - over_subtraction * noise / power),
+    // smoothed against the previous gains with attack (falling) and release (rising) coefficients
+    void spectralGateGains(const float *power, const float *noise_power, float *gains, size_t count,
+                           float over_subtraction, float floor, float attack, float release);
+
+    // Decibel conversion helpers
+    float dbToGain(float db);
+    float gainToDb(float gain);
+}
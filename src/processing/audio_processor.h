@@ -0,0 +1,61 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/packet.h>
+#include <libavutil/frame.h>
+}
+
+#include <vector>
+
+namespace video_codec
+{
+    class AudioProcessor
+    {
+    public:
+        virtual ~AudioProcessor() = default;
+
+        // Processing audio frame
+        // - frame: planar float samples (AV_SAMPLE_FMT_FLTP), writable and
+        //   borrowed for the duration of the call; pts counts samples
+        virtual bool processAudioFrame(AVFrame *frame) = 0;
+
+        // End of the stream, for processors that buffer samples
+        virtual bool finishAudio() { return true; }
+
+        // Stream copy. Processors that take the compressed source packets
+        // unchanged (muxers) return true from acceptsPackets() and receive
+        // processAudioPacket() instead of decoded frames.
+        virtual bool acceptsPackets() const { return false; }
+        virtual bool processAudioPacket(AVPacket * /*packet*/, AVRational /*time_base*/) { return false; }
+    };
+
+    // Runs several processors on the same frame in order
+    class AudioProcessorChain : public AudioProcessor
+    {
+    public:
+        void add(AudioProcessor &processor) { processors_.push_back(&processor); }
+        bool empty() const { return processors_.empty(); }
+
+        bool processAudioFrame(AVFrame *frame) override
+        {
+            for (AudioProcessor *processor : processors_)
+            {
+                if (!processor->processAudioFrame(frame))
+                    return false;
+            }
+            return true;
+        }
+
+        bool finishAudio() override
+        {
+            bool result = true;
+            for (AudioProcessor *processor : processors_)
+                result = processor->finishAudio() && result;
+            return result;
+        }
+
+    private:
+        std::vector<AudioProcessor *> processors_;
+    };
+}
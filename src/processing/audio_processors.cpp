@@ -0,0 +1,231 @@
+#include <processing/audio_processors.h>
+#include <processing/audio_kernels.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace video_codec
+{
+    namespace
+    {
+        // One-pole smoothing coefficient for a block of samples
+        float blockCoefficient(double time_ms, int block_samples, int sample_rate)
+        {
+            if (time_ms <= 0.0 || sample_rate <= 0)
+                return 1.0f;
+            return static_cast<float>(1.0 - std::exp(-block_samples / (time_ms * 0.001 * sample_rate)));
+        }
+
+        float *channelData(AVFrame *frame, int channel)
+        {
+            return reinterpret_cast<float *>(frame->extended_data[channel]);
+        }
+    }
+
+    GainProcessor::GainProcessor(double gain_db)
+        : target_gain_(dbToGain(static_cast<float>(gain_db))),
+          current_gain_(target_gain_)
+    {
+    }
+
+    void GainProcessor::setGain(double gain_db)
+    {
+        target_gain_ = dbToGain(static_cast<float>(gain_db));
+    }
+
+    bool GainProcessor::processAudioFrame(AVFrame *frame)
+    {
+        for (int c = 0; c < frame->ch_layout.nb_channels; ++c)
+            applyGainRamp(channelData(frame, c), frame->nb_samples, current_gain_, target_gain_);
+
+        current_gain_ = target_gain_;
+        return true;
+    }
+
+    LimiterProcessor::LimiterProcessor(double threshold_db, double release_ms)
+        : threshold_(dbToGain(static_cast<float>(threshold_db))),
+          release_ms_(release_ms)
+    {
+    }
+
+    bool LimiterProcessor::processAudioFrame(AVFrame *frame)
+    {
+        const int channels = frame->ch_layout.nb_channels;
+
+        for (int offset = 0; offset < frame->nb_samples; offset += kAudioBlockSize)
+        {
+            int count = std::min(kAudioBlockSize, frame->nb_samples - offset);
+
+            float peak = 0.0f;
+            for (int c = 0; c < channels; ++c)
+                peak = std::max(peak, peakLevel(channelData(frame, c) + offset, count));
+
+            // Attack at once, recover towards unity gain
+            float target = gain_ + (1.0f - gain_) * blockCoefficient(release_ms_, count, frame->sample_rate);
+            if (peak * target > threshold_)
+                target = threshold_ / peak;
+
+            for (int c = 0; c < channels; ++c)
+            {
+                float *samples = channelData(frame, c) + offset;
+                applyGainRamp(samples, count, gain_, target);
+                clipSamples(samples, count, threshold_);
+            }
+
+            gain_ = target;
+        }
+
+        return true;
+    }
+
+    BgmMixProcessor::BgmMixProcessor(const std::string &bgm_filename, double bgm_gain_db,
+                                     const DuckingSettings &ducking, bool loop)
+        : bgm_filename_(bgm_filename),
+          bgm_gain_(dbToGain(static_cast<float>(bgm_gain_db))),
+          ducking_(ducking),
+          loop_(loop)
+    {
+    }
+
+    BgmMixProcessor::~BgmMixProcessor()
+    {
+        if (packet_)
+            av_packet_free(&packet_);
+    }
+
+    bool BgmMixProcessor::openBgm(int sample_rate, int channels)
+    {
+        opened_ = true;
+
+        if (!bgm_file_.open(bgm_filename_))
+        {
+            std::cerr << "Could not open BGM file: " << bgm_filename_ << std::endl;
+            return false;
+        }
+
+        // Decode straight to the program format
+        bgm_stream_ = bgm_file_.getAudioStream(-1, sample_rate, channels);
+        packet_ = av_packet_alloc();
+        if (!bgm_stream_.getCodecContext() || !packet_)
+        {
+            std::cerr << "Could not decode BGM audio: " << bgm_filename_ << std::endl;
+            return false;
+        }
+
+        buffer_.channels.assign(channels, {});
+        block_.resize(kAudioBlockSize);
+
+        std::cout << "Mixing BGM: " << bgm_filename_ << std::endl;
+        return true;
+    }
+
+    bool BgmMixProcessor::fillBuffer(size_t count)
+    {
+        AVFormatContext *ctx = bgm_file_.getFormatContext();
+        int stream_index = bgm_file_.findAudioStreamIndex();
+        size_t available_at_start = buffer_.available();
+        bool decoded_any = false;
+
+        while (buffer_.available() < count && !bgm_ended_)
+        {
+            if (av_read_frame(ctx, packet_) >= 0)
+            {
+                bool ok = packet_->stream_index != stream_index || bgm_stream_.decodePacket(packet_, buffer_);
+                av_packet_unref(packet_);
+                if (!ok)
+                    return false;
+
+                decoded_any = decoded_any || buffer_.available() > available_at_start;
+                continue;
+            }
+
+            // End of the BGM file: drain, then loop or stop
+            if (!bgm_stream_.decodePacket(nullptr, buffer_))
+                return false;
+
+            decoded_any = decoded_any || buffer_.available() > available_at_start;
+            if (!loop_ || !decoded_any || !bgm_stream_.seek(0))
+                bgm_ended_ = true;
+        }
+
+        return true;
+    }
+
+    bool BgmMixProcessor::processAudioFrame(AVFrame *frame)
+    {
+        const int channels = frame->ch_layout.nb_channels;
+
+        if (!opened_ && !openBgm(frame->sample_rate, channels))
+            return false;
+
+        if (bgm_ended_ && buffer_.available() == 0)
+            return true;
+
+        if (!fillBuffer(frame->nb_samples))
+            return false;
+
+        const float attack = blockCoefficient(ducking_.attack_ms, kAudioBlockSize, frame->sample_rate);
+        const float release = blockCoefficient(ducking_.release_ms, kAudioBlockSize, frame->sample_rate);
+        const float threshold = dbToGain(static_cast<float>(ducking_.threshold_db));
+        const float duck = dbToGain(static_cast<float>(ducking_.duck_db));
+
+        for (int offset = 0; offset < frame->nb_samples; offset += kAudioBlockSize)
+        {
+            int count = std::min<int>({kAudioBlockSize, frame->nb_samples - offset,
+                                       static_cast<int>(buffer_.available())});
+            if (count <= 0)
+                break;
+
+            // Sidechain: program RMS drives the BGM level
+            float start_gain = duck_gain_;
+            if (ducking_.enabled)
+            {
+                float sum = 0.0f;
+                for (int c = 0; c < channels; ++c)
+                    sum += sumSquares(channelData(frame, c) + offset, count);
+                float rms = std::sqrt(sum / (count * channels));
+
+                envelope_ += (rms - envelope_) * (rms > envelope_ ? attack : release);
+
+                float target = envelope_ > threshold ? duck : 1.0f;
+                duck_gain_ += (target - duck_gain_) * (target < duck_gain_ ? attack : release);
+            }
+
+            for (int c = 0; c < channels; ++c)
+            {
+                const float *bgm = buffer_.channels[c].data() + buffer_.read_pos;
+                std::copy(bgm, bgm + count, block_.data());
+                applyGainRamp(block_.data(), count, start_gain * bgm_gain_, duck_gain_ * bgm_gain_);
+                mixInto(channelData(frame, c) + offset, block_.data(), count, 1.0f);
+            }
+
+            buffer_.consume(count);
+        }
+
+        return true;
+    }
+
+    void BgmMixProcessor::SampleBuffer::consume(size_t count)
+    {
+        read_pos += count;
+
+        // Drop consumed samples once they dominate the buffer
+        if (read_pos >= 4096 && read_pos * 2 >= channels[0].size())
+        {
+            for (auto &channel : channels)
+                channel.erase(channel.begin(), channel.begin() + read_pos);
+            read_pos = 0;
+        }
+    }
+
+    bool BgmMixProcessor::SampleBuffer::processAudioFrame(AVFrame *frame)
+    {
+        int count = std::min<int>(frame->ch_layout.nb_channels, static_cast<int>(channels.size()));
+        for (int c = 0; c < count; ++c)
+        {
+            const float *samples = reinterpret_cast<const float *>(frame->extended_data[c]);
+            channels[c].insert(channels[c].end(), samples, samples + frame->nb_samples);
+        }
+        return true;
+    }
+}
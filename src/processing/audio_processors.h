@@ -0,0 +1,104 @@
+#pragma once
+
+#include <processing/audio_processor.h>
+#include <media/media_file.h>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // Native audio processors on planar float frames, working in blocks of
+    // kAudioBlockSize samples so that levels and gains update smoothly
+    constexpr int kAudioBlockSize = 256;
+
+    // Volume adjustment in dB
+    class GainProcessor : public AudioProcessor
+    {
+    public:
+        explicit GainProcessor(double gain_db);
+
+        // New gain, ramped in over the next frame
+        void setGain(double gain_db);
+
+        bool processAudioFrame(AVFrame *frame) override;
+
+    private:
+        float target_gain_;
+        float current_gain_;
+    };
+
+    // Peak limiter: instant attack, exponential release, and a final clip
+    // at the threshold as a safety net
+    // - threshold_db: ceiling in dBFS
+    // - release_ms: time for the gain to recover
+    class LimiterProcessor : public AudioProcessor
+    {
+    public:
+        explicit LimiterProcessor(double threshold_db = -1.0, double release_ms = 100.0);
+
+        bool processAudioFrame(AVFrame *frame) override;
+
+    private:
+        float threshold_;
+        double release_ms_;
+        float gain_{1.0f};
+    };
+
+    struct DuckingSettings
+    {
+        bool enabled{true};
+        double threshold_db{-30.0}; // Program level (RMS) that triggers ducking
+        double duck_db{-12.0};      // BGM attenuation while the program is above the threshold
+        double attack_ms{20.0};
+        double release_ms{400.0};
+    };
+
+    // Mixes a background music file under the program audio.
+    // The BGM is decoded and resampled to the program format on demand;
+    // with ducking, its level follows the program level (sidechain).
+    class BgmMixProcessor : public AudioProcessor
+    {
+    public:
+        BgmMixProcessor(const std::string &bgm_filename, double bgm_gain_db = -6.0,
+                        const DuckingSettings &ducking = {}, bool loop = true);
+        ~BgmMixProcessor() override;
+
+        bool processAudioFrame(AVFrame *frame) override;
+
+    private:
+        // Decoded BGM samples waiting to be mixed
+        class SampleBuffer : public AudioProcessor
+        {
+        public:
+            std::vector<std::vector<float>> channels;
+            size_t read_pos{0};
+
+            size_t available() const { return channels.empty() ? 0 : channels[0].size() - read_pos; }
+            void consume(size_t count);
+
+            bool processAudioFrame(AVFrame *frame) override;
+        };
+
+        std::string bgm_filename_;
+        float bgm_gain_;
+        DuckingSettings ducking_;
+        bool loop_;
+
+        MediaFile bgm_file_;
+        AudioStream bgm_stream_;
+        AVPacket *packet_{nullptr};
+        bool opened_{false};
+        bool bgm_ended_{false};
+        SampleBuffer buffer_;
+        std::vector<float> block_;
+
+        // Sidechain state
+        float envelope_{0.0f};
+        float duck_gain_{1.0f};
+
+        bool openBgm(int sample_rate, int channels);
+
+        // Decode until count samples are buffered or the BGM ends
+        bool fillBuffer(size_t count);
+    };
+}
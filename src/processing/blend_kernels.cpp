@@ -0,0 +1,196 @@
+#include <processing/blend_kernels.h>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/pixdesc.h>
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace video_codec
+{
+    namespace
+    {
+        // (a * (256 - w) + b * w + 128) >> 8 stays within 16 bits for 8-bit inputs
+        inline uint8_t blendPixel(uint8_t a, uint8_t b, int weight)
+        {
+            return static_cast<uint8_t>((a * (256 - weight) + b * weight + 128) >> 8);
+        }
+
+        // Planes of a frame that the kernels can work on
+        int blendablePlanes(const AVFrame *frame)
+        {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+            if (!desc || !(desc->flags & AV_PIX_FMT_FLAG_PLANAR) || (desc->flags & AV_PIX_FMT_FLAG_BITSTREAM))
+                return 0;
+
+            for (int c = 0; c < desc->nb_components; ++c)
+            {
+                if (desc->comp[c].depth != 8 || desc->comp[c].step != 1)
+                    return 0;
+            }
+
+            return av_pix_fmt_count_planes(static_cast<AVPixelFormat>(frame->format));
+        }
+
+        // Size of plane p of frame in bytes per row and rows
+        void planeSize(const AVFrame *frame, int plane, int &width, int &height)
+        {
+            const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+            bool chroma = plane == 1 || plane == 2;
+
+            width = chroma ? AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w) : frame->width;
+            height = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        }
+
+        bool sameLayout(const AVFrame *a, const AVFrame *b)
+        {
+            return a->format == b->format && a->width == b->width && a->height == b->height;
+        }
+    }
+
+    void blendRow(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t count, int weight)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - weight));
+        const __m128i wb = _mm_set1_epi16(static_cast<short>(weight));
+        const __m128i round = _mm_set1_epi16(128);
+
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+
+            // Unsigned 16-bit products; the sum never exceeds 65408
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                       _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+#elif defined(__ARM_NEON)
+        // Weights up to 256 do not fit an 8-bit lane, so widen first
+        const uint16x8_t wa16 = vdupq_n_u16(static_cast<uint16_t>(256 - weight));
+        const uint16x8_t wb16 = vdupq_n_u16(static_cast<uint16_t>(weight));
+
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16_t va = vld1q_u8(a + i);
+            uint8x16_t vb = vld1q_u8(b + i);
+
+            uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(va)), wa16), vmovl_u8(vget_low_u8(vb)), wb16);
+            uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(va)), wa16), vmovl_u8(vget_high_u8(vb)), wb16);
+
+            // Rounding narrow: (x + 128) >> 8
+            vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+#endif
+
+        for (; i < count; ++i)
+            dst[i] = blendPixel(a[i], b[i], weight);
+    }
+
+    void fadeRow(const uint8_t *src, uint8_t value, uint8_t *dst, size_t count, int weight)
+    {
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - weight));
+        // Constant term including rounding: value * weight + 128
+        const __m128i bias = _mm_set1_epi16(static_cast<short>(value * weight + 128));
+
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), wa), bias);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), wa), bias);
+            lo = _mm_srli_epi16(lo, 8);
+            hi = _mm_srli_epi16(hi, 8);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+        }
+#elif defined(__ARM_NEON)
+        const uint16x8_t wa16 = vdupq_n_u16(static_cast<uint16_t>(256 - weight));
+        const uint16x8_t bias = vdupq_n_u16(static_cast<uint16_t>(value * weight));
+
+        for (; i + 16 <= count; i += 16)
+        {
+            uint8x16_t v = vld1q_u8(src + i);
+
+            uint16x8_t lo = vmlaq_u16(bias, vmovl_u8(vget_low_u8(v)), wa16);
+            uint16x8_t hi = vmlaq_u16(bias, vmovl_u8(vget_high_u8(v)), wa16);
+
+            vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+        }
+#endif
+
+        for (; i < count; ++i)
+            dst[i] = blendPixel(src[i], value, weight);
+    }
+
+    bool blendFrames(const AVFrame *a, const AVFrame *b, AVFrame *dst, int weight)
+    {
+        int planes = blendablePlanes(a);
+        if (planes == 0 || !sameLayout(a, b) || !sameLayout(a, dst))
+        {
+            std::cerr << "Frames cannot be blended: planar 8-bit frames of one size are required" << std::endl;
+            return false;
+        }
+
+        for (int p = 0; p < planes; ++p)
+        {
+            int width, height;
+            planeSize(a, p, width, height);
+
+            for (int y = 0; y < height; ++y)
+            {
+                blendRow(a->data[p] + y * a->linesize[p], b->data[p] + y * b->linesize[p],
+                         dst->data[p] + y * dst->linesize[p], width, weight);
+            }
+        }
+
+        return true;
+    }
+
+    bool fadeFrame(const AVFrame *src, AVFrame *dst, int weight)
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(src->format));
+        int planes = blendablePlanes(src);
+        if (planes == 0 || (desc->flags & AV_PIX_FMT_FLAG_RGB) || !sameLayout(src, dst))
+        {
+            std::cerr << "Frame cannot be faded: planar 8-bit YUV is required" << std::endl;
+            return false;
+        }
+
+        // Black in the frame's range; alpha stays opaque
+        bool full_range = src->color_range == AVCOL_RANGE_JPEG;
+        const uint8_t black[4] = {static_cast<uint8_t>(full_range ? 0 : 16), 128, 128, 255};
+
+        for (int p = 0; p < planes; ++p)
+        {
+            int width, height;
+            planeSize(src, p, width, height);
+
+            for (int y = 0; y < height; ++y)
+            {
+                fadeRow(src->data[p] + y * src->linesize[p], black[p],
+                        dst->data[p] + y * dst->linesize[p], width, weight);
+            }
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+#include <cstddef>
+#include <cstdint>
+
+namespace video_codec
+{
+    // Alpha-blend kernels for transitions.
+    // Weights are fixed point in [0, 256]: 0 keeps the first source, 256 the second.
+    // SSE2 and NEON versions are picked at compile time, with a scalar fallback.
+
+    // dst[i] = a[i] + (b[i] - a[i]) * weight / 256
+    void blendRow(const uint8_t *a, const uint8_t *b, uint8_t *dst, size_t count, int weight);
+
+    // dst[i] = src[i] + (value - src[i]) * weight / 256
+    void fadeRow(const uint8_t *src, uint8_t value, uint8_t *dst, size_t count, int weight);
+
+    // Blend every plane of two frames of the same planar 8-bit format and size into dst
+    bool blendFrames(const AVFrame *a, const AVFrame *b, AVFrame *dst, int weight);
+
+    // Fade a planar 8-bit YUV frame towards black (weight 256 is fully black)
+    bool fadeFrame(const AVFrame *src, AVFrame *dst, int weight);
+
+    // Convert a position in a transition to a blend weight
+    inline int blendWeight(int64_t position, int64_t duration)
+    {
+        if (duration <= 0 || position >= duration)
+            return 256;
+        if (position <= 0)
+            return 0;
+        return static_cast<int>(position * 256 / duration);
+    }
+}
@@ -0,0 +1,117 @@
+#include <processing/crop_detect_processor.h>
+#include <processing/luma_kernels.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <iostream>
+
+namespace video_codec
+{
+    CropDetectProcessor::CropDetectProcessor(const CropDetectOptions &options)
+        : options_(options)
+    {
+        options_.limit = std::clamp(options_.limit, 0, 255);
+    }
+
+    bool CropDetectProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (!hasLumaPlane(frame))
+        {
+            last_error_ = "Crop detection needs frames with an 8-bit luma plane (decoded YUV or gray)";
+            std::cerr << last_error_ << std::endl;
+            return false;
+        }
+
+        // Boxes of different sizes cannot be merged; start over on a size change
+        if (frame->width != width_ || frame->height != height_)
+        {
+            width_ = frame->width;
+            height_ = frame->height;
+            found_ = false;
+        }
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("crop detect");
+        int width = frame->width;
+        int height = frame->height;
+        int first_row = -1;
+        int last_row = -1;
+
+        // Row means decide top and bottom; column sums over all rows decide left and right
+        column_sums_.assign(static_cast<size_t>(width), 0);
+        timeStage(metrics, frame_number, [&]
+                  {
+                      uint64_t row_limit = static_cast<uint64_t>(options_.limit) * static_cast<uint64_t>(width);
+                      for (int y = 0; y < height; ++y)
+                      {
+                          const uint8_t *row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+                          uint64_t sum = 0;
+                          for (int x = 0; x < width; ++x)
+                          {
+                              column_sums_[x] += row[x];
+                              sum += row[x];
+                          }
+
+                          if (sum > row_limit)
+                          {
+                              if (first_row < 0)
+                                  first_row = y;
+                              last_row = y;
+                          }
+                      }
+                      return true; });
+        metrics.addFrames(1);
+        ++frame_count_;
+
+        if (first_row < 0)
+            return true;
+
+        uint64_t column_limit = static_cast<uint64_t>(options_.limit) * static_cast<uint64_t>(height);
+        int first_column = -1;
+        int last_column = -1;
+        for (int x = 0; x < width; ++x)
+        {
+            if (column_sums_[x] > column_limit)
+            {
+                if (first_column < 0)
+                    first_column = x;
+                last_column = x;
+            }
+        }
+        if (first_column < 0)
+            return true;
+
+        if (!found_)
+        {
+            left_ = first_column;
+            top_ = first_row;
+            right_ = last_column + 1;
+            bottom_ = last_row + 1;
+            found_ = true;
+        }
+        else
+        {
+            left_ = std::min(left_, first_column);
+            top_ = std::min(top_, first_row);
+            right_ = std::max(right_, last_column + 1);
+            bottom_ = std::max(bottom_, last_row + 1);
+        }
+        return true;
+    }
+
+    CropRect CropDetectProcessor::getCrop(AVPixelFormat format) const
+    {
+        CropRect rect;
+        if (found_)
+        {
+            rect.x = left_;
+            rect.y = top_;
+            rect.width = right_ - left_;
+            rect.height = bottom_ - top_;
+        }
+        else
+        {
+            rect.width = width_;
+            rect.height = height_;
+        }
+        return alignCropRect(rect, width_, height_, format);
+    }
+}
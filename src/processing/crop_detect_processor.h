@@ -0,0 +1,56 @@
+#pragma once
+
+#include <processing/crop_processor.h>
+#include <processing/frame_processor.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    struct CropDetectOptions
+    {
+        int limit{24};    // Rows and columns with a mean luma up to this are bars
+        int samples{24};  // Frames sampled over the video (VideoStream::processSampledFrames())
+    };
+
+    // Auto-crop: finds letterbox and pillarbox bars on the luma plane.
+    //
+    // Every frame contributes the box between its first and last rows and
+    // columns brighter than the limit; the result is the union of these
+    // boxes, so dark scenes do not eat into the picture. Frames with no
+    // content at all (fades to black) are ignored. Feed decoded YUV or gray
+    // frames, a sampled subset is enough.
+    class CropDetectProcessor : public FrameProcessor
+    {
+    public:
+        explicit CropDetectProcessor(const CropDetectOptions &options = {});
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Picture area of the frames seen so far, aligned for format
+        // (alignCropRect()); the whole frame if no frame had content
+        CropRect getCrop(AVPixelFormat format) const;
+
+        int64_t getFrameCount() const { return frame_count_; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        CropDetectOptions options_;
+        int64_t frame_count_{0};
+        int width_{0};
+        int height_{0};
+
+        // Union of the content boxes, empty until a frame had content
+        int left_{0};
+        int top_{0};
+        int right_{0};
+        int bottom_{0};
+        bool found_{false};
+
+        // Scratch sums of the current frame
+        std::vector<uint32_t> column_sums_;
+
+        std::string last_error_;
+    };
+}
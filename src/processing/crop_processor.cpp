@@ -0,0 +1,95 @@
+#include <processing/crop_processor.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/pixdesc.h>
+}
+
+namespace video_codec
+{
+    bool parseCropRect(const std::string &text, int frame_width, int frame_height, CropRect &rect)
+    {
+        int values[4] = {0, 0, -1, -1};
+        int count = std::sscanf(text.c_str(), "%d:%d:%d:%d", &values[0], &values[1], &values[2], &values[3]);
+        if (count < 2 || values[0] <= 0 || values[1] <= 0)
+            return false;
+
+        rect.width = values[0];
+        rect.height = values[1];
+        rect.x = count >= 3 ? values[2] : (frame_width - rect.width) / 2;
+        rect.y = count >= 4 ? values[3] : (frame_height - rect.height) / 2;
+        return rect.x >= 0 && rect.y >= 0 && rect.x + rect.width <= frame_width && rect.y + rect.height <= frame_height;
+    }
+
+    CropRect alignCropRect(const CropRect &rect, int frame_width, int frame_height, AVPixelFormat format)
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+        int align_x = desc ? 1 << desc->log2_chroma_w : 1;
+        int align_y = desc ? 1 << desc->log2_chroma_h : 1;
+
+        int left = std::clamp(rect.x, 0, frame_width);
+        int top = std::clamp(rect.y, 0, frame_height);
+        int right = std::clamp(rect.x + rect.width, left, frame_width);
+        int bottom = std::clamp(rect.y + rect.height, top, frame_height);
+
+        // Round the origin up onto the chroma grid, then the size down to even
+        left = (left + align_x - 1) / align_x * align_x;
+        top = (top + align_y - 1) / align_y * align_y;
+
+        CropRect aligned;
+        aligned.x = left;
+        aligned.y = top;
+        aligned.width = std::max(right - left, 0) & ~1;
+        aligned.height = std::max(bottom - top, 0) & ~1;
+        return aligned;
+    }
+
+    CropProcessor::CropProcessor(const CropRect &rect, FrameProcessor *next_processor)
+        : rect_(rect), next_processor_(next_processor)
+    {
+    }
+
+    bool CropProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        // A new reference is cropped; the caller's frame keeps its geometry
+        FramePtr view = refFrame(frame);
+        if (!view)
+        {
+            std::cerr << "Could not reference frame" << std::endl;
+            return false;
+        }
+        return consumeFrame(std::move(view), frame_number);
+    }
+
+    bool CropProcessor::consumeFrame(FramePtr frame, int frame_number)
+    {
+        if (!next_processor_)
+        {
+            std::cerr << "CropProcessor has no next processor" << std::endl;
+            return false;
+        }
+
+        CropRect rect = alignCropRect(rect_, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format));
+        if (rect.isEmpty())
+        {
+            std::cerr << "Crop region is outside frame #" << frame_number << std::endl;
+            return false;
+        }
+
+        // Only pointers and sizes change; unaligned keeps the exact left edge
+        frame->crop_left = static_cast<size_t>(rect.x);
+        frame->crop_top = static_cast<size_t>(rect.y);
+        frame->crop_right = static_cast<size_t>(frame->width - rect.x - rect.width);
+        frame->crop_bottom = static_cast<size_t>(frame->height - rect.y - rect.height);
+        if (av_frame_apply_cropping(frame.get(), AV_FRAME_CROP_UNALIGNED) < 0)
+        {
+            std::cerr << "Could not crop frame #" << frame_number << std::endl;
+            return false;
+        }
+
+        return next_processor_->consumeFrame(std::move(frame), frame_number);
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <string>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+}
+
+namespace video_codec
+{
+    // Region of a frame in pixels of its first plane
+    struct CropRect
+    {
+        int x{0};
+        int y{0};
+        int width{0};
+        int height{0};
+
+        bool isEmpty() const { return width <= 0 || height <= 0; }
+    };
+
+    // Parse "W:H:X:Y" (the FFmpeg crop filter order); X and Y default to centering
+    bool parseCropRect(const std::string &text, int frame_width, int frame_height, CropRect &rect);
+
+    // Shrink rect to the frame and to what format can address without
+    // splitting chroma samples: x and y on the chroma grid, even width and
+    // height for encoding to 4:2:0. Shrinks inward, never adds picture.
+    CropRect alignCropRect(const CropRect &rect, int frame_width, int frame_height, AVPixelFormat format);
+
+    // Transform processor that crops without copying pixels.
+    //
+    // Each frame is passed on as a new reference whose data pointers are
+    // advanced to the top-left of the region and whose width and height are
+    // the region's (av_frame_apply_cropping()); the linesizes, and so the
+    // buffers, stay those of the full frame. VideoWriter and the scalers
+    // read through data and linesize, so they take the view as it is; open
+    // the writer with the cropped size.
+    class CropProcessor : public FrameProcessor
+    {
+    public:
+        // rect is aligned to every frame's format on use
+        explicit CropProcessor(const CropRect &rect, FrameProcessor *next_processor = nullptr);
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+        bool consumeFrame(FramePtr frame, int frame_number) override;
+
+        void setNextProcessor(FrameProcessor *next_processor) { next_processor_ = next_processor; }
+
+        const CropRect &getRect() const { return rect_; }
+
+    private:
+        CropRect rect_;
+        FrameProcessor *next_processor_;
+    };
+}
@@ -5,6 +5,9 @@ extern "C"
 #include <libavutil/frame.h>
 }
 
+#include <media/frame_ref.h>
+#include <span>
+
 namespace video_codec
 {
     class FrameProcessor
@@ -13,8 +16,34 @@ namespace video_codec
         virtual ~FrameProcessor() = default;
 
         // Processing frame
-        // - frame: frame to be processed (RGB)
+        // - frame: frame to be processed (RGB), borrowed for the duration of the call
         // - frame_number: frame number to recognize the time
         virtual bool processFrame(AVFrame *frame, int frame_number) = 0;
+
+        // Processing frame with ownership transfer
+        // - frame: reference-counted frame handed over to the processor
+        // - frame_number: frame number to recognize the time
+        // Processors that keep or forward frames override this and move the
+        // reference along instead of copying pixel data. The default borrows
+        // the frame for processFrame() and drops the reference afterwards.
+        virtual bool consumeFrame(FramePtr frame, int frame_number)
+        {
+            return processFrame(frame.get(), frame_number);
+        }
+
+        // Processing a batch of consecutive frames
+        // - frames: frames to be processed (RGB), borrowed for the duration of the call
+        // - first_index: frame number of frames[0]
+        // Processors that work on several frames at once (SIMD kernels,
+        // encoders) override this. The default feeds processFrame() one by one.
+        virtual bool processFrames(std::span<AVFrame *> frames, int first_index)
+        {
+            for (size_t i = 0; i < frames.size(); ++i)
+            {
+                if (!processFrame(frames[i], first_index + static_cast<int>(i)))
+                    return false;
+            }
+            return true;
+        }
     };
 }
\ No newline at end of file
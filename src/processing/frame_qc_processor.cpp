@@ -0,0 +1,150 @@
+#include <processing/frame_qc_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <iostream>
+
+namespace video_codec
+{
+    const char *toString(FrameRunType type)
+    {
+        switch (type)
+        {
+        case FrameRunType::Duplicate:
+            return "duplicate";
+        case FrameRunType::Freeze:
+            return "freeze";
+        case FrameRunType::Black:
+            return "black";
+        }
+        return "unknown";
+    }
+
+    FrameQcProcessor::FrameQcProcessor(AVRational time_base, const FrameQcOptions &options)
+        : time_base_(time_base), options_(options)
+    {
+        options_.black_level = std::clamp(options_.black_level, 0, 256);
+    }
+
+    bool FrameQcProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (!hasLumaPlane(frame))
+        {
+            last_error_ = "Frame QC needs frames with an 8-bit luma plane (decoded YUV or gray)";
+            std::cerr << last_error_ << std::endl;
+            return false;
+        }
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("frame qc");
+        uint32_t histogram[kLumaHistogramBins] = {};
+        std::vector<uint8_t> &thumbnail = next_thumbnail_;
+        int thumbnail_width = frame->width / kLumaBlockSize;
+        int thumbnail_height = frame->height / kLumaBlockSize;
+        thumbnail.resize(static_cast<size_t>(thumbnail_width) * thumbnail_height);
+
+        uint64_t hash = timeStage(metrics, frame_number, [&]
+                                  {
+                                      accumulateLumaHistogram(frame->data[0], frame->linesize[0], frame->width, frame->height, histogram);
+                                      downsampleLuma(frame->data[0], frame->linesize[0], frame->width, frame->height, thumbnail.data());
+
+                                      float input[kHashInputSize * kHashInputSize];
+                                      resampleHashInput(thumbnail.data(), thumbnail_width, thumbnail_height, input);
+                                      return perceptualHash(input); });
+        metrics.addFrames(1);
+
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (pts == AV_NOPTS_VALUE)
+            pts = frame_number;
+        int64_t duration = frame->duration > 0 ? frame->duration : (previous_ ? pts - previous_pts_ : 1);
+
+        bool comparable = previous_ && previous_->width == frame->width && previous_->height == frame->height &&
+                          previous_->format == frame->format;
+
+        bool similar = false;
+        bool duplicate = false;
+        if (comparable)
+        {
+            uint64_t difference = thumbnail.empty() ? 0 : sumAbsDiff(thumbnail.data(), thumbnail_.data(), thumbnail.size());
+            similar = static_cast<double>(difference) <= options_.freeze_difference * static_cast<double>(std::max<size_t>(thumbnail.size(), 1));
+            duplicate = hash == previous_hash_ && difference == 0 && framesEqual(frame, previous_.get());
+        }
+
+        if (duplicate)
+        {
+            if (duplicate_.frames == 0)
+                duplicate_.start_pts = pts;
+            ++duplicate_.frames;
+            ++duplicate_count_;
+        }
+        else
+            closeRun(FrameRunType::Duplicate, duplicate_, pts, 0.0);
+
+        // A freeze starts with the first frame of the still picture
+        if (similar)
+        {
+            if (freeze_.frames == 0)
+            {
+                freeze_.start_pts = previous_pts_;
+                freeze_.frames = 1;
+            }
+            ++freeze_.frames;
+        }
+        else
+            closeRun(FrameRunType::Freeze, freeze_, pts, options_.min_freeze_duration);
+
+        uint32_t black_bins = static_cast<uint32_t>((options_.black_level + 3) / 4);
+        uint64_t black_pixels = 0;
+        for (uint32_t bin = 0; bin < black_bins && bin < kLumaHistogramBins; ++bin)
+            black_pixels += histogram[bin];
+        bool black = static_cast<double>(black_pixels) >= options_.black_ratio * frame->width * frame->height;
+        if (black)
+        {
+            if (black_.frames == 0)
+                black_.start_pts = pts;
+            ++black_.frames;
+        }
+        else
+            closeRun(FrameRunType::Black, black_, pts, options_.min_black_duration);
+
+        hashes_.push_back(hash);
+        previous_ = refFrame(frame);
+        if (!previous_)
+        {
+            last_error_ = "Could not reference frame";
+            std::cerr << last_error_ << std::endl;
+            return false;
+        }
+        previous_hash_ = hash;
+        thumbnail_.swap(next_thumbnail_);
+        previous_pts_ = pts;
+        previous_end_ = pts + duration;
+        return true;
+    }
+
+    void FrameQcProcessor::finish()
+    {
+        closeRun(FrameRunType::Duplicate, duplicate_, previous_end_, 0.0);
+        closeRun(FrameRunType::Freeze, freeze_, previous_end_, options_.min_freeze_duration);
+        closeRun(FrameRunType::Black, black_, previous_end_, options_.min_black_duration);
+        previous_.reset();
+    }
+
+    void FrameQcProcessor::closeRun(FrameRunType type, OpenRun &run, int64_t end_pts, double min_duration)
+    {
+        if (run.frames == 0)
+            return;
+
+        double duration = av_q2d(time_base_) * static_cast<double>(end_pts - run.start_pts);
+        if (duration >= min_duration)
+        {
+            FrameRun result;
+            result.type = type;
+            result.start_pts = run.start_pts;
+            result.end_pts = end_pts;
+            result.frames = run.frames;
+            result.start = av_q2d(time_base_) * static_cast<double>(run.start_pts);
+            result.duration = duration;
+            runs_.push_back(result);
+        }
+        run = OpenRun();
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <processing/luma_kernels.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/rational.h>
+}
+
+namespace video_codec
+{
+    struct FrameQcOptions
+    {
+        double freeze_difference{1.0};   // Mean thumbnail difference (levels) two frames of a freeze may have
+        double min_freeze_duration{2.0}; // Seconds a picture has to stand still to be reported
+        int black_level{32};             // Luma values below this count as black
+        double black_ratio{0.98};        // Share of black pixels that makes a black frame
+        double min_black_duration{0.0};  // Seconds of black to be reported
+    };
+
+    enum class FrameRunType
+    {
+        Duplicate, // Exact copies of the frame before the run
+        Freeze,    // Frames that look the same, from the first one on
+        Black
+    };
+
+    struct FrameRun
+    {
+        FrameRunType type;
+        int64_t start_pts; // First frame of the run (stream time base)
+        int64_t end_pts;   // End of the last frame of the run
+        int64_t frames;
+        double start;      // Seconds
+        double duration;   // Seconds
+    };
+
+    const char *toString(FrameRunType type);
+
+    // QC analysis of decoded frames: perceptual hash per frame, runs of
+    // exactly duplicated frames, freezes and black frames.
+    //
+    // Works on the luma plane of frames in their decoded YUV or gray format
+    // (see VideoStream::processNativeFrames()). Each frame is reduced to a
+    // histogram, an 8x8 block thumbnail and a pHash of that thumbnail; a
+    // frame is compared pixel by pixel with its predecessor only when its
+    // hash and thumbnail are identical, so exact duplicates cost little more
+    // than the hash. Freezes are judged on the thumbnail difference, which
+    // unlike the hash does not flip with sensor noise on flat pictures.
+    class FrameQcProcessor : public FrameProcessor
+    {
+    public:
+        explicit FrameQcProcessor(AVRational time_base, const FrameQcOptions &options = {});
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Close the runs still open at the end of the stream
+        void finish();
+
+        const std::vector<FrameRun> &getRuns() const { return runs_; }
+        const std::vector<uint64_t> &getHashes() const { return hashes_; }
+        int64_t getFrameCount() const { return static_cast<int64_t>(hashes_.size()); }
+        int64_t getDuplicateCount() const { return duplicate_count_; }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        // Run under way; frames == 0 when there is none
+        struct OpenRun
+        {
+            int64_t start_pts{0};
+            int64_t frames{0};
+        };
+
+        AVRational time_base_;
+        FrameQcOptions options_;
+        std::vector<FrameRun> runs_;
+        std::vector<uint64_t> hashes_;
+        int64_t duplicate_count_{0};
+
+        // Previous frame
+        FramePtr previous_;
+        uint64_t previous_hash_{0};
+        std::vector<uint8_t> thumbnail_;
+        std::vector<uint8_t> next_thumbnail_; // Reused for the current frame
+        int64_t previous_pts_{0};
+        int64_t previous_end_{0};
+
+        OpenRun duplicate_;
+        OpenRun freeze_;
+        OpenRun black_;
+
+        std::string last_error_;
+
+        // Report run if it is long enough, and reset it
+        void closeRun(FrameRunType type, OpenRun &run, int64_t end_pts, double min_duration);
+    };
+}
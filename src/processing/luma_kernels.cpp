@@ -0,0 +1,350 @@
+#include <processing/luma_kernels.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace video_codec
+{
+    namespace
+    {
+        // Rounding average, the same as _mm_avg_epu8 and vrhaddq_u8
+        inline uint8_t average(uint8_t a, uint8_t b)
+        {
+            return static_cast<uint8_t>((a + b + 1) >> 1);
+        }
+
+        // Column mean of 8 rows as a tree of pairwise averages, matching the SIMD paths
+        inline uint8_t columnMean(const uint8_t *const rows[8], int x)
+        {
+            return average(average(average(rows[0][x], rows[1][x]), average(rows[2][x], rows[3][x])),
+                           average(average(rows[4][x], rows[5][x]), average(rows[6][x], rows[7][x])));
+        }
+
+        uint8_t blockMean(const uint8_t *const rows[8], int x)
+        {
+            int sum = 0;
+            for (int i = 0; i < kLumaBlockSize; ++i)
+                sum += columnMean(rows, x + i);
+            return static_cast<uint8_t>((sum + 4) >> 3);
+        }
+
+        constexpr int kHashFrequencies = 8;
+
+        // Orthonormal DCT-II basis of the lowest frequencies: basis[u][k]
+        using DctBasis = std::array<std::array<float, kHashInputSize>, kHashFrequencies>;
+
+        const DctBasis &dctBasis()
+        {
+            static const DctBasis basis = []
+            {
+                DctBasis table{};
+                const double pi = std::acos(-1.0);
+                for (int u = 0; u < kHashFrequencies; ++u)
+                {
+                    double scale = std::sqrt((u == 0 ? 1.0 : 2.0) / kHashInputSize);
+                    for (int k = 0; k < kHashInputSize; ++k)
+                        table[u][k] = static_cast<float>(scale * std::cos((2 * k + 1) * u * pi / (2 * kHashInputSize)));
+                }
+                return table;
+            }();
+            return basis;
+        }
+
+        // sum of a[i] * b[i] over kHashInputSize values, in four interleaved
+        // partial sums so every path adds in the same order
+        float dot(const float *a, const float *b)
+        {
+            float partial[4];
+
+#if defined(__SSE2__)
+            __m128 acc = _mm_setzero_ps();
+            for (int i = 0; i < kHashInputSize; i += 4)
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            _mm_storeu_ps(partial, acc);
+#elif defined(__ARM_NEON)
+            float32x4_t acc = vdupq_n_f32(0.0f);
+            for (int i = 0; i < kHashInputSize; i += 4)
+                acc = vaddq_f32(acc, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+            vst1q_f32(partial, acc);
+#else
+            std::fill(std::begin(partial), std::end(partial), 0.0f);
+            for (int i = 0; i < kHashInputSize; i += 4)
+            {
+                for (int lane = 0; lane < 4; ++lane)
+                    partial[lane] += a[i + lane] * b[i + lane];
+            }
+#endif
+
+            return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+        }
+
+        // dst[i] += src[i] * weight over kHashInputSize values
+        void addScaled(float *dst, const float *src, float weight)
+        {
+            int i = 0;
+
+#if defined(__SSE2__)
+            const __m128 w = _mm_set1_ps(weight);
+            for (; i < kHashInputSize; i += 4)
+                _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), w)));
+#elif defined(__ARM_NEON)
+            const float32x4_t w = vdupq_n_f32(weight);
+            for (; i < kHashInputSize; i += 4)
+                vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vmulq_f32(vld1q_f32(src + i), w)));
+#endif
+
+            for (; i < kHashInputSize; ++i)
+                dst[i] += src[i] * weight;
+        }
+    }
+
+    void accumulateLumaHistogram(const uint8_t *plane, int linesize, int width, int height, uint32_t *histogram)
+    {
+        // Four interleaved sub-histograms, so consecutive equal values do not
+        // wait on each other's increments; neither SSE2 nor NEON can scatter
+        uint32_t counts[4][kLumaHistogramBins] = {};
+        alignas(16) uint8_t bins[16];
+
+        for (int y = 0; y < height; ++y)
+        {
+            const uint8_t *row = plane + static_cast<ptrdiff_t>(y) * linesize;
+            int x = 0;
+
+#if defined(__SSE2__)
+            const __m128i mask = _mm_set1_epi8(kLumaHistogramBins - 1);
+            for (; x + 16 <= width; x += 16)
+            {
+                // No 8-bit shift in SSE2: shift 16-bit lanes and mask off the neighbour's bits
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+                _mm_store_si128(reinterpret_cast<__m128i *>(bins), _mm_and_si128(_mm_srli_epi16(v, 2), mask));
+                for (int i = 0; i < 16; i += 4)
+                {
+                    ++counts[0][bins[i]];
+                    ++counts[1][bins[i + 1]];
+                    ++counts[2][bins[i + 2]];
+                    ++counts[3][bins[i + 3]];
+                }
+            }
+#elif defined(__ARM_NEON)
+            for (; x + 16 <= width; x += 16)
+            {
+                vst1q_u8(bins, vshrq_n_u8(vld1q_u8(row + x), 2));
+                for (int i = 0; i < 16; i += 4)
+                {
+                    ++counts[0][bins[i]];
+                    ++counts[1][bins[i + 1]];
+                    ++counts[2][bins[i + 2]];
+                    ++counts[3][bins[i + 3]];
+                }
+            }
+#endif
+
+            for (; x < width; ++x)
+                ++counts[x & 3][row[x] >> 2];
+        }
+
+        for (int bin = 0; bin < kLumaHistogramBins; ++bin)
+            histogram[bin] += counts[0][bin] + counts[1][bin] + counts[2][bin] + counts[3][bin];
+    }
+
+    void downsampleLuma(const uint8_t *plane, int linesize, int width, int height, uint8_t *thumbnail)
+    {
+        int blocks_x = width / kLumaBlockSize;
+        int blocks_y = height / kLumaBlockSize;
+
+        for (int by = 0; by < blocks_y; ++by)
+        {
+            const uint8_t *rows[8];
+            for (int i = 0; i < kLumaBlockSize; ++i)
+                rows[i] = plane + static_cast<ptrdiff_t>(by * kLumaBlockSize + i) * linesize;
+
+            uint8_t *out = thumbnail + static_cast<ptrdiff_t>(by) * blocks_x;
+            int bx = 0;
+
+#if defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            for (; bx + 2 <= blocks_x; bx += 2)
+            {
+                int x = bx * kLumaBlockSize;
+                auto load = [&](int i)
+                { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[i] + x)); };
+
+                __m128i mean = _mm_avg_epu8(_mm_avg_epu8(_mm_avg_epu8(load(0), load(1)), _mm_avg_epu8(load(2), load(3))),
+                                            _mm_avg_epu8(_mm_avg_epu8(load(4), load(5)), _mm_avg_epu8(load(6), load(7))));
+
+                // SAD against zero sums each half of 8 columns into a 64-bit lane
+                __m128i sums = _mm_sad_epu8(mean, zero);
+                out[bx] = static_cast<uint8_t>((_mm_cvtsi128_si32(sums) + 4) >> 3);
+                out[bx + 1] = static_cast<uint8_t>((_mm_extract_epi16(sums, 4) + 4) >> 3);
+            }
+#elif defined(__ARM_NEON)
+            for (; bx + 2 <= blocks_x; bx += 2)
+            {
+                int x = bx * kLumaBlockSize;
+                auto load = [&](int i)
+                { return vld1q_u8(rows[i] + x); };
+
+                uint8x16_t mean = vrhaddq_u8(vrhaddq_u8(vrhaddq_u8(load(0), load(1)), vrhaddq_u8(load(2), load(3))),
+                                             vrhaddq_u8(vrhaddq_u8(load(4), load(5)), vrhaddq_u8(load(6), load(7))));
+
+                uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(mean)));
+                out[bx] = static_cast<uint8_t>((vgetq_lane_u64(sums, 0) + 4) >> 3);
+                out[bx + 1] = static_cast<uint8_t>((vgetq_lane_u64(sums, 1) + 4) >> 3);
+            }
+#endif
+
+            for (; bx < blocks_x; ++bx)
+                out[bx] = blockMean(rows, bx * kLumaBlockSize);
+        }
+    }
+
+    uint64_t sumAbsDiff(const uint8_t *a, const uint8_t *b, size_t count)
+    {
+        uint64_t sum = 0;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        __m128i acc = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        sum = lanes[0] + lanes[1];
+#elif defined(__ARM_NEON)
+        // A 32-bit lane grows by at most 1020 per iteration; fold the lanes
+        // into the 64-bit total every 1 MiB, long before they could overflow
+        while (i + 16 <= count)
+        {
+            uint32x4_t acc = vdupq_n_u32(0);
+            size_t end = count - i > (size_t{1} << 20) ? i + (size_t{1} << 20) : count;
+            for (; i + 16 <= end; i += 16)
+                acc = vpadalq_u16(acc, vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i))));
+            uint64x2_t lanes = vpaddlq_u32(acc);
+            sum += vgetq_lane_u64(lanes, 0) + vgetq_lane_u64(lanes, 1);
+        }
+#endif
+
+        for (; i < count; ++i)
+            sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+        return sum;
+    }
+
+    void resampleHashInput(const uint8_t *image, int width, int height, float *input)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            std::fill(input, input + kHashInputSize * kHashInputSize, 0.0f);
+            return;
+        }
+
+        // Each output pixel is the mean of its source area, at least one pixel
+        for (int ty = 0; ty < kHashInputSize; ++ty)
+        {
+            int y0 = ty * height / kHashInputSize;
+            int y1 = std::max((ty + 1) * height / kHashInputSize, y0 + 1);
+            for (int tx = 0; tx < kHashInputSize; ++tx)
+            {
+                int x0 = tx * width / kHashInputSize;
+                int x1 = std::max((tx + 1) * width / kHashInputSize, x0 + 1);
+
+                int sum = 0;
+                for (int y = y0; y < y1; ++y)
+                {
+                    for (int x = x0; x < x1; ++x)
+                        sum += image[static_cast<ptrdiff_t>(y) * width + x];
+                }
+                input[ty * kHashInputSize + tx] = static_cast<float>(sum) / static_cast<float>((y1 - y0) * (x1 - x0));
+            }
+        }
+    }
+
+    uint64_t perceptualHash(const float *input)
+    {
+        const DctBasis &basis = dctBasis();
+
+        // Separable 2D DCT of the lowest frequencies only: vertical pass
+        // into rows[u][x], then horizontal pass into coefficients[u][v]
+        alignas(16) float rows[kHashFrequencies][kHashInputSize] = {};
+        for (int u = 0; u < kHashFrequencies; ++u)
+        {
+            for (int y = 0; y < kHashInputSize; ++y)
+                addScaled(rows[u], input + y * kHashInputSize, basis[u][y]);
+        }
+
+        float coefficients[kHashFrequencies * kHashFrequencies];
+        for (int u = 0; u < kHashFrequencies; ++u)
+        {
+            for (int v = 0; v < kHashFrequencies; ++v)
+                coefficients[u * kHashFrequencies + v] = dot(rows[u], basis[v].data());
+        }
+
+        // Median of the AC coefficients; the DC term only carries the mean brightness
+        float ac[kHashFrequencies * kHashFrequencies - 1];
+        std::copy(coefficients + 1, std::end(coefficients), ac);
+        std::nth_element(std::begin(ac), std::begin(ac) + std::size(ac) / 2, std::end(ac));
+        float median = ac[std::size(ac) / 2];
+
+        uint64_t hash = 0;
+        for (int i = 0; i < kHashFrequencies * kHashFrequencies; ++i)
+        {
+            if (coefficients[i] > median)
+                hash |= uint64_t{1} << i;
+        }
+        return hash;
+    }
+
+    bool framesEqual(const AVFrame *a, const AVFrame *b)
+    {
+        if (a->format != b->format || a->width != b->width || a->height != b->height)
+            return false;
+
+        AVPixelFormat format = static_cast<AVPixelFormat>(a->format);
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+        if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL))
+            return false;
+
+        for (int p = 0; p < av_pix_fmt_count_planes(format); ++p)
+        {
+            // Padding beyond the visible width may hold anything
+            int row_bytes = av_image_get_linesize(format, a->width, p);
+            int rows = (p == 1 || p == 2) ? AV_CEIL_RSHIFT(a->height, desc->log2_chroma_h) : a->height;
+            if (row_bytes <= 0)
+                return false;
+
+            for (int y = 0; y < rows; ++y)
+            {
+                if (std::memcmp(a->data[p] + static_cast<ptrdiff_t>(y) * a->linesize[p],
+                                b->data[p] + static_cast<ptrdiff_t>(y) * b->linesize[p], row_bytes) != 0)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    bool hasLumaPlane(const AVFrame *frame)
+    {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+        if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)))
+            return false;
+
+        // Gray or YUV with luma alone in plane 0 (planar and semi-planar formats)
+        return desc->comp[0].plane == 0 && desc->comp[0].depth == 8 && desc->comp[0].step == 1;
+    }
+}
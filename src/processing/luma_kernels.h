@@ -0,0 +1,51 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace video_codec
+{
+    // Analysis kernels on decoded frames, mostly on their 8-bit luma plane.
+    // SSE2 and NEON versions are picked at compile time, with a scalar fallback
+    // that gives identical results.
+
+    constexpr int kLumaHistogramBins = 64;
+    constexpr int kLumaBlockSize = 8;
+    constexpr int kHashInputSize = 32; // pHash works on a 32x32 image
+
+    // Add the values of a plane to a histogram of kLumaHistogramBins bins (value >> 2)
+    void accumulateLumaHistogram(const uint8_t *plane, int linesize, int width, int height, uint32_t *histogram);
+
+    // Thumbnail of (width / 8) x (height / 8) pixels, each the mean of an 8x8 block.
+    // Blocks cut by the right or bottom edge are dropped.
+    void downsampleLuma(const uint8_t *plane, int linesize, int width, int height, uint8_t *thumbnail);
+
+    // Sum of |a[i] - b[i]|
+    uint64_t sumAbsDiff(const uint8_t *a, const uint8_t *b, size_t count);
+
+    // Area-resample a luma image (e.g. a thumbnail from downsampleLuma()) to
+    // the kHashInputSize x kHashInputSize input of perceptualHash()
+    void resampleHashInput(const uint8_t *image, int width, int height, float *input);
+
+    // 64-bit pHash: each bit tells whether one of the 8x8 lowest DCT
+    // frequencies of the input is above their median. Similar images have
+    // hashes within a few bits of each other.
+    uint64_t perceptualHash(const float *input);
+
+    inline int hashDistance(uint64_t a, uint64_t b)
+    {
+        return std::popcount(a ^ b);
+    }
+
+    // Whether two frames have the same format, size and pixels (any 8-bit or wider format)
+    bool framesEqual(const AVFrame *a, const AVFrame *b);
+
+    // Whether data[0] of frames in this format is an 8-bit luma plane
+    bool hasLumaPlane(const AVFrame *frame);
+}
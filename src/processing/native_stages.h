@@ -0,0 +1,69 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace video_codec
+{
+    // Native pipeline stages (see processing/pipeline.h)
+
+    // Grayscale conversion with BT.601 luma weights
+    struct GrayscaleStage
+    {
+        void pixel(uint8_t &r, uint8_t &g, uint8_t &b) const
+        {
+            // Weights sum to 256 so white stays white
+            uint8_t luma = static_cast<uint8_t>((77 * r + 150 * g + 29 * b) >> 8);
+            r = luma;
+            g = luma;
+            b = luma;
+        }
+    };
+
+    // Brightness/contrast adjustment through a lookup table, the same on
+    // every RGB channel: out = (in - 128) * contrast + 128 + brightness * 255.
+    // This is libavfilter's lutrgb with that expression, not eq, which
+    // adjusts the luma of YUV frames only.
+    // - brightness: -1.0 to 1.0
+    // - contrast: 0.0 to 3.0, 1.0 is normal
+    class BrightnessContrastStage
+    {
+    public:
+        BrightnessContrastStage(double brightness, double contrast)
+        {
+            for (int v = 0; v < 256; ++v)
+            {
+                double adjusted = (v - 128.0) * contrast + 128.0 + brightness * 255.0;
+                lut_[v] = static_cast<uint8_t>(std::clamp(std::lround(adjusted), 0L, 255L));
+            }
+        }
+
+        void pixel(uint8_t &r, uint8_t &g, uint8_t &b) const
+        {
+            r = lut_[r];
+            g = lut_[g];
+            b = lut_[b];
+        }
+
+    private:
+        std::array<uint8_t, 256> lut_{};
+    };
+
+    // Terminal stage handing frames to a runtime processor (writer, saver, ...)
+    class ProcessorStage
+    {
+    public:
+        explicit ProcessorStage(FrameProcessor &processor) : processor_(&processor) {}
+
+        bool process(AVFrame *frame, int frame_number)
+        {
+            return processor_->processFrame(frame, frame_number);
+        }
+
+    private:
+        FrameProcessor *processor_;
+    };
+}
@@ -0,0 +1,262 @@
+#include <processing/noise_reduction.h>
+#include <processing/audio_kernels.h>
+#include <media/frame_ref.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/mem.h>
+}
+
+namespace video_codec
+{
+    NoiseReductionProcessor::NoiseReductionProcessor(const NoiseReductionSettings &settings,
+                                                     AudioProcessor *next)
+        : settings_(settings),
+          next_processor_(next),
+          fft_size_(std::max(64, settings.fft_size & ~3)),
+          hop_(fft_size_ / 4),
+          bins_(fft_size_ / 2 + 1)
+    {
+        // Periodic Hann window, used for analysis and synthesis
+        window_.resize(fft_size_);
+        for (int i = 0; i < fft_size_; ++i)
+            window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / fft_size_));
+
+        power_.resize(bins_);
+        noise_sum_.assign(bins_, 0.0);
+    }
+
+    NoiseReductionProcessor::~NoiseReductionProcessor()
+    {
+        av_tx_uninit(&fft_);
+        av_tx_uninit(&ifft_);
+        av_freep(&time_buffer_);
+        av_freep(&spectrum_);
+        av_channel_layout_uninit(&ch_layout_);
+    }
+
+    void NoiseReductionProcessor::setNoiseProfile(std::vector<float> noise_power)
+    {
+        if (static_cast<int>(noise_power.size()) != bins_)
+        {
+            std::cerr << "Noise profile has " << noise_power.size() << " bins, expected " << bins_ << std::endl;
+            return;
+        }
+
+        noise_power_ = std::move(noise_power);
+        profile_ready_ = true;
+    }
+
+    bool NoiseReductionProcessor::initialize(const AVFrame *frame)
+    {
+        initialized_ = true;
+
+        float scale = 1.0f;
+        float inverse_scale = 1.0f / fft_size_;
+        if (av_tx_init(&fft_, &fft_fn_, AV_TX_FLOAT_RDFT, 0, fft_size_, &scale, 0) < 0 ||
+            av_tx_init(&ifft_, &ifft_fn_, AV_TX_FLOAT_RDFT, 1, fft_size_, &inverse_scale, 0) < 0)
+        {
+            std::cerr << "Could not initialize FFT of size " << fft_size_ << std::endl;
+            return false;
+        }
+
+        // The transforms want SIMD-aligned buffers; the spectrum has one spare bin
+        time_buffer_ = static_cast<float *>(av_malloc(sizeof(float) * (fft_size_ + 2)));
+        spectrum_ = static_cast<AVComplexFloat *>(av_malloc(sizeof(AVComplexFloat) * (bins_ + 1)));
+        if (!time_buffer_ || !spectrum_ || av_channel_layout_copy(&ch_layout_, &frame->ch_layout) < 0)
+        {
+            std::cerr << "Could not allocate noise reduction buffers" << std::endl;
+            return false;
+        }
+
+        sample_rate_ = frame->sample_rate;
+        channels_.resize(frame->ch_layout.nb_channels);
+        for (Channel &channel : channels_)
+        {
+            channel.analysis.assign(fft_size_, 0.0f);
+            channel.overlap.assign(fft_size_, 0.0f);
+            channel.gains.assign(bins_, 1.0f);
+        }
+
+        // Gain smoothing per hop
+        double hop_ms = 1000.0 * hop_ / sample_rate_;
+        attack_ = static_cast<float>(1.0 - std::exp(-hop_ms / std::max(settings_.attack_ms, 1e-3)));
+        release_ = static_cast<float>(1.0 - std::exp(-hop_ms / std::max(settings_.release_ms, 1e-3)));
+
+        learn_blocks_ = profile_ready_ ? 0 : static_cast<int64_t>(std::ceil(settings_.learn_seconds * sample_rate_ / hop_));
+        if (!profile_ready_ && learn_blocks_ <= 0)
+            std::cerr << "No noise profile, audio passes through unchanged" << std::endl;
+
+        // Output starts where the input started
+        to_drop_ = getLatency();
+        next_pts_ = frame->pts;
+        return true;
+    }
+
+    void NoiseReductionProcessor::processBlock(Channel &channel, bool learn)
+    {
+        for (int i = 0; i < fft_size_; ++i)
+            time_buffer_[i] = channel.analysis[i] * window_[i];
+
+        // Forward transforms take the input stride in bytes, inverse ones the output stride
+        fft_fn_(fft_, spectrum_, time_buffer_, sizeof(float));
+        complexPower(reinterpret_cast<const float *>(spectrum_), power_.data(), bins_);
+
+        if (learn)
+        {
+            for (int k = 0; k < bins_; ++k)
+                noise_sum_[k] += power_[k];
+        }
+        else if (profile_ready_)
+        {
+            spectralGateGains(power_.data(), noise_power_.data(), channel.gains.data(), bins_,
+                              static_cast<float>(settings_.sensitivity),
+                              dbToGain(static_cast<float>(-settings_.reduction_db)), attack_, release_);
+            applyComplexGains(reinterpret_cast<float *>(spectrum_), channel.gains.data(), bins_);
+        }
+
+        ifft_fn_(ifft_, time_buffer_, spectrum_, sizeof(AVComplexFloat));
+
+        // Hann^2 at 75% overlap sums to 1.5
+        constexpr float kOverlapNorm = 1.0f / 1.5f;
+        for (int i = 0; i < fft_size_; ++i)
+            channel.overlap[i] += time_buffer_[i] * window_[i] * kOverlapNorm;
+
+        // The first hop is complete
+        channel.output.insert(channel.output.end(), channel.overlap.begin(), channel.overlap.begin() + hop_);
+        std::memmove(channel.overlap.data(), channel.overlap.data() + hop_, sizeof(float) * (fft_size_ - hop_));
+        std::fill(channel.overlap.end() - hop_, channel.overlap.end(), 0.0f);
+    }
+
+    void NoiseReductionProcessor::processPending()
+    {
+        // All channels hold the same number of samples
+        size_t available = channels_.empty() ? 0 : channels_[0].input.size();
+        size_t consumed = 0;
+
+        while (available - consumed >= static_cast<size_t>(hop_))
+        {
+            bool learn = !profile_ready_ && noise_blocks_ < learn_blocks_;
+
+            for (Channel &channel : channels_)
+            {
+                std::memmove(channel.analysis.data(), channel.analysis.data() + hop_, sizeof(float) * (fft_size_ - hop_));
+                std::memcpy(channel.analysis.data() + fft_size_ - hop_, channel.input.data() + consumed, sizeof(float) * hop_);
+                processBlock(channel, learn);
+            }
+            consumed += hop_;
+
+            if (learn && ++noise_blocks_ == learn_blocks_)
+            {
+                // Average over blocks and channels
+                noise_power_.resize(bins_);
+                double blocks = static_cast<double>(noise_blocks_ * channels_.size());
+                for (int k = 0; k < bins_; ++k)
+                    noise_power_[k] = static_cast<float>(noise_sum_[k] / blocks);
+
+                profile_ready_ = true;
+                std::cout << "Noise profile learned from " << settings_.learn_seconds << "s" << std::endl;
+            }
+        }
+
+        for (Channel &channel : channels_)
+            channel.input.erase(channel.input.begin(), channel.input.begin() + consumed);
+    }
+
+    bool NoiseReductionProcessor::emit(int64_t max_samples)
+    {
+        // Compensate the latency by dropping the leading silence
+        Channel &first = channels_[0];
+        int64_t drop = std::min<int64_t>(to_drop_, first.output.size());
+        if (drop > 0)
+        {
+            for (Channel &channel : channels_)
+                channel.output.erase(channel.output.begin(), channel.output.begin() + drop);
+            to_drop_ -= drop;
+        }
+
+        int count = static_cast<int>(std::min<int64_t>(max_samples, first.output.size()));
+        if (count <= 0)
+            return true;
+
+        FramePtr out = makeFrame();
+        if (!out)
+        {
+            std::cerr << "Could not allocate audio frame" << std::endl;
+            return false;
+        }
+
+        out->format = AV_SAMPLE_FMT_FLTP;
+        out->sample_rate = sample_rate_;
+        out->nb_samples = count;
+        if (av_channel_layout_copy(&out->ch_layout, &ch_layout_) < 0 || av_frame_get_buffer(out.get(), 0) < 0)
+        {
+            std::cerr << "Could not allocate audio frame buffer" << std::endl;
+            return false;
+        }
+
+        for (size_t c = 0; c < channels_.size(); ++c)
+        {
+            std::vector<float> &output = channels_[c].output;
+            std::memcpy(out->extended_data[c], output.data(), sizeof(float) * count);
+            output.erase(output.begin(), output.begin() + count);
+        }
+
+        out->pts = next_pts_;
+        out->time_base = AVRational{1, sample_rate_};
+        if (next_pts_ != AV_NOPTS_VALUE)
+            next_pts_ += count;
+        output_samples_ += count;
+
+        return next_processor_ ? next_processor_->processAudioFrame(out.get()) : true;
+    }
+
+    bool NoiseReductionProcessor::processAudioFrame(AVFrame *frame)
+    {
+        if (!initialized_ && !initialize(frame))
+            return false;
+
+        if (frame->ch_layout.nb_channels != static_cast<int>(channels_.size()) || frame->sample_rate != sample_rate_)
+        {
+            std::cerr << "Audio format changed during noise reduction" << std::endl;
+            return false;
+        }
+
+        for (size_t c = 0; c < channels_.size(); ++c)
+        {
+            const float *samples = reinterpret_cast<const float *>(frame->extended_data[c]);
+            channels_[c].input.insert(channels_[c].input.end(), samples, samples + frame->nb_samples);
+        }
+        input_samples_ += frame->nb_samples;
+
+        processPending();
+        return emit(input_samples_ - output_samples_);
+    }
+
+    bool NoiseReductionProcessor::finishAudio()
+    {
+        bool result = true;
+
+        if (initialized_ && !channels_.empty())
+        {
+            // Push silence through until every input sample came out
+            while (output_samples_ + static_cast<int64_t>(channels_[0].output.size()) - to_drop_ < input_samples_)
+            {
+                for (Channel &channel : channels_)
+                    channel.input.resize(channel.input.size() + hop_, 0.0f);
+                processPending();
+            }
+
+            result = emit(input_samples_ - output_samples_);
+        }
+
+        if (next_processor_ && !next_processor_->finishAudio())
+            result = false;
+
+        return result;
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libavutil/tx.h>
+}
+
+#include <processing/audio_processor.h>
+#include <vector>
+
+namespace video_codec
+{
+    struct NoiseReductionSettings
+    {
+        int fft_size{1024};         // Even, at least 64; the hop is a quarter of it
+        double reduction_db{18.0};  // Largest attenuation of noise bins
+        double sensitivity{2.0};    // Over-subtraction factor on the noise power
+        double learn_seconds{0.5};  // Learn the profile from the start of the stream unless one is set
+        double attack_ms{5.0};      // Gain smoothing when a bin gets quieter
+        double release_ms{60.0};    // Gain smoothing when a bin gets louder
+    };
+
+    // STFT noise suppression by spectral gating against a noise profile.
+    // Audio is analysed in Hann-windowed blocks with 75% overlap and
+    // resynthesised by overlap-add, so the processor has a fixed latency of
+    // 3/4 of the FFT size and memory bounded by a few blocks per channel.
+    // The latency is compensated: frames handed to next start at the
+    // timestamp of the input and the tail is flushed by finishAudio().
+    // Since the output frames differ from the input ones, the processor
+    // forwards them to next instead of working in place.
+    class NoiseReductionProcessor : public AudioProcessor
+    {
+    public:
+        explicit NoiseReductionProcessor(const NoiseReductionSettings &settings = {},
+                                         AudioProcessor *next = nullptr);
+        ~NoiseReductionProcessor() override;
+
+        // Not Allowed to copy
+        NoiseReductionProcessor(const NoiseReductionProcessor &) = delete;
+        NoiseReductionProcessor &operator=(const NoiseReductionProcessor &) = delete;
+
+        // Noise power per bin (fft_size / 2 + 1 values), e.g. learned in an earlier run
+        void setNoiseProfile(std::vector<float> noise_power);
+        const std::vector<float> &getNoiseProfile() const { return noise_power_; }
+        bool isProfileReady() const { return profile_ready_; }
+
+        int getLatency() const { return fft_size_ - hop_; }
+
+        bool processAudioFrame(AVFrame *frame) override;
+        bool finishAudio() override;
+
+    private:
+        struct Channel
+        {
+            std::vector<float> input;    // Samples not yet analysed
+            std::vector<float> analysis; // Sliding analysis block
+            std::vector<float> overlap;  // Overlap-add accumulator
+            std::vector<float> gains;    // Smoothed per-bin gains
+            std::vector<float> output;   // Resynthesised samples ready to hand over
+        };
+
+        NoiseReductionSettings settings_;
+        AudioProcessor *next_processor_;
+
+        int fft_size_;
+        int hop_;
+        int bins_;
+
+        // Transforms and aligned scratch buffers
+        AVTXContext *fft_{nullptr};
+        AVTXContext *ifft_{nullptr};
+        av_tx_fn fft_fn_{nullptr};
+        av_tx_fn ifft_fn_{nullptr};
+        float *time_buffer_{nullptr};
+        AVComplexFloat *spectrum_{nullptr};
+        std::vector<float> power_;
+        std::vector<float> window_;
+
+        // Noise profile
+        std::vector<float> noise_power_;
+        std::vector<double> noise_sum_;
+        int64_t noise_blocks_{0};
+        int64_t learn_blocks_{0};
+        bool profile_ready_{false};
+
+        // Stream state
+        bool initialized_{false};
+        int sample_rate_{0};
+        AVChannelLayout ch_layout_{};
+        std::vector<Channel> channels_;
+        int64_t next_pts_{AV_NOPTS_VALUE};
+        int64_t input_samples_{0};
+        int64_t output_samples_{0};
+        int64_t to_drop_{0};
+        float attack_{1.0f};
+        float release_{1.0f};
+
+        bool initialize(const AVFrame *frame);
+
+        // Analyse, gate and resynthesise one hop of a channel
+        void processBlock(Channel &channel, bool learn);
+
+        // Run every complete hop buffered in the channels
+        void processPending();
+
+        // Hand up to max_samples resynthesised samples to next
+        bool emit(int64_t max_samples);
+    };
+}
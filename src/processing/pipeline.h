@@ -0,0 +1,183 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace video_codec
+{
+    // Stage that transforms a single RGB24 pixel in place.
+    // Consecutive pixel stages of a Pipeline are fused into one pass over the frame.
+    template <typename Stage>
+    concept PixelStage = requires(Stage &stage, uint8_t &c) {
+        stage.pixel(c, c, c);
+    };
+
+    // Stage that works on a whole frame (analysis, output, ...)
+    template <typename Stage>
+    concept FrameStage = requires(Stage &stage, AVFrame *frame, int frame_number) {
+        { stage.process(frame, frame_number) } -> std::convertible_to<bool>;
+    };
+
+    // Processor chain composed at compile time.
+    // Stages are called directly instead of through FrameProcessor pointers,
+    // so the compiler can inline them and runs of pixel stages share a single
+    // loop over the frame. The pipeline itself is a FrameProcessor and can be
+    // used anywhere a runtime chain is expected.
+    // Pixel stages modify the frame in place, so frames must be reference-counted.
+    template <typename... Stages>
+    class Pipeline final : public FrameProcessor
+    {
+        static_assert(((PixelStage<Stages> || FrameStage<Stages>) && ...),
+                      "Pipeline stages must provide pixel(r, g, b) or process(frame, frame_number)");
+
+    public:
+        Pipeline() = default;
+        explicit Pipeline(Stages... stages) : stages_(std::move(stages)...) {}
+
+        // Access a stage, e.g. to read results of an analysis stage
+        template <size_t I>
+        auto &stage() { return std::get<I>(stages_); }
+
+        bool processFrame(AVFrame *frame, int frame_number) override
+        {
+            if (!prepareFrame(frame))
+                return false;
+
+            return runFrom<0>(frame, frame_number);
+        }
+
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override
+        {
+            for (size_t i = 0; i < frames.size(); ++i)
+            {
+                if (!prepareFrame(frames[i]) || !runFrom<0>(frames[i], first_index + static_cast<int>(i)))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        template <size_t I>
+        using StageAt = std::tuple_element_t<I, std::tuple<Stages...>>;
+
+        static constexpr bool has_pixel_stages_ = (PixelStage<Stages> || ...);
+
+        std::tuple<Stages...> stages_;
+
+        bool prepareFrame(AVFrame *frame)
+        {
+            if constexpr (has_pixel_stages_)
+            {
+                if (frame->format != AV_PIX_FMT_RGB24)
+                {
+                    std::cerr << "Pipeline pixel stages require RGB24 frames" << std::endl;
+                    return false;
+                }
+
+                // No-op when we hold the only reference to the buffer
+                if (av_frame_make_writable(frame) < 0)
+                {
+                    std::cerr << "Could not make frame writable" << std::endl;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Index one past the run of pixel stages that starts at I
+        template <size_t I>
+        static constexpr size_t pixelRunEnd()
+        {
+            if constexpr (I < sizeof...(Stages))
+            {
+                if constexpr (PixelStage<StageAt<I>>)
+                    return pixelRunEnd<I + 1>();
+                else
+                    return I;
+            }
+            else
+                return I;
+        }
+
+        template <size_t I>
+        bool runFrom(AVFrame *frame, int frame_number)
+        {
+            if constexpr (I == sizeof...(Stages))
+            {
+                return true;
+            }
+            else if constexpr (PixelStage<StageAt<I>>)
+            {
+                constexpr size_t end = pixelRunEnd<I>();
+                applyPixels<I>(frame, std::make_index_sequence<end - I>{});
+                return runFrom<end>(frame, frame_number);
+            }
+            else
+            {
+                if (!std::get<I>(stages_).process(frame, frame_number))
+                    return false;
+                return runFrom<I + 1>(frame, frame_number);
+            }
+        }
+
+        // Single pass over the frame; each pixel goes through the whole run
+        template <size_t First, size_t... Is>
+        void applyPixels(AVFrame *frame, std::index_sequence<Is...>)
+        {
+            for (int y = 0; y < frame->height; ++y)
+            {
+                uint8_t *row = frame->data[0] + static_cast<ptrdiff_t>(y) * frame->linesize[0];
+                for (int x = 0; x < frame->width; ++x)
+                {
+                    uint8_t *px = row + x * 3;
+                    uint8_t r = px[0];
+                    uint8_t g = px[1];
+                    uint8_t b = px[2];
+
+                    (std::get<First + Is>(stages_).pixel(r, g, b), ...);
+
+                    px[0] = r;
+                    px[1] = g;
+                    px[2] = b;
+                }
+            }
+        }
+    };
+
+    // Runtime adaptor for a single stage, for chains wired through next_processor_
+    template <typename Stage>
+    class StageProcessor : public FrameProcessor
+    {
+    public:
+        explicit StageProcessor(Stage stage, FrameProcessor *next_processor = nullptr)
+            : pipeline_(std::move(stage)), next_processor_(next_processor) {}
+
+        bool processFrame(AVFrame *frame, int frame_number) override
+        {
+            if (!pipeline_.processFrame(frame, frame_number))
+                return false;
+
+            return next_processor_ ? next_processor_->processFrame(frame, frame_number) : true;
+        }
+
+        void setNextProcessor(FrameProcessor *next_processor)
+        {
+            next_processor_ = next_processor;
+        }
+
+    private:
+        Pipeline<Stage> pipeline_;
+        FrameProcessor *next_processor_;
+    };
+}
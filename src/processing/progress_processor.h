@@ -0,0 +1,54 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <cstdint>
+#include <functional>
+
+namespace video_codec
+{
+    // Frames done so far and the expected total (-1 if unknown)
+    using ProgressCallback = std::function<void(int64_t frames_done, int64_t frames_total)>;
+
+    // Pass-through processor at the head of a chain that reports how many
+    // frames went through. Ownership and batches are forwarded unchanged.
+    class ProgressProcessor : public FrameProcessor
+    {
+    public:
+        ProgressProcessor(FrameProcessor &next_processor, ProgressCallback callback, int64_t frames_total = -1)
+            : next_processor_(next_processor), callback_(std::move(callback)), frames_total_(frames_total) {}
+
+        bool processFrame(AVFrame *frame, int frame_number) override
+        {
+            bool result = next_processor_.processFrame(frame, frame_number);
+            report(1);
+            return result;
+        }
+
+        bool consumeFrame(FramePtr frame, int frame_number) override
+        {
+            bool result = next_processor_.consumeFrame(std::move(frame), frame_number);
+            report(1);
+            return result;
+        }
+
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override
+        {
+            bool result = next_processor_.processFrames(frames, first_index);
+            report(static_cast<int64_t>(frames.size()));
+            return result;
+        }
+
+    private:
+        void report(int64_t frames)
+        {
+            frames_done_ += frames;
+            if (callback_)
+                callback_(frames_done_, frames_total_);
+        }
+
+        FrameProcessor &next_processor_;
+        ProgressCallback callback_;
+        int64_t frames_total_;
+        int64_t frames_done_{0};
+    };
+}
@@ -0,0 +1,49 @@
+#include <processing/proxy_writer_processor.h>
+#include <iostream>
+
+namespace video_codec
+{
+    ProxyWriterProcessor::ProxyWriterProcessor(const std::string &proxy_filename, const ProxySource &source,
+                                               const ProxyOptions &options)
+    {
+        if (writer_.open(proxy_filename, source, options))
+        {
+            initialized_ = true;
+            std::cout << "Proxy opened: " << proxy_filename << " (" << writer_.getWidth() << "x" << writer_.getHeight()
+                      << ", " << options.codec << " intra-only)" << std::endl;
+        }
+        else
+            std::cerr << "Failed to open proxy: " << writer_.getLastError() << std::endl;
+    }
+
+    ProxyWriterProcessor::~ProxyWriterProcessor()
+    {
+        if (initialized_ && !finalized_)
+            finalize();
+    }
+
+    bool ProxyWriterProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (!initialized_ || finalized_)
+        {
+            std::cerr << "ProxyWriterProcessor not writable" << std::endl;
+            return false;
+        }
+
+        if (!writer_.writeFrame(frame))
+        {
+            std::cerr << "Failed to write proxy frame #" << frame_number << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool ProxyWriterProcessor::finalize()
+    {
+        if (finalized_)
+            return true;
+        finalized_ = true;
+
+        return writer_.close();
+    }
+}
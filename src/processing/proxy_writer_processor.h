@@ -0,0 +1,31 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <media/proxy_writer.h>
+#include <string>
+
+namespace video_codec
+{
+    // Terminal processor that writes a proxy of the decoded frames, so a
+    // proxy can be produced in the same decode pass as other outputs
+    class ProxyWriterProcessor : public FrameProcessor
+    {
+    public:
+        ProxyWriterProcessor(const std::string &proxy_filename, const ProxySource &source,
+                             const ProxyOptions &options = {});
+        ~ProxyWriterProcessor() override;
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Flush the encoder and finish the file
+        bool finalize();
+
+        bool isInitialized() const { return initialized_; }
+        const std::string &getLastError() const { return writer_.getLastError(); }
+
+    private:
+        ProxyWriter writer_;
+        bool initialized_{false};
+        bool finalized_{false};
+    };
+}
@@ -0,0 +1,198 @@
+#include <processing/quality_kernels.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace video_codec
+{
+    namespace
+    {
+        // Accumulator lanes grow by at most 2 * 2 * 255^2 per 16 pixels; fold
+        // them into the 64-bit total every 64 KiB, long before they overflow
+        constexpr size_t kFoldBytes = size_t{1} << 16;
+
+        void blockSums(const uint8_t *a, int a_stride, const uint8_t *b, int b_stride, int32_t sums[4])
+        {
+            int32_t s1 = 0, s2 = 0, ss = 0, s12 = 0;
+            for (int y = 0; y < 4; ++y)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    int va = a[y * a_stride + x];
+                    int vb = b[y * b_stride + x];
+                    s1 += va;
+                    s2 += vb;
+                    ss += va * va + vb * vb;
+                    s12 += va * vb;
+                }
+            }
+            sums[0] = s1;
+            sums[1] = s2;
+            sums[2] = ss;
+            sums[3] = s12;
+        }
+
+        // SSIM of one 8x8 window from its summed statistics (64 pixels)
+        double windowSsim(int64_t s1, int64_t s2, int64_t ss, int64_t s12)
+        {
+            constexpr int64_t c1 = static_cast<int64_t>(.01 * .01 * 255 * 255 * 64 + .5);
+            constexpr int64_t c2 = static_cast<int64_t>(.03 * .03 * 255 * 255 * 64 * 63 + .5);
+
+            int64_t vars = ss * 64 - s1 * s1 - s2 * s2;
+            int64_t covar = s12 * 64 - s1 * s2;
+            return static_cast<double>(2 * s1 * s2 + c1) * static_cast<double>(2 * covar + c2) /
+                   (static_cast<double>(s1 * s1 + s2 * s2 + c1) * static_cast<double>(vars + c2));
+        }
+    }
+
+    uint64_t sumSquaredDiff(const uint8_t *a, const uint8_t *b, size_t count)
+    {
+        uint64_t sum = 0;
+        size_t i = 0;
+
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        while (i + 16 <= count)
+        {
+            __m128i acc = _mm_setzero_si128();
+            size_t end = count - i > kFoldBytes ? i + kFoldBytes : count;
+            for (; i + 16 <= end; i += 16)
+            {
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+                __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+
+                // Differences fit signed 16 bits; madd squares them and adds pairs into 32 bits
+                __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero));
+                __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero));
+                acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+            }
+
+            alignas(16) uint32_t lanes[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+            sum += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        }
+#elif defined(__ARM_NEON)
+        while (i + 16 <= count)
+        {
+            uint32x4_t acc = vdupq_n_u32(0);
+            size_t end = count - i > kFoldBytes ? i + kFoldBytes : count;
+            for (; i + 16 <= end; i += 16)
+            {
+                uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+                acc = vpadalq_u16(acc, vmull_u8(vget_low_u8(diff), vget_low_u8(diff)));
+                acc = vpadalq_u16(acc, vmull_u8(vget_high_u8(diff), vget_high_u8(diff)));
+            }
+
+            uint64x2_t lanes = vpaddlq_u32(acc);
+            sum += vgetq_lane_u64(lanes, 0) + vgetq_lane_u64(lanes, 1);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            int diff = a[i] - b[i];
+            sum += static_cast<uint64_t>(diff * diff);
+        }
+        return sum;
+    }
+
+    void ssimBlockSums(const uint8_t *a, int a_stride, const uint8_t *b, int b_stride, int count, int32_t (*sums)[4])
+    {
+        int block = 0;
+
+#if defined(__SSE2__)
+        // Four blocks (16 pixels) per iteration: madd leaves sums of pixel
+        // pairs in 32-bit lanes, two lanes per block and row
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; block + 4 <= count; block += 4)
+        {
+            __m128i s1[2] = {zero, zero}, s2[2] = {zero, zero}, ss[2] = {zero, zero}, s12[2] = {zero, zero};
+            for (int y = 0; y < 4; ++y)
+            {
+                __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + y * a_stride + block * 4));
+                __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + y * b_stride + block * 4));
+                __m128i wa[2] = {_mm_unpacklo_epi8(va, zero), _mm_unpackhi_epi8(va, zero)};
+                __m128i wb[2] = {_mm_unpacklo_epi8(vb, zero), _mm_unpackhi_epi8(vb, zero)};
+
+                for (int h = 0; h < 2; ++h)
+                {
+                    s1[h] = _mm_add_epi32(s1[h], _mm_madd_epi16(wa[h], ones));
+                    s2[h] = _mm_add_epi32(s2[h], _mm_madd_epi16(wb[h], ones));
+                    ss[h] = _mm_add_epi32(ss[h], _mm_add_epi32(_mm_madd_epi16(wa[h], wa[h]), _mm_madd_epi16(wb[h], wb[h])));
+                    s12[h] = _mm_add_epi32(s12[h], _mm_madd_epi16(wa[h], wb[h]));
+                }
+            }
+
+            alignas(16) int32_t lanes[4][8];
+            const __m128i *stats[4] = {s1, s2, ss, s12};
+            for (int s = 0; s < 4; ++s)
+            {
+                _mm_store_si128(reinterpret_cast<__m128i *>(lanes[s]), stats[s][0]);
+                _mm_store_si128(reinterpret_cast<__m128i *>(lanes[s] + 4), stats[s][1]);
+                for (int j = 0; j < 4; ++j)
+                    sums[block + j][s] = lanes[s][2 * j] + lanes[s][2 * j + 1];
+            }
+        }
+#elif defined(__ARM_NEON)
+        for (; block + 4 <= count; block += 4)
+        {
+            uint16x8_t s1 = vdupq_n_u16(0), s2 = vdupq_n_u16(0);
+            uint32x4_t ss[2] = {vdupq_n_u32(0), vdupq_n_u32(0)};
+            uint32x4_t s12[2] = {vdupq_n_u32(0), vdupq_n_u32(0)};
+            for (int y = 0; y < 4; ++y)
+            {
+                uint8x16_t va = vld1q_u8(a + y * a_stride + block * 4);
+                uint8x16_t vb = vld1q_u8(b + y * b_stride + block * 4);
+
+                // Pair sums of 4 rows stay below 2^16
+                s1 = vpadalq_u8(s1, va);
+                s2 = vpadalq_u8(s2, vb);
+                ss[0] = vpadalq_u16(ss[0], vmull_u8(vget_low_u8(va), vget_low_u8(va)));
+                ss[0] = vpadalq_u16(ss[0], vmull_u8(vget_low_u8(vb), vget_low_u8(vb)));
+                ss[1] = vpadalq_u16(ss[1], vmull_u8(vget_high_u8(va), vget_high_u8(va)));
+                ss[1] = vpadalq_u16(ss[1], vmull_u8(vget_high_u8(vb), vget_high_u8(vb)));
+                s12[0] = vpadalq_u16(s12[0], vmull_u8(vget_low_u8(va), vget_low_u8(vb)));
+                s12[1] = vpadalq_u16(s12[1], vmull_u8(vget_high_u8(va), vget_high_u8(vb)));
+            }
+
+            // One lane per block after adding neighbouring pairs
+            uint32_t block_s1[4], block_s2[4];
+            vst1q_u32(block_s1, vpaddlq_u16(s1));
+            vst1q_u32(block_s2, vpaddlq_u16(s2));
+            uint32_t pair_ss[8], pair_s12[8];
+            vst1q_u32(pair_ss, ss[0]);
+            vst1q_u32(pair_ss + 4, ss[1]);
+            vst1q_u32(pair_s12, s12[0]);
+            vst1q_u32(pair_s12 + 4, s12[1]);
+
+            for (int j = 0; j < 4; ++j)
+            {
+                sums[block + j][0] = static_cast<int32_t>(block_s1[j]);
+                sums[block + j][1] = static_cast<int32_t>(block_s2[j]);
+                sums[block + j][2] = static_cast<int32_t>(pair_ss[2 * j] + pair_ss[2 * j + 1]);
+                sums[block + j][3] = static_cast<int32_t>(pair_s12[2 * j] + pair_s12[2 * j + 1]);
+            }
+        }
+#endif
+
+        for (; block < count; ++block)
+            blockSums(a + block * 4, a_stride, b + block * 4, b_stride, sums[block]);
+    }
+
+    double ssimWindowRow(const int32_t (*top)[4], const int32_t (*bottom)[4], int count)
+    {
+        double total = 0.0;
+        for (int i = 0; i < count; ++i)
+        {
+            int64_t s[4];
+            for (int k = 0; k < 4; ++k)
+                s[k] = static_cast<int64_t>(top[i][k]) + top[i + 1][k] + bottom[i][k] + bottom[i + 1][k];
+            total += windowSsim(s[0], s[1], s[2], s[3]);
+        }
+        return total;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace video_codec
+{
+    // Objective quality kernels on 8-bit planes (PSNR and SSIM).
+    // SSE2 and NEON versions are picked at compile time, with a scalar fallback
+    // that gives identical results.
+
+    // Sum of (a[i] - b[i])^2
+    uint64_t sumSquaredDiff(const uint8_t *a, const uint8_t *b, size_t count);
+
+    // SSIM statistics of count horizontally adjacent 4x4 blocks:
+    // sums[i] = {sum a, sum b, sum a^2 + b^2, sum a * b}
+    void ssimBlockSums(const uint8_t *a, int a_stride, const uint8_t *b, int b_stride, int count, int32_t (*sums)[4]);
+
+    // Sum of the SSIM of count 8x8 windows overlapping by 4 pixels, from the
+    // block sums of two consecutive block rows (count + 1 blocks each).
+    // Constants follow x264 and FFmpeg, so results are comparable to theirs.
+    double ssimWindowRow(const int32_t (*top)[4], const int32_t (*bottom)[4], int count);
+}
@@ -0,0 +1,66 @@
+#include <processing/raw_frame_writer_processor.h>
+#include <iostream>
+
+extern "C"
+{
+#include <libavutil/rational.h>
+}
+
+namespace video_codec
+{
+    RawFrameWriterProcessor::RawFrameWriterProcessor(const std::string &output_filename, double fps)
+        : output_filename_(output_filename), fps_(fps)
+    {
+    }
+
+    RawFrameWriterProcessor::~RawFrameWriterProcessor()
+    {
+        if (!finalized_)
+            finalize();
+    }
+
+    bool RawFrameWriterProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (finalized_)
+        {
+            std::cerr << "RawFrameWriterProcessor already finalized" << std::endl;
+            return false;
+        }
+
+        if (!writer_.isOpen())
+        {
+            AVRational frame_rate = av_d2q(fps_, 1 << 16);
+            AVRational time_base = frame->time_base.num > 0 ? frame->time_base : av_inv_q(frame_rate);
+            if (!writer_.open(output_filename_, frame->width, frame->height,
+                              static_cast<AVPixelFormat>(frame->format), time_base, frame_rate))
+                return false;
+
+            std::cout << "Raw frame output opened: " << output_filename_ << " ("
+                      << frame->width << "x" << frame->height << ")" << std::endl;
+        }
+
+        if (!writer_.writeFrame(frame))
+        {
+            std::cerr << "Failed to write raw frame #" << frame_number << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool RawFrameWriterProcessor::finalize()
+    {
+        if (finalized_)
+            return true;
+        finalized_ = true;
+
+        if (!writer_.isOpen())
+            return true;
+
+        uint64_t frames = writer_.getFrameCount();
+        if (!writer_.close())
+            return false;
+
+        std::cout << "Raw frame output finished: " << frames << " frames" << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <media/raw_frame_file.h>
+#include <string>
+
+namespace video_codec
+{
+    // Terminal processor that stores frames in a raw frame file (.vcraw)
+    // for later passes. The file takes the geometry, pixel format and time
+    // base of the first frame.
+    class RawFrameWriterProcessor : public FrameProcessor
+    {
+    public:
+        explicit RawFrameWriterProcessor(const std::string &output_filename, double fps = 30.0);
+        ~RawFrameWriterProcessor() override;
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Write the index; the file is unreadable until then
+        bool finalize();
+
+        const std::string &getLastError() const { return writer_.getLastError(); }
+
+    private:
+        RawFrameWriter writer_;
+        std::string output_filename_;
+        double fps_;
+        bool finalized_{false};
+    };
+}
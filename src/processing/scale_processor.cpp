@@ -0,0 +1,91 @@
+#include <processing/scale_processor.h>
+#include <media/codec_cache.h>
+#include <profiling/pipeline_metrics.h>
+#include <iostream>
+
+namespace video_codec
+{
+    ScaleProcessor::ScaleProcessor(int width, int height, FrameProcessor *next_processor, int flags)
+        : next_processor_(next_processor), width_(width), height_(height), flags_(flags)
+    {
+    }
+
+    ScaleProcessor::~ScaleProcessor()
+    {
+        release();
+    }
+
+    bool ScaleProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (!next_processor_)
+        {
+            std::cerr << "ScaleProcessor has no next processor" << std::endl;
+            return false;
+        }
+
+        if (frame->width == width_ && frame->height == height_)
+        {
+            FramePtr same = refFrame(frame);
+            return same && next_processor_->consumeFrame(std::move(same), frame_number);
+        }
+
+        if (frame->width != src_width_ || frame->height != src_height_ || frame->format != src_format_)
+        {
+            if (!initialize(frame))
+                return false;
+        }
+
+        FramePtr scaled = pool_.acquire();
+        if (!scaled)
+        {
+            std::cerr << "Could not allocate scaled frame" << std::endl;
+            return false;
+        }
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("scale");
+        int ret = timeStage(metrics, frame_number, [&]
+                            { return sws_scale(sws_ctx_, frame->data, frame->linesize, 0, frame->height,
+                                               scaled->data, scaled->linesize); });
+        metrics.addFrames(1);
+        if (ret <= 0)
+        {
+            std::cerr << "Error scaling frame #" << frame_number << std::endl;
+            return false;
+        }
+
+        av_frame_copy_props(scaled.get(), frame);
+        return next_processor_->consumeFrame(std::move(scaled), frame_number);
+    }
+
+    bool ScaleProcessor::initialize(const AVFrame *frame)
+    {
+        release();
+
+        AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+        sws_ctx_ = CodecCache::instance().acquireScaler(frame->width, frame->height, format,
+                                                        width_, height_, format, flags_);
+        if (!sws_ctx_ || !pool_.initialize(width_, height_, format))
+        {
+            std::cerr << "Could not initialize scaling to " << width_ << "x" << height_ << std::endl;
+            release();
+            return false;
+        }
+
+        src_width_ = frame->width;
+        src_height_ = frame->height;
+        src_format_ = format;
+        return true;
+    }
+
+    void ScaleProcessor::release()
+    {
+        if (sws_ctx_)
+        {
+            CodecCache::instance().releaseScaler(sws_ctx_);
+            sws_ctx_ = nullptr;
+        }
+        src_width_ = 0;
+        src_height_ = 0;
+        src_format_ = AV_PIX_FMT_NONE;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <media/frame_pool.h>
+
+extern "C"
+{
+#include <libswscale/swscale.h>
+}
+
+namespace video_codec
+{
+    // Transform node that resizes frames to a fixed size, keeping their pixel
+    // format, and hands them to the next processor.
+    //
+    // Output frames come from a FramePool and are passed on with
+    // consumeFrame(), so they can sit in ProcessingGraph edges and feed
+    // further ScaleProcessors (cascaded downscaling: each rung of a ladder
+    // is scaled from the one above instead of from the full-size frame).
+    // Frames already at the target size are forwarded by reference.
+    class ScaleProcessor : public FrameProcessor
+    {
+    public:
+        ScaleProcessor(int width, int height, FrameProcessor *next_processor = nullptr, int flags = SWS_AREA);
+        ~ScaleProcessor() override;
+
+        // Not Allowed to copy
+        ScaleProcessor(const ScaleProcessor &) = delete;
+        ScaleProcessor &operator=(const ScaleProcessor &) = delete;
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        void setNextProcessor(FrameProcessor *next_processor) { next_processor_ = next_processor; }
+
+        int getWidth() const { return width_; }
+        int getHeight() const { return height_; }
+
+    private:
+        FrameProcessor *next_processor_;
+        int width_;
+        int height_;
+        int flags_;
+
+        // Scaler for the current input geometry
+        SwsContext *sws_ctx_{nullptr};
+        int src_width_{0};
+        int src_height_{0};
+        AVPixelFormat src_format_{AV_PIX_FMT_NONE};
+        FramePool pool_;
+
+        bool initialize(const AVFrame *frame);
+        void release();
+    };
+}
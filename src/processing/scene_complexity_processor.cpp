@@ -0,0 +1,112 @@
+#include <processing/scene_complexity_processor.h>
+#include <processing/luma_kernels.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <iostream>
+
+namespace video_codec
+{
+    SceneComplexityProcessor::SceneComplexityProcessor(AVRational time_base, const SceneDetectOptions &options)
+        : detector_(time_base, options), time_base_(time_base)
+    {
+        detector_.setCutCallback([this](const SceneCut &)
+                                 { cut_ = true; });
+    }
+
+    bool SceneComplexityProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        cut_ = false;
+        if (!detector_.processFrame(frame, frame_number))
+        {
+            last_error_ = detector_.getLastError();
+            return false;
+        }
+
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (pts == AV_NOPTS_VALUE)
+            pts = frame_number;
+        int64_t duration = frame->duration > 0 ? frame->duration : (previous_ ? pts - previous_pts_ : 1);
+        duration = std::max<int64_t>(duration, 1);
+
+        if (cut_)
+            closeScene(pts);
+        if (scene_.start_pts == AV_NOPTS_VALUE)
+            scene_.start_pts = pts;
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("scene complexity");
+        const uint8_t *plane = frame->data[0];
+        int linesize = frame->linesize[0];
+        int width = frame->width;
+        int height = frame->height;
+
+        // Motion within the scene only; the difference across a cut says nothing about either scene
+        bool comparable = !cut_ && previous_ && previous_->width == width && previous_->height == height &&
+                          previous_->format == frame->format;
+
+        uint64_t gradient = 0;
+        uint64_t motion = 0;
+        timeStage(metrics, frame_number, [&]
+                  {
+                      for (int y = 0; y < height; ++y)
+                      {
+                          const uint8_t *row = plane + static_cast<ptrdiff_t>(y) * linesize;
+                          if (width > 1)
+                              gradient += sumAbsDiff(row, row + 1, static_cast<size_t>(width - 1));
+                          if (y + 1 < height)
+                              gradient += sumAbsDiff(row, row + linesize, static_cast<size_t>(width));
+                          if (comparable)
+                              motion += sumAbsDiff(row, previous_->data[0] + static_cast<ptrdiff_t>(y) * previous_->linesize[0],
+                                                   static_cast<size_t>(width));
+                      }
+                      return true; });
+        metrics.addFrames(1);
+
+        double pixels = static_cast<double>(width) * static_cast<double>(height);
+        if (pixels > 0)
+        {
+            scene_.spatial_sum += static_cast<double>(gradient) / pixels;
+            if (comparable)
+            {
+                scene_.temporal_sum += static_cast<double>(motion) / pixels;
+                ++scene_.temporal_frames;
+            }
+        }
+        ++scene_.frames;
+
+        previous_ = refFrame(frame);
+        if (!previous_)
+        {
+            last_error_ = "Could not reference frame";
+            std::cerr << last_error_ << std::endl;
+            return false;
+        }
+        previous_pts_ = pts;
+        previous_end_ = pts + duration;
+        return true;
+    }
+
+    void SceneComplexityProcessor::finish()
+    {
+        closeScene(previous_end_);
+        previous_.reset();
+    }
+
+    void SceneComplexityProcessor::closeScene(int64_t end_pts)
+    {
+        if (scene_.frames == 0)
+            return;
+
+        SceneComplexity result;
+        result.start_pts = scene_.start_pts;
+        result.end_pts = end_pts;
+        result.start = av_q2d(time_base_) * static_cast<double>(scene_.start_pts);
+        result.duration = av_q2d(time_base_) * static_cast<double>(end_pts - scene_.start_pts);
+        result.frames = scene_.frames;
+        result.spatial = scene_.spatial_sum / static_cast<double>(scene_.frames);
+        result.temporal = scene_.temporal_frames > 0 ? scene_.temporal_sum / static_cast<double>(scene_.temporal_frames) : 0.0;
+        result.complexity = result.spatial + result.temporal;
+        scenes_.push_back(result);
+
+        scene_ = OpenScene();
+    }
+}
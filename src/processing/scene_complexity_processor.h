@@ -0,0 +1,79 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <processing/scene_detect_processor.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/rational.h>
+}
+
+namespace video_codec
+{
+    struct SceneComplexity
+    {
+        int64_t start_pts{0}; // First frame (stream time base)
+        int64_t end_pts{0};   // End of the last frame
+        double start{0.0};    // Seconds
+        double duration{0.0};
+        int64_t frames{0};
+
+        // Mean absolute luma differences per pixel: to the right and lower
+        // neighbour (texture) and to the previous frame (motion)
+        double spatial{0.0};
+        double temporal{0.0};
+
+        // Rough encoding cost of the scene, spatial + temporal
+        double complexity{0.0};
+    };
+
+    // Splits a video into scenes (SceneDetectProcessor) and measures how
+    // hard each one is to encode, for per-scene rate control.
+    //
+    // Works on the decoded luma plane like the scene detector; a low
+    // resolution decode (VideoStream::setLowres()) keeps the pre-pass cheap
+    // while preserving the ranking of the scenes. Decode every frame:
+    // the temporal measure is meaningless on keyframes only.
+    class SceneComplexityProcessor : public FrameProcessor
+    {
+    public:
+        explicit SceneComplexityProcessor(AVRational time_base, const SceneDetectOptions &options = {});
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Close the last scene after the final frame
+        void finish();
+
+        const std::vector<SceneComplexity> &getScenes() const { return scenes_; }
+        const std::vector<SceneCut> &getCuts() const { return detector_.getCuts(); }
+        const std::string &getLastError() const { return last_error_; }
+
+    private:
+        // Scene being measured
+        struct OpenScene
+        {
+            int64_t start_pts{AV_NOPTS_VALUE};
+            int64_t frames{0};
+            double spatial_sum{0.0};
+            double temporal_sum{0.0};
+            int64_t temporal_frames{0};
+        };
+
+        SceneDetectProcessor detector_;
+        AVRational time_base_;
+        std::vector<SceneComplexity> scenes_;
+        OpenScene scene_;
+        bool cut_{false}; // Set by the detector for the current frame
+
+        FramePtr previous_;
+        int64_t previous_pts_{0};
+        int64_t previous_end_{0};
+
+        std::string last_error_;
+
+        void closeScene(int64_t end_pts);
+    };
+}
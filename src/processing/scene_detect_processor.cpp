@@ -0,0 +1,117 @@
+#include <processing/scene_detect_processor.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace video_codec
+{
+    namespace
+    {
+        // Mean block difference counted as a complete change of layout
+        constexpr double kFullSadChange = 64.0;
+
+        // Weight of a new score in the running mean of the scene
+        constexpr double kBaselineRate = 0.1;
+    }
+
+    SceneDetectProcessor::SceneDetectProcessor(AVRational time_base, const SceneDetectOptions &options)
+        : time_base_(time_base), options_(options)
+    {
+        options_.histogram_weight = std::clamp(options_.histogram_weight, 0.0, 1.0);
+    }
+
+    bool SceneDetectProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        if (!hasLumaPlane(frame))
+        {
+            last_error_ = "Scene detection needs frames with an 8-bit luma plane (decoded YUV or gray)";
+            std::cerr << last_error_ << std::endl;
+            return false;
+        }
+
+        static StageMetrics &metrics = PipelineMetrics::instance().stage("scene detect");
+        uint32_t histogram[kLumaHistogramBins] = {};
+        std::vector<uint8_t> &thumbnail = next_thumbnail_;
+        thumbnail.resize(static_cast<size_t>(frame->width / kLumaBlockSize) * (frame->height / kLumaBlockSize));
+
+        timeStage(metrics, frame_number, [&]
+                  {
+                      accumulateLumaHistogram(frame->data[0], frame->linesize[0], frame->width, frame->height, histogram);
+                      downsampleLuma(frame->data[0], frame->linesize[0], frame->width, frame->height, thumbnail.data());
+                      return true; });
+        metrics.addFrames(1);
+
+        int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+        if (pts == AV_NOPTS_VALUE)
+            pts = frame_number; // Timestamps are only used for ordering and the minimum scene length
+
+        // The first frame, and the first after a change of size, only set the reference
+        bool comparable = frame_count_ > 0 && frame->width == width_ && frame->height == height_;
+        if (!comparable)
+            last_cut_pts_ = pts;
+        else
+        {
+            double value = score(histogram, thumbnail, static_cast<int64_t>(frame->width) * frame->height);
+            double since_cut = av_q2d(time_base_) * static_cast<double>(pts - last_cut_pts_);
+
+            // A cut has to stand out from the motion within the scene as well
+            if (value >= options_.threshold && value - baseline_ >= options_.threshold / 2 &&
+                since_cut >= options_.min_scene_length)
+            {
+                SceneCut cut;
+                cut.pts = pts;
+                cut.time = av_q2d(time_base_) * static_cast<double>(pts);
+                cut.score = value;
+                cut.confidence = std::clamp((value - baseline_) / std::max(1.0 - baseline_, 1e-6), 0.0, 1.0);
+                cuts_.push_back(cut);
+                if (callback_)
+                    callback_(cut);
+
+                last_cut_pts_ = pts;
+                baseline_ = 0.0;
+            }
+            else
+                baseline_ += (value - baseline_) * kBaselineRate;
+        }
+
+        std::copy(std::begin(histogram), std::end(histogram), histogram_);
+        thumbnail_.swap(next_thumbnail_);
+        width_ = frame->width;
+        height_ = frame->height;
+        ++frame_count_;
+        return true;
+    }
+
+    void SceneDetectProcessor::reset()
+    {
+        cuts_.clear();
+        frame_count_ = 0;
+        std::fill(std::begin(histogram_), std::end(histogram_), 0);
+        thumbnail_.clear();
+        width_ = 0;
+        height_ = 0;
+        last_cut_pts_ = 0;
+        baseline_ = 0.0;
+        last_error_.clear();
+    }
+
+    double SceneDetectProcessor::score(const uint32_t *histogram, const std::vector<uint8_t> &thumbnail, int64_t pixels) const
+    {
+        // Histograms hold the same number of pixels, so half the L1 distance is the share that moved
+        uint64_t moved = 0;
+        for (int bin = 0; bin < kLumaHistogramBins; ++bin)
+            moved += histogram[bin] > histogram_[bin] ? histogram[bin] - histogram_[bin] : histogram_[bin] - histogram[bin];
+        double histogram_score = pixels > 0 ? static_cast<double>(moved) / (2.0 * static_cast<double>(pixels)) : 0.0;
+
+        double sad_score = 0.0;
+        if (!thumbnail.empty())
+        {
+            double mean = static_cast<double>(sumAbsDiff(thumbnail.data(), thumbnail_.data(), thumbnail.size())) /
+                          static_cast<double>(thumbnail.size());
+            sad_score = std::min(mean / kFullSadChange, 1.0);
+        }
+
+        return options_.histogram_weight * histogram_score + (1.0 - options_.histogram_weight) * sad_score;
+    }
+}
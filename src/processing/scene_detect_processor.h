@@ -0,0 +1,81 @@
+#pragma once
+
+#include <processing/frame_processor.h>
+#include <processing/luma_kernels.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/rational.h>
+}
+
+namespace video_codec
+{
+    struct SceneDetectOptions
+    {
+        double threshold{0.4};         // Score from which a frame starts a new scene (0.0 to 1.0)
+        double histogram_weight{0.5};  // Share of the histogram difference in the score, the rest is SAD
+        double min_scene_length{0.5};  // Seconds; cuts closer than this to the previous one are dropped
+    };
+
+    struct SceneCut
+    {
+        int64_t pts;       // First frame of the new scene (stream time base)
+        double time;       // Same in seconds
+        double score;      // Difference to the previous frame, 0.0 to 1.0
+        double confidence; // How far the score stands out from the motion within the scene, 0.0 to 1.0
+    };
+
+    // Shot boundary detection on the luma plane of decoded frames.
+    //
+    // Consecutive frames are compared by their luma histograms (global
+    // changes of brightness distribution) and by the SAD of 8x8 block
+    // thumbnails (changes of layout). Frames must be in their decoded
+    // YUV or gray format; there is no RGB conversion.
+    //
+    // Only the histogram and thumbnail of the previous frame are kept, so
+    // the processor works the same on every frame, on keyframes only or on
+    // low-resolution decodes (see VideoStream::processNativeFrames()).
+    class SceneDetectProcessor : public FrameProcessor
+    {
+    public:
+        explicit SceneDetectProcessor(AVRational time_base, const SceneDetectOptions &options = {});
+
+        bool processFrame(AVFrame *frame, int frame_number) override;
+
+        // Called for every cut as soon as it is detected
+        void setCutCallback(std::function<void(const SceneCut &)> callback) { callback_ = std::move(callback); }
+
+        const std::vector<SceneCut> &getCuts() const { return cuts_; }
+        int64_t getFrameCount() const { return frame_count_; }
+        const std::string &getLastError() const { return last_error_; }
+
+        // Forget the previous frame and the cuts
+        void reset();
+
+    private:
+        AVRational time_base_;
+        SceneDetectOptions options_;
+        std::function<void(const SceneCut &)> callback_;
+        std::vector<SceneCut> cuts_;
+        int64_t frame_count_{0};
+
+        // Previous frame
+        uint32_t histogram_[kLumaHistogramBins]{};
+        std::vector<uint8_t> thumbnail_;
+        std::vector<uint8_t> next_thumbnail_; // Reused for the current frame
+        int width_{0};
+        int height_{0};
+        int64_t last_cut_pts_{0};
+
+        // Running mean of the scores within the current scene
+        double baseline_{0.0};
+
+        std::string last_error_;
+
+        double score(const uint32_t *histogram, const std::vector<uint8_t> &thumbnail, int64_t pixels) const;
+    };
+}
@@ -1,4 +1,7 @@
 #include <processing/simple_frame_processor.h>
+#include <media/codec_cache.h>
+#include <profiling/memory_tracker.h>
+#include <profiling/pipeline_metrics.h>
 #include <filesystem>
 #include <sstream>
 #include <iomanip>
@@ -29,8 +32,7 @@ namespace video_codec
         }
 
         // Generate filename
-        std::ostringstream filename;
-        filename << output_dir_ << "/frame_" << std::setw(5) << std::setfill('0') << frame_number << "." << format_;
+        std::string filename = makeFilename(frame_number);
 
         // Debug frame information
         std::cout << "Processing frame: " << frame_number << std::endl;
@@ -38,6 +40,48 @@ namespace video_codec
         std::cout << "  Width: " << frame->width << std::endl;
         std::cout << "  Height: " << frame->height << std::endl;
 
+        if (!saveFrame(frame, filename))
+            return false;
+
+        std::cout << "Saved frame #" << frame_number << " to " << filename << std::endl;
+
+        return true;
+    }
+
+    bool FrameSaverProcessor::processFrames(std::span<AVFrame *> frames, int first_index)
+    {
+        int saved = 0;
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            // Only save frames at specified interval
+            int frame_number = first_index + static_cast<int>(i);
+            if (frame_number % save_interval_ != 0)
+                continue;
+
+            if (!saveFrame(frames[i], makeFilename(frame_number)))
+                return false;
+
+            saved++;
+        }
+
+        if (saved > 0)
+        {
+            std::cout << "Saved " << saved << " frames (#" << first_index << "-#"
+                      << first_index + frames.size() - 1 << ") to " << output_dir_ << std::endl;
+        }
+
+        return true;
+    }
+
+    std::string FrameSaverProcessor::makeFilename(int frame_number) const
+    {
+        std::ostringstream filename;
+        filename << output_dir_ << "/frame_" << std::setw(5) << std::setfill('0') << frame_number << "." << format_;
+        return filename.str();
+    }
+
+    bool FrameSaverProcessor::saveFrame(AVFrame *frame, const std::string &filename)
+    {
         // Check if frame data is valid
         if (!frame->data[0])
         {
@@ -67,6 +111,9 @@ namespace video_codec
             return false;
         }
 
+        static MemoryAccount &saver_memory = MemoryTracker::instance().account("frame saver");
+        MemoryTracker::instance().trackFrame(rgb_frame, saver_memory);
+
         // Make sure the frame data is writable
         ret = av_frame_make_writable(rgb_frame);
         if (ret < 0)
@@ -76,9 +123,6 @@ namespace video_codec
             return false;
         }
 
-        // Create swscale context
-        struct SwsContext *sws_ctx = nullptr;
-
         // Get source pixel format from frame
         AVPixelFormat src_pix_fmt = (AVPixelFormat)frame->format;
 
@@ -89,10 +133,12 @@ namespace video_codec
             src_pix_fmt = AV_PIX_FMT_YUV420P;
         }
 
-        sws_ctx = sws_getContext(
+        // The swscale context and the image encoder are reused across frames
+        CodecCache &cache = CodecCache::instance();
+        SwsContext *sws_ctx = cache.acquireScaler(
             frame->width, frame->height, src_pix_fmt,
             rgb_frame->width, rgb_frame->height, AV_PIX_FMT_RGB24,
-            SWS_BILINEAR, nullptr, nullptr, nullptr);
+            SWS_BILINEAR);
 
         if (!sws_ctx)
         {
@@ -106,22 +152,21 @@ namespace video_codec
             sws_ctx,
             (const uint8_t *const *)frame->data, frame->linesize, 0, frame->height,
             rgb_frame->data, rgb_frame->linesize);
+        cache.releaseScaler(sws_ctx);
 
         if (ret <= 0)
         {
             std::cerr << "Error scaling frame: " << ret << std::endl;
-            sws_freeContext(sws_ctx);
             av_frame_free(&rgb_frame);
             return false;
         }
 
         // Save as PNG (simpler approach using libpng or stb_image)
         // For this example, we'll write raw RGB data as a PPM file (simple format)
-        FILE *f = fopen(filename.str().c_str(), "wb");
+        FILE *f = fopen(filename.c_str(), "wb");
         if (!f)
         {
-            std::cerr << "Could not open output file: " << filename.str() << std::endl;
-            sws_freeContext(sws_ctx);
+            std::cerr << "Could not open output file: " << filename << std::endl;
             av_frame_free(&rgb_frame);
             return false;
         }
@@ -131,40 +176,12 @@ namespace video_codec
         {
             // Use FFmpeg encoding
             AVCodecID codec_id = (format_ == "png") ? AV_CODEC_ID_PNG : AV_CODEC_ID_MJPEG;
-            const AVCodec *codec = avcodec_find_encoder(codec_id);
-
-            if (!codec)
-            {
-                std::cerr << "Codec not found" << std::endl;
-                fclose(f);
-                sws_freeContext(sws_ctx);
-                av_frame_free(&rgb_frame);
-                return false;
-            }
-
-            AVCodecContext *codec_ctx = avcodec_alloc_context3(codec);
+            AVCodecContext *codec_ctx = cache.acquireImageEncoder(codec_id, rgb_frame->width, rgb_frame->height,
+                                                                  AV_PIX_FMT_RGB24);
             if (!codec_ctx)
-            {
-                std::cerr << "Could not allocate codec context" << std::endl;
-                fclose(f);
-                sws_freeContext(sws_ctx);
-                av_frame_free(&rgb_frame);
-                return false;
-            }
-
-            codec_ctx->width = rgb_frame->width;
-            codec_ctx->height = rgb_frame->height;
-            codec_ctx->pix_fmt = AV_PIX_FMT_RGB24;
-            codec_ctx->time_base = {1, 25};
-            codec_ctx->compression_level = 5; // Medium compression
-
-            ret = avcodec_open2(codec_ctx, codec, nullptr);
-            if (ret < 0)
             {
                 std::cerr << "Could not open codec" << std::endl;
-                avcodec_free_context(&codec_ctx);
                 fclose(f);
-                sws_freeContext(sws_ctx);
                 av_frame_free(&rgb_frame);
                 return false;
             }
@@ -173,9 +190,8 @@ namespace video_codec
             if (!pkt)
             {
                 std::cerr << "Could not allocate packet" << std::endl;
-                avcodec_free_context(&codec_ctx);
+                cache.releaseImageEncoder(codec_ctx);
                 fclose(f);
-                sws_freeContext(sws_ctx);
                 av_frame_free(&rgb_frame);
                 return false;
             }
@@ -187,7 +203,6 @@ namespace video_codec
                 av_packet_free(&pkt);
                 avcodec_free_context(&codec_ctx);
                 fclose(f);
-                sws_freeContext(sws_ctx);
                 av_frame_free(&rgb_frame);
                 return false;
             }
@@ -199,7 +214,6 @@ namespace video_codec
                 av_packet_free(&pkt);
                 avcodec_free_context(&codec_ctx);
                 fclose(f);
-                sws_freeContext(sws_ctx);
                 av_frame_free(&rgb_frame);
                 return false;
             }
@@ -207,9 +221,9 @@ namespace video_codec
             // Write encoded data to file
             fwrite(pkt->data, 1, pkt->size, f);
 
-            // Clean up encoding resources
+            // The encoder is idle again and can take the next image
             av_packet_free(&pkt);
-            avcodec_free_context(&codec_ctx);
+            cache.releaseImageEncoder(codec_ctx);
         }
         else
         {
@@ -226,25 +240,19 @@ namespace video_codec
         fclose(f);
 
         // Clean up
-        sws_freeContext(sws_ctx);
         av_frame_free(&rgb_frame);
 
-        std::cout << "Saved frame #" << frame_number << " to " << filename.str() << std::endl;
-
         return true;
     }
 
     FilterProcessor::FilterProcessor(const std::string &filter_desc, FrameProcessor *next_processor)
         : filter_desc_(filter_desc), next_processor_(next_processor)
     {
-        filtered_frame_ = av_frame_alloc();
     }
 
     FilterProcessor::~FilterProcessor()
     {
         cleanup();
-        if (filtered_frame_)
-            av_frame_free(&filtered_frame_);
     }
 
     bool FilterProcessor::initFilterGraph(int width, int height, AVPixelFormat pix_fmt)
@@ -334,6 +342,18 @@ namespace video_codec
     }
 
     bool FilterProcessor::processFrame(AVFrame *frame, int frame_number)
+    {
+        FramePtr frame_ref = refFrame(frame);
+        if (!frame_ref)
+        {
+            std::cerr << "Could not reference frame for filtering" << std::endl;
+            return false;
+        }
+
+        return consumeFrame(std::move(frame_ref), frame_number);
+    }
+
+    bool FilterProcessor::consumeFrame(FramePtr frame, int frame_number)
     {
         int ret;
 
@@ -347,38 +367,123 @@ namespace video_codec
             }
         }
 
-        // Push the frame into the filter graph
-        ret = av_buffersrc_add_frame_flags(buffersrc_ctx_, frame,
-                                           AV_BUFFERSRC_FLAG_KEEP_REF);
-        if (ret < 0)
+        std::vector<FramePtr> filtered;
         {
-            std::cerr << "Error while feeding the filter graph" << std::endl;
-            return false;
+            static StageMetrics &filter_metrics = PipelineMetrics::instance().stage("filter");
+            ScopedStageTimer timer(filter_metrics, frame_number);
+            filter_metrics.addFrames(1);
+
+            // Push the frame into the filter graph.
+            // The graph takes over our reference, so no extra ref or copy is made.
+            ret = av_buffersrc_add_frame_flags(buffersrc_ctx_, frame.get(), 0);
+            if (ret < 0)
+            {
+                std::cerr << "Error while feeding the filter graph" << std::endl;
+                return false;
+            }
+
+            // Pull filtered frames from the filter graph
+            if (!drainFilterGraph(filtered))
+                return false;
         }
 
-        // Pull filtered frames from the filter graph
-        ret = av_buffersink_get_frame(buffersink_ctx_, filtered_frame_);
-        if (ret < 0)
+        // Hand the filtered frames over to the next processor if any
+        for (auto &filtered_frame : filtered)
+        {
+            int output_number = output_frame_count_++;
+            if (next_processor_ && !next_processor_->consumeFrame(std::move(filtered_frame), output_number))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool FilterProcessor::processFrames(std::span<AVFrame *> frames, int first_index)
+    {
+        if (frames.empty())
+            return true;
+
+        // Initialize filter graph if needed
+        if (!initialized_)
         {
-            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            if (!initFilterGraph(frames[0]->width, frames[0]->height,
+                                 static_cast<AVPixelFormat>(frames[0]->format)))
             {
-                std::cerr << "Error while retrieving filtered frame" << std::endl;
                 return false;
             }
-            return true; // No output frame ready yet
         }
 
-        // Pass the filtered frame to the next processor if any
-        bool result = true;
-        if (next_processor_)
+        std::vector<FramePtr> filtered;
         {
-            result = next_processor_->processFrame(filtered_frame_, frame_number);
+            static StageMetrics &filter_metrics = PipelineMetrics::instance().stage("filter");
+            ScopedStageTimer timer(filter_metrics, first_index);
+            filter_metrics.addFrames(frames.size());
+
+            // Push the whole batch into the filter graph.
+            // The frames are borrowed, so the graph takes its own references.
+            for (AVFrame *frame : frames)
+            {
+                int ret = av_buffersrc_add_frame_flags(buffersrc_ctx_, frame,
+                                                       AV_BUFFERSRC_FLAG_KEEP_REF);
+                if (ret < 0)
+                {
+                    std::cerr << "Error while feeding the filter graph" << std::endl;
+                    return false;
+                }
+            }
+
+            // Pull filtered frames from the filter graph
+            if (!drainFilterGraph(filtered))
+                return false;
         }
 
-        // Unreference the filtered frame for reuse
-        av_frame_unref(filtered_frame_);
+        // Filters may drop or add frames, so output numbers are counted here
+        int output_index = output_frame_count_;
+        output_frame_count_ += static_cast<int>(filtered.size());
+
+        if (!next_processor_ || filtered.empty())
+            return true;
 
-        return result;
+        // Pass the filtered frames to the next processor as one batch
+        std::vector<AVFrame *> filtered_view;
+        filtered_view.reserve(filtered.size());
+        for (const auto &filtered_frame : filtered)
+            filtered_view.push_back(filtered_frame.get());
+
+        return next_processor_->processFrames(filtered_view, output_index);
+    }
+
+    bool FilterProcessor::drainFilterGraph(std::vector<FramePtr> &filtered)
+    {
+        while (true)
+        {
+            FramePtr filtered_frame = makeFrame();
+            if (!filtered_frame)
+            {
+                std::cerr << "Could not allocate filtered frame" << std::endl;
+                return false;
+            }
+
+            int ret = av_buffersink_get_frame(buffersink_ctx_, filtered_frame.get());
+            if (ret < 0)
+            {
+                if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                {
+                    std::cerr << "Error while retrieving filtered frame" << std::endl;
+                    return false;
+                }
+                return true; // No more output frame ready yet
+            }
+
+            static MemoryAccount &filter_memory = MemoryTracker::instance().account("filter");
+            if (!MemoryTracker::instance().trackFrame(filtered_frame.get(), filter_memory))
+            {
+                std::cerr << "Could not track filtered frame" << std::endl;
+                return false;
+            }
+
+            filtered.push_back(std::move(filtered_frame));
+        }
     }
 
     void FilterProcessor::cleanup()
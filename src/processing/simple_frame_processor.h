@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <filesystem>
+#include <vector>
 
 extern "C"
 {
@@ -28,6 +29,18 @@ namespace video_codec
 
             return true;
         }
+
+        // One line per batch instead of one per frame
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override
+        {
+            if (frames.empty())
+                return true;
+
+            std::cout << "Processing frames #" << first_index << "-#" << first_index + frames.size() - 1
+                      << " (size: " << frames[0]->width << "x" << frames[0]->height << ")" << std::endl;
+
+            return true;
+        }
     };
 
     // Frame saver processor - saves frames as image files
@@ -43,8 +56,14 @@ namespace video_codec
         }
 
         bool processFrame(AVFrame *frame, int frame_number) override;
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override;
 
     private:
+        // Encode the frame and write it to its image file
+        bool saveFrame(AVFrame *frame, const std::string &filename);
+
+        std::string makeFilename(int frame_number) const;
+
         std::string output_dir_;
         int save_interval_;
         std::string format_;
@@ -57,7 +76,14 @@ namespace video_codec
         FilterProcessor(const std::string &filter_desc, FrameProcessor *next_processor = nullptr);
         virtual ~FilterProcessor();
 
+        // Borrowed frames are referenced (no pixel copy for refcounted frames)
+        // and then consumed like owned ones
         bool processFrame(AVFrame *frame, int frame_number) override;
+        bool consumeFrame(FramePtr frame, int frame_number) override;
+
+        // Feeds the whole batch into the graph and forwards the filtered
+        // frames to the next processor as one batch
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override;
 
         // Add method to set next processor
         void setNextProcessor(FrameProcessor *next_processor)
@@ -69,14 +95,17 @@ namespace video_codec
         bool initFilterGraph(int width, int height, AVPixelFormat pix_fmt);
         void cleanup();
 
+        // Pull every frame the graph has ready into filtered
+        bool drainFilterGraph(std::vector<FramePtr> &filtered);
+
         FrameProcessor *next_processor_;
         std::string filter_desc_;
 
         AVFilterGraph *filter_graph_ = nullptr;
         AVFilterContext *buffersrc_ctx_ = nullptr;
         AVFilterContext *buffersink_ctx_ = nullptr;
-        AVFrame *filtered_frame_ = nullptr;
         bool initialized_ = false;
+        int output_frame_count_ = 0; // Frames forwarded so far, numbers the output
     };
 
     // Grayscale processor using FFmpeg filters
@@ -5,16 +5,32 @@ namespace video_codec
 {
     VideoWriterProcessor::VideoWriterProcessor(const std::string &output_filename,
                                                int width, int height, double fps,
-                                               const std::string &codec)
-        : writer_(std::make_unique<VideoWriter>())
+                                               const std::string &codec,
+                                               const AudioOutputSettings &audio,
+                                               int encoder_threads,
+                                               const SegmentedOutputSettings &segmented,
+                                               const VideoEncodeSettings &encode)
+        : writer_(std::make_unique<VideoWriter>()),
+          audio_mode_(audio.mode)
     {
-        if (writer_->open(output_filename, width, height, fps, codec))
+        writer_->setEncoderThreads(encoder_threads);
+        writer_->setSegmentedOutput(segmented);
+        writer_->setEncodeSettings(encode);
+        if (writer_->open(output_filename, width, height, fps, codec, audio))
         {
             initialized_ = true;
             std::cout << "VideoWriter opened successfully: " << output_filename << std::endl;
             std::cout << "  Resolution: " << width << "x" << height << std::endl;
             std::cout << "  FPS: " << fps << std::endl;
             std::cout << "  Codec: " << codec << std::endl;
+            if (encode.bit_rate > 0)
+                std::cout << "  Bit rate: " << encode.bit_rate / 1000 << " kb/s" << std::endl;
+            if (audio.mode == AudioOutputSettings::Mode::Encode)
+                std::cout << "  Audio: " << audio.codec << " " << audio.sample_rate << "Hz " << audio.channels << "ch" << std::endl;
+            else if (audio.mode == AudioOutputSettings::Mode::Copy)
+                std::cout << "  Audio: stream copy" << std::endl;
+            if (segmented.mode != SegmentedOutputSettings::Mode::None)
+                std::cout << "  Segments: " << segmented.segment_duration << "s" << std::endl;
         }
         else
             std::cerr << "Failed to open VideoWriter: " << writer_->getLastError() << std::endl;
@@ -51,6 +67,72 @@ namespace video_codec
         return true;
     }
 
+    bool VideoWriterProcessor::processFrames(std::span<AVFrame *> frames, int first_index)
+    {
+        if (!initialized_)
+        {
+            std::cerr << "VideoWriterProcessor not initialized" << std::endl;
+            return false;
+        }
+
+        if (finalized_)
+        {
+            std::cerr << "VideoWriterProcessor already finalized" << std::endl;
+            return false;
+        }
+
+        if (frames.empty())
+            return true;
+
+        std::cout << "Writing frames #" << first_index << "-#" << first_index + frames.size() - 1 << std::endl;
+
+        for (AVFrame *frame : frames)
+        {
+            if (!writer_->writeFrame(frame))
+            {
+                std::cerr << "Failed to write frame: " << writer_->getLastError() << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool VideoWriterProcessor::processAudioFrame(AVFrame *frame)
+    {
+        if (!initialized_ || finalized_)
+        {
+            std::cerr << "VideoWriterProcessor not ready for audio" << std::endl;
+            return false;
+        }
+
+        if (!writer_->writeAudioFrame(frame))
+        {
+            std::cerr << "Failed to write audio: " << writer_->getLastError() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool VideoWriterProcessor::processAudioPacket(AVPacket *packet, AVRational time_base)
+    {
+        if (!initialized_ || finalized_)
+        {
+            std::cerr << "VideoWriterProcessor not ready for audio" << std::endl;
+            av_packet_unref(packet);
+            return false;
+        }
+
+        if (!writer_->writeAudioPacket(packet, time_base))
+        {
+            std::cerr << "Failed to write audio packet: " << writer_->getLastError() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
     bool VideoWriterProcessor::finalize()
     {
         if (!initialized_)
@@ -64,6 +146,9 @@ namespace video_codec
         bool result = writer_->close();
         finalized_ = true;
 
+        if (writer_->getDroppedFrames() > 0)
+            std::cout << "Dropped " << writer_->getDroppedFrames() << " duplicate frames" << std::endl;
+
         if (result)
             std::cout << "Video output completed successfully" << std::endl;
         else
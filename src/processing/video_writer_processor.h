@@ -1,22 +1,39 @@
 #pragma once
 
+#include <processing/audio_processor.h>
 #include <processing/frame_processor.h>
 #include <media/video_writer.h>
 #include <memory>
 
 namespace video_codec
 {
-    class VideoWriterProcessor : public FrameProcessor
+    // 映像フレームと音声（フレームまたはコピーするパケット）を1つのファイルに書き込む
+    class VideoWriterProcessor : public FrameProcessor, public AudioProcessor
     {
     public:
         VideoWriterProcessor(const std::string &output_filename,
                              int width, int height, double fps = 30.0,
-                             const std::string &codec = "libx264");
+                             const std::string &codec = "libx264",
+                             const AudioOutputSettings &audio = {},
+                             int encoder_threads = 0,
+                             const SegmentedOutputSettings &segmented = {},
+                             const VideoEncodeSettings &encode = {});
 
         virtual ~VideoWriterProcessor();
 
         bool processFrame(AVFrame *frame, int frame_number) override;
 
+        // バッチ単位でフレームを書き込む（ログもバッチごとに1行）
+        bool processFrames(std::span<AVFrame *> frames, int first_index) override;
+
+        // 音声トラック（AudioOutputSettings の mode に従う）
+        bool processAudioFrame(AVFrame *frame) override;
+        bool acceptsPackets() const override { return audio_mode_ == AudioOutputSettings::Mode::Copy; }
+        bool processAudioPacket(AVPacket *packet, AVRational time_base) override;
+
+        // 直前と完全に同じフレームをエンコード前に捨てる（VideoWriter::setDropDuplicates）
+        void setDropDuplicates(bool drop_duplicates) { writer_->setDropDuplicates(drop_duplicates); }
+
         // 動画出力を終了
         bool finalize();
 
@@ -26,5 +43,6 @@ namespace video_codec
         std::unique_ptr<VideoWriter> writer_;
         bool initialized_{false};
         bool finalized_{false};
+        AudioOutputSettings::Mode audio_mode_{AudioOutputSettings::Mode::None};
     };
 }
\ No newline at end of file
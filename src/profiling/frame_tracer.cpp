@@ -0,0 +1,142 @@
+#include <profiling/frame_tracer.h>
+#include <profiling/pipeline_metrics.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace video_codec
+{
+    namespace
+    {
+        thread_local std::string current_thread_name;
+    }
+
+    thread_local FrameTracer::ThreadBuffer *FrameTracer::current_buffer_ = nullptr;
+
+    FrameTracer &FrameTracer::instance()
+    {
+        static FrameTracer tracer;
+        return tracer;
+    }
+
+    void FrameTracer::setBufferCapacity(size_t events_per_thread)
+    {
+        capacity_.store(events_per_thread > 0 ? events_per_thread : 1, std::memory_order_relaxed);
+    }
+
+    void FrameTracer::setThreadName(const std::string &name)
+    {
+        current_thread_name = name;
+
+        // Rename a thread that is already on the timeline
+        if (current_buffer_)
+        {
+            FrameTracer &tracer = instance();
+            std::lock_guard<std::mutex> lock(tracer.mutex_);
+            current_buffer_->thread_name = name;
+        }
+    }
+
+    FrameTracer::ThreadBuffer &FrameTracer::currentBuffer()
+    {
+        if (!current_buffer_)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto buffer = std::make_unique<ThreadBuffer>(static_cast<uint32_t>(buffers_.size() + 1),
+                                                         capacity_.load(std::memory_order_relaxed));
+            buffer->thread_name = current_thread_name.empty()
+                                      ? "thread " + std::to_string(buffer->tid)
+                                      : current_thread_name;
+            current_buffer_ = buffer.get();
+            buffers_.push_back(std::move(buffer));
+        }
+        return *current_buffer_;
+    }
+
+    void FrameTracer::record(const char *name, int64_t frame_number,
+                             std::chrono::steady_clock::time_point begin,
+                             std::chrono::steady_clock::time_point end)
+    {
+        ThreadBuffer &buffer = currentBuffer();
+
+        // Single writer per ring: only the owning thread advances written
+        uint64_t index = buffer.written.load(std::memory_order_relaxed);
+        TraceEvent &event = buffer.events[index % buffer.events.size()];
+        event.name = name;
+        event.frame_number = frame_number;
+        event.begin_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch_).count();
+        event.end_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - epoch_).count();
+        buffer.written.store(index + 1, std::memory_order_release);
+    }
+
+    uint64_t FrameTracer::getDroppedEvents() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t dropped = 0;
+        for (const auto &buffer : buffers_)
+        {
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            if (written > buffer->events.size())
+                dropped += written - buffer->events.size();
+        }
+        return dropped;
+    }
+
+    bool FrameTracer::writeChromeTrace(const std::string &filename) const
+    {
+        std::ofstream file(filename);
+        if (!file)
+        {
+            std::cerr << "Could not open trace file: " << filename << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Timestamps are in microseconds
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"video_codec\"}}";
+
+        for (const auto &buffer : buffers_)
+        {
+            file << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->tid
+                 << ", \"args\": {\"name\": \"" << escapeJson(buffer->thread_name) << "\"}}";
+
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            size_t capacity = buffer->events.size();
+            uint64_t first = written > capacity ? written - capacity : 0;
+
+            for (uint64_t i = first; i < written; ++i)
+            {
+                const TraceEvent &event = buffer->events[i % capacity];
+                file << ",\n{\"name\": \"" << escapeJson(event.name) << "\", \"cat\": \"pipeline\", \"ph\": \"X\""
+                     << ", \"ts\": " << event.begin_ns / 1e3
+                     << ", \"dur\": " << (event.end_ns - event.begin_ns) / 1e3
+                     << ", \"pid\": 1, \"tid\": " << buffer->tid;
+                if (event.frame_number >= 0)
+                    file << ", \"args\": {\"frame\": " << event.frame_number << "}";
+                file << "}";
+            }
+        }
+
+        file << "\n]}\n";
+        return static_cast<bool>(file);
+    }
+
+    ScopedTrace::ScopedTrace(const char *name, int64_t frame_number)
+        : frame_number_(frame_number)
+    {
+        if (!FrameTracer::instance().isEnabled())
+            return;
+
+        name_ = name;
+        begin_ = std::chrono::steady_clock::now();
+    }
+
+    ScopedTrace::~ScopedTrace()
+    {
+        if (name_)
+            FrameTracer::instance().record(name_, frame_number_, begin_, std::chrono::steady_clock::now());
+    }
+}
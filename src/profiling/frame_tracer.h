@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace video_codec
+{
+    // One completed span on a thread's timeline
+    struct TraceEvent
+    {
+        const char *name{nullptr}; // Must outlive the tracer (literals, StageMetrics::name)
+        int64_t frame_number{-1};  // -1 when the span is not tied to a frame
+        int64_t begin_ns{0};       // steady_clock time
+        int64_t end_ns{0};
+    };
+
+    // Opt-in timeline of per-frame stage spans, exported as Chrome trace JSON
+    // (chrome://tracing, https://ui.perfetto.dev).
+    //
+    // Every thread writes into its own fixed-size ring buffer, so recording
+    // takes no lock and never allocates after the first event of a thread.
+    // When a ring is full the oldest events are overwritten. ScopedStageTimer
+    // records a span for every instrumented stage while tracing is enabled.
+    //
+    // Export once the pipeline is idle; events written concurrently with
+    // writeChromeTrace() may be torn.
+    class FrameTracer
+    {
+    public:
+        static FrameTracer &instance();
+
+        // Not Allowed to copy
+        FrameTracer(const FrameTracer &) = delete;
+        FrameTracer &operator=(const FrameTracer &) = delete;
+
+        void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+        bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // Events kept per thread; applies to threads that have not recorded yet
+        void setBufferCapacity(size_t events_per_thread);
+
+        // Label of the calling thread in the exported timeline
+        static void setThreadName(const std::string &name);
+
+        void record(const char *name, int64_t frame_number,
+                    std::chrono::steady_clock::time_point begin,
+                    std::chrono::steady_clock::time_point end);
+
+        // Events lost to ring buffer wrap-around
+        uint64_t getDroppedEvents() const;
+
+        bool writeChromeTrace(const std::string &filename) const;
+
+    private:
+        struct ThreadBuffer
+        {
+            ThreadBuffer(uint32_t thread_id, size_t capacity) : tid(thread_id), events(capacity) {}
+
+            const uint32_t tid;
+            std::string thread_name;
+            std::vector<TraceEvent> events;
+            std::atomic<uint64_t> written{0};
+        };
+
+        FrameTracer() = default;
+
+        ThreadBuffer &currentBuffer();
+
+        static thread_local ThreadBuffer *current_buffer_;
+
+        std::atomic<bool> enabled_{false};
+        std::atomic<size_t> capacity_{1 << 16};
+        const std::chrono::steady_clock::time_point epoch_{std::chrono::steady_clock::now()};
+
+        // Buffers live as long as the tracer, so threads may exit before export
+        mutable std::mutex mutex_;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    };
+
+    // Records the enclosing scope as one span while tracing is enabled.
+    // For work that is not a metrics stage (ScopedStageTimer traces those).
+    class ScopedTrace
+    {
+    public:
+        explicit ScopedTrace(const char *name, int64_t frame_number = -1);
+        ~ScopedTrace();
+
+        // Not Allowed to copy
+        ScopedTrace(const ScopedTrace &) = delete;
+        ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+    private:
+        const char *name_{nullptr};
+        int64_t frame_number_;
+        std::chrono::steady_clock::time_point begin_;
+    };
+}
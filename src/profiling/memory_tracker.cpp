@@ -0,0 +1,266 @@
+#include <profiling/memory_tracker.h>
+#include <profiling/pipeline_metrics.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <sys/resource.h>
+
+namespace video_codec
+{
+    namespace
+    {
+        void atomicMax(std::atomic<int64_t> &target, int64_t value)
+        {
+            int64_t current = target.load(std::memory_order_relaxed);
+            while (value > current &&
+                   !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+
+    // Wrapper buffer that keeps the original reference alive
+    struct MemoryTracker::TrackedBuffer
+    {
+        AVBufferRef *inner;
+        MemoryAccount *account;
+        int64_t size;
+    };
+
+    MemoryTracker &MemoryTracker::instance()
+    {
+        static MemoryTracker tracker;
+        return tracker;
+    }
+
+    MemoryAccount &MemoryTracker::account(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &account : accounts_)
+        {
+            if (account.name == name)
+                return account;
+        }
+        return accounts_.emplace_back(name);
+    }
+
+    void MemoryTracker::charge(MemoryAccount &account, int64_t bytes)
+    {
+        int64_t account_bytes = account.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t total_bytes = live_bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+        if (bytes > 0)
+        {
+            atomicMax(account.peak_bytes, account_bytes);
+            atomicMax(peak_bytes_, total_bytes);
+        }
+        else
+        {
+            // Wake producers waiting for room
+            std::lock_guard<std::mutex> lock(room_mutex_);
+            room_.notify_all();
+        }
+    }
+
+    bool MemoryTracker::trackBuffer(AVBufferRef **buffer, MemoryAccount &account)
+    {
+        AVBufferRef *inner = *buffer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!tracked_data_.insert(inner->data).second)
+                return true; // Charged to the stage that allocated it
+        }
+
+        auto *tracked = new TrackedBuffer{inner, &account, static_cast<int64_t>(inner->size)};
+
+        // A shared buffer must stay read-only behind the wrapper, or
+        // av_frame_make_writable() would write into it
+        int flags = av_buffer_is_writable(inner) ? 0 : AV_BUFFER_FLAG_READONLY;
+        AVBufferRef *wrapper = av_buffer_create(inner->data, inner->size, releaseTrackedBuffer, tracked, flags);
+        if (!wrapper)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tracked_data_.erase(inner->data);
+            delete tracked;
+            return false;
+        }
+
+        account.live_buffers.fetch_add(1, std::memory_order_relaxed);
+        account.total_buffers.fetch_add(1, std::memory_order_relaxed);
+        charge(account, tracked->size);
+
+        *buffer = wrapper;
+        return true;
+    }
+
+    void MemoryTracker::releaseTrackedBuffer(void *opaque, uint8_t *)
+    {
+        auto *tracked = static_cast<TrackedBuffer *>(opaque);
+        MemoryTracker &tracker = instance();
+
+        {
+            std::lock_guard<std::mutex> lock(tracker.mutex_);
+            tracker.tracked_data_.erase(tracked->inner->data);
+        }
+
+        tracked->account->live_buffers.fetch_sub(1, std::memory_order_relaxed);
+        tracker.charge(*tracked->account, -tracked->size);
+
+        av_buffer_unref(&tracked->inner);
+        delete tracked;
+    }
+
+    bool MemoryTracker::trackFrame(AVFrame *frame, MemoryAccount &account)
+    {
+        if (!isEnabled() || !frame)
+            return true;
+
+        for (AVBufferRef *&buffer : frame->buf)
+        {
+            if (buffer && !trackBuffer(&buffer, account))
+                return false;
+        }
+
+        for (int i = 0; i < frame->nb_extended_buf; ++i)
+        {
+            if (!trackBuffer(&frame->extended_buf[i], account))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool MemoryTracker::trackPacket(AVPacket *packet, MemoryAccount &account)
+    {
+        if (!isEnabled() || !packet || !packet->buf)
+            return true;
+
+        return trackBuffer(&packet->buf, account);
+    }
+
+    void MemoryTracker::adjustEstimate(MemoryAccount &account, int64_t delta_bytes)
+    {
+        if (delta_bytes != 0)
+            charge(account, delta_bytes);
+    }
+
+    bool MemoryTracker::isOverBudget() const
+    {
+        int64_t budget = getBudget();
+        return budget > 0 && getLiveBytes() > budget;
+    }
+
+    bool MemoryTracker::waitForRoom(int64_t bytes)
+    {
+        int64_t budget = getBudget();
+        if (!isEnabled() || budget <= 0)
+            return true;
+
+        auto fits = [&]
+        { return getLiveBytes() + bytes <= budget; };
+        if (fits())
+        {
+            saturated_.store(false, std::memory_order_relaxed);
+            return true;
+        }
+
+        // Nothing to wait for when the request alone exceeds the budget, or
+        // when the last wait already timed out without anything being freed
+        bool result = false;
+        if (getLiveBytes() > 0 && !saturated_.load(std::memory_order_relaxed))
+        {
+            static StageMetrics &wait_metrics = PipelineMetrics::instance().stage("memory budget wait");
+            ScopedStageTimer timer(wait_metrics);
+
+            std::unique_lock<std::mutex> lock(room_mutex_);
+            result = room_.wait_for(lock, std::chrono::milliseconds(max_wait_ms_.load(std::memory_order_relaxed)), fits);
+        }
+
+        if (!result)
+        {
+            saturated_.store(true, std::memory_order_relaxed);
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    void MemoryTracker::resetPeaks()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &account : accounts_)
+        {
+            account.peak_bytes.store(account.live_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            account.total_buffers.store(0, std::memory_order_relaxed);
+        }
+        peak_bytes_.store(getLiveBytes(), std::memory_order_relaxed);
+        overruns_.store(0, std::memory_order_relaxed);
+        saturated_.store(false, std::memory_order_relaxed);
+    }
+
+    void MemoryTracker::printSummary(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        out << std::left << std::setw(28) << "memory"
+            << std::right << std::setw(12) << "live MB"
+            << std::setw(12) << "peak MB"
+            << std::setw(12) << "buffers" << std::endl;
+
+        out << std::fixed << std::setprecision(1);
+        for (const auto &account : accounts_)
+        {
+            out << std::left << std::setw(28) << account.name
+                << std::right << std::setw(12) << account.live_bytes.load(std::memory_order_relaxed) / 1048576.0
+                << std::setw(12) << account.peak_bytes.load(std::memory_order_relaxed) / 1048576.0
+                << std::setw(12) << account.total_buffers.load(std::memory_order_relaxed) << std::endl;
+        }
+
+        out << std::left << std::setw(28) << "total tracked"
+            << std::right << std::setw(12) << getLiveBytes() / 1048576.0
+            << std::setw(12) << getPeakBytes() / 1048576.0 << std::endl;
+        if (getBudget() > 0)
+            out << "budget " << getBudget() / 1048576.0 << " MB, " << getOverruns() << " overruns" << std::endl;
+        out << "peak RSS " << peakRssBytes() / 1048576.0 << " MB" << std::endl;
+        out << std::defaultfloat;
+    }
+
+    std::string MemoryTracker::toJson() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream out;
+
+        out << "{\"live_bytes\": " << getLiveBytes()
+            << ", \"peak_bytes\": " << getPeakBytes()
+            << ", \"budget_bytes\": " << getBudget()
+            << ", \"overruns\": " << getOverruns()
+            << ", \"peak_rss_bytes\": " << peakRssBytes()
+            << ", \"accounts\": [";
+
+        bool first = true;
+        for (const auto &account : accounts_)
+        {
+            out << (first ? "" : ", ");
+            first = false;
+
+            out << "{\"name\": \"" << escapeJson(account.name) << "\""
+                << ", \"live_bytes\": " << account.live_bytes.load(std::memory_order_relaxed)
+                << ", \"peak_bytes\": " << account.peak_bytes.load(std::memory_order_relaxed)
+                << ", \"buffers\": " << account.total_buffers.load(std::memory_order_relaxed) << "}";
+        }
+        out << "]}";
+
+        return out.str();
+    }
+
+    int64_t peakRssBytes()
+    {
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+#if defined(__APPLE__)
+        return usage.ru_maxrss; // bytes
+#else
+        return static_cast<int64_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+    }
+}
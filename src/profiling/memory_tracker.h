@@ -0,0 +1,126 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+}
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+
+namespace video_codec
+{
+    // Live bytes and buffers attributed to one owning stage
+    struct MemoryAccount
+    {
+        explicit MemoryAccount(const std::string &account_name) : name(account_name) {}
+
+        const std::string name;
+        std::atomic<int64_t> live_bytes{0};
+        std::atomic<int64_t> peak_bytes{0};
+        std::atomic<int64_t> live_buffers{0};
+        std::atomic<uint64_t> total_buffers{0};
+    };
+
+    // Accounting of frame and packet buffers by owning stage, plus a
+    // process-wide memory budget.
+    //
+    // trackFrame()/trackPacket() wrap the buffers of a frame or packet so
+    // that their bytes are charged to an account until the last reference,
+    // wherever it ends up (queues, filter graphs, muxer interleaving), is
+    // dropped. Buffers already tracked stay with the account that saw them
+    // first, i.e. the stage that allocated them. Memory owned privately by
+    // a library (encoder lookahead) is reported with adjustEstimate().
+    //
+    // Producers call waitForRoom() before allocating; it blocks while the
+    // budget is exceeded so consumers on other threads can drain. The wait
+    // is bounded, because in a single-threaded chain nothing else would free
+    // memory; exceeding the budget anyway is counted as an overrun. After a
+    // timed-out wait, later calls return at once until the request fits
+    // again, so such a chain is not stalled on every frame.
+    class MemoryTracker
+    {
+    public:
+        static MemoryTracker &instance();
+
+        // Not Allowed to copy
+        MemoryTracker(const MemoryTracker &) = delete;
+        MemoryTracker &operator=(const MemoryTracker &) = delete;
+
+        // Disabled trackers leave buffers untouched
+        void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+        bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // Budget in bytes, 0 for none
+        void setBudget(int64_t bytes) { budget_bytes_.store(bytes, std::memory_order_relaxed); }
+        int64_t getBudget() const { return budget_bytes_.load(std::memory_order_relaxed); }
+
+        // Longest wait in waitForRoom() before giving up
+        void setMaxWait(std::chrono::milliseconds max_wait) { max_wait_ms_.store(max_wait.count(), std::memory_order_relaxed); }
+
+        // Account by name, created on first use. References stay valid.
+        MemoryAccount &account(const std::string &name);
+
+        // Charge the buffers of frame/packet to account
+        bool trackFrame(AVFrame *frame, MemoryAccount &account);
+        bool trackPacket(AVPacket *packet, MemoryAccount &account);
+
+        // Add (or with a negative delta remove) bytes that cannot be tracked
+        // per buffer; callers undo their own estimates
+        void adjustEstimate(MemoryAccount &account, int64_t delta_bytes);
+
+        // Wait until bytes more fit into the budget (see class comment).
+        // Returns false if the budget is overrun (wait timed out or skipped).
+        bool waitForRoom(int64_t bytes);
+
+        // True while tracked memory exceeds the budget
+        bool isOverBudget() const;
+
+        int64_t getLiveBytes() const { return live_bytes_.load(std::memory_order_relaxed); }
+        int64_t getPeakBytes() const { return peak_bytes_.load(std::memory_order_relaxed); }
+        uint64_t getOverruns() const { return overruns_.load(std::memory_order_relaxed); }
+
+        // Clear peaks and counters (live bytes stay)
+        void resetPeaks();
+
+        // Per-account table and JSON object, including the process peak RSS
+        void printSummary(std::ostream &out) const;
+        std::string toJson() const;
+
+    private:
+        struct TrackedBuffer;
+
+        MemoryTracker() = default;
+
+        bool trackBuffer(AVBufferRef **buffer, MemoryAccount &account);
+        void charge(MemoryAccount &account, int64_t bytes);
+        static void releaseTrackedBuffer(void *opaque, uint8_t *data);
+
+        std::atomic<bool> enabled_{false};
+        std::atomic<int64_t> budget_bytes_{0};
+        std::atomic<int64_t> max_wait_ms_{100};
+        std::atomic<int64_t> live_bytes_{0};
+        std::atomic<int64_t> peak_bytes_{0};
+        std::atomic<uint64_t> overruns_{0};
+        std::atomic<bool> saturated_{false};
+
+        mutable std::mutex mutex_;
+        std::deque<MemoryAccount> accounts_;
+        std::unordered_set<const uint8_t *> tracked_data_;
+
+        std::mutex room_mutex_;
+        std::condition_variable room_;
+    };
+
+    // Peak resident set size of the process in bytes
+    int64_t peakRssBytes();
+}
@@ -0,0 +1,360 @@
+#include <profiling/pipeline_metrics.h>
+#include <profiling/frame_tracer.h>
+#include <profiling/memory_tracker.h>
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace video_codec
+{
+    namespace
+    {
+        int bucketOf(uint64_t value)
+        {
+            return std::min(static_cast<int>(std::bit_width(value)), Log2Histogram::kBuckets - 1);
+        }
+
+        uint64_t bucketUpperBound(int bucket)
+        {
+            return bucket == 0 ? 0 : (uint64_t{1} << bucket) - 1;
+        }
+
+        void atomicMax(std::atomic<uint64_t> &target, uint64_t value)
+        {
+            uint64_t current = target.load(std::memory_order_relaxed);
+            while (value > current &&
+                   !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void writeHistogramJson(std::ostream &out, const Log2Histogram &histogram)
+        {
+            out << "{\"count\": " << histogram.getCount()
+                << ", \"mean\": " << histogram.getMean()
+                << ", \"p50\": " << histogram.getPercentile(0.5)
+                << ", \"p90\": " << histogram.getPercentile(0.9)
+                << ", \"p99\": " << histogram.getPercentile(0.99)
+                << ", \"max\": " << histogram.getMax() << "}";
+        }
+    }
+
+    std::string escapeJson(const std::string &text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            switch (c)
+            {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                }
+                else
+                    escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    void Log2Histogram::record(uint64_t value)
+    {
+        buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        atomicMax(max_, value);
+    }
+
+    void Log2Histogram::reset()
+    {
+        for (auto &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+        count_.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+    double Log2Histogram::getMean() const
+    {
+        uint64_t count = getCount();
+        return count > 0 ? static_cast<double>(getSum()) / count : 0.0;
+    }
+
+    uint64_t Log2Histogram::getPercentile(double p) const
+    {
+        uint64_t count = getCount();
+        if (count == 0)
+            return 0;
+
+        uint64_t rank = static_cast<uint64_t>(std::clamp(p, 0.0, 1.0) * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            uint64_t in_bucket = buckets_[i].load(std::memory_order_relaxed);
+            if (seen + in_bucket >= rank)
+            {
+                // Interpolate linearly inside the bucket
+                uint64_t lower = i == 0 ? 0 : uint64_t{1} << (i - 1);
+                uint64_t upper = std::min(bucketUpperBound(i), getMax());
+                double fraction = static_cast<double>(rank - seen) / in_bucket;
+                return lower + static_cast<uint64_t>(fraction * (upper > lower ? upper - lower : 0));
+            }
+            seen += in_bucket;
+        }
+        return getMax();
+    }
+
+    PipelineMetrics &PipelineMetrics::instance()
+    {
+        static PipelineMetrics metrics;
+        return metrics;
+    }
+
+    void PipelineMetrics::setEnabled(bool enabled)
+    {
+        if (enabled && !isEnabled())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            run_start_ = std::chrono::steady_clock::now();
+        }
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    StageMetrics &PipelineMetrics::stage(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &stage : stages_)
+        {
+            if (stage.name == name)
+                return stage;
+        }
+        return stages_.emplace_back(name);
+    }
+
+    QueueMetrics &PipelineMetrics::queue(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &queue : queues_)
+        {
+            if (queue.name == name)
+                return queue;
+        }
+        return queues_.emplace_back(name);
+    }
+
+    void PipelineMetrics::reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &stage : stages_)
+        {
+            stage.calls.store(0, std::memory_order_relaxed);
+            stage.wall_ns.store(0, std::memory_order_relaxed);
+            stage.cpu_ns.store(0, std::memory_order_relaxed);
+            stage.frames.store(0, std::memory_order_relaxed);
+            stage.bytes_read.store(0, std::memory_order_relaxed);
+            stage.bytes_written.store(0, std::memory_order_relaxed);
+            stage.latency_ns.reset();
+        }
+        for (auto &queue : queues_)
+            queue.depth_samples.reset();
+
+        run_start_ = std::chrono::steady_clock::now();
+    }
+
+    double PipelineMetrics::getRunSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start_).count();
+    }
+
+    void PipelineMetrics::printSummary(std::ostream &out) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double run_seconds = getRunSeconds();
+
+        out << "\nPipeline metrics (" << std::fixed << std::setprecision(3) << run_seconds << " s run)" << std::endl;
+        out << std::left << std::setw(28) << "stage"
+            << std::right << std::setw(9) << "calls"
+            << std::setw(9) << "frames"
+            << std::setw(11) << "wall ms"
+            << std::setw(11) << "cpu ms"
+            << std::setw(8) << "wall%"
+            << std::setw(10) << "mean us"
+            << std::setw(10) << "p50 us"
+            << std::setw(10) << "p99 us"
+            << std::setw(10) << "max us"
+            << std::setw(10) << "MB in"
+            << std::setw(10) << "MB out" << std::endl;
+
+        for (const auto &stage : stages_)
+        {
+            uint64_t calls = stage.calls.load(std::memory_order_relaxed);
+            if (calls == 0 && stage.frames.load(std::memory_order_relaxed) == 0)
+                continue;
+
+            double wall_ms = stage.wall_ns.load(std::memory_order_relaxed) / 1e6;
+            out << std::left << std::setw(28) << stage.name
+                << std::right << std::setw(9) << calls
+                << std::setw(9) << stage.frames.load(std::memory_order_relaxed)
+                << std::setprecision(1)
+                << std::setw(11) << wall_ms
+                << std::setw(11) << stage.cpu_ns.load(std::memory_order_relaxed) / 1e6
+                << std::setw(8) << (run_seconds > 0 ? wall_ms / (run_seconds * 10.0) : 0.0)
+                << std::setw(10) << stage.latency_ns.getMean() / 1e3
+                << std::setw(10) << stage.latency_ns.getPercentile(0.5) / 1e3
+                << std::setw(10) << stage.latency_ns.getPercentile(0.99) / 1e3
+                << std::setw(10) << stage.latency_ns.getMax() / 1e3
+                << std::setprecision(2)
+                << std::setw(10) << stage.bytes_read.load(std::memory_order_relaxed) / 1e6
+                << std::setw(10) << stage.bytes_written.load(std::memory_order_relaxed) / 1e6 << std::endl;
+        }
+
+        bool header_printed = false;
+        for (const auto &queue : queues_)
+        {
+            if (queue.depth_samples.getCount() == 0)
+                continue;
+
+            if (!header_printed)
+            {
+                out << std::left << std::setw(28) << "queue"
+                    << std::right << std::setw(9) << "samples"
+                    << std::setw(10) << "mean"
+                    << std::setw(10) << "p99"
+                    << std::setw(10) << "max" << std::endl;
+                header_printed = true;
+            }
+
+            out << std::left << std::setw(28) << queue.name
+                << std::right << std::setw(9) << queue.depth_samples.getCount()
+                << std::setprecision(1)
+                << std::setw(10) << queue.depth_samples.getMean()
+                << std::setw(10) << queue.depth_samples.getPercentile(0.99)
+                << std::setw(10) << queue.depth_samples.getMax() << std::endl;
+        }
+
+        out << std::defaultfloat;
+
+        if (MemoryTracker::instance().isEnabled())
+            MemoryTracker::instance().printSummary(out);
+    }
+
+    std::string PipelineMetrics::toJson() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ostringstream out;
+
+        out << "{\n  \"run_seconds\": " << getRunSeconds() << ",\n  \"stages\": [";
+        bool first = true;
+        for (const auto &stage : stages_)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "    {\"name\": \"" << escapeJson(stage.name) << "\""
+                << ", \"calls\": " << stage.calls.load(std::memory_order_relaxed)
+                << ", \"frames\": " << stage.frames.load(std::memory_order_relaxed)
+                << ", \"wall_ns\": " << stage.wall_ns.load(std::memory_order_relaxed)
+                << ", \"cpu_ns\": " << stage.cpu_ns.load(std::memory_order_relaxed)
+                << ", \"bytes_read\": " << stage.bytes_read.load(std::memory_order_relaxed)
+                << ", \"bytes_written\": " << stage.bytes_written.load(std::memory_order_relaxed)
+                << ", \"latency_ns\": ";
+            writeHistogramJson(out, stage.latency_ns);
+            out << "}";
+        }
+        out << "\n  ],\n  \"queues\": [";
+
+        first = true;
+        for (const auto &queue : queues_)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "    {\"name\": \"" << escapeJson(queue.name) << "\", \"depth\": ";
+            writeHistogramJson(out, queue.depth_samples);
+            out << "}";
+        }
+        out << "\n  ]";
+
+        if (MemoryTracker::instance().isEnabled())
+            out << ",\n  \"memory\": " << MemoryTracker::instance().toJson();
+        out << "\n}\n";
+
+        return out.str();
+    }
+
+    bool PipelineMetrics::writeJson(const std::string &filename) const
+    {
+        std::ofstream file(filename);
+        if (!file)
+        {
+            std::cerr << "Could not open metrics file: " << filename << std::endl;
+            return false;
+        }
+
+        file << toJson();
+        return static_cast<bool>(file);
+    }
+
+    ScopedStageTimer::ScopedStageTimer(StageMetrics &stage, int64_t frame_number)
+        : frame_number_(frame_number)
+    {
+        measure_ = PipelineMetrics::instance().isEnabled();
+        trace_ = FrameTracer::instance().isEnabled();
+        if (!measure_ && !trace_)
+            return;
+
+        stage_ = &stage;
+        wall_start_ = std::chrono::steady_clock::now();
+        if (measure_)
+            cpu_start_ns_ = threadCpuTimeNs();
+    }
+
+    ScopedStageTimer::~ScopedStageTimer()
+    {
+        if (!stage_)
+            return;
+
+        auto wall_end = std::chrono::steady_clock::now();
+        if (trace_)
+            FrameTracer::instance().record(stage_->name.c_str(), frame_number_, wall_start_, wall_end);
+        if (!measure_)
+            return;
+
+        uint64_t wall_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(wall_end - wall_start_).count());
+        uint64_t cpu_ns = threadCpuTimeNs() - cpu_start_ns_;
+
+        stage_->calls.fetch_add(1, std::memory_order_relaxed);
+        stage_->wall_ns.fetch_add(wall_ns, std::memory_order_relaxed);
+        stage_->cpu_ns.fetch_add(cpu_ns, std::memory_order_relaxed);
+        stage_->latency_ns.record(wall_ns);
+    }
+
+    uint64_t threadCpuTimeNs()
+    {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+        // Process CPU time where per-thread clocks are unavailable
+        return static_cast<uint64_t>(std::clock()) * (1000000000ull / CLOCKS_PER_SEC);
+    }
+}
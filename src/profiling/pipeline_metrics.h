@@ -0,0 +1,189 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace video_codec
+{
+    // Lock-free histogram with power-of-two buckets.
+    // Bucket i holds values in [2^(i-1), 2^i), bucket 0 holds 0.
+    class Log2Histogram
+    {
+    public:
+        static constexpr int kBuckets = 48;
+
+        void record(uint64_t value);
+        void reset();
+
+        uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+        uint64_t getSum() const { return sum_.load(std::memory_order_relaxed); }
+        uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+        double getMean() const;
+
+        // Estimate of the p-th percentile (0..1), interpolated inside its bucket
+        uint64_t getPercentile(double p) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> max_{0};
+    };
+
+    // Counters of one pipeline stage (demux, decode, sws, encode, mux, a processor, ...).
+    // Updated from any thread; each timed call adds one latency sample.
+    // The add functions do nothing while metrics are disabled.
+    struct StageMetrics
+    {
+        explicit StageMetrics(const std::string &stage_name) : name(stage_name) {}
+
+        void addFrames(uint64_t count);
+        void addBytesRead(uint64_t count);
+        void addBytesWritten(uint64_t count);
+
+        const std::string name;
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> wall_ns{0};
+        std::atomic<uint64_t> cpu_ns{0};
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> bytes_read{0};
+        std::atomic<uint64_t> bytes_written{0};
+        Log2Histogram latency_ns;
+    };
+
+    // Depth samples of a queue, taken whenever an item is pushed
+    struct QueueMetrics
+    {
+        explicit QueueMetrics(const std::string &queue_name) : name(queue_name) {}
+
+        void recordDepth(size_t depth);
+
+        const std::string name;
+        Log2Histogram depth_samples;
+    };
+
+    // Process-wide registry of stage and queue metrics.
+    //
+    // Disabled by default; instrumented code then pays one relaxed atomic
+    // load per call site. Stages are created on first use and never removed,
+    // so call sites cache the reference in a function-local static:
+    //
+    //     static StageMetrics &decode = PipelineMetrics::instance().stage("decode");
+    //     ScopedStageTimer timer(decode);
+    class PipelineMetrics
+    {
+    public:
+        static PipelineMetrics &instance();
+
+        // Not Allowed to copy
+        PipelineMetrics(const PipelineMetrics &) = delete;
+        PipelineMetrics &operator=(const PipelineMetrics &) = delete;
+
+        // Enabling (re)starts the run clock used for the totals
+        void setEnabled(bool enabled);
+        bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // Stage or queue by name, created on first use. References stay valid.
+        StageMetrics &stage(const std::string &name);
+        QueueMetrics &queue(const std::string &name);
+
+        // Clear every counter (stages stay registered)
+        void reset();
+
+        // Summary table, one line per stage and queue, in registration order
+        void printSummary(std::ostream &out) const;
+
+        // Machine-readable form of the same data
+        std::string toJson() const;
+        bool writeJson(const std::string &filename) const;
+
+    private:
+        PipelineMetrics() = default;
+
+        double getRunSeconds() const;
+
+        std::atomic<bool> enabled_{false};
+        std::chrono::steady_clock::time_point run_start_{std::chrono::steady_clock::now()};
+
+        // deque keeps references stable while stages are added
+        mutable std::mutex mutex_;
+        std::deque<StageMetrics> stages_;
+        std::deque<QueueMetrics> queues_;
+    };
+
+    inline void StageMetrics::addFrames(uint64_t count)
+    {
+        if (PipelineMetrics::instance().isEnabled())
+            frames.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    inline void StageMetrics::addBytesRead(uint64_t count)
+    {
+        if (PipelineMetrics::instance().isEnabled())
+            bytes_read.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    inline void StageMetrics::addBytesWritten(uint64_t count)
+    {
+        if (PipelineMetrics::instance().isEnabled())
+            bytes_written.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    inline void QueueMetrics::recordDepth(size_t depth)
+    {
+        if (PipelineMetrics::instance().isEnabled())
+            depth_samples.record(depth);
+    }
+
+    // Adds wall and thread CPU time of a scope to a stage as one call, and
+    // records the scope as a span on the FrameTracer timeline.
+    // Does nothing while both metrics and tracing are disabled.
+    class ScopedStageTimer
+    {
+    public:
+        explicit ScopedStageTimer(StageMetrics &stage, int64_t frame_number = -1);
+        ~ScopedStageTimer();
+
+        // Not Allowed to copy
+        ScopedStageTimer(const ScopedStageTimer &) = delete;
+        ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+    private:
+        StageMetrics *stage_{nullptr};
+        bool measure_{false};
+        bool trace_{false};
+        int64_t frame_number_;
+        std::chrono::steady_clock::time_point wall_start_;
+        uint64_t cpu_start_ns_{0};
+    };
+
+    // Run fn as one timed call of stage and return its result, e.g.
+    //     while (timeStage(demux, [&] { return av_read_frame(ctx, packet); }) >= 0)
+    template <typename Fn>
+    decltype(auto) timeStage(StageMetrics &stage, Fn &&fn)
+    {
+        ScopedStageTimer timer(stage);
+        return std::forward<Fn>(fn)();
+    }
+
+    // Same, with the span tagged with the frame it works on
+    template <typename Fn>
+    decltype(auto) timeStage(StageMetrics &stage, int64_t frame_number, Fn &&fn)
+    {
+        ScopedStageTimer timer(stage, frame_number);
+        return std::forward<Fn>(fn)();
+    }
+
+    // CPU time consumed by the calling thread, in nanoseconds
+    uint64_t threadCpuTimeNs();
+
+    // Quote-safe form of text for a JSON string literal
+    std::string escapeJson(const std::string &text);
+}